@@ -0,0 +1,20 @@
+// ArrayBuffer Graphics fill/clear/scroll/blit speed. 'interleavex' makes the buffer non-linear,
+// which forces the per-pixel code, so we can compare against the word-at-a-time code
+function bench(bpp, opts) {
+  var g = Graphics.createArrayBuffer(176,176,bpp,opts);
+  var t = getTime(), i;
+  for (i=0;i<200;i++) g.clear();
+  var tClear = getTime()-t; t = getTime();
+  for (i=0;i<200;i++) g.setColor(i).fillRect(3+(i&7),5,150+(i&7),170);
+  var tFill = getTime()-t; t = getTime();
+  for (i=0;i<50;i++) g.scroll((i&1)?3:-3, (i&2)?2:-2);
+  var tScroll = getTime()-t; t = getTime();
+  for (i=0;i<50;i++) g.blit({x1:1+(i&3),y1:10,w:120,h:100,x2:40,y2:30+(i&1)});
+  var tBlit = getTime()-t;
+  return [tClear,tFill,tScroll,tBlit].map(t=>(t*1000).toFixed(0)+"ms").join("\t");
+}
+print("bpp\t\tclear\tfill\tscroll\tblit");
+[1,2,4,8,16].forEach(function(bpp) {
+  print(bpp+" words\t"+bench(bpp, {msb:true}));
+  print(bpp+" pixels\t"+bench(bpp, {msb:true, interleavex:true}));
+});
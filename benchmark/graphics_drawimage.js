@@ -0,0 +1,27 @@
+// drawImage speed for icon-sized images (with runs of the same colour, as in most app icons)
+// into a 16 bit ArrayBuffer Graphics, at 1:1 and 2x scale
+function makeImage(bpp, w, h) {
+  var bits = new Uint8Array((w*h*bpp+7)>>3);
+  for (var y=0;y<h;y++) for (var x=0;x<w;x++) {
+    var c = ((x>>3)+(y>>2))&((1<<bpp)-1), i = (x+y*w)*bpp;
+    for (var b=0;b<bpp;b++) if (c&(1<<(bpp-1-b))) bits[(i+b)>>3] |= 128>>((i+b)&7);
+  }
+  var img = {width:w,height:h,bpp:bpp,buffer:E.toArrayBuffer(E.toFlatString(bits))};
+  if (bpp<=4) img.palette = new Uint16Array(E.toArrayBuffer(E.toFlatString(new Uint8Array(2<<bpp).map((v,i)=>i*37))));
+  return img;
+}
+var g = Graphics.createArrayBuffer(176,176,16);
+print("image\t\t1:1\tscale 2\ttransparent");
+[1,2,4,8,16].forEach(function(bpp) {
+  var img = makeImage(bpp, 48, 48);
+  var t = getTime(), i;
+  for (i=0;i<300;i++) g.drawImage(img, i&63, i&31);
+  var t1 = getTime()-t; t = getTime();
+  for (i=0;i<100;i++) g.drawImage(img, i&63, i&31, {scale:2});
+  var t2 = getTime()-t;
+  img.transparent = 0;
+  t = getTime();
+  for (i=0;i<300;i++) g.drawImage(img, i&63, i&31);
+  var t3 = getTime()-t;
+  print(bpp+"bpp 48x48\t"+[t1,t2,t3].map(t=>(t*1000).toFixed(0)+"ms").join("\t"));
+});
@@ -0,0 +1,36 @@
+// drawString/stringWidth/wrapString speed for Vector and PBF fonts, redrawing the same text
+// as a messages screen would. A PBF font split over many strings can't use the glyph cache.
+var seed = 1;
+function rnd(n) { seed = (seed*1103515245+12345)&0x7FFFFFFF; return seed%n; }
+function makePBF() { // version 1 PBF font, glyphs ' '..'~' 10x14 1bpp
+  var count = 95, hashTable = new Uint8Array(255*4), offsets = new Uint8Array(count*6), data = "";
+  var off = 4;
+  for (var i=0;i<count;i++) {
+    var cp = 32+i;
+    hashTable.set([cp, 1, (i*6)&255, (i*6)>>8], cp*4);
+    offsets.set([cp, 0, off&255, off>>8, 0, 0], i*6);
+    var d = [10, 14, 0, 1, 11];
+    for (var j=0;j<18;j++) d.push(rnd(256));
+    data += E.toString(d);
+    off += d.length;
+  }
+  return String.fromCharCode(1, 16, count, 0, 32, 0) + E.toString(hashTable) + E.toString(offsets) + "\0\0\0\0" + data;
+}
+var font = makePBF();
+var flatFont = E.toFlatString(font);
+var splitFont = "";
+for (var i=0;i<font.length;i+=10) splitFont += font.substr(i,10);
+var txt = "Meeting moved to 3pm\nPlease bring the slides and the notes from last week";
+var g = Graphics.createArrayBuffer(176,176,16);
+function bench(name, setFont) {
+  var t = getTime(), i;
+  for (i=0;i<200;i++) setFont(g).drawString(txt, 0, 20);
+  var tDraw = getTime()-t; t = getTime();
+  for (i=0;i<200;i++) setFont(g).wrapString(txt, 170);
+  var tWrap = getTime()-t;
+  print(name+"\t"+[tDraw,tWrap].map(t=>(t*1000).toFixed(0)+"ms").join("\t"));
+}
+print("font\t\tdraw\twrap");
+bench("Vector:18", g=>g.setFont("Vector:18"));
+bench("PBF flat", g=>g.setFontPBF(flatFont));
+bench("PBF split", g=>g.setFontPBF(splitFont));
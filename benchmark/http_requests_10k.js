@@ -0,0 +1,23 @@
+// Serve 10000 HTTP requests from require("http").createServer (Linux), one after the other
+var http = require("http");
+var COUNT = 10000;
+var server = http.createServer(function(req, res) {
+  res.writeHead(200, {'Content-Type': 'text/plain', 'Transfer-Encoding': 'chunked'});
+  res.write("Hello ");
+  res.end(req.url);
+});
+server.listen(8082);
+var done = 0, bytes = 0;
+var t = getTime();
+function next() {
+  http.get("http://localhost:8082/"+done, function(res) {
+    res.on('data', function(d) { bytes += d.length; });
+    res.on('close', function() {
+      if (++done < COUNT) return next();
+      t = getTime()-t;
+      print(done+" requests, "+bytes+" bytes in "+t.toFixed(2)+"s ("+(done/t).toFixed(0)+" req/s)");
+      server.close();
+    });
+  });
+}
+next();
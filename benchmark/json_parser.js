@@ -0,0 +1,23 @@
+// JSON.parse vs JSON.parser when we only want a few values out of a big settings-style file in Storage
+var doc = { version : 1, apps : [] };
+for (var i=0;i<60;i++)
+  doc.apps.push({ id : "app"+i, name : "Application "+i, version : "0."+i, files : ["app"+i+".app.js","app"+i+".img"], settings : { enabled : !(i&1), level : i } });
+var s = require("Storage");
+s.write("bench.json", JSON.stringify(doc));
+
+function bench(name, fn) {
+  var t = getTime(), r;
+  for (var i=0;i<5;i++) r = fn();
+  print(name+": "+Math.round((getTime()-t)*1000/5)+"ms ("+r+")");
+}
+bench("JSON.parse", function() {
+  return JSON.parse(s.read("bench.json")).apps.map(a=>a.name).length;
+});
+bench("JSON.parser path apps,*,name", function() {
+  var names = [];
+  var p = JSON.parser({path:["apps","*","name"]});
+  p.on('value', function(v) { names.push(v); });
+  p.end(s.read("bench.json"));
+  return names.length;
+});
+s.erase("bench.json");
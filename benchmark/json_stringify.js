@@ -0,0 +1,24 @@
+// JSON.stringify speed for big arrays and deeply nested objects
+function bench(name, v, space) {
+  var t = getTime(), s;
+  for (var i=0;i<20;i++) s = JSON.stringify(v, null, space);
+  print(name+": "+Math.round((getTime()-t)*1000/20)+"ms ("+s.length+" chars)");
+}
+var ints = [], floats = [], strs = [];
+for (var i=0;i<10000;i++) {
+  ints.push(i*37);
+  floats.push(i/7);
+  strs.push("item "+i);
+}
+bench("10k ints", ints);
+bench("10k floats", floats);
+bench("10k strings", strs);
+var objs = [];
+for (var i=0;i<2000;i++)
+  objs.push({ id : i, name : "Sensor "+i, value : i*1.5, enabled : !(i&1), tags : ["a","b"] });
+bench("2k objects", objs);
+function deep(n) { return n ? { level : n, next : deep(n-1), data : [n,n+1,"x"] } : null; }
+var d = deep(100);
+bench("depth 100 object", d);
+bench("depth 100 object, indented", d, 2);
+bench("2k objects, indented", objs, 2);
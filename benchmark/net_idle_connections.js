@@ -0,0 +1,15 @@
+// 200 open but idle TCP connections - how much CPU do we use while waiting? (run with 'time')
+var net = require("net");
+var server = net.createServer(function(c) {});
+server.listen(8081);
+var clients = [];
+// connect a few at a time, as the server only has a backlog of 10
+var connecter = setInterval(function() {
+  for (var i=0;i<5;i++) clients.push(net.connect({host:"localhost", port:8081}, function() {}));
+  if (clients.length>=200) clearInterval(connecter);
+}, 20);
+setTimeout(function() {
+  print(clients.length+" connections");
+  clients.forEach(c=>c.end());
+  server.close();
+}, 4000);
@@ -0,0 +1,35 @@
+// RegExp speed on a multi-KB log, as when filtering logs on-device: test/exec/match/replace/split
+var levels = ["INFO","WARN","ERROR","DEBUG"];
+var log = "";
+for (var i=0;i<100;i++)
+  log += "2024-05-"+(10+(i%20))+" 12:"+(10+(i%50))+" "+levels[i%4]+" sensor"+(i%7)+": temperature="+(20+i%9)+"."+(i%10)+" battery="+(90-i%30)+"%\n";
+var lines = log.split("\n");
+
+function bench(name, fn) {
+  var t = getTime(), r;
+  for (var i=0;i<20;i++) r = fn();
+  print(name+": "+Math.round((getTime()-t)*1000)+"ms ("+r+")");
+}
+bench("test lines /ERROR|WARN/", function() {
+  var re = /ERROR|WARN/, n=0;
+  lines.forEach(function(l) { if (re.test(l)) n++; });
+  return n;
+});
+bench("match /sensor3: temperature=(\\d+)\\.\\d/g", function() {
+  return log.match(/sensor3: temperature=(\d+)\.\d/g).length;
+});
+bench("replace /battery=\\d+%/g", function() {
+  return log.replace(/battery=\d+%/g, "").length;
+});
+bench("split /\\r?\\n/", function() {
+  return log.split(/\r?\n/).length;
+});
+var abab = "abababababababababab";
+while (abab.length<2000) abab += abab;
+bench("no match /(a|b)*c$/ on 'abab...'", function() {
+  return /(a|b)*c$/.test(abab) ? 1 : 0;
+});
+var aaa = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+bench("no match /a*a*a*b/ on 'aaa...'", function() {
+  return /a*a*a*b/.test(aaa) ? 1 : 0;
+});
@@ -0,0 +1,7 @@
+// How fast can we queue data to be sent? Serial1 isn't connected on Linux so data is just discarded
+var s = "";
+for (var i=0;i<1024;i++) s += String.fromCharCode(32+(i%90));
+s = E.toString(s);
+var t = getTime();
+for (var i=0;i<100;i++) Serial1.write(s);
+print("100kB in "+Math.round((getTime()-t)*1000)+"ms");
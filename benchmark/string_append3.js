@@ -0,0 +1,8 @@
+// Building up a String with `s = s + x` (appends in place) vs `s += x` and prepending (copies)
+function bench(name, fn) {
+  var t = getTime(), r = fn();
+  print(name+": "+Math.round((getTime()-t)*1000)+"ms ("+r+")");
+}
+bench("s = s + 'XXXXXXXXXX'", function() { var s = ""; for (var i=0;i<2000;i++) s = s + "XXXXXXXXXX"; return s.length; });
+bench("s += 'XXXXXXXXXX'", function() { var s = ""; for (var i=0;i<2000;i++) s += "XXXXXXXXXX"; return s.length; });
+bench("s = 'X' + s", function() { var s = ""; for (var i=0;i<2000;i++) s = "X" + s; return s.length; });
@@ -0,0 +1,9 @@
+// 1000 timers waiting, while a fast interval runs - how often can it be called?
+for (var i=0;i<1000;i++) setTimeout(function() {}, 100000+i);
+var n = 0;
+setInterval(function() { n++; }, 0.1);
+var t = getTime();
+setTimeout(function() {
+  print(n+" intervals in "+Math.round((getTime()-t)*1000)+"ms");
+  clearInterval();
+}, 2000);
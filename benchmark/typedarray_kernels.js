@@ -0,0 +1,21 @@
+// Typed array sort/indexOf/includes and E.sum/E.variance on flat buffers
+function bench(name, fn) {
+  var t = getTime(), r = fn();
+  print(name+": "+Math.round((getTime()-t)*1000)+"ms ("+r+")");
+}
+var seed = 1;
+function fill(a) {
+  for (var i=0;i<a.length;i++) { seed = (seed*1103515245 + 12345) & 0x7FFFFFFF; a[i] = (seed>>8) - 4194304; }
+  return a;
+}
+var N = 2000;
+var i16 = fill(new Int16Array(N)), i32 = fill(new Int32Array(N));
+var f64 = fill(new Float64Array(N)), u8 = fill(new Uint8Array(N));
+bench("Uint8Array sort", function() { u8.sort(); return u8[0]+","+u8[N-1]; });
+bench("Int16Array sort", function() { i16.sort(); return i16[0]+","+i16[N-1]; });
+bench("Int32Array sort", function() { i32.sort(); return i32[0]+","+i32[N-1]; });
+bench("Float64Array sort", function() { f64.sort(); return f64[0]+","+f64[N-1]; });
+bench("Int32Array indexOf x100", function() { var r; for (var j=0;j<100;j++) r = i32.indexOf(12345678); return r; });
+bench("Uint8Array includes x100", function() { var r; for (var j=0;j<100;j++) r = u8.includes(256); return r; });
+bench("E.sum x100", function() { var r; for (var j=0;j<100;j++) r = E.sum(i32); return r; });
+bench("E.variance x100", function() { var r; for (var j=0;j<100;j++) r = E.variance(f64, 0); return Math.round(r/1e9); });
@@ -1163,10 +1163,7 @@ void lcd_flip(JsVar *parent, int all) {
   } else
 #endif
   if (all) {
-    graphicsInternal.data.modMinX = 0;
-    graphicsInternal.data.modMinY = 0;
-    graphicsInternal.data.modMaxX = LCD_WIDTH-1;
-    graphicsInternal.data.modMaxY = LCD_HEIGHT-1;
+    graphicsSetModified(&graphicsInternal, 0, 0, LCD_WIDTH-1, LCD_HEIGHT-1);
   }
   graphicsInternalFlip();
 #endif
@@ -2521,6 +2518,9 @@ void jswrap_banglejs_setLCDMode(JsVar *mode) {
     jsvUnLock(arrData);
   }
   graphicsStructResetState(&graphicsInternal); // reset colour, cliprect, etc
+  // the first flip in a buffered mode should send the whole buffer
+  graphicsClearModified(&graphicsInternal);
+  graphicsSetModified(&graphicsInternal, 0, 0, graphicsInternal.data.width-1, graphicsInternal.data.height-1);
   jsvUnLock(graphics);
   lcdST7789_setMode( lcdMode );
   graphicsSetCallbacks(&graphicsInternal); // set the callbacks up after the mode change
@@ -2712,10 +2712,7 @@ void jswrap_banglejs_setLCDOverlay(JsVar *imgVar, JsVar *xv, int y, JsVar *optio
 #if defined(LCD_CONTROLLER_ST7789V) || defined(LCD_CONTROLLER_ST7735) || defined(LCD_CONTROLLER_GC9A01)
   lcdSetOverlay_SPILCD(imgVar, x, y);
   // set all as modified
-  graphicsInternal.data.modMinX = 0;
-  graphicsInternal.data.modMinY = 0;
-  graphicsInternal.data.modMaxX = LCD_WIDTH-1;
-  graphicsInternal.data.modMaxY = LCD_HEIGHT-1;
+  graphicsSetModified(&graphicsInternal, 0, 0, LCD_WIDTH-1, LCD_HEIGHT-1);
 #endif
 }
 
@@ -0,0 +1,272 @@
+/*
+ * This file is part of Espruino, a JavaScript interpreter for Microcontrollers
+ *
+ * Copyright (C) 2013 Gordon Williams <gw@pur3.co.uk>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * ----------------------------------------------------------------------------
+ * Cache of rendered font glyphs (for Vector and PBF fonts)
+ *
+ * Glyphs are stored one after the other in a flat string of
+ * GRAPHICS_GLYPH_CACHE_SIZE bytes (in execInfo.hiddenRoot). When there's no
+ * space for a new glyph, the least recently used glyphs are removed and
+ * the ones after them are moved down. The cache is freed when Espruino is
+ * reset or saved (see jswrap_graphics_kill), or when we run out of memory
+ * (see jsiFreeMoreMemory) - it's recreated next time it's needed.
+ * ----------------------------------------------------------------------------
+ */
+#include "glyph_cache.h"
+
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+#include "jsparse.h"
+#ifndef NO_VECTOR_FONT
+#include "vector_font.h"
+#endif
+
+#define GLYPHCACHE_NAME "glyphs"
+/// Round up to a multiple of 4 bytes so every entry is aligned
+#define GLYPHCACHE_ALIGN(x) (((x)+3)&~(size_t)3)
+
+typedef struct {
+  uint16_t used; ///< bytes used by glyph entries
+  uint16_t tick; ///< incremented each time a glyph is used
+} GlyphCacheHeader;
+
+/// How many bytes we have for glyph entries
+#define GLYPHCACHE_CAPACITY (GRAPHICS_GLYPH_CACHE_SIZE - sizeof(GlyphCacheHeader))
+
+static GlyphCacheHeader *glyphCacheGetHeader(JsVar *cache) {
+  return (GlyphCacheHeader*)GLYPHCACHE_ALIGN((size_t)jsvGetFlatStringPointer(cache));
+}
+
+JsVar *glyphCacheGet() {
+  JsVar *cache = jsvObjectGetChildIfExists(execInfo.hiddenRoot, GLYPHCACHE_NAME);
+  if (cache) return cache;
+  // +3 so we can align the start
+  cache = jsvNewFlatStringOfLength(GRAPHICS_GLYPH_CACHE_SIZE+3);
+  if (!cache) return 0; // no memory - we just won't cache
+  GlyphCacheHeader *hdr = glyphCacheGetHeader(cache);
+  hdr->used = 0;
+  hdr->tick = 0;
+  jsvObjectSetChild(execInfo.hiddenRoot, GLYPHCACHE_NAME, cache);
+  return cache;
+}
+
+GlyphCacheEntry *glyphCacheFind(JsVar *cache, const GlyphCacheKey *key, bool needBitmap) {
+  GlyphCacheHeader *hdr = glyphCacheGetHeader(cache);
+  uint8_t *p = (uint8_t*)(hdr+1);
+  uint8_t *end = p + hdr->used;
+  while (p<end) {
+    GlyphCacheEntry *glyph = (GlyphCacheEntry*)p;
+    if (memcmp(&glyph->key, key, sizeof(GlyphCacheKey))==0) {
+      if (needBitmap && !(glyph->flags & (GLYPHCACHE_FLAG_BITMAP|GLYPHCACHE_FLAG_MISSING)))
+        return 0;
+      glyph->lastUsed = ++hdr->tick;
+      return glyph;
+    }
+    p += glyph->size;
+  }
+  return 0;
+}
+
+/// Remove a glyph, moving all the glyphs after it down
+static void glyphCacheRemove(GlyphCacheHeader *hdr, GlyphCacheEntry *glyph) {
+  uint8_t *p = (uint8_t*)glyph;
+  uint8_t *end = (uint8_t*)(hdr+1) + hdr->used;
+  uint16_t size = glyph->size;
+  memmove(p, p+size, (size_t)(end-(p+size)));
+  hdr->used = (uint16_t)(hdr->used - size);
+}
+
+GlyphCacheEntry *glyphCacheAdd(JsVar *cache, const GlyphCacheKey *key, size_t bitmapBytes) {
+  size_t size = GLYPHCACHE_ALIGN(sizeof(GlyphCacheEntry) + bitmapBytes);
+  if (size > GLYPHCACHE_CAPACITY/4) return 0; // don't let one big glyph push everything else out
+  GlyphCacheHeader *hdr = glyphCacheGetHeader(cache);
+  GlyphCacheEntry *glyph = glyphCacheFind(cache, key, false);
+  if (glyph) glyphCacheRemove(hdr, glyph);
+  // remove the least recently used glyphs until we have space
+  while (GLYPHCACHE_CAPACITY - hdr->used < size) {
+    uint8_t *p = (uint8_t*)(hdr+1);
+    uint8_t *end = p + hdr->used;
+    GlyphCacheEntry *oldest = 0;
+    uint16_t oldestAge = 0;
+    while (p<end) {
+      glyph = (GlyphCacheEntry*)p;
+      uint16_t age = (uint16_t)(hdr->tick - glyph->lastUsed);
+      if (!oldest || age>=oldestAge) {
+        oldest = glyph;
+        oldestAge = age;
+      }
+      p += glyph->size;
+    }
+    glyphCacheRemove(hdr, oldest);
+  }
+  glyph = (GlyphCacheEntry*)((uint8_t*)(hdr+1) + hdr->used);
+  memset(glyph, 0, size);
+  glyph->key = *key;
+  glyph->size = (uint16_t)size;
+  glyph->lastUsed = ++hdr->tick;
+  hdr->used = (uint16_t)(hdr->used + size);
+  return glyph;
+}
+
+void glyphCacheRemoveFont(uint32_t fontId) {
+  JsVar *cache = jsvObjectGetChildIfExists(execInfo.hiddenRoot, GLYPHCACHE_NAME);
+  if (!cache) return;
+  GlyphCacheHeader *hdr = glyphCacheGetHeader(cache);
+  uint8_t *p = (uint8_t*)(hdr+1);
+  while (p < (uint8_t*)(hdr+1) + hdr->used) {
+    GlyphCacheEntry *glyph = (GlyphCacheEntry*)p;
+    if (glyph->key.fontId == fontId)
+      glyphCacheRemove(hdr, glyph); // the next glyph is now at p
+    else
+      p += glyph->size;
+  }
+  jsvUnLock(cache);
+}
+
+bool glyphCacheFree() {
+  JsVar *cache = jsvObjectGetChildIfExists(execInfo.hiddenRoot, GLYPHCACHE_NAME);
+  if (!cache) return false;
+  jsvUnLock(cache);
+  jsvObjectRemoveChild(execInfo.hiddenRoot, GLYPHCACHE_NAME);
+  return true;
+}
+
+void glyphCacheDraw(JsGraphics *gfx, GlyphCacheEntry *glyph, int x, int y, int scalex, int scaley, bool solidBackground) {
+  if (!(glyph->flags & GLYPHCACHE_FLAG_BITMAP)) return;
+  int bpp = glyph->bpp;
+  int bppRange = (1<<bpp)-1;
+  assert(bpp==1 || bpp==2); // Vector glyphs are 1bpp, PBF are 1 or 2
+  unsigned int cols[4];
+  cols[0] = gfx->data.bgColor;
+  cols[bppRange] = gfx->data.fgColor;
+  for (int i=1;i<bppRange;i++)
+    cols[i] = graphicsBlendGfxColor(gfx, (256*i)/bppRange);
+  const uint8_t *bitmap = GLYPHCACHE_BITMAP(glyph);
+  unsigned int bitIdx = 0;
+  x += glyph->x;
+  y += glyph->y;
+  for (int cy=0;cy<glyph->h;cy++) {
+    int py = y + cy*scaley;
+    int cx = 0;
+    while (cx<glyph->w) {
+      // find a run of pixels with the same colour and draw them in one go
+      int col = (bitmap[bitIdx>>3] >> (bitIdx&7)) & bppRange;
+      int runStart = cx;
+      do {
+        cx++;
+        bitIdx += (unsigned)bpp;
+      } while (cx<glyph->w && ((bitmap[bitIdx>>3] >> (bitIdx&7)) & bppRange)==col);
+      if (col || solidBackground)
+        graphicsFillRect(gfx, x+runStart*scalex, py, x+cx*scalex-1, py+scaley-1, cols[col]);
+    }
+  }
+}
+
+#ifndef NO_VECTOR_FONT
+/// graphicsPolyCallback that works out the bounding box of the polygons (in 1/16th pixels)
+static void glyphCacheBoundsCallback(void *data, int points, short *vertices) {
+  int *bounds = (int*)data;
+  for (int i=0;i<points;i++) {
+    int vx = vertices[i*2], vy = vertices[i*2+1];
+    if (vx<bounds[0]) bounds[0]=vx;
+    if (vy<bounds[1]) bounds[1]=vy;
+    if (vx>bounds[2]) bounds[2]=vx;
+    if (vy>bounds[3]) bounds[3]=vy;
+  }
+}
+
+/// fillRect for the temporary Graphics we use to render vector glyphs - sets bits in the bitmap
+static void glyphCacheFillRect(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
+  NOT_USED(col);
+  GlyphCacheEntry *glyph = (GlyphCacheEntry*)gfx->backendData;
+  uint8_t *bitmap = GLYPHCACHE_BITMAP(glyph);
+  for (int y=y1;y<=y2;y++) {
+    for (int x=x1;x<=x2;x++) {
+      unsigned int bit = (unsigned)(x + y*glyph->w);
+      bitmap[bit>>3] = (uint8_t)(bitmap[bit>>3] | (1<<(bit&7)));
+    }
+  }
+}
+static void glyphCacheSetPixel(JsGraphics *gfx, int x, int y, unsigned int col) {
+  glyphCacheFillRect(gfx, x, y, x, y, col);
+}
+
+GlyphCacheEntry *glyphCacheAddVectorChar(JsVar *cache, const GlyphCacheKey *key, int sizex, int sizey, char ch) {
+  // Work out which pixels graphicsFillPoly could fill if we drew the character at 0,0
+  int bounds[4] = { 0x7FFF, 0x7FFF, -0x8000, -0x8000 };
+  graphicsGetVectorChar(glyphCacheBoundsCallback, bounds, 0, 0, sizex, sizey, ch);
+  int x1 = 0, y1 = 0, w = 0, h = 0;
+  if (bounds[0]<=bounds[2]) {
+    x1 = (bounds[0]+15)>>4;
+    y1 = bounds[1]>>4;
+    w = ((bounds[2]+15)>>4) - x1;
+    h = (bounds[3]>>4) + 1 - y1;
+    if (w<0) w=0;
+  }
+  if (w>255 || h>255) return 0;
+  GlyphCacheEntry *glyph = glyphCacheAdd(cache, key, (size_t)(w*h+7)>>3);
+  if (!glyph) return 0;
+  glyph->advance = (int16_t)graphicsVectorCharWidth((unsigned int)sizex, ch);
+  glyph->x = (int16_t)x1;
+  glyph->y = (int16_t)y1;
+  glyph->w = (uint8_t)w;
+  glyph->h = (uint8_t)h;
+  glyph->bpp = 1;
+  glyph->flags = GLYPHCACHE_FLAG_BITMAP;
+  if (w && h) {
+    /* Render with graphicsFillPoly into a temporary Graphics that writes to the
+    bitmap. Vector fonts are always positioned at whole pixels, so the result
+    is exactly what we'd get if we drew the character directly. */
+    JsGraphics gfx;
+    memset(&gfx, 0, sizeof(gfx));
+    gfx.data.width = (unsigned short)w;
+    gfx.data.height = (unsigned short)h;
+    gfx.data.bpp = 1;
+    gfx.data.fgColor = 1;
+    gfx.data.clipRect.x2 = (unsigned short)(w-1);
+    gfx.data.clipRect.y2 = (unsigned short)(h-1);
+    graphicsClearModified(&gfx);
+    gfx.backendData = glyph;
+    gfx.setPixel = glyphCacheSetPixel;
+    gfx.fillRect = glyphCacheFillRect;
+    graphicsGetVectorChar((graphicsPolyCallback)graphicsFillPoly, &gfx, -x1, -y1, sizex, sizey, ch);
+  }
+  return glyph;
+}
+#endif
+
+#ifdef ESPR_PBF_FONTS
+GlyphCacheEntry *glyphCacheAddPBFChar(JsVar *cache, const GlyphCacheKey *key, PbfFontLoaderInfo *info, int codepoint, bool withBitmap) {
+  GlyphCacheEntry *glyph;
+  PbfFontLoaderGlyph result;
+  if (!jspbfFontFindGlyph(info, codepoint, &result)) {
+    glyph = glyphCacheAdd(cache, key, 0);
+    if (glyph) glyph->flags = GLYPHCACHE_FLAG_MISSING;
+    return glyph;
+  }
+  size_t bitmapBytes = withBitmap ? ((size_t)result.w*result.h*result.bpp + 7)>>3 : 0;
+  glyph = glyphCacheAdd(cache, key, bitmapBytes);
+  if (!glyph) return 0;
+  glyph->advance = (int16_t)(result.advance*key->scalex);
+  glyph->x = (int16_t)(result.x*key->scalex);
+  glyph->y = (int16_t)(result.y*key->scaley);
+  glyph->w = result.w;
+  glyph->h = result.h;
+  glyph->bpp = result.bpp;
+  if (withBitmap) {
+    // PBF bitmaps are in the same format as ours, and the iterator is left pointing at the data
+    glyph->flags = GLYPHCACHE_FLAG_BITMAP;
+    uint8_t *bitmap = GLYPHCACHE_BITMAP(glyph);
+    for (size_t i=0;i<bitmapBytes;i++)
+      bitmap[i] = (uint8_t)jsvStringIteratorGetCharAndNext(&info->it);
+  }
+  return glyph;
+}
+#endif
+
+#endif // GRAPHICS_GLYPH_CACHE_SIZE
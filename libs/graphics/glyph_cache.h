@@ -0,0 +1,79 @@
+/*
+ * This file is part of Espruino, a JavaScript interpreter for Microcontrollers
+ *
+ * Copyright (C) 2013 Gordon Williams <gw@pur3.co.uk>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * ----------------------------------------------------------------------------
+ * Cache of rendered font glyphs (for Vector and PBF fonts)
+ * ----------------------------------------------------------------------------
+ */
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include "graphics.h"
+
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+#ifdef ESPR_PBF_FONTS
+#include "pbf_font.h"
+#endif
+
+/// What the glyph is for. Glyphs are only reused if every field matches
+typedef struct {
+  uint32_t fontId;    ///< which font (see _jswrap_graphics_getFontInfo)
+  uint32_t fontCheck; ///< extra check for the font (eg. length of font data)
+  uint32_t codepoint;
+  uint16_t scalex, scaley;
+} GlyphCacheKey;
+
+typedef enum {
+  GLYPHCACHE_FLAG_BITMAP = 1,  ///< bitmap data follows the entry (otherwise we only have the metrics)
+  GLYPHCACHE_FLAG_MISSING = 2, ///< the font doesn't contain this character
+} GlyphCacheFlags;
+
+/** A cached glyph. The bitmap follows straight after this in memory, w*h*bpp bits
+ * packed LSB first with rows following each other directly (the same as PBF fonts) */
+typedef struct {
+  GlyphCacheKey key;
+  uint16_t size;      ///< size of this entry in bytes including the bitmap
+  uint16_t lastUsed;  ///< value of the cache's tick when we last used this
+  int16_t advance;    ///< how far to move right after drawing the character (pixels, scaled)
+  int16_t x, y;       ///< offset of the bitmap from where the character is drawn (pixels, scaled)
+  uint8_t w, h;       ///< size of the bitmap in pixels (unscaled)
+  uint8_t bpp;        ///< bits per pixel in the bitmap
+  uint8_t flags;      ///< GlyphCacheFlags
+} GlyphCacheEntry;
+
+/// Get a pointer to the glyph's bitmap data
+#define GLYPHCACHE_BITMAP(ENTRY) ((uint8_t*)((ENTRY)+1))
+
+/// Get the glyph cache (creating it if it doesn't exist). Returns a locked variable or 0 if we don't have the memory
+JsVar *glyphCacheGet();
+/** Find a glyph in the cache, or return 0. The pointer is only valid until glyphCacheAdd* is called
+ * or the cache is unlocked. If needBitmap, only return a glyph that has its bitmap */
+GlyphCacheEntry *glyphCacheFind(JsVar *cache, const GlyphCacheKey *key, bool needBitmap);
+/** Add a glyph with room for bitmapBytes of bitmap data (filled with 0), removing the least
+ * recently used glyphs if needed. Any existing glyph with the same key is replaced. Returns 0 if it won't fit */
+GlyphCacheEntry *glyphCacheAdd(JsVar *cache, const GlyphCacheKey *key, size_t bitmapBytes);
+/// Remove all glyphs for the given font (if we have a cache)
+void glyphCacheRemoveFont(uint32_t fontId);
+/// Free the glyph cache (so it isn't saved, or to get memory back). Returns true if there was one
+bool glyphCacheFree();
+/** Draw a cached glyph at x,y (the position the character is drawn at). Each bitmap pixel is drawn
+ * scalex*scaley pixels big. 2bpp bitmaps are blended between background and foreground colours */
+void glyphCacheDraw(JsGraphics *gfx, GlyphCacheEntry *glyph, int x, int y, int scalex, int scaley, bool solidBackground);
+
+#ifndef NO_VECTOR_FONT
+/// Render a vector font character into the cache. Returns 0 if it won't fit
+GlyphCacheEntry *glyphCacheAddVectorChar(JsVar *cache, const GlyphCacheKey *key, int sizex, int sizey, char ch);
+#endif
+#ifdef ESPR_PBF_FONTS
+/// Add a PBF font character to the cache (with its bitmap if withBitmap). Returns 0 if it won't fit
+GlyphCacheEntry *glyphCacheAddPBFChar(JsVar *cache, const GlyphCacheKey *key, PbfFontLoaderInfo *info, int codepoint, bool withBitmap);
+#endif
+
+#endif // GRAPHICS_GLYPH_CACHE_SIZE
+#endif // GLYPH_CACHE_H
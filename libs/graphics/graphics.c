@@ -97,7 +97,7 @@ void graphicsFallbackBlit(JsGraphics *gfx, int x1, int y1, int w, int h, int x2,
       graphicsFallbackBlitX(gfx, x1, y+y1, w, x2, y+y2);
   } else {
     for (int y=h-1;y>=0;y--)
-      graphicsFallbackBlitX(gfx, x1, y1, w, x2, y2);
+      graphicsFallbackBlitX(gfx, x1, y+y1, w, x2, y+y2);
   }
 }
 
@@ -107,7 +107,7 @@ void graphicsFallbackScroll(JsGraphics *gfx, int xdir, int ydir, int x1, int y1,
   #define MAX(a,b) ((a) > (b) ? (a) : (b))
   #define MIN(a,b) ((a) < (b) ? (a) : (b))
   graphicsFallbackBlit(gfx, x1-MIN(xdir,0), y1-MIN(ydir,0),
-    x2-(x1+abs(xdir)), y2-(y1+abs(xdir)), // width/height
+    (1+x2-x1)-abs(xdir), (1+y2-y1)-abs(ydir), // width/height
     x1+MAX(xdir,0), y1+MAX(ydir,0));
   #undef MIN
   #undef MAX
@@ -154,12 +154,7 @@ void graphicsStructInit(JsGraphics *gfx, int width, int height, int bpp) {
   gfx->data.height = (unsigned short)height;
   gfx->data.bpp = (unsigned char)bpp;
   graphicsStructResetState(gfx);
-#ifndef NO_MODIFIED_AREA
-  gfx->data.modMaxX = -32768;
-  gfx->data.modMaxY = -32768;
-  gfx->data.modMinX = 32767;
-  gfx->data.modMinY = 32767;
-#endif
+  graphicsClearModified(gfx);
 }
 
 /// Set up the callbacks for this graphics instance (usually done by graphicsGetFromVar)
@@ -317,6 +312,52 @@ unsigned short graphicsGetHeight(const JsGraphics *gfx) {
   return (gfx->data.flags & JSGRAPHICSFLAGS_SWAP_XY) ? gfx->data.width : gfx->data.height;
 }
 
+#if GRAPHICS_MODIFIED_RECTS>1
+/// How many more pixels we'd have to send if we sent the area covering both rects rather than each separately
+static int graphicsRectMergeCost(const JsGraphicsRect *r, int x1, int y1, int x2, int y2) {
+  int ux1 = (r->x1<x1) ? r->x1 : x1, uy1 = (r->y1<y1) ? r->y1 : y1;
+  int ux2 = (r->x2>x2) ? r->x2 : x2, uy2 = (r->y2>y2) ? r->y2 : y2;
+  return (1+ux2-ux1)*(1+uy2-uy1) - (1+r->x2-r->x1)*(1+r->y2-r->y1) - (1+x2-x1)*(1+y2-y1);
+}
+
+/// Add an area to the list of modified areas, merging it with any others where that's cheaper than keeping them separate
+static void graphicsAddModifiedRect(JsGraphics *gfx, int x1, int y1, int x2, int y2) {
+  JsGraphicsRect *rects = gfx->data.modRects;
+  int n = gfx->data.modRectCount;
+  // Usually we're drawing inside the area we modified last
+  if (n) {
+    JsGraphicsRect *r = &rects[n-1];
+    if (x1>=r->x1 && y1>=r->y1 && x2<=r->x2 && y2<=r->y2) return;
+  }
+  int i = 0, best = -1;
+  while (i<n) {
+    if (graphicsRectMergeCost(&rects[i], x1,y1,x2,y2) <= GRAPHICS_MODIFIED_MERGE_AREA) {
+      best = i;
+    } else if (n==GRAPHICS_MODIFIED_RECTS && i==n-1) { // no space left - merge with the cheapest
+      best = 0;
+      for (int j=1;j<n;j++)
+        if (graphicsRectMergeCost(&rects[j], x1,y1,x2,y2) < graphicsRectMergeCost(&rects[best], x1,y1,x2,y2))
+          best = j;
+    }
+    if (best>=0) {
+      if (rects[best].x1 < x1) x1 = rects[best].x1;
+      if (rects[best].y1 < y1) y1 = rects[best].y1;
+      if (rects[best].x2 > x2) x2 = rects[best].x2;
+      if (rects[best].y2 > y2) y2 = rects[best].y2;
+      rects[best] = rects[--n];
+      best = -1;
+      i = 0; // our area is bigger now, so check again
+    } else i++;
+  }
+  // put it on the end, as it's the one most likely to get drawn in next
+  rects[n].x1 = (short)x1;
+  rects[n].y1 = (short)y1;
+  rects[n].x2 = (short)x2;
+  rects[n].y2 = (short)y2;
+  gfx->data.modRectCount = (unsigned char)(n+1);
+}
+#endif
+
 // Set the area modified by a draw command and also clip to the screen/clipping bounds. Returns true if clipped. If coordsRotatedAlready we assume the coordinates have gone through deviceToGraphicsCoordinates already
 bool graphicsSetModifiedAndClip(JsGraphics *gfx, int *x1, int *y1, int *x2, int *y2, bool coordsRotatedAlready) {
   bool modified = false;
@@ -346,6 +387,9 @@ bool graphicsSetModifiedAndClip(JsGraphics *gfx, int *x1, int *y1, int *x2, int
   if (*x2 > gfx->data.modMaxX) { gfx->data.modMaxX=(short)*x2; modified = true; }
   if (*y1 < gfx->data.modMinY) { gfx->data.modMinY=(short)*y1; modified = true; }
   if (*y2 > gfx->data.modMaxY) { gfx->data.modMaxY=(short)*y2; modified = true; }
+#if GRAPHICS_MODIFIED_RECTS>1
+  if (*x1<=*x2 && *y1<=*y2) graphicsAddModifiedRect(gfx, *x1, *y1, *x2, *y2);
+#endif
 #endif
   return modified;
 }
@@ -357,9 +401,80 @@ void graphicsSetModified(JsGraphics *gfx, int x1, int y1, int x2, int y2) {
   if (x2 > gfx->data.modMaxX) { gfx->data.modMaxX=(short)x2; }
   if (y1 < gfx->data.modMinY) { gfx->data.modMinY=(short)y1; }
   if (y2 > gfx->data.modMaxY) { gfx->data.modMaxY=(short)y2; }
+#if GRAPHICS_MODIFIED_RECTS>1
+  if (x1<=x2 && y1<=y2) graphicsAddModifiedRect(gfx, x1, y1, x2, y2);
+#endif
+#endif
+}
+
+// Mark the whole screen as unmodified (eg. after a flip)
+void graphicsClearModified(JsGraphics *gfx) {
+#ifndef NO_MODIFIED_AREA
+  gfx->data.modMaxX = -32768;
+  gfx->data.modMaxY = -32768;
+  gfx->data.modMinX = 32767;
+  gfx->data.modMinY = 32767;
+#if GRAPHICS_MODIFIED_RECTS>1
+  gfx->data.modRectCount = 0;
+#endif
 #endif
 }
 
+#ifndef NO_MODIFIED_AREA
+/** Get the areas that have been modified (at most GRAPHICS_MODIFIED_RECTS) clipped to the screen, and return how many there are.
+If mergeRowGap>=0 the areas are for sending as full rows - they are sorted by y, and areas that overlap or are within mergeRowGap rows of each other are merged */
+int graphicsGetModifiedRects(JsGraphics *gfx, JsGraphicsRect *rects, int mergeRowGap) {
+  if (gfx->data.modMinX > gfx->data.modMaxX || gfx->data.modMinY > gfx->data.modMaxY)
+    return 0;
+  int n = 0;
+#if GRAPHICS_MODIFIED_RECTS>1
+  n = gfx->data.modRectCount;
+  memcpy(rects, gfx->data.modRects, sizeof(JsGraphicsRect)*(size_t)n);
+#endif
+  if (!n) { // just the bounding box
+    rects[0].x1 = gfx->data.modMinX;
+    rects[0].y1 = gfx->data.modMinY;
+    rects[0].x2 = gfx->data.modMaxX;
+    rects[0].y2 = gfx->data.modMaxY;
+    n = 1;
+  }
+  // clip to the screen
+  int i = 0;
+  while (i<n) {
+    JsGraphicsRect *r = &rects[i];
+    if (r->x1 < 0) r->x1 = 0;
+    if (r->y1 < 0) r->y1 = 0;
+    if (r->x2 >= gfx->data.width) r->x2 = (short)(gfx->data.width-1);
+    if (r->y2 >= gfx->data.height) r->y2 = (short)(gfx->data.height-1);
+    if (r->x1>r->x2 || r->y1>r->y2) rects[i] = rects[--n]; // offscreen
+    else i++;
+  }
+  if (mergeRowGap<0) return n;
+  // sort by y1 (there are only a few)
+  for (i=1;i<n;i++) {
+    JsGraphicsRect r = rects[i];
+    int j = i;
+    while (j>0 && rects[j-1].y1 > r.y1) {
+      rects[j] = rects[j-1];
+      j--;
+    }
+    rects[j] = r;
+  }
+  // merge any rows that are close enough
+  int out = 0;
+  for (i=0;i<n;i++) {
+    if (out && rects[i].y1 <= rects[out-1].y2+1+mergeRowGap) {
+      JsGraphicsRect *r = &rects[out-1];
+      if (rects[i].x1 < r->x1) r->x1 = rects[i].x1;
+      if (rects[i].x2 > r->x2) r->x2 = rects[i].x2;
+      if (rects[i].y2 > r->y2) r->y2 = rects[i].y2;
+    } else
+      rects[out++] = rects[i];
+  }
+  return out;
+}
+#endif
+
 /// Get a setPixel function (assuming coordinates already clipped with graphicsSetModifiedAndClip) - if all is ok it can choose a faster draw function
 JsGraphicsSetPixelFn graphicsGetSetPixelFn(JsGraphics *gfx) {
   if (gfx->data.flags & JSGRAPHICSFLAGS_MAPPEDXY)
@@ -446,10 +561,7 @@ static void graphicsSetPixelDevice(JsGraphics *gfx, int x, int y, unsigned int c
       y<gfx->data.clipRect.y1 ||
       x>gfx->data.clipRect.x2 ||
       y>gfx->data.clipRect.y2) return;
-  if (x < gfx->data.modMinX) gfx->data.modMinX=(short)x;
-  if (x > gfx->data.modMaxX) gfx->data.modMaxX=(short)x;
-  if (y < gfx->data.modMinY) gfx->data.modMinY=(short)y;
-  if (y > gfx->data.modMaxY) gfx->data.modMaxY=(short)y;
+  graphicsSetModified(gfx, x, y, x, y);
 #else
   if (x<0 || y<0 || x>=gfx->data.width || y>=gfx->data.height) return;
 #endif
@@ -491,12 +603,7 @@ void graphicsFillRectDevice(JsGraphics *gfx, int x1, int y1, int x2, int y2, uns
   if (y2>gfx->data.clipRect.y2) y2 = gfx->data.clipRect.y2;
 #endif
   if (x2<x1 || y2<y1) return; // nope
-#ifndef NO_MODIFIED_AREA
-  if (x1 < gfx->data.modMinX) gfx->data.modMinX=(short)x1;
-  if (x2 > gfx->data.modMaxX) gfx->data.modMaxX=(short)x2;
-  if (y1 < gfx->data.modMinY) gfx->data.modMinY=(short)y1;
-  if (y2 > gfx->data.modMaxY) gfx->data.modMaxY=(short)y2;
-#endif
+  graphicsSetModified(gfx, x1, y1, x2, y2);
   if (x1==x2 && y1==y2) {
     gfx->setPixel(gfx,(int)x1,(int)y1,col);
     return;
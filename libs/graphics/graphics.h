@@ -30,10 +30,24 @@
 #endif
 #endif
 
+#ifndef NO_MODIFIED_AREA
+#ifdef SAVE_ON_FLASH
+#define GRAPHICS_MODIFIED_RECTS 1 // just the bounding box
+#else
+#define GRAPHICS_MODIFIED_RECTS 4 // Keep track of separate modified areas so we can send less data on flip
+#endif
+#define GRAPHICS_MODIFIED_MERGE_AREA 64 // Merge modified areas if that adds fewer than this many unmodified pixels
+#endif
+
 #if defined(LINUX) || defined(BANGLEJS)
 #define GRAPHICS_FAST_PATHS // execute more optimised code when no rotation/etc
 #endif
 
+// Other boards can enable the glyph cache with -DGRAPHICS_GLYPH_CACHE_SIZE=...
+#if (defined(LINUX) || defined(BANGLEJS)) && !defined(NO_GLYPH_CACHE) && !defined(GRAPHICS_GLYPH_CACHE_SIZE)
+#define GRAPHICS_GLYPH_CACHE_SIZE 1024 // Bytes of RAM used to cache Vector/PBF font glyphs (see glyph_cache.c)
+#endif
+
 typedef enum {
   JSGRAPHICSTYPE_ARRAYBUFFER, ///< Write everything into an ArrayBuffer
   JSGRAPHICSTYPE_JS,          ///< Call JavaScript when we want to write something
@@ -100,12 +114,18 @@ typedef enum {
 #define JSGRAPHICS_CUSTOMFONT_WIDTH JS_HIDDEN_CHAR_STR"fnW"
 #define JSGRAPHICS_CUSTOMFONT_HEIGHT JS_HIDDEN_CHAR_STR"fnH"
 #define JSGRAPHICS_CUSTOMFONT_FIRSTCHAR JS_HIDDEN_CHAR_STR"fn1"
+#define JSGRAPHICS_CUSTOMFONT_CHECK JS_HIDDEN_CHAR_STR"fnC" // hash of a PBF font's tables, for the glyph cache
 
 typedef struct {
   unsigned short x1,y1;
   unsigned short x2,y2;
 } PACKED_FLAGS JsGraphicsClipRect;
 
+typedef struct {
+  short x1,y1;
+  short x2,y2;
+} PACKED_FLAGS JsGraphicsRect;
+
 typedef struct {
   JsGraphicsType type;
   JsGraphicsFlags flags;
@@ -123,6 +143,10 @@ typedef struct {
 #ifndef NO_MODIFIED_AREA
   JsGraphicsClipRect clipRect;
   short modMinX, modMinY, modMaxX, modMaxY; ///< area that has been modified
+#if GRAPHICS_MODIFIED_RECTS>1
+  unsigned char modRectCount; ///< how many of modRects are used
+  JsGraphicsRect modRects[GRAPHICS_MODIFIED_RECTS]; ///< separate areas that have been modified (modMinX..modMaxY is the bounding box of these)
+#endif
 #endif
 } PACKED_FLAGS JsGraphicsData;
 
@@ -200,6 +224,13 @@ unsigned short graphicsGetHeight(const JsGraphics *gfx);
 bool graphicsSetModifiedAndClip(JsGraphics *gfx, int *x1, int *y1, int *x2, int *y2, bool coordsRotatedAlready);
 // Set the area modified by a draw command
 void graphicsSetModified(JsGraphics *gfx, int x1, int y1, int x2, int y2);
+// Mark the whole screen as unmodified (eg. after a flip)
+void graphicsClearModified(JsGraphics *gfx);
+#ifndef NO_MODIFIED_AREA
+/** Get the areas that have been modified (at most GRAPHICS_MODIFIED_RECTS) clipped to the screen, and return how many there are.
+If mergeRowGap>=0 the areas are for sending as full rows - they are sorted by y, and areas that overlap or are within mergeRowGap rows of each other are merged */
+int graphicsGetModifiedRects(JsGraphics *gfx, JsGraphicsRect *rects, int mergeRowGap);
+#endif
 /// Get a setPixel function (assuming coordinates already clipped with graphicsSetModifiedAndClip) - if all is ok it can choose a faster draw function
 JsGraphicsSetPixelFn graphicsGetSetPixelFn(JsGraphics *gfx);
 /// Get a setPixel function and set modified area (assuming no clipping) (inclusive of x2,y2) - if all is ok it can choose a faster draw function
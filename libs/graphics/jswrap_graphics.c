@@ -49,6 +49,7 @@
 #ifdef ESPR_PBF_FONTS
 #include "pbf_font.h"
 #endif
+#include "glyph_cache.h"
 #ifdef ESPR_LINE_FONTS
 #include "line_font.h"
 #endif
@@ -170,7 +171,10 @@ bool _jswrap_graphics_parseImage(JsGraphics *gfx, JsVar *image, size_t imageOffs
     v = jsvObjectGetChildIfExists(image, "palette");
     if (v) {
       jsvUnLock(_jswrap_graphics_parseImage_palette(info, v));
-      if (!info->palettePtr) return false;
+      if (!info->palettePtr) {
+        _jswrap_graphics_freeImageInfo(info);
+        return false;
+      }
     }
 #endif
 
@@ -429,6 +433,133 @@ NO_INLINE void _jswrap_drawImageSimpleRow(JsGraphics *gfx, int xPos, int y, GfxD
 }
 
 
+#ifdef GRAPHICS_FAST_PATHS
+/// How many pixels of an image row we decode at once in _jswrap_drawImageFast
+#define GFX_DRAWIMAGE_ROW_CHUNK 32
+/// Runs of the same colour shorter than this are drawn with setPixel rather than fillRect
+#define GFX_DRAWIMAGE_MIN_SPAN 3
+
+/// Reads image bits either directly from memory (if the image is flat/memory-mapped) or with a StringIterator
+typedef struct {
+  const unsigned char *ptr; ///< if nonzero, read image bytes directly from here
+  JsvStringIterator *it; ///< otherwise read them from here
+  uint32_t colData; ///< bits that have been read but not used yet
+  int bits; ///< number of valid bits in colData (negative = we must skip that many bits)
+} GfxDrawImageReader;
+
+/// Skip forward the given amount of bits
+static void _jswrap_drawImageReaderSkip(GfxDrawImageReader *r, int bits) {
+  r->bits -= bits;
+  if (r->bits<0 && r->ptr) { // we can just jump forwards in memory
+    r->ptr += (unsigned)(-r->bits)>>3;
+    r->bits = -((-r->bits)&7);
+  }
+}
+
+/// Decode 'n' pixels of image data into 'cols' (no palette lookup)
+static void _jswrap_drawImageReaderDecode(GfxDrawImageReader *r, const GfxDrawImageInfo *img, uint32_t *cols, int n) {
+  int bpp = img->bpp;
+  uint32_t bitMask = img->bitMask;
+  uint32_t colData = r->colData;
+  int bits = r->bits;
+  if (r->ptr) {
+    const unsigned char *p = r->ptr;
+    if (bpp==8 && bits==0) { // byte aligned 8 bit - very common
+      for (int i=0;i<n;i++) cols[i] = *(p++);
+    } else {
+      for (int i=0;i<n;i++) {
+        while (bits < bpp) {
+          colData = (colData<<8) | *(p++);
+          bits += 8;
+        }
+        cols[i] = (colData>>(bits-bpp))&bitMask;
+        bits -= bpp;
+      }
+    }
+    r->ptr = p;
+  } else {
+    for (int i=0;i<n;i++) {
+      while (bits < bpp) {
+        colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetUTF8CharAndNext(r->it));
+        bits += 8;
+      }
+      cols[i] = (colData>>(bits-bpp))&bitMask;
+      bits -= bpp;
+    }
+  }
+  r->colData = colData;
+  r->bits = bits;
+}
+
+/* Draw decoded image pixels (image columns col..col+n-1) as runs of the same colour. Each image
+pixel is 's' pixels wide and covers device rows y1..y2. Output is clipped in X to cx1..cx2. */
+static void _jswrap_drawImageSpans(JsGraphics *gfx, const GfxDrawImageInfo *img, const uint32_t *cols, int n, int x, int s, int y1, int y2, int cx1, int cx2) {
+  // mask colours to the device's bpp as graphicsSetPixel does
+  unsigned int colMask = (unsigned int)((1L<<gfx->data.bpp)-1);
+  int i = 0;
+  while (i<n) {
+    uint32_t c = cols[i];
+    int j = i+1;
+    while (j<n && cols[j]==c) j++;
+    if (c!=img->transparentCol) {
+      int sx1 = x+i*s, sx2 = x+j*s-1;
+      if (sx1<cx1) sx1=cx1;
+      if (sx2>cx2) sx2=cx2;
+      // palette lookup is done once per run rather than once per pixel
+      unsigned int col = (img->palettePtr ? img->palettePtr[c&img->paletteMask] : c) & colMask;
+      if (y1==y2 && sx2-sx1 < GFX_DRAWIMAGE_MIN_SPAN-1) {
+        for (int px=sx1;px<=sx2;px++)
+          gfx->setPixel(gfx, px, y1, col);
+      } else if (sx1<=sx2)
+        gfx->fillRect(gfx, sx1, y1, sx2, y2, col);
+    }
+    i = j;
+  }
+}
+
+/* Draw an image at xPos,yPos with integer scale 's' when the Graphics has no
+coordinate mapping (rotation/mirroring). Rows are decoded a chunk at a time and
+written out as runs of the same colour with fillRect. Only the visible part of the
+image is decoded, and if the image is in a flat/memory-mapped string we read it directly. */
+NO_INLINE void _jswrap_drawImageFast(JsGraphics *gfx, int xPos, int yPos, int s, GfxDrawImageInfo *img, JsvStringIterator *it) {
+  assert(!(gfx->data.flags & JSGRAPHICSFLAGS_MAPPEDXY));
+  int x1 = xPos, y1 = yPos, x2 = xPos+img->width*s-1, y2 = yPos+img->height*s-1;
+  graphicsSetModifiedAndClip(gfx,&x1,&y1,&x2,&y2, true);
+  if (x2<x1 || y2<y1) return; // offscreen
+  GfxDrawImageReader r;
+  r.ptr = 0;
+  r.it = it;
+  r.colData = 0;
+  r.bits = 0;
+  if (!jsvIsUTF8String(img->buffer)) {
+    size_t dataLen = 0;
+    const unsigned char *dataPtr = (const unsigned char *)jsvGetDataPointer(img->buffer, &dataLen);
+    size_t bitmapLength = ((size_t)img->width*(size_t)img->height*(size_t)img->bpp + 7)>>3;
+    if (dataPtr && (size_t)img->bitmapOffset + bitmapLength <= dataLen)
+      r.ptr = dataPtr + img->bitmapOffset;
+  }
+  // work out which image rows and columns are visible
+  int row1 = (y1-yPos)/s, row2 = (y2-yPos)/s;
+  int col1 = (x1-xPos)/s, col2 = (x2-xPos)/s;
+  int bitsPerRow = img->width*img->bpp;
+  _jswrap_drawImageReaderSkip(&r, row1*bitsPerRow);
+  uint32_t cols[GFX_DRAWIMAGE_ROW_CHUNK];
+  for (int row=row1;row<=row2;row++) {
+    int py1 = yPos+row*s, py2 = py1+s-1;
+    if (py1<y1) py1=y1;
+    if (py2>y2) py2=y2;
+    _jswrap_drawImageReaderSkip(&r, col1*img->bpp);
+    for (int col=col1;col<=col2;col+=GFX_DRAWIMAGE_ROW_CHUNK) {
+      int n = col2+1-col;
+      if (n>GFX_DRAWIMAGE_ROW_CHUNK) n=GFX_DRAWIMAGE_ROW_CHUNK;
+      _jswrap_drawImageReaderDecode(&r, img, cols, n);
+      _jswrap_drawImageSpans(gfx, img, cols, n, xPos+col*s, s, py1, py2, x1, x2);
+    }
+    _jswrap_drawImageReaderSkip(&r, (img->width-1-col2)*img->bpp);
+  }
+}
+#endif
+
 /* Draw an image 1:1 at xPos,yPos. If parseFullImage=true we ensure
 we leave the StringIterator pointing right at the end of the image. If not
 we can optimise if the image is clipped/offscreen. */
@@ -437,6 +568,12 @@ NO_INLINE void _jswrap_drawImageSimple(JsGraphics *gfx, int xPos, int yPos, GfxD
   uint32_t colData=0;
   int x1 = xPos, y1 = yPos, x2 = xPos+img->width-1, y2 = yPos+img->height-1;
   if (!jsvStringIteratorHasChar(it)) return; // no data
+#ifdef GRAPHICS_FAST_PATHS
+  if (!parseFullImage && !(gfx->data.flags&JSGRAPHICSFLAGS_MAPPEDXY)) {
+    _jswrap_drawImageFast(gfx, xPos, yPos, 1, img, it);
+    return;
+  }
+#endif
 #ifndef SAVE_ON_FLASH
   if (!(gfx->data.flags&JSGRAPHICSFLAGS_SWAP_XY)) {
     /* if we've not swapped X/Y we can so some optimisations
@@ -555,6 +692,16 @@ bool jswrap_graphics_idle() {
   return false;
 }
 
+/*JSON{
+  "type" : "kill",
+  "generate" : "jswrap_graphics_kill"
+}*/
+void jswrap_graphics_kill() {
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  glyphCacheFree(); // don't save the glyph cache
+#endif
+}
+
 /*JSON{
   "type" : "init",
   "generate" : "jswrap_graphics_init",
@@ -1942,6 +2089,10 @@ JsVar *jswrap_graphics_setFontCustom(JsVar *parent, JsVar *bitmap, int firstChar
   "return" : ["JsVar","The instance of Graphics this was called on, to allow call chaining"],
   "return_object" : "Graphics"
 }
+Set the current font to a PBF font file.
+
+If you change the font data after calling this, call `setFontPBF` again so that
+glyphs cached from the old data aren't used.
 */
 JsVar *jswrap_graphics_setFontPBF(JsVar *parent, JsVar *file, int scale) {
 #ifdef ESPR_PBF_FONTS
@@ -1952,6 +2103,27 @@ JsVar *jswrap_graphics_setFontPBF(JsVar *parent, JsVar *file, int scale) {
     return 0;
   }
   if (scale<1) scale = 1;
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  size_t len = 0;
+  char *ptr = jsvGetDataPointer(file, &len);
+  if (ptr) {
+    // Glyphs cached for a font previously at this address may be stale now
+    glyphCacheRemoveFont((uint32_t)(size_t)ptr);
+    /* The font data may be moved (eg. by memory compaction) to where another font's
+    glyphs were cached, so also key glyphs on a hash of the header, hash table and
+    offset table. This is only done here as it's slow for big fonts */
+    PbfFontLoaderInfo pbfInfo;
+    jspbfFontNew(&pbfInfo, file);
+    size_t hdrLen = pbfInfo.glyphTableOffset;
+    jspbfFontFree(&pbfInfo);
+    if (hdrLen > len) hdrLen = len;
+    uint32_t hash = 2166136261u ^ (uint32_t)len; // FNV-1a
+    for (size_t i=0;i<hdrLen;i++)
+      hash = (hash ^ (uint8_t)ptr[i]) * 16777619u;
+    jsvObjectSetChildAndUnLock(parent, JSGRAPHICS_CUSTOMFONT_CHECK, jsvNewFromInteger((JsVarInt)hash));
+  } else
+    jsvObjectRemoveChild(parent, JSGRAPHICS_CUSTOMFONT_CHECK);
+#endif
   jsvObjectSetChild(parent, JSGRAPHICS_CUSTOMFONT_BMP, file);
   gfx.data.fontSize = (unsigned short)(scale | JSGRAPHICS_FONTSIZE_CUSTOM_PBF);
   graphicsSetVar(&gfx);
@@ -2244,8 +2416,64 @@ typedef struct {
 #ifdef ESPR_PBF_FONTS
   PbfFontLoaderInfo pbfInfo;
 #endif
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  JsVar *glyphCache; // If set, the glyph cache to use for this font
+  GlyphCacheKey glyphKey; // Key for glyphs in this font (codepoint is set for each character)
+#endif
 } JsGraphicsFontInfo;
 
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+/// Set up info->glyphCache/glyphKey if the font is one we can cache glyphs for
+static void _jswrap_graphics_getFontGlyphCache(JsGraphics *gfx, JsGraphicsFontInfo *info) {
+  NOT_USED(gfx);
+  info->glyphCache = 0;
+  memset(&info->glyphKey, 0, sizeof(GlyphCacheKey));
+  info->glyphKey.scalex = info->scalex;
+  info->glyphKey.scaley = info->scaley;
+  if (info->font == JSGRAPHICS_FONTSIZE_VECTOR) {
+#ifdef NO_VECTOR_FONT
+    return;
+#endif
+#ifdef ESPR_PBF_FONTS
+  } else if ((info->font & JSGRAPHICS_FONTSIZE_FONT_MASK)==JSGRAPHICS_FONTSIZE_CUSTOM_PBF) {
+    /* PBF fonts are identified by where their data is. If the font isn't in one
+    block of memory (or flash) we can't tell if it's the same font next time, so don't cache */
+    size_t len = 0;
+    char *ptr = jsvGetDataPointer(info->bitmap, &len);
+    if (!ptr) return;
+    info->glyphKey.fontId = (uint32_t)(size_t)ptr;
+    // worked out by setFontPBF
+    info->glyphKey.fontCheck = (uint32_t)jsvGetIntegerAndUnLock(jsvObjectGetChildIfExists(gfx->graphicsVar, JSGRAPHICS_CUSTOMFONT_CHECK));
+#endif
+  } else return; // bitmap fonts are already quick
+  info->glyphCache = glyphCacheGet();
+}
+
+/** Get the cached glyph for a character (adding it if needed), or 0 if it can't be cached.
+ * If needBitmap the glyph's bitmap is rendered too, not just the metrics */
+static GlyphCacheEntry *_jswrap_graphics_getCachedGlyph(JsGraphicsFontInfo *info, int ch, bool needBitmap) {
+  if (!info->glyphCache) return 0;
+  info->glyphKey.codepoint = (uint32_t)ch;
+  GlyphCacheEntry *glyph = glyphCacheFind(info->glyphCache, &info->glyphKey, needBitmap);
+  if (glyph) return glyph;
+#ifndef NO_VECTOR_FONT
+  if (info->font == JSGRAPHICS_FONTSIZE_VECTOR) {
+    if (ch>=256) return 0;
+    if (needBitmap)
+      return glyphCacheAddVectorChar(info->glyphCache, &info->glyphKey, info->scalex, info->scaley, (char)ch);
+    glyph = glyphCacheAdd(info->glyphCache, &info->glyphKey, 0);
+    if (glyph) glyph->advance = (int16_t)graphicsVectorCharWidth(info->scalex, (char)ch);
+    return glyph;
+  }
+#endif
+#ifdef ESPR_PBF_FONTS
+  if ((info->font & JSGRAPHICS_FONTSIZE_FONT_MASK)==JSGRAPHICS_FONTSIZE_CUSTOM_PBF)
+    return glyphCacheAddPBFChar(info->glyphCache, &info->glyphKey, &info->pbfInfo, ch, needBitmap);
+#endif
+  return 0;
+}
+#endif
+
 static void _jswrap_graphics_getFontInfo(JsGraphics *gfx, JsGraphicsFontInfo *info) {
   info->font = gfx->data.fontSize & JSGRAPHICS_FONTSIZE_FONT_MASK;
   info->scale = gfx->data.fontSize & JSGRAPHICS_FONTSIZE_SCALE_MASK;
@@ -2267,10 +2495,15 @@ static void _jswrap_graphics_getFontInfo(JsGraphics *gfx, JsGraphicsFontInfo *in
   } else
 #endif
     info->customFirstChar = 0;
-
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  _jswrap_graphics_getFontGlyphCache(gfx, info);
+#endif
 }
 
 static void _jswrap_graphics_freeFontInfo(JsGraphicsFontInfo *info) {
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  jsvUnLock(info->glyphCache);
+#endif
 #ifndef SAVE_ON_FLASH
   if (info->font & JSGRAPHICS_FONTSIZE_CUSTOM_BIT) {
     jsvUnLock2(info->widths, info->bitmap);
@@ -2283,6 +2516,10 @@ static void _jswrap_graphics_freeFontInfo(JsGraphicsFontInfo *info) {
 }
 
 static int _jswrap_graphics_getCharWidth(JsGraphicsFontInfo *info, int ch) {
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+  GlyphCacheEntry *glyph = _jswrap_graphics_getCachedGlyph(info, ch, false);
+  if (glyph) return glyph->advance;
+#endif
   if ((info->font == JSGRAPHICS_FONTSIZE_VECTOR) && (ch<256)) {
 #ifndef NO_VECTOR_FONT
     return (int)graphicsVectorCharWidth(info->scalex, (char)ch);
@@ -2990,11 +3227,21 @@ JsVar *jswrap_graphics_drawString(JsVar *parent, JsVar *var, int x, int y, bool
 #endif
     if ((info.font == JSGRAPHICS_FONTSIZE_VECTOR) && (ch<256)) {
 #ifndef NO_VECTOR_FONT
-      int w = (int)graphicsVectorCharWidth(info.scalex, (char)ch);
+      int w = _jswrap_graphics_getCharWidth(&info, ch);
       // TODO: potentially we could do this in x16 accuracy so vector chars rendered together better
       if (x>minX-w && x<maxX  && y>minY-fontHeight && y<=maxY) {
         if (solidBackground)
           graphicsFillRect(&gfx,x,y,x+w-1,y+fontHeight-1, gfx.data.bgColor);
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+        /* Cached glyphs are rendered in user coordinates, but if we're rotated graphicsFillPoly
+        rounds in device coordinates, so only use the cache if there's no rotation */
+        GlyphCacheEntry *glyph = 0;
+        if (!(gfx.data.flags & JSGRAPHICSFLAGS_MAPPEDXY))
+          glyph = _jswrap_graphics_getCachedGlyph(&info, ch, true);
+        if (glyph)
+          glyphCacheDraw(&gfx, glyph, x, y, 1, 1, false);
+        else
+#endif
         graphicsGetVectorChar((graphicsPolyCallback)graphicsFillPoly, &gfx, x, y, info.scalex, info.scaley, (char)ch);
       }
       x+=w;
@@ -3012,6 +3259,14 @@ JsVar *jswrap_graphics_drawString(JsVar *parent, JsVar *var, int x, int y, bool
 #ifndef SAVE_ON_FLASH
 #ifdef ESPR_PBF_FONTS
     } else if ((info.font & JSGRAPHICS_FONTSIZE_FONT_MASK)==JSGRAPHICS_FONTSIZE_CUSTOM_PBF) {
+#ifdef GRAPHICS_GLYPH_CACHE_SIZE
+      GlyphCacheEntry *cachedGlyph = _jswrap_graphics_getCachedGlyph(&info, ch, true);
+      if (cachedGlyph) {
+        glyphCacheDraw(&gfx, cachedGlyph, x, y, info.scalex, info.scaley, solidBackground);
+        x += cachedGlyph->advance;
+        continue;
+      }
+#endif
       PbfFontLoaderGlyph glyph;
       if (jspbfFontFindGlyph(&info.pbfInfo, ch, &glyph)) {
         jspbfFontRenderGlyph(&info.pbfInfo, &glyph, &gfx,
@@ -3763,9 +4018,9 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
     if (fastPath) { // fast path for non-rotated, integer scale
       int s = (int)scale;
       // Scaled blitting
-      /* Output as scanlines rather than small fillrects so
-       * that on direct-coupled displays we can optimise away
-       * coordinate setting
+      /* Each image row is decoded once and output as s-high
+       * fillRects of runs of the same colour, so we don't have to
+       * re-read the image data for every scaled line
        */
 #ifdef USE_LCD_ST7789_8BIT // can we blit directly to the display?
       if (isST7789 &&
@@ -3786,48 +4041,7 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
     } else
 #endif
       {
-        // jsiConsolePrintf("fallback2\n");
-        int bits=0;
-        int yp = yPos;
-        for (y=0;y<img.height;y++) {
-          // Store current pos as we need to rewind
-          size_t lastIt = jsvStringIteratorGetIndex(&it);
-          int lastBits = bits;
-          unsigned int lastColData = colData;
-          // do a new iteration for each line we're scaling
-          for (int iy=0;iy<s;iy++) {
-            if (iy) { // rewind for all but the first line of scaling
-              jsvStringIteratorGoto(&it, img.buffer, lastIt);
-              bits = lastBits;
-              colData = lastColData;
-            }
-            // iterate over x
-            int xp = xPos;
-            for (x=0;x<img.width;x++) {
-              // Get the data we need...
-              while (bits < img.bpp) {
-                colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetCharAndNext(&it));
-                bits += 8;
-              }
-              // extract just the bits we want
-              unsigned int col = (colData>>(bits-img.bpp))&img.bitMask;
-              bits -= img.bpp;
-              // Try and write pixel!
-              if (img.transparentCol!=col && yp>=gfx.data.clipRect.y1 && yp<=gfx.data.clipRect.y2) {
-                if (img.palettePtr) col = img.palettePtr[col&img.paletteMask];
-                for (int ix=0;ix<s;ix++) {
-                  if (xp>=gfx.data.clipRect.x1 && xp<=gfx.data.clipRect.x2)
-                    gfx.setPixel(&gfx, xp, yp, col);
-                  xp++;
-                }
-              } else xp += s;
-            }
-            yp++;
-          }
-        }
-        // update modified area since we went direct
-        int x1=xPos, y1=yPos, x2=xPos+s*img.width, y2=yPos+s*img.height;
-        graphicsSetModifiedAndClip(&gfx,&x1,&y1,&x2,&y2,false);
+        _jswrap_drawImageFast(&gfx, xPos, yPos, s, &img, &it);
       }
     } else { // handle rotation, and default to center the image
 #else
@@ -4298,10 +4512,7 @@ JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset) {
     }
   }
   if (reset) {
-    gfx.data.modMaxX = -32768;
-    gfx.data.modMaxY = -32768;
-    gfx.data.modMinX = 32767;
-    gfx.data.modMinY = 32767;
+    graphicsClearModified(&gfx);
     graphicsSetVar(&gfx);
   }
   return obj;
@@ -4310,6 +4521,55 @@ JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset) {
 #endif
 }
 
+/*JSON{
+  "type" : "method",
+  "class" : "Graphics",
+  "name" : "getModifiedRects",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_graphics_getModifiedRects",
+  "params" : [
+    ["reset","bool","Whether to reset the modified area or not"]
+  ],
+  "return" : ["JsVar","An array of objects `{x1,y1,x2,y2}`, one for each separate area that has been modified"],
+  "typescript" : "getModifiedRects(reset?: boolean): { x1: number, y1: number, x2: number, y2: number }[];"
+}
+Like `g.getModified()`, but rather than returning one area that covers
+everything that has been modified, this returns a list of the separate areas
+(up to 4). Areas are merged if covering both with one rectangle would add only a
+few unmodified pixels.
+
+This is what `g.flip()` uses on built-in displays to only send the parts of the
+screen that have changed.
+
+For instance after `g.setPixel(10,20).setPixel(100,150)` this would return
+`[{x1:10,y1:20,x2:10,y2:20},{x1:100,y1:150,x2:100,y2:150}]`
+*/
+JsVar *jswrap_graphics_getModifiedRects(JsVar *parent, bool reset) {
+#ifndef NO_MODIFIED_AREA
+  JsGraphics gfx; if (!graphicsGetFromVar(&gfx, parent)) return 0;
+  JsVar *arr = jsvNewEmptyArray();
+  if (!arr) return 0;
+  JsGraphicsRect rects[GRAPHICS_MODIFIED_RECTS];
+  int n = graphicsGetModifiedRects(&gfx, rects, -1);
+  for (int i=0;i<n;i++) {
+    JsVar *obj = jsvNewObject();
+    if (!obj) break;
+    jsvObjectSetIntChild(obj, "x1", rects[i].x1);
+    jsvObjectSetIntChild(obj, "y1", rects[i].y1);
+    jsvObjectSetIntChild(obj, "x2", rects[i].x2);
+    jsvObjectSetIntChild(obj, "y2", rects[i].y2);
+    jsvArrayPushAndUnLock(arr, obj);
+  }
+  if (reset) {
+    graphicsClearModified(&gfx);
+    graphicsSetVar(&gfx);
+  }
+  return arr;
+#else
+  return 0;
+#endif
+}
+
 /*JSON{
   "type" : "method",
   "class" : "Graphics",
@@ -24,6 +24,7 @@ extern const uint16_t PALETTE_8BIT[256];
 #endif
 
 bool jswrap_graphics_idle();
+void jswrap_graphics_kill();
 void jswrap_graphics_init();
 
 JsVar *jswrap_graphics_getInstance();
@@ -84,6 +85,7 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
 JsVar *jswrap_graphics_drawImages(JsVar *parent, JsVar *layersVar, JsVar *options);
 JsVar *jswrap_graphics_asImage(JsVar *parent, JsVar *options);
 JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset);
+JsVar *jswrap_graphics_getModifiedRects(JsVar *parent, bool reset);
 JsVar *jswrap_graphics_scroll(JsVar *parent, int x, int y);
 JsVar *jswrap_graphics_blit(JsVar *parent, JsVar *options);
 JsVar *jswrap_graphics_asBMP(JsVar *parent);
@@ -157,3 +159,7 @@ void _jswrap_drawImageLayerNextY(GfxDrawImageLayer *l);
 // Called by _jswrap_drawImageSimple to blit out a row
 void _jswrap_drawImageSimpleRow(JsGraphics *gfx, int xPos, int y, GfxDrawImageInfo *img, JsvStringIterator *it, JsGraphicsSetPixelFn setPixel, int *_bits, uint32_t *_colData);
 void _jswrap_drawImageSimple(JsGraphics *gfx, int xPos, int yPos, GfxDrawImageInfo *img, JsvStringIterator *it, bool parseFullImage);
+#ifdef GRAPHICS_FAST_PATHS
+// Draw an image at integer scale 's' as spans, when the Graphics has no rotation/mirroring
+void _jswrap_drawImageFast(JsGraphics *gfx, int xPos, int yPos, int s, GfxDrawImageInfo *img, JsvStringIterator *it);
+#endif
@@ -262,6 +262,215 @@ void lcdScroll_ArrayBuffer_flat(JsGraphics *gfx, int xdir, int ydir, int x1, int
 }
 
 #ifdef GRAPHICS_FAST_PATHS
+/* Word-at-a-time kernels for flat, linear buffers of 1,2,4,8 or 16 bpp. These
+work on runs of bits (MSB or LSB first), so they cope with rows that start
+part way through a byte and only need masking for the first and last byte. */
+typedef uintptr_t LcdWord; // 32 bits on microcontrollers, 64 on Linux
+#define LCDWORD_BYTES ((int)sizeof(LcdWord))
+
+// Load a word, with the byte at the lowest address in the most significant (msb) or least significant bits
+static ALWAYS_INLINE LcdWord lcdLoadWord(const uint8_t *p, bool msb) {
+  LcdWord w;
+  memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (msb) {
+#else
+  if (!msb) {
+#endif
+#if UINTPTR_MAX > 0xFFFFFFFF
+    w = __builtin_bswap64(w);
+#else
+    w = __builtin_bswap32(w);
+#endif
+  }
+  return w;
+}
+static ALWAYS_INLINE void lcdStoreWord(uint8_t *p, LcdWord w, bool msb) {
+  w = lcdLoadWord((uint8_t*)&w, msb); // swapping is its own inverse
+  memcpy(p, &w, sizeof(w));
+}
+
+// Mask for bits 'bit'...'bit+n-1' of a byte (bit 0 is the first pixel)
+static ALWAYS_INLINE uint8_t lcdBitMask(unsigned int bit, unsigned int n, bool msb) {
+  unsigned int m = (0xFFu >> (8-n)); // n bits
+  return (uint8_t)(msb ? (m << (8-bit-n)) : (m << bit));
+}
+
+/// Fill 'bits' bits starting at bit 'bitIdx' of buf. pattern is the byte to use at even and odd offsets from buf
+static void lcdFillBits(uint8_t *buf, size_t bitIdx, size_t bits, const uint8_t pattern[2], bool msb) {
+  uint8_t *p = &buf[bitIdx>>3];
+  unsigned int bit = bitIdx&7;
+  if (bit) { // start part way through a byte
+    unsigned int n = 8-bit;
+    if (n > bits) n = (unsigned int)bits;
+    uint8_t mask = lcdBitMask(bit, n, msb);
+    *p = (uint8_t)((*p & ~mask) | (pattern[0] & mask));
+    p++;
+    bits -= n;
+  }
+  if (pattern[0]==pattern[1]) { // all bytes the same - memset is as fast as it gets
+    size_t n = bits>>3;
+    memset(p, pattern[0], n);
+    p += n;
+    bits &= 7;
+  }
+  // bytes until we're aligned
+  while (bits>=8 && ((uintptr_t)p & (LCDWORD_BYTES-1))) {
+    *p = pattern[(p-buf)&1];
+    p++;
+    bits -= 8;
+  }
+  // whole words
+  if (bits >= 8*LCDWORD_BYTES) {
+    LcdWord w;
+    uint8_t *wp = (uint8_t*)&w;
+    for (int i=0;i<LCDWORD_BYTES;i++)
+      wp[i] = pattern[((p-buf)+i)&1];
+    while (bits >= 8*LCDWORD_BYTES) {
+      memcpy(p, &w, sizeof(w));
+      p += LCDWORD_BYTES;
+      bits -= 8*LCDWORD_BYTES;
+    }
+  }
+  // remaining bytes
+  while (bits>=8) {
+    *p = pattern[(p-buf)&1];
+    p++;
+    bits -= 8;
+  }
+  if (bits) { // end part way through a byte
+    uint8_t mask = lcdBitMask(0, (unsigned int)bits, msb);
+    *p = (uint8_t)((*p & ~mask) | (pattern[0] & mask));
+  }
+}
+
+/// Get the 8 bits starting at bit 'pos' (which may be part way into a byte). Bytes outside s1..s2 are read as 0
+static ALWAYS_INLINE uint8_t lcdReadBits8(const uint8_t *buf, ptrdiff_t pos, ptrdiff_t s1, ptrdiff_t s2, bool msb) {
+  ptrdiff_t b = (pos>=0) ? (pos>>3) : -1;
+  unsigned int o = (unsigned int)pos & 7;
+  unsigned int lo = (b>=s1 && b<=s2) ? buf[b] : 0;
+  if (!o) return (uint8_t)lo;
+  unsigned int hi = (b+1>=s1 && b+1<=s2) ? buf[b+1] : 0;
+  return (uint8_t)(msb ? ((lo << o) | (hi >> (8-o))) : ((lo >> o) | (hi << (8-o))));
+}
+
+/// Write dst byte d from the source bits that line up with it
+static ALWAYS_INLINE void lcdCopyBitsByte(uint8_t *buf, ptrdiff_t d, size_t dstIdx, size_t bits, ptrdiff_t delta, ptrdiff_t s1, ptrdiff_t s2, bool msb) {
+  size_t from = (size_t)d*8, to = from+8; // bits in this byte...
+  if (from < dstIdx) from = dstIdx; // ...that are in the run
+  if (to > dstIdx+bits) to = dstIdx+bits;
+  uint8_t mask = lcdBitMask((unsigned int)(from&7), (unsigned int)(to-from), msb);
+  uint8_t v = lcdReadBits8(buf, d*8+delta, s1, s2, msb);
+  buf[d] = (uint8_t)((buf[d] & ~mask) | (v & mask));
+}
+
+/// Copy 'bits' bits from bit 'srcIdx' to bit 'dstIdx' of buf. Like memmove, this copes with overlapping areas
+static void lcdCopyBits(uint8_t *buf, size_t dstIdx, size_t srcIdx, size_t bits, bool msb) {
+  if (!bits || dstIdx==srcIdx) return;
+  ptrdiff_t delta = (ptrdiff_t)srcIdx - (ptrdiff_t)dstIdx; // bit offset from dst to src
+  ptrdiff_t d1 = (ptrdiff_t)(dstIdx>>3), d2 = (ptrdiff_t)((dstIdx+bits-1)>>3); // first/last dst byte
+  ptrdiff_t s1 = (ptrdiff_t)(srcIdx>>3), s2 = (ptrdiff_t)((srcIdx+bits-1)>>3); // first/last src byte
+  if (!(delta&7)) { // same alignment - partial bytes at each end, memmove in the middle
+    ptrdiff_t m1 = (dstIdx&7) ? d1+1 : d1; // whole bytes in the middle
+    ptrdiff_t m2 = ((dstIdx+bits)&7) ? d2-1 : d2;
+    if (m1>m2) { // no whole bytes
+      if (delta>0) for (ptrdiff_t d=d1;d<=d2;d++) lcdCopyBitsByte(buf, d, dstIdx, bits, delta, s1, s2, msb);
+      else for (ptrdiff_t d=d2;d>=d1;d--) lcdCopyBitsByte(buf, d, dstIdx, bits, delta, s1, s2, msb);
+      return;
+    }
+    // when copying backwards do the end first so we don't overwrite source data before we use it
+    if (delta<0 && m2<d2) lcdCopyBitsByte(buf, d2, dstIdx, bits, delta, s1, s2, msb);
+    if (delta>0 && m1>d1) lcdCopyBitsByte(buf, d1, dstIdx, bits, delta, s1, s2, msb);
+    memmove(&buf[m1], &buf[m1+(delta>>3)], (size_t)(1+m2-m1));
+    if (delta<0 && m1>d1) lcdCopyBitsByte(buf, d1, dstIdx, bits, delta, s1, s2, msb);
+    if (delta>0 && m2<d2) lcdCopyBitsByte(buf, d2, dstIdx, bits, delta, s1, s2, msb);
+    return;
+  }
+  // Different alignment - we have to shift. Every dst byte's bits come from 2 source bytes
+  unsigned int o = (unsigned int)delta & 7;
+  if (delta>0) { // source is after dest - go forwards
+    ptrdiff_t d = d1;
+    lcdCopyBitsByte(buf, d++, dstIdx, bits, delta, s1, s2, msb);
+    while (d+LCDWORD_BYTES <= d2) { // whole words that aren't the last byte
+      ptrdiff_t sb = (d*8+delta)>>3;
+      if (sb+LCDWORD_BYTES > s2) break;
+      LcdWord w = lcdLoadWord(&buf[sb], msb);
+      LcdWord next = buf[sb+LCDWORD_BYTES];
+      if (msb) w = (w << o) | (next >> (8-o));
+      else w = (w >> o) | (next << (8*LCDWORD_BYTES-o));
+      lcdStoreWord(&buf[d], w, msb);
+      d += LCDWORD_BYTES;
+    }
+    for (;d<=d2;d++) lcdCopyBitsByte(buf, d, dstIdx, bits, delta, s1, s2, msb);
+  } else { // source is before dest - go backwards
+    ptrdiff_t d = d2;
+    lcdCopyBitsByte(buf, d, dstIdx, bits, delta, s1, s2, msb);
+    while (d-LCDWORD_BYTES > d1) { // whole words that aren't the first byte
+      ptrdiff_t ws = d-LCDWORD_BYTES;
+      ptrdiff_t sb = (ws*8+delta)>>3;
+      if (sb < s1) break;
+      LcdWord w = lcdLoadWord(&buf[sb], msb);
+      LcdWord next = buf[sb+LCDWORD_BYTES];
+      if (msb) w = (w << o) | (next >> (8-o));
+      else w = (w >> o) | (next << (8*LCDWORD_BYTES-o));
+      lcdStoreWord(&buf[ws], w, msb);
+      d = ws;
+    }
+    while (d>d1) lcdCopyBitsByte(buf, --d, dstIdx, bits, delta, s1, s2, msb);
+  }
+}
+
+/// Is bit/byte order MSB first for this buffer?
+static ALWAYS_INLINE bool lcdIsMSB_ArrayBuffer(JsGraphics *gfx) {
+  return (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB)!=0;
+}
+
+static void lcdFillRect_ArrayBuffer_flatWords(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
+  unsigned int bpp = gfx->data.bpp;
+  bool msb = lcdIsMSB_ArrayBuffer(gfx);
+  uint8_t pattern[2];
+  if (bpp==16) {
+    pattern[0] = (uint8_t)(msb ? (col>>8) : col);
+    pattern[1] = (uint8_t)(msb ? col : (col>>8));
+  } else { // repeat the pixel to fill a byte
+    unsigned int b = col & ((1U<<bpp)-1);
+    for (unsigned int i=bpp;i<8;i<<=1) b |= b<<i;
+    pattern[0] = pattern[1] = (uint8_t)b;
+  }
+  size_t width = gfx->data.width;
+  size_t bits = (size_t)(1+x2-x1)*bpp;
+  if (x1==0 && x2==(int)width-1) { // whole rows, so we can do it all in one go (eg. clear)
+    bits *= (size_t)(1+y2-y1);
+    y2 = y1;
+  }
+  for (int y=y1;y<=y2;y++)
+    lcdFillBits((uint8_t*)gfx->backendData, ((size_t)x1 + (size_t)y*width)*bpp, bits, pattern, msb);
+}
+
+static void lcdBlit_ArrayBuffer_flatWords(JsGraphics *gfx, int x1, int y1, int w, int h, int x2, int y2) {
+  if (w<=0 || h<=0) return;
+  unsigned int bpp = gfx->data.bpp;
+  bool msb = lcdIsMSB_ArrayBuffer(gfx);
+  uint8_t *buf = (uint8_t*)gfx->backendData;
+  size_t width = gfx->data.width;
+  size_t bits = (size_t)w*bpp;
+  if (x1==0 && x2==0 && w==(int)width) { // whole rows, so we can do it all in one go
+    bits *= (size_t)h;
+    h = 1;
+  }
+  // go in the right direction so we don't overwrite rows we haven't copied yet
+  int yStart = (y2>y1) ? h-1 : 0, yStep = (y2>y1) ? -1 : 1;
+  for (int y=yStart;y>=0 && y<h;y+=yStep)
+    lcdCopyBits(buf, ((size_t)x2 + (size_t)(y2+y)*width)*bpp, ((size_t)x1 + (size_t)(y1+y)*width)*bpp, bits, msb);
+}
+
+static void lcdScroll_ArrayBuffer_flatWords(JsGraphics *gfx, int xdir, int ydir, int x1, int y1, int x2, int y2) {
+  lcdBlit_ArrayBuffer_flatWords(gfx,
+    (xdir<0) ? x1-xdir : x1, (ydir<0) ? y1-ydir : y1,
+    (1+x2-x1) - abs(xdir), (1+y2-y1) - abs(ydir), // width/height
+    (xdir>0) ? x1+xdir : x1, (ydir>0) ? y1+ydir : y1);
+}
+
 // 1 bit
 void lcdSetPixel_ArrayBuffer_flat1(JsGraphics *gfx, int x, int y, unsigned int col) {
   int p = x + y*gfx->data.width;
@@ -274,41 +483,6 @@ unsigned int lcdGetPixel_ArrayBuffer_flat1(struct JsGraphics *gfx, int x, int y)
   uint8_t byte = ((uint8_t*)gfx->backendData)[p>>3];
   return (byte >> (7-(p&7))) & 1;
 }
-void lcdFillRect_ArrayBuffer_flat1(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
-  if (x2-x1 < 8) return lcdFillRect_ArrayBuffer_flat(gfx,x1,y1,x2,y2,col); // not worth trying to work around this
-  uint8_t *pixels = (uint8_t *)gfx->backendData;
-  // build up 8 pixels in 1 byte for fast writes
-  col &= 1;
-  uint8_t colByte = (uint8_t)col | (uint8_t)(col<<1);
-  colByte |= colByte<<2;
-  colByte |= colByte<<4;
-  // do each row separately
-  for (int y=y1;y<=y2;y++) {
-    int py = y*gfx->data.width;
-    int p = x1 + py; // pixel index (not bit)
-    int p2 = x2 + py; // pixel index (not bit)
-    uint8_t *byte = &pixels[p>>3];
-    // start off unaligned
-    if (p&7) {
-      int amt = (8-(p&7));
-      int mask = ~(0xFF << amt);
-      *byte = (*byte & ~mask) | (colByte & mask);
-      byte++;
-      p = (p&~7)+8;
-    }
-    // now we're aligned, just write bytes
-    while (p+7<=p2) {
-      *(byte++) = colByte;
-      p+=8;
-    }
-    // finish off unaligned
-    if (p<=p2) {
-      int amt = 1+p2-p;
-      int mask = ~(0xFF >> amt);
-      *byte = (*byte & ~mask) | (colByte & mask);
-    }
-  }
-}
 // 2 bit
 void lcdSetPixel_ArrayBuffer_flat2(JsGraphics *gfx, int x, int y, unsigned int col) {
   int p = (x + y*gfx->data.width); // pixel index (not bit)
@@ -322,40 +496,6 @@ unsigned int lcdGetPixel_ArrayBuffer_flat2(struct JsGraphics *gfx, int x, int y)
   uint8_t *byte = &((uint8_t*)gfx->backendData)[p>>2];
   return (*byte >> (6-b)) & 3;
 }
-void lcdFillRect_ArrayBuffer_flat2(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
-  if (x2-x1 < 4) return lcdFillRect_ArrayBuffer_flat(gfx,x1,y1,x2,y2,col); // not worth trying to work around this
-  uint8_t *pixels = (uint8_t *)gfx->backendData;
-  // build up 4 pixels in 1 byte for fast writes
-  col &= 3;
-  uint8_t colByte = (uint8_t)col | (uint8_t)(col<<2);
-  colByte |= colByte<<4;
-  // do each row separately
-  for (int y=y1;y<=y2;y++) {
-    int py = y*gfx->data.width;
-    int p = x1 + py; // pixel index (not bit)
-    int p2 = x2 + py; // pixel index (not bit)
-    uint8_t *byte = &pixels[p>>2];
-    // start off unaligned
-    if (p&3) {
-      int amt = (4-(p&3));
-      int mask = ~(0xFF << (amt<<1));
-      *byte = (*byte & ~mask) | (colByte & mask);
-      byte++;
-      p = (p&~3)+4;
-    }
-    // now we're aligned, just write bytes
-    while (p+3<=p2) {
-      *(byte++) = colByte;
-      p+=4;
-    }
-    // finish off unaligned
-    if (p<=p2) {
-      int amt = 1+p2-p;
-      int mask = ~(0xFF >> (amt<<1));
-      *byte = (*byte & ~mask) | (colByte & mask);
-    }
-  }
-}
 // 4 bit
 void lcdSetPixel_ArrayBuffer_flat4(JsGraphics *gfx, int x, int y, unsigned int col) {
   int p = (x + y*gfx->data.width); // pixel index (not bit)
@@ -369,35 +509,6 @@ unsigned int lcdGetPixel_ArrayBuffer_flat4(struct JsGraphics *gfx, int x, int y)
   uint8_t *byte = &((uint8_t*)gfx->backendData)[p>>1];
   return (*byte >> (4-b)) & 15;
 }
-void lcdFillRect_ArrayBuffer_flat4(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
-  if (x2-x1 < 2) return lcdFillRect_ArrayBuffer_flat(gfx,x1,y1,x2,y2,col); // not worth trying to work around this
-  uint8_t *pixels = (uint8_t *)gfx->backendData;
-  // build up 4 pixels in 1 byte for fast writes
-  col &= 15;
-  uint8_t colByte = (uint8_t)col | (uint8_t)(col<<4);
-  // do each row separately
-  for (int y=y1;y<=y2;y++) {
-    int py = y*gfx->data.width;
-    int p = x1 + py; // pixel index (not bit)
-    int p2 = x2 + py; // pixel index (not bit)
-    uint8_t *byte = &pixels[p>>1];
-    // start off unaligned
-    if (p&1) {
-      *byte = (*byte & 0xF0) | col;
-      byte++;
-      p++;
-    }
-    // now we're aligned, just write bytes
-    while (p+1<=p2) {
-      *(byte++) = colByte;
-      p+=2;
-    }
-    // finish off unaligned
-    if (p<=p2) {
-      *byte = (*byte & 0x0F) | (col<<4);
-    }
-  }
-}
 // 8 bit
 void lcdSetPixel_ArrayBuffer_flat8(JsGraphics *gfx, int x, int y, unsigned int col) {
   ((uint8_t*)gfx->backendData)[x + y*gfx->data.width] = (uint8_t)col;
@@ -406,27 +517,10 @@ unsigned int lcdGetPixel_ArrayBuffer_flat8(struct JsGraphics *gfx, int x, int y)
   return ((uint8_t*)gfx->backendData)[x + y*gfx->data.width];
 }
 void lcdFillRect_ArrayBuffer_flat8(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col) {
-  for (int y=y1;y<=y2;y++) {
-    uint8_t *p = &((uint8_t*)gfx->backendData)[x1 + y*gfx->data.width];
-    for (int x=x1;x<=x2;x++)
-      *(p++) = (uint8_t)col;
-  }
+  lcdFillRect_ArrayBuffer_flatWords(gfx, x1, y1, x2, y2, col);
 }
-
 void lcdScroll_ArrayBuffer_flat8(JsGraphics *gfx, int xdir, int ydir, int x1, int y1, int x2, int y2) {
-  int clipWidth = x2 - x1;
-  int clipHeight = y2 - y1;
-  int pixels = -(xdir + ydir*clipWidth);
-  int startPixel = gfx->data.width * (y1 - ydir) + x1;
-  int row;
-  for (row=0; row<(clipHeight+ydir); row++) {
-    if (pixels<0) {
-      memcpy(&((uint8_t*)gfx->backendData)[startPixel-pixels],&((uint8_t*)gfx->backendData)[startPixel],(size_t)(clipWidth+xdir));
-    } else {
-      memcpy(&((uint8_t*)gfx->backendData)[startPixel],&((uint8_t*)gfx->backendData)[startPixel+pixels],(size_t)(clipWidth-xdir));
-    }
-    startPixel += gfx->data.width;
-  }
+  lcdScroll_ArrayBuffer_flatWords(gfx, xdir, ydir, x1, y1, x2, y2);
 }
 #endif
 
@@ -455,34 +549,30 @@ void lcdSetCallbacks_ArrayBuffer(JsGraphics *gfx) {
   if (dataPtr && len>=graphicsGetMemoryRequired(gfx) && !(gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_ZIGZAG)) {
     gfx->backendData = dataPtr;
 #ifdef GRAPHICS_FAST_PATHS
-    if (gfx->data.bpp==1 &&
-        (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB) &&
-        !(gfx->data.flags & JSGRAPHICSFLAGS_NONLINEAR)
-        ) { // super fast path for 1 bit
-      gfx->setPixel = lcdSetPixel_ArrayBuffer_flat1;
-      gfx->getPixel = lcdGetPixel_ArrayBuffer_flat1;
-      gfx->fillRect = lcdFillRect_ArrayBuffer_flat1;
-    } else if (gfx->data.bpp==2 &&
-        (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB) &&
-        !(gfx->data.flags & JSGRAPHICSFLAGS_NONLINEAR)
-        ) { // super fast path for 1 bit
-      gfx->setPixel = lcdSetPixel_ArrayBuffer_flat2;
-      gfx->getPixel = lcdGetPixel_ArrayBuffer_flat2;
-      gfx->fillRect = lcdFillRect_ArrayBuffer_flat2;
-    } else if (gfx->data.bpp==4 &&
-        (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB) &&
-        !(gfx->data.flags & JSGRAPHICSFLAGS_NONLINEAR)
-        ) { // super fast path for 1 bit
-      gfx->setPixel = lcdSetPixel_ArrayBuffer_flat4;
-      gfx->getPixel = lcdGetPixel_ArrayBuffer_flat4;
-      gfx->fillRect = lcdFillRect_ArrayBuffer_flat4;
-    } else if (gfx->data.bpp==8 &&
-               !(gfx->data.flags & JSGRAPHICSFLAGS_NONLINEAR)
-        ) { // super fast path for 8 bits
-      gfx->setPixel = lcdSetPixel_ArrayBuffer_flat8;
-      gfx->getPixel = lcdGetPixel_ArrayBuffer_flat8;
-      gfx->fillRect = lcdFillRect_ArrayBuffer_flat8;
-      gfx->scroll = lcdScroll_ArrayBuffer_flat8;
+    if (!(gfx->data.flags & JSGRAPHICSFLAGS_NONLINEAR) &&
+        (gfx->data.bpp==1 || gfx->data.bpp==2 || gfx->data.bpp==4 || gfx->data.bpp==8 || gfx->data.bpp==16)) {
+      // word-at-a-time fills/copies
+      gfx->setPixel = lcdSetPixel_ArrayBuffer_flat;
+      gfx->getPixel = lcdGetPixel_ArrayBuffer_flat;
+      gfx->fillRect = lcdFillRect_ArrayBuffer_flatWords;
+      gfx->blit = lcdBlit_ArrayBuffer_flatWords;
+      gfx->scroll = lcdScroll_ArrayBuffer_flatWords;
+      // super fast setPixel for common formats
+      if (gfx->data.bpp==8) {
+        gfx->setPixel = lcdSetPixel_ArrayBuffer_flat8;
+        gfx->getPixel = lcdGetPixel_ArrayBuffer_flat8;
+      } else if (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB) {
+        if (gfx->data.bpp==1) {
+          gfx->setPixel = lcdSetPixel_ArrayBuffer_flat1;
+          gfx->getPixel = lcdGetPixel_ArrayBuffer_flat1;
+        } else if (gfx->data.bpp==2) {
+          gfx->setPixel = lcdSetPixel_ArrayBuffer_flat2;
+          gfx->getPixel = lcdGetPixel_ArrayBuffer_flat2;
+        } else if (gfx->data.bpp==4) {
+          gfx->setPixel = lcdSetPixel_ArrayBuffer_flat4;
+          gfx->getPixel = lcdGetPixel_ArrayBuffer_flat4;
+        }
+      }
     } else
 #endif
     {
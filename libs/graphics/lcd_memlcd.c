@@ -374,21 +374,23 @@ static void _lcdMemLCD_setPixel_mirrored(JsGraphics *gfx, int x, int y, unsigned
 }
 // send the data to the screen
 void lcdMemLCD_flip(JsGraphics *gfx) {
-  if (gfx->data.modMinY > gfx->data.modMaxY) return; // nothing to do!
+  /* We always send whole rows, but we only send the rows that have been
+   * modified. Each separate block of rows is a separate transfer, so
+   * blocks that are only a few rows apart get merged */
+  JsGraphicsRect rows[GRAPHICS_MODIFIED_RECTS];
+#ifdef LCD_CONTROLLER_ZJ012BD01A
+  int rowCount = graphicsGetModifiedRects(gfx, rows, 16); // we pad to 16 rows anyway
+#else
+  int rowCount = graphicsGetModifiedRects(gfx, rows, 2);
+#endif
+  if (!rowCount) return; // nothing to do!
 #ifdef EMULATED
   EMSCRIPTEN_GFX_CHANGED = true;
 #endif
   lcdMemLCD_waitForSendComplete();
 
-  int y1 = gfx->data.modMinY;
-  int y2 = gfx->data.modMaxY;
-#ifdef LCD_CONTROLLER_ZJ012BD01A
-  // on this we can only start on even lines, and only send 8 at a time
-  y1 = y1 & ~1;
-  y2 = (y2+1) & ~1;
-  y2 = y1 + ((15+y2-y1)&~15) - 1; // pad out to 16px (see LCD_ROWS_BUFFERED in controller)
-#endif
-  int l = 1+y2-y1;
+  int y1 = rows[0].y1;
+  int y2 = rows[rowCount-1].y2;
 
   bool hasOverlay = false;
   GfxDrawImageInfo overlayImg;
@@ -412,6 +414,12 @@ void lcdMemLCD_flip(JsGraphics *gfx) {
   jshDelayMicroseconds(10); // give it time to wake
 #endif
   if (hasOverlay) {
+#ifdef LCD_CONTROLLER_ZJ012BD01A
+    // on this we can only start on even lines, and only send 8 at a time
+    y1 = y1 & ~1;
+    y2 = (y2+1) & ~1;
+    y2 = y1 + ((15+y2-y1)&~15) - 1; // pad out to 16px (see LCD_ROWS_BUFFERED in controller)
+#endif
     /* If lcdOverlayImage is defined, we want to overlay this image
      * on top of what we have in our LCD buffer. Do this line by
      * line. It's slower but it won't use a bunch of memory.
@@ -468,21 +476,41 @@ void lcdMemLCD_flip(JsGraphics *gfx) {
 #ifdef EMULATED
     memcpy(fakeLCDBuffer, lcdBuffer, LCD_HEIGHT*LCD_STRIDE);
 #else
-    lcdIsBusy = true;
     int trailingBytes = 0;
 #if defined(LCD_CONTROLLER_LPM013M126)
     trailingBytes = 2;
 #endif
-    if (!jshSPISendMany(LCD_SPI, &lcdBuffer[LCD_STRIDE*y1], NULL, (l*LCD_STRIDE)+trailingBytes, lcdMemLCD_flip_spi_callback))
-      lcdMemLCD_flip_spi_callback();
-    // lcdMemLCD_flip_spi_callback will call jshPinSetValue(LCD_SPI_CS, LCD_CS_OFF); when done and set lcdIsBusy=false
+    for (int r=0;r<rowCount;r++) {
+      y1 = rows[r].y1;
+      y2 = rows[r].y2;
+#ifdef LCD_CONTROLLER_ZJ012BD01A
+      // on this we can only start on even lines, and only send 8 at a time
+      y1 = y1 & ~1;
+      y2 = (y2+1) & ~1;
+      y2 = y1 + ((15+y2-y1)&~15) - 1; // pad out to 16px (see LCD_ROWS_BUFFERED in controller)
+#endif
+      int l = 1+y2-y1;
+      if (r>0) { // start a new transfer
+        jshPinSetValue(LCD_SPI_CS, LCD_CS_ON);
+#ifdef LCD_CONTROLLER_ZJ012BD01A
+        jshDelayMicroseconds(10); // give it time to wake
+#endif
+      }
+      if (r<rowCount-1) { // send and wait so we can start the next block
+        jshSPISendMany(LCD_SPI, &lcdBuffer[LCD_STRIDE*y1], NULL, (l*LCD_STRIDE)+trailingBytes, NULL);
+        jshSPIWait(LCD_SPI);
+        jshPinSetValue(LCD_SPI_CS, LCD_CS_OFF);
+      } else { // last block - let it finish in the background
+        lcdIsBusy = true;
+        if (!jshSPISendMany(LCD_SPI, &lcdBuffer[LCD_STRIDE*y1], NULL, (l*LCD_STRIDE)+trailingBytes, lcdMemLCD_flip_spi_callback))
+          lcdMemLCD_flip_spi_callback();
+        // lcdMemLCD_flip_spi_callback will call jshPinSetValue(LCD_SPI_CS, LCD_CS_OFF); when done and set lcdIsBusy=false
+      }
+    }
 #endif
   }
   // Reset modified-ness
-  gfx->data.modMaxX = -32768;
-  gfx->data.modMaxY = -32768;
-  gfx->data.modMinX = 32767;
-  gfx->data.modMinY = 32767;
+  graphicsClearModified(gfx);
 }
 
 void lcdMemLCD_init(JsGraphics *gfx) {
@@ -579,10 +607,7 @@ void lcdMemLCD_setOverlayModified(JsGraphics *gfx) {
        _jswrap_graphics_freeImageInfo(&overlayImg);
     }
   } else { // no overlay - redraw everything
-    graphicsInternal.data.modMinX = 0;
-    graphicsInternal.data.modMinY = 0;
-    graphicsInternal.data.modMaxX = LCD_WIDTH-1;
-    graphicsInternal.data.modMaxY = LCD_HEIGHT-1;
+    graphicsSetModified(&graphicsInternal, 0, 0, LCD_WIDTH-1, LCD_HEIGHT-1);
   }
 }
 
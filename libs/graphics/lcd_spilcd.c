@@ -181,8 +181,45 @@ void lcdFlip_SPILCD_callback() {
   // just an empty stub for SPIsend - we'll just push data as fast as we can
 }
 
+// Set the LCD window to x1,y1..x2,y2 (inclusive) and get ready to send pixel data into it
+static void lcdFlipSetWindow_SPILCD(int x1, int y1, int x2, int y2) {
+  unsigned char buffer[4];
+  jshPinSetValue(LCD_SPI_DC, 0); // command
+  buffer[0] = SPILCD_CMD_WINDOW_X;
+  jshSPISendMany(LCD_SPI, buffer, NULL, 1, NULL);
+  jshPinSetValue(LCD_SPI_DC, 1); // data
+  buffer[0] = 0;
+  buffer[1] = x1;
+  buffer[2] = 0;
+  buffer[3] = x2;
+  jshSPISendMany(LCD_SPI, buffer, NULL, 4, NULL);
+  jshPinSetValue(LCD_SPI_DC, 0); // command
+  buffer[0] = SPILCD_CMD_WINDOW_Y;
+  jshSPISendMany(LCD_SPI, buffer, NULL, 1, NULL);
+  jshPinSetValue(LCD_SPI_DC, 1); // data
+  buffer[0] = 0;
+  buffer[1] = y1;
+  buffer[2] = 0;
+  buffer[3] = y2;
+  jshSPISendMany(LCD_SPI, buffer, NULL, 4, NULL);
+  jshPinSetValue(LCD_SPI_DC, 0); // command
+  buffer[0] = SPILCD_CMD_DATA;
+  jshSPISendMany(LCD_SPI, buffer, NULL, 1, NULL);
+  jshPinSetValue(LCD_SPI_DC, 1); // data
+}
+
 void lcdFlip_SPILCD(JsGraphics *gfx) {
-  if (gfx->data.modMinX > gfx->data.modMaxX) return; // nothing to do!
+  JsGraphicsRect rects[GRAPHICS_MODIFIED_RECTS];
+#if LCD_BPP==12 || LCD_BPP==16
+  // Just send full rows as this allows us to issue a single SPI
+  // transfer for each area. Setting a new window costs about the same
+  // as sending a couple of rows, so areas closer than that are merged.
+  // TODO: could swap to a transfer per row if we're filling less than half a row
+  int rectCount = graphicsGetModifiedRects(gfx, rects, 2);
+#else
+  int rectCount = graphicsGetModifiedRects(gfx, rects, -1);
+#endif
+  if (!rectCount) return; // nothing to do!
 
   unsigned char buffer1[LCD_STRIDE];
 
@@ -199,22 +236,14 @@ void lcdFlip_SPILCD(JsGraphics *gfx) {
      * We use this rarely so don't mess around, we're just going to send the
      * whole buffer rather than part of it.
      */
-    gfx->data.modMinX = 0;
-    gfx->data.modMaxX = LCD_WIDTH-1;
+    for (int r=1;r<rectCount;r++) {
+      if (rects[r].y1 < rects[0].y1) rects[0].y1 = rects[r].y1;
+      if (rects[r].y2 > rects[0].y2) rects[0].y2 = rects[r].y2;
+    }
+    rects[0].x1 = 0;
+    rects[0].x2 = LCD_WIDTH-1;
+    rectCount = 1;
   }
-#if LCD_BPP==12 || LCD_BPP==16
-  // Just send full rows as this allows us to issue a single SPI
-  // transfer.
-  // TODO: could swap to a transfer per row if we're filling less than half a row
-  gfx->data.modMinX = 0;
-  gfx->data.modMaxX = LCD_WIDTH-1;
-#else
-  // use nearest 2 pixels as we're sending 12 bits
-  gfx->data.modMinX = (gfx->data.modMinX)&~1;
-  gfx->data.modMaxX = (gfx->data.modMaxX+2)&~1;
-  int xlen = gfx->data.modMaxX - gfx->data.modMinX;
-  int xstart = gfx->data.modMinX;
-#endif
 
 #ifdef ESPR_USE_SPI3
   // anomaly 195 workaround - enable SPI before use
@@ -222,126 +251,114 @@ void lcdFlip_SPILCD(JsGraphics *gfx) {
 #endif
 
   jshPinSetValue(LCD_SPI_CS, 0);
-  jshPinSetValue(LCD_SPI_DC, 0); // command
-  buffer1[0] = SPILCD_CMD_WINDOW_X;
-  jshSPISendMany(LCD_SPI, buffer1, NULL, 1, NULL);
-  jshPinSetValue(LCD_SPI_DC, 1); // data
-  buffer1[0] = 0;
-  buffer1[1] = gfx->data.modMinX;
-  buffer1[2] = 0;
-  buffer1[3] = gfx->data.modMaxX;
-  jshSPISendMany(LCD_SPI, buffer1, NULL, 4, NULL);
-  jshPinSetValue(LCD_SPI_DC, 0); // command
-  buffer1[0] = SPILCD_CMD_WINDOW_Y;
-  jshSPISendMany(LCD_SPI, buffer1, NULL, 1, NULL);
-  jshPinSetValue(LCD_SPI_DC, 1); // data
-  buffer1[0] = 0;
-  buffer1[1] = gfx->data.modMinY;
-  buffer1[2] = 0;
-  buffer1[3] = gfx->data.modMaxY;
-  jshSPISendMany(LCD_SPI, buffer1, NULL, 4, NULL);
-  jshPinSetValue(LCD_SPI_DC, 0); // command
-  buffer1[0] = SPILCD_CMD_DATA;
-  jshSPISendMany(LCD_SPI, buffer1, NULL, 1, NULL);
-  jshPinSetValue(LCD_SPI_DC, 1); // data
-
+  for (int r=0;r<rectCount;r++) {
+    int y1 = rects[r].y1, y2 = rects[r].y2;
 #if LCD_BPP==12 || LCD_BPP==16
-  if (hasOverlay) { // we have an overlay, just send line by line
-    // initialise image layer
-    GfxDrawImageLayer l;
-    int ovY = lcdOverlayY;
-    l.x1 = 0;
-    l.y1 = ovY;
-    l.img = overlayImg;
-    l.rotate = 0;
-    l.scale = 1;
-    l.center = false;
-    l.repeat = false;
-    jsvStringIteratorNew(&l.it, l.img.buffer, (size_t)l.img.bitmapOffset);
-    _jswrap_drawImageLayerInit(&l);
-    _jswrap_drawImageLayerSetStart(&l, 0, gfx->data.modMinY);
-    unsigned char buffer2[LCD_STRIDE];
-    memcpy(buffer1, &lcdBuffer[LCD_STRIDE*0], LCD_STRIDE); // save first 2 lines
-    memcpy(buffer2, &lcdBuffer[LCD_STRIDE*1], LCD_STRIDE);
-
-    for (int y=gfx->data.modMinY;y<=gfx->data.modMaxY;y++) {
-      int bufferLine = y&1; // alternate lines so we can send while calculating next line
-      unsigned char *buf = &lcdBuffer[LCD_STRIDE * bufferLine];
-      // copy original line in
-      memcpy(buf, &lcdBuffer[LCD_STRIDE*y], LCD_STRIDE);
-      // overwrite areas with overlay image
-      if (y>=ovY && y<ovY+overlayImg.height) {
-        _jswrap_drawImageLayerStartX(&l);
-        for (int x=0;x<overlayImg.width;x++) {
-          unsigned int c;
-          int ox = x+lcdOverlayX;
-          if (_jswrap_drawImageLayerGetPixel(&l, &c) && (ox < LCD_WIDTH) && (ox >= 0))
-            lcdSetPixel_SPILCD(NULL, ox, y&1, c);
-          _jswrap_drawImageLayerNextX(&l);
+    lcdFlipSetWindow_SPILCD(0, y1, LCD_WIDTH-1, y2);
+    if (hasOverlay) { // we have an overlay, just send line by line
+      // initialise image layer
+      GfxDrawImageLayer l;
+      int ovY = lcdOverlayY;
+      l.x1 = 0;
+      l.y1 = ovY;
+      l.img = overlayImg;
+      l.rotate = 0;
+      l.scale = 1;
+      l.center = false;
+      l.repeat = false;
+      jsvStringIteratorNew(&l.it, l.img.buffer, (size_t)l.img.bitmapOffset);
+      _jswrap_drawImageLayerInit(&l);
+      _jswrap_drawImageLayerSetStart(&l, 0, y1);
+      unsigned char buffer2[LCD_STRIDE];
+      memcpy(buffer1, &lcdBuffer[LCD_STRIDE*0], LCD_STRIDE); // save first 2 lines
+      memcpy(buffer2, &lcdBuffer[LCD_STRIDE*1], LCD_STRIDE);
+
+      for (int y=y1;y<=y2;y++) {
+        int bufferLine = y&1; // alternate lines so we can send while calculating next line
+        unsigned char *buf = &lcdBuffer[LCD_STRIDE * bufferLine];
+        // copy original line in
+        memcpy(buf, &lcdBuffer[LCD_STRIDE*y], LCD_STRIDE);
+        // overwrite areas with overlay image
+        if (y>=ovY && y<ovY+overlayImg.height) {
+          _jswrap_drawImageLayerStartX(&l);
+          for (int x=0;x<overlayImg.width;x++) {
+            unsigned int c;
+            int ox = x+lcdOverlayX;
+            if (_jswrap_drawImageLayerGetPixel(&l, &c) && (ox < LCD_WIDTH) && (ox >= 0))
+              lcdSetPixel_SPILCD(NULL, ox, y&1, c);
+            _jswrap_drawImageLayerNextX(&l);
+          }
         }
+        _jswrap_drawImageLayerNextY(&l);
+        // send the line
+        jshSPISendMany(LCD_SPI, buf, 0, LCD_STRIDE, lcdFlip_SPILCD_callback);
+      }
+      jsvStringIteratorFree(&l.it);
+
+      memcpy(&lcdBuffer[LCD_STRIDE*0], buffer1, LCD_STRIDE); // restore first 2 lines
+      memcpy(&lcdBuffer[LCD_STRIDE*1], buffer2, LCD_STRIDE);
+
+      jshSPIWait(LCD_SPI);
+    } else { // ============================================  standard, non-overlay transfer
+      // FIXME: hack because SPI send on NRF52 fails for >65k transfers
+      // we should fix this in jshardware.c
+      unsigned char *p = &lcdBuffer[LCD_STRIDE*y1];
+      int c = (y2+1-y1)*LCD_STRIDE;
+      while (c) {
+        int n = c;
+        if (n>65535) n=65535;
+        jshSPISendMany(
+            LCD_SPI,
+            p,
+            0,
+            n,
+            NULL);
+        if (jspIsInterrupted()) break;
+        p+=n;
+        c-=n;
       }
-      _jswrap_drawImageLayerNextY(&l);
-      // send the line
-      jshSPISendMany(LCD_SPI, buf, 0, LCD_STRIDE, lcdFlip_SPILCD_callback);
-    }
-    jsvStringIteratorFree(&l.it);
-    _jswrap_graphics_freeImageInfo(&overlayImg);
-
-    memcpy(&lcdBuffer[LCD_STRIDE*0], buffer1, LCD_STRIDE); // restore first 2 lines
-    memcpy(&lcdBuffer[LCD_STRIDE*1], buffer2, LCD_STRIDE);
-
-    jshSPIWait(LCD_SPI);
-  } else { // ============================================  standard, non-overlay transfer
-    // FIXME: hack because SPI send on NRF52 fails for >65k transfers
-    // we should fix this in jshardware.c
-    unsigned char *p = &lcdBuffer[LCD_STRIDE*gfx->data.modMinY];
-    int c = (gfx->data.modMaxY+1-gfx->data.modMinY)*LCD_STRIDE;
-    while (c) {
-      int n = c;
-      if (n>65535) n=65535;
-      jshSPISendMany(
-          LCD_SPI,
-          p,
-          0,
-          n,
-          NULL);
-      if (jspIsInterrupted()) break;
-      p+=n;
-      c-=n;
     }
-  }
 #else // Data stored paletted - must decode the palette before sending
-  unsigned char buffer2[LCD_STRIDE];
-  for (int y=gfx->data.modMinY;y<=gfx->data.modMaxY;y++) {
-    unsigned char *buffer = (y&1)?buffer1:buffer2;
-    // skip any lines that don't need updating
+    // use nearest 2 pixels as we're sending 12 bits
+    int xstart = rects[r].x1&~1;
+    int xend = (rects[r].x2+2)&~1;
+    int xlen = xend - xstart;
+    lcdFlipSetWindow_SPILCD(xstart, y1, xend, y2);
+    unsigned char buffer2[LCD_STRIDE];
+    for (int y=y1;y<=y2;y++) {
+      unsigned char *buffer = (y&1)?buffer1:buffer2;
+      // skip any lines that don't need updating
 #if LCD_BPP==4
-    unsigned char *px = &lcdBuffer[y*LCD_STRIDE + (xstart>>1)];
+      unsigned char *px = &lcdBuffer[y*LCD_STRIDE + (xstart>>1)];
 #endif
 #if LCD_BPP==8
-    unsigned char *px = &lcdBuffer[y*LCD_STRIDE + xstart];
+      unsigned char *px = &lcdBuffer[y*LCD_STRIDE + xstart];
 #endif
-    unsigned char *bufPtr = (unsigned char*)buffer;
-    for (int x=0;x<xlen;x+=2) {
+      unsigned char *bufPtr = (unsigned char*)buffer;
+      for (int x=0;x<xlen;x+=2) {
 #if LCD_BPP==4
-      unsigned char c = *(px++);
-      unsigned int a = lcdPalette[c >> 4];
-      unsigned int b = lcdPalette[c & 15];
+        unsigned char c = *(px++);
+        unsigned int a = lcdPalette[c >> 4];
+        unsigned int b = lcdPalette[c & 15];
 #endif
 #if LCD_BPP==8
-      unsigned int a = lcdPalette[*(px++)];
-      unsigned int b = lcdPalette[*(px++)];
+        unsigned int a = lcdPalette[*(px++)];
+        unsigned int b = lcdPalette[*(px++)];
 #endif
-      *(bufPtr++) = a>>4;
-      *(bufPtr++) = (a<<4) | (b>>8);
-      *(bufPtr++) = b;
+        *(bufPtr++) = a>>4;
+        *(bufPtr++) = (a<<4) | (b>>8);
+        *(bufPtr++) = b;
+      }
+      size_t len = ((unsigned char*)bufPtr)-buffer;
+      jshSPISendMany(LCD_SPI, buffer, 0, len, lcdFlip_SPILCD_callback);
+      if (jspIsInterrupted()) break;
     }
-    size_t len = ((unsigned char*)bufPtr)-buffer;
-    jshSPISendMany(LCD_SPI, buffer, 0, len, lcdFlip_SPILCD_callback);
+    jshSPIWait(LCD_SPI);
+#endif // End of paletted send
     if (jspIsInterrupted()) break;
   }
-  jshSPIWait(LCD_SPI);
-#endif // End of paletted send
+  if (hasOverlay)
+    _jswrap_graphics_freeImageInfo(&overlayImg);
   jshPinSetValue(LCD_SPI_CS,1);
 #ifdef ESPR_USE_SPI3
   // anomaly 195 workaround - disable SPI when done
@@ -350,10 +367,7 @@ void lcdFlip_SPILCD(JsGraphics *gfx) {
 #endif
 
   // Reset modified-ness
-  gfx->data.modMaxX = -32768;
-  gfx->data.modMaxY = -32768;
-  gfx->data.modMinX = 32767;
-  gfx->data.modMinY = 32767;
+  graphicsClearModified(gfx);
 }
 
 
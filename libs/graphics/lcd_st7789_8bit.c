@@ -238,29 +238,28 @@ void lcdST7789_flip(JsGraphics *gfx) {
       }
       lcdST7789_scrollCmd();
     } break;
-    case LCDST7789_MODE_BUFFER_120x120: {
-      // offscreen buffer - BLIT
-      JsVar *buffer = jsvObjectGetChildIfExists(gfx->graphicsVar, "buffer");
-      JsVar *str = jsvGetArrayBufferBackingString(buffer, NULL);
-      if (str) {
-        JsvStringIterator it;
-        jsvStringIteratorNew(&it, str, 0);
-        lcdST7789_blit8Bit(0,0,120,120,2,&it,PALETTE_8BIT);
-        jsvStringIteratorFree(&it);
-      }
-      jsvUnLock2(str,buffer);
-    } break;
+    case LCDST7789_MODE_BUFFER_120x120:
     case LCDST7789_MODE_BUFFER_80x80: {
-      // offscreen buffer - BLIT
+      // offscreen buffer - BLIT just the rows that have been modified
+      int size = (lcdMode==LCDST7789_MODE_BUFFER_120x120) ? 120 : 80;
+      int scale = (lcdMode==LCDST7789_MODE_BUFFER_120x120) ? 2 : 3;
+      JsGraphicsRect rows[GRAPHICS_MODIFIED_RECTS];
+      int rowCount = graphicsGetModifiedRects(gfx, rows, 2);
       JsVar *buffer = jsvObjectGetChildIfExists(gfx->graphicsVar, "buffer");
       JsVar *str = jsvGetArrayBufferBackingString(buffer, NULL);
       if (str) {
-        JsvStringIterator it;
-        jsvStringIteratorNew(&it, str, 0);
-        lcdST7789_blit8Bit(0,0,80,80,3,&it,PALETTE_8BIT);
-        jsvStringIteratorFree(&it);
+        for (int r=0;r<rowCount;r++) {
+          int y1 = rows[r].y1, y2 = rows[r].y2;
+          if (y2>=size) y2 = size-1;
+          if (y1>y2) continue;
+          JsvStringIterator it;
+          jsvStringIteratorNew(&it, str, (size_t)(y1*size));
+          lcdST7789_blit8Bit(0,y1*scale,size,1+y2-y1,scale,&it,PALETTE_8BIT);
+          jsvStringIteratorFree(&it);
+        }
       }
       jsvUnLock2(str,buffer);
+      graphicsClearModified(gfx);
     } break;
   }
 }
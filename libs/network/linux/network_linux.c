@@ -40,6 +40,11 @@
  typedef int SOCKET;
 #endif
 
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+ #include <sys/epoll.h>
+ #define USE_EPOLL
+#endif
+
 #define closesocket(SOCK) close(SOCK)
 
 #if NET_DBG > 0
@@ -50,6 +55,68 @@
 #endif
 
 
+#ifdef USE_EPOLL
+/* All our sockets are added to one epoll set. Each idle we ask it which
+ * ones are ready, so recv/accept don't have to make system calls for
+ * sockets that have nothing for us, and jshSleep can wait on it. */
+static int epollFd = -1;
+/// How many sockets are in epollFd
+static int epollSockets = 0;
+/// Sockets this high or above are always treated as ready
+#define EPOLL_READY_MAX 1024
+/// Bit set for each socket that epoll said was ready when we last checked
+static uint32_t epollReady[EPOLL_READY_MAX/32];
+/// How many events we get from epoll each idle
+#define EPOLL_EVENTS 64
+
+static void net_linux_setReady(int sckt, bool ready) {
+  if (sckt<0 || sckt>=EPOLL_READY_MAX) return;
+  if (ready) epollReady[sckt>>5] |= 1u<<(sckt&31);
+  else epollReady[sckt>>5] &= ~(1u<<(sckt&31));
+}
+
+/// Could this socket have data (or a connection, or have closed)?
+static bool net_linux_isReady(int sckt) {
+  if (epollFd<0 || sckt<0 || sckt>=EPOLL_READY_MAX) return true;
+  return (epollReady[sckt>>5] & (1u<<(sckt&31))) != 0;
+}
+
+/// Add a new socket to our epoll set
+static void net_linux_watchSocket(int sckt) {
+  if (epollFd<0) return; // we'll just check every socket
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.fd = sckt;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, sckt, &ev)==0)
+    epollSockets++;
+  // it's new, so check it the first time around
+  net_linux_setReady(sckt, true);
+}
+
+/// Update epollReady from epoll, waiting for up to 'timeout' milliseconds. Returns the number of ready sockets
+static int net_linux_pollSockets(int timeout) {
+  struct epoll_event events[EPOLL_EVENTS];
+  int n = epoll_wait(epollFd, events, EPOLL_EVENTS, timeout);
+  for (int i=0;i<n;i++)
+    net_linux_setReady(events[i].data.fd, true);
+  return n;
+}
+
+/** Sleep for up to 'usecs', waking early if a socket becomes ready. Returns
+ * false if there are no sockets to wait on (so we didn't sleep). */
+bool net_linux_sleep(unsigned int usecs) {
+  if (epollFd<0 || !epollSockets) return false;
+  net_linux_pollSockets((int)(usecs/1000));
+  return true;
+}
+
+/// Are any sockets open? socketIdle doesn't report this when sleeping on epoll (see JsNetwork.wakesOnSocketData)
+bool net_linux_hasSockets() {
+  return epollSockets>0;
+}
+#endif
+
 /// Get an IP address from a name. Sets out_ip_addr to 0 on failure
 void net_linux_gethostbyname(JsNetwork *net, char * hostName, uint32_t* out_ip_addr) {
   NOT_USED(net);
@@ -61,6 +128,13 @@ void net_linux_gethostbyname(JsNetwork *net, char * hostName, uint32_t* out_ip_a
 /// Called on idle. Do any checks required for this device
 void net_linux_idle(JsNetwork *net) {
   NOT_USED(net);
+#ifdef USE_EPOLL
+  // find out which sockets have anything for us
+  if (epollFd>=0 && epollSockets) {
+    memset(epollReady, 0, sizeof(epollReady));
+    net_linux_pollSockets(0);
+  }
+#endif
 }
 
 /// Call just before returning to idle loop. This checks for errors and tries to recover. Returns true if no errors.
@@ -182,6 +256,10 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
         closesocket(sckt);
         return -1;
       }
+#ifdef USE_EPOLL
+      // so accept() returns straight away if the client went away before we got to it
+      fcntl(sckt, F_SETFL, fcntl(sckt, F_GETFL, 0) | O_NONBLOCK);
+#endif
     }
   }
 
@@ -198,6 +276,9 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
   if (setsockopt(sckt,SOL_SOCKET,SO_NOSIGPIPE,(const char *)&optval,sizeof(optval))<0)
     jsWarn("setsockopt(SO_NOSIGPIPE) failed\n");
 #endif
+#ifdef USE_EPOLL
+  net_linux_watchSocket(sckt);
+#endif
 
   return sckt;
 }
@@ -205,12 +286,28 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
 /// destroys the given socket
 void net_linux_closesocket(JsNetwork *net, int sckt) {
   NOT_USED(net);
+#ifdef USE_EPOLL
+  if (epollFd>=0 && epoll_ctl(epollFd, EPOLL_CTL_DEL, sckt, NULL)==0)
+    epollSockets--;
+  net_linux_setReady(sckt, false);
+#endif
   closesocket(sckt);
 }
 
 /// If the given server socket can accept a connection, return it (or return < 0)
 int net_linux_accept(JsNetwork *net, int sckt) {
   NOT_USED(net);
+#ifdef USE_EPOLL
+  if (epollFd>=0) {
+    if (!net_linux_isReady(sckt)) return -1;
+    net_linux_setReady(sckt, false);
+    // we may have a client waiting to connect (the server socket is non-blocking, so this won't wait)
+    int theClient = accept(sckt,0,0);
+    if (theClient>=0)
+      net_linux_watchSocket(theClient);
+    return theClient;
+  }
+#endif
   // TODO: look for unreffed servers?
   fd_set s;
   FD_ZERO(&s);
@@ -234,14 +331,27 @@ int net_linux_recv(JsNetwork *net, SocketType socketType, int sckt, void *buf, s
   struct sockaddr_in fromAddr;
   int fromAddrLen = sizeof(fromAddr);
   int num = 0;
-  fd_set s;
-  FD_ZERO(&s);
-  FD_SET(sckt,&s);
-  // check for waiting clients
-  struct timeval timeout;
-  timeout.tv_sec = 0;
-  timeout.tv_usec = 0;
-  int n = select(sckt+1,&s,NULL,NULL,&timeout);
+  int flags = 0;
+  int n;
+#ifdef USE_EPOLL
+  if (epollFd>=0) {
+    // only check sockets that epoll says are ready, and never block
+    if (!net_linux_isReady(sckt)) return 0;
+    net_linux_setReady(sckt, false);
+    flags = MSG_DONTWAIT;
+    n = 1;
+  } else
+#endif
+  {
+    fd_set s;
+    FD_ZERO(&s);
+    FD_SET(sckt,&s);
+    // check for waiting clients
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+    n = select(sckt+1,&s,NULL,NULL,&timeout);
+  }
   if (n==SOCKET_ERROR) {
     // we probably disconnected
     return -1;
@@ -249,7 +359,8 @@ int net_linux_recv(JsNetwork *net, SocketType socketType, int sckt, void *buf, s
     // receive data
     if (socketType & ST_UDP) {
       JsNetUDPPacketHeader *header = (JsNetUDPPacketHeader*)buf;
-      num = (int)recvfrom(sckt,buf+sizeof(JsNetUDPPacketHeader),len-sizeof(JsNetUDPPacketHeader),0,(struct sockaddr *)&fromAddr,(socklen_t*)&fromAddrLen);
+      num = (int)recvfrom(sckt,buf+sizeof(JsNetUDPPacketHeader),len-sizeof(JsNetUDPPacketHeader),flags,(struct sockaddr *)&fromAddr,(socklen_t*)&fromAddrLen);
+      if (num<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) return 0; // nothing there after all
       *(in_addr_t*)&header->host = fromAddr.sin_addr.s_addr;
       header->port = ntohs(fromAddr.sin_port);
       header->length = (uint16_t)num;
@@ -258,7 +369,8 @@ int net_linux_recv(JsNetwork *net, SocketType socketType, int sckt, void *buf, s
       if (num==0) return -1; // select says data, but recv says 0 means connection is closed
       num += sizeof(JsNetUDPPacketHeader);
     } else {
-      num = (int)recvfrom(sckt,buf,len,0,(struct sockaddr *)&fromAddr,(socklen_t*)&fromAddrLen);
+      num = (int)recvfrom(sckt,buf,len,flags,(struct sockaddr *)&fromAddr,(socklen_t*)&fromAddrLen);
+      if (num<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) return 0; // nothing there after all
       if (num==0) return -1; // select says data, but recv says 0 means connection is closed
     }
   }
@@ -312,4 +424,8 @@ void netSetCallbacks_linux(JsNetwork *net) {
   net->recv = net_linux_recv;
   net->send = net_linux_send;
   net->chunkSize = 536;
+#ifdef USE_EPOLL
+  if (epollFd<0) epollFd = epoll_create1(EPOLL_CLOEXEC);
+  net->wakesOnSocketData = epollFd>=0; // jshSleep waits on epollFd
+#endif
 }
@@ -14,3 +14,9 @@
 #include "network.h"
 
 void netSetCallbacks_linux(JsNetwork *net);
+
+/** Sleep for up to 'usecs', waking early if a socket becomes ready. Returns
+ * false if there are no sockets to wait on (so we didn't sleep). */
+bool net_linux_sleep(unsigned int usecs);
+/// Are any sockets open? If so we shouldn't exit
+bool net_linux_hasSockets();
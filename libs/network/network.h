@@ -66,6 +66,9 @@ typedef struct JsNetwork {
   unsigned char _blank; ///< this is needed as jsvGetString for 'data' wants to add a trailing zero  
 
   int chunkSize; ///< Amount of memory to allocate for chunks of data when using send/recv
+  /** If true, jshSleep will wake when a socket gets data, so socketIdle only needs to report
+   * that it is busy when something happened (rather than whenever sockets are open) */
+  bool wakesOnSocketData;
 
   /// Called on idle. Do any checks required for this device
   void (*idle)(struct JsNetwork *net);
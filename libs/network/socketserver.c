@@ -33,6 +33,9 @@
 #define HTTP_NAME_OPTIONS_VAR "opt"
 #define HTTP_NAME_SERVER_VAR "svr"
 #define HTTP_NAME_CHUNKED "chunked"
+#define HTTP_NAME_CHUNK_STATE "chSt" // HttpChunkState - where we are in a chunked body
+#define HTTP_NAME_CHUNK_REMAINING "chRem" // bytes of the current chunk still to receive (or the chunk size while parsing it)
+#define HTTP_NAME_HEADER_SCAN "hScn" // how many bytes we have searched for the end of the headers
 #define HTTP_NAME_HEADERS "headers"
 #define HTTP_NAME_CLOSENOW "clsNow"  // boolean: gotta close
 #define HTTP_NAME_CONNECTED "conn"     // boolean: we are connected
@@ -64,6 +67,15 @@ static char DBG_LIB[] = "socketserver"; // library name
 #define DBG(format, ...) do { } while(0)
 #endif
 
+/// Where we are in receiving a body with 'Transfer-Encoding: chunked'
+typedef enum {
+  HTTP_CHUNK_SIZE,     ///< reading the chunk size (hex)
+  HTTP_CHUNK_EXT,      ///< skipping chunk extensions after the size, up to the newline
+  HTTP_CHUNK_DATA,     ///< reading chunk data (HTTP_NAME_CHUNK_REMAINING bytes left)
+  HTTP_CHUNK_DATA_END, ///< skipping the CRLF after chunk data
+  HTTP_CHUNK_DONE,     ///< we've had the last (zero length) chunk
+} HttpChunkState;
+
 // -----------------------------
 
 static ALWAYS_INLINE bool compareTransferEncodingAndUnlock(JsVar *encoding, char *value) {
@@ -93,12 +105,14 @@ static void httpAppendHeaders(JsVar *string, JsVar *headerObject) {
 // httpParseHeaders(&receiveData, reqVar, true) // server
 // httpParseHeaders(&receiveData, resVar, false) // client
 bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer) {
-  // find /r/n/r/n
+  /* find /r/n/r/n. We only search the data that's new since last time (plus
+   * 3 chars in case /r/n/r/n was split between packets) */
   int newlineIdx = 0;
-  int strIdx = 0;
+  int strIdx = (int)jsvGetIntegerAndUnLock(jsvObjectGetChildIfExists(objectForData, HTTP_NAME_HEADER_SCAN));
+  strIdx = (strIdx>3) ? strIdx-3 : 0;
   int headerEnd = -1;
   JsvStringIterator it;
-  jsvStringIteratorNew(&it, *receiveData, 0);
+  jsvStringIteratorNew(&it, *receiveData, (size_t)strIdx);
   while (jsvStringIteratorHasChar(&it)) {
     char ch = jsvStringIteratorGetCharAndNext(&it);
     if (ch == '\r') {
@@ -115,7 +129,11 @@ bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer)
   }
   jsvStringIteratorFree(&it);
   // skip if we have no header
-  if (headerEnd<0) return false;
+  if (headerEnd<0) {
+    jsvObjectSetIntChild(objectForData, HTTP_NAME_HEADER_SCAN, strIdx);
+    return false;
+  }
+  jsvObjectRemoveChild(objectForData, HTTP_NAME_HEADER_SCAN);
   // Now parse the header
   JsVar *vHeaders = jsvNewObject();
   if (!vHeaders) return true;
@@ -167,6 +185,8 @@ bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer)
   JsVarInt contentToReceive;
   if (compareTransferEncodingAndUnlock(jsvObjectGetChildI(vHeaders, "Transfer-Encoding"), "chunked")) {
     jsvObjectSetBoolChild(objectForData, HTTP_NAME_CHUNKED, true);
+    jsvObjectSetIntChild(objectForData, HTTP_NAME_CHUNK_STATE, HTTP_CHUNK_SIZE);
+    jsvObjectSetIntChild(objectForData, HTTP_NAME_CHUNK_REMAINING, 0);
     contentToReceive = 1;
   } else {
     contentToReceive = jsvGetIntegerAndUnLock(jsvObjectGetChildI(vHeaders,"Content-Length"));
@@ -304,83 +324,88 @@ int socketSendData(JsNetwork *net, JsVar *connection, int sckt, JsVar **sendData
   return 0;
 }
 
+/** Decode a 'Transfer-Encoding: chunked' body in receiveData, pushing the
+ * data in each chunk to 'reader' as we find it. We only go through the data
+ * once, and what's left of a chunk that's split between packets is pushed
+ * as soon as it arrives, so receiveData is normally empty afterwards. */
+static void socketPushReceiveDataChunked(JsVar *reader, JsVar **receiveData, bool force) {
+  HttpChunkState state = (HttpChunkState)jsvGetIntegerAndUnLock(jsvObjectGetChildIfExists(reader, HTTP_NAME_CHUNK_STATE));
+  JsVarInt remaining = jsvGetIntegerAndUnLock(jsvObjectGetChildIfExists(reader, HTTP_NAME_CHUNK_REMAINING));
+  size_t len = jsvGetStringLength(*receiveData);
+  size_t idx = 0; // how far through receiveData we are
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, *receiveData, 0);
+  while (idx<len && state!=HTTP_CHUNK_DONE) {
+    if (state==HTTP_CHUNK_DATA) {
+      // push as much of this chunk as we have
+      size_t dataLen = (size_t)remaining;
+      if (dataLen > len-idx) dataLen = len-idx;
+      JsVar *chunkData = jsvNewFromStringVar(*receiveData, idx, dataLen);
+      if (!chunkData) break; // out of memory
+      bool ok = jswrap_stream_pushData(reader, chunkData, force);
+      jsvUnLock(chunkData);
+      if (!ok) break; // no space - leave it in receiveData for next time
+      idx += dataLen;
+      remaining -= (JsVarInt)dataLen;
+      if (!remaining) state = HTTP_CHUNK_DATA_END;
+      jsvStringIteratorGoto(&it, *receiveData, idx);
+      continue;
+    }
+    char ch = jsvStringIteratorGetCharAndNext(&it);
+    idx++;
+    if (state==HTTP_CHUNK_SIZE) {
+      int digit = chtod(ch);
+      if (digit>=0 && digit<16) remaining = remaining*16 + digit;
+      else if (ch=='\n') state = HTTP_CHUNK_DATA; // no extensions
+      else state = HTTP_CHUNK_EXT; // '\r' or ';'
+    } else if (state==HTTP_CHUNK_EXT || state==HTTP_CHUNK_DATA_END) {
+      if (ch=='\n') state = (state==HTTP_CHUNK_EXT) ? HTTP_CHUNK_DATA : HTTP_CHUNK_SIZE;
+    }
+    if (state==HTTP_CHUNK_DATA && !remaining) { // zero length chunk = end of data
+      state = HTTP_CHUNK_DONE;
+      DBG("D:done\n");
+    }
+  }
+  jsvStringIteratorFree(&it);
+  if (state==HTTP_CHUNK_DONE) idx = len; // ignore any trailers
+  // for 'chunked' set the counter to 1 to read on or 0 if at last chunk
+  jsvObjectSetIntChild(reader, HTTP_NAME_RECEIVE_COUNT, state!=HTTP_CHUNK_DONE);
+  jsvObjectSetIntChild(reader, HTTP_NAME_CHUNK_STATE, state);
+  jsvObjectSetIntChild(reader, HTTP_NAME_CHUNK_REMAINING, remaining);
+  // keep any chunk data we couldn't push for next time
+  JsVar *newReceiveData = 0;
+  if (idx < len)
+    newReceiveData = jsvNewFromStringVar(*receiveData, idx, JSVAPPENDSTRINGVAR_MAXLENGTH);
+  jsvUnLock(*receiveData);
+  *receiveData = newReceiveData;
+}
+
 void socketPushReceiveData(JsVar *reader, JsVar **receiveData, bool isHttp, bool force) {
   if (!*receiveData || jsvIsEmptyString(*receiveData)) {
     // no data available (after headers)
     return;
   }
 
-  JsVar *nextChunk = 0;
-  JsVar *partialChunk = 0;
-
   // Keep track of how much we received (so we can close once we have it)
   if (isHttp) {
-    size_t len = (size_t)jsvGetStringLength(*receiveData);
     if (jsvGetBoolAndUnLock(jsvObjectGetChildIfExists(reader, HTTP_NAME_CHUNKED))) {
-      // check for incomplete chunk, at least "0\r\n\r\n"
-      if (len < 5) return; // incomplete, wait for more data
-
-      JsVar *crlf = jsvNewFromString("\r\n");
-      JsVar *zero = jsvNewFromInteger(0);
-      size_t startIdx = (size_t)jswrap_string_indexOf(*receiveData, crlf, zero, false);
-      jsvUnLock2(crlf, zero);
-
-      JsVar *sixteen = jsvNewFromInteger(16);
-      int chunkLen = jsvGetIntegerAndUnLock(jswrap_parseInt(*receiveData, sixteen));
-      jsvUnLock(sixteen);
-      DBG("D:%d\n", chunkLen);
-
-      // for 'chunked' set the counter to 1 to read on or 0 if at last chunk
-      jsvObjectSetIntChild(reader, HTTP_NAME_RECEIVE_COUNT, chunkLen ? 1 : 0);
-      if (!chunkLen) { // no 'data' callback
-        // clear received data
-        jsvUnLock(*receiveData);
-        *receiveData = 0;
-        return;
-      }
-
-      startIdx += 2; // skip the CRLF
-      size_t nextIdx = startIdx + (size_t)chunkLen + 2; // CRLF at the end
-      if (nextIdx < len) { // there is another chunk in the buffer
-        DBG("D:nextIdx %d %d\n", nextIdx, len);
-        nextChunk = jsvNewFromEmptyString();
-        if (!nextChunk) return; // out of memory
-        jsvAppendStringVar(nextChunk, *receiveData, nextIdx, len-nextIdx);
-      } else if (nextIdx > len) { // chunk not complete
-        DBG("D:partialIdx %d %d %d\n", len - startIdx, nextIdx - len - 2, len);
-        if (nextIdx - len < 3) return; // just CRLF missing, wait
-        // use the data available, write remaining length, wait
-        partialChunk = jsvNewFromEmptyString();
-        if (!partialChunk) return; // out of memory
-        jsvAppendPrintf(partialChunk, "%x\r\n", nextIdx - len - 2);
-      }
-
-      JsVar *chunkData = jsvNewFromEmptyString();
-      if (!chunkData) return; // out of memory
-      jsvAppendStringVar(chunkData, *receiveData, startIdx, (size_t)chunkLen);
-      jsvUnLock(*receiveData);
-      *receiveData = chunkData;
-    } else {
-      jsvObjectSetChildAndUnLock(reader, HTTP_NAME_RECEIVE_COUNT,
-        jsvNewFromInteger(
-          jsvGetIntegerAndUnLock(jsvObjectGetChild(reader, HTTP_NAME_RECEIVE_COUNT, JSV_INTEGER)) - (JsVarInt)len)
-        );
+      socketPushReceiveDataChunked(reader, receiveData, force);
+      return;
     }
+    size_t len = (size_t)jsvGetStringLength(*receiveData);
+    jsvObjectSetChildAndUnLock(reader, HTTP_NAME_RECEIVE_COUNT,
+      jsvNewFromInteger(
+        jsvGetIntegerAndUnLock(jsvObjectGetChild(reader, HTTP_NAME_RECEIVE_COUNT, JSV_INTEGER)) - (JsVarInt)len)
+      );
   }
 
   // execute 'data' callback or save data
-  if (!jswrap_stream_pushData(reader, *receiveData, force)) {
-    jsvUnLock2(nextChunk, partialChunk);
+  if (!jswrap_stream_pushData(reader, *receiveData, force))
     return;
-  }
 
   // clear received data
   jsvUnLock(*receiveData);
-  *receiveData = nextChunk ? nextChunk : partialChunk;
-
-  if (nextChunk) { // process following chunks if any
-    socketPushReceiveData(reader, receiveData, isHttp, force);
-  }
+  *receiveData = 0;
 }
 
 void socketReceivedUDP(JsVar *connection, JsVar **receiveData) {
@@ -493,6 +518,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
   if (!arr) return false;
 
   bool hadSockets = false;
+  bool hadActivity = false; // did anything happen? See JsNetwork.wakesOnSocketData
   JsvObjectIterator it;
   jsvObjectIteratorNew(&it, arr);
   while (jsvObjectIteratorHasValue(&it)) {
@@ -510,6 +536,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
 
     if (!closeConnectionNow) {
       int num = netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
+      if (num) hadActivity = true;
       if (num<0) {
         // we probably disconnected so just get rid of this
         closeConnectionNow = true;
@@ -530,6 +557,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
       // send data if possible
       JsVar *sendData = jsvObjectGetChildIfExists(socket,HTTP_NAME_SEND_DATA);
       if (sendData && !jsvIsEmptyString(sendData)) {
+        hadActivity = true;
         int sent = socketSendData(net, socket, sckt, &sendData);
         // FIXME? checking for errors is a bit iffy. With the esp8266 network that returns
         // varied error codes we'd want to skip SOCKET_ERR_CLOSED and let the recv side deal
@@ -551,6 +579,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
           if (contentToReceive > 0 || !hadHeaders) {
             reallyCloseNow = false;
           } else if (!jsvGetBoolAndUnLock(jsvObjectGetChildIfExists(connection,HTTP_NAME_ENDED))) {
+            hadActivity = true;
             jsvObjectSetBoolChild(connection, HTTP_NAME_ENDED, true);
             jsiQueueObjectCallbacks(connection, HTTP_NAME_ON_END, NULL, 0);
             DBG("ONEND %d (%d)\n", contentToReceive, reallyCloseNow);
@@ -563,6 +592,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
     }
     if (closeConnectionNow) {
       DBG("CLOSE NOW\n");
+      hadActivity = true;
 
       // send out any data that we were POSTed
       bool hadHeaders = jsvGetBoolAndUnLock(jsvObjectGetChildIfExists(connection,HTTP_NAME_HAD_HEADERS));
@@ -597,7 +627,7 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
   jsvObjectIteratorFree(&it);
   jsvUnLock(arr);
 
-  return hadSockets;
+  return net->wakesOnSocketData ? hadActivity : hadSockets;
 }
 
 
@@ -608,6 +638,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
   if (!arr) return false;
 
   bool hadSockets = false;
+  bool hadActivity = false; // did anything happen? See JsNetwork.wakesOnSocketData
   JsvObjectIterator it;
   jsvObjectIteratorNew(&it, arr);
   while (jsvObjectIteratorHasValue(&it)) {
@@ -642,6 +673,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
         JsVar *sendData = jsvObjectGetChildIfExists(connection,HTTP_NAME_SEND_DATA);
         // send data if possible
         if (sendData && !jsvIsEmptyString(sendData)) {
+          hadActivity = true;
           // don't try to send if we're already in error state
           int num = 0;
           if (error == 0) {
@@ -666,6 +698,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
             if (contentToReceive > 0 || !hadHeaders) {
               closeConnectionNow = false;
             } else if (!jsvGetBoolAndUnLock(jsvObjectGetChildIfExists(socket,HTTP_NAME_ENDED))) {
+              hadActivity = true;
               jsvObjectSetBoolChild(socket, HTTP_NAME_ENDED, true);
               jsiQueueObjectCallbacks(socket, HTTP_NAME_ON_END, NULL, 0);
               DBG("onEnd %d (%d) %d\n", contentToReceive, closeConnectionNow, hadHeaders);
@@ -674,6 +707,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
         }
         // Now read data if possible (and we have space for it)
         int num = netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
+        if (num || !alreadyConnected) hadActivity = true;
         if (!alreadyConnected && num == SOCKET_ERR_NO_CONN) {
           ; // ignore... it's just telling us we're not connected yet
         } else if (num < 0) {
@@ -716,6 +750,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
 
     if (closeConnectionNow) {
       DBG("close now\n");
+      hadActivity = true;
 
       socketPushReceiveData(socket, &receiveData, isHttp, true);
       if (!receiveData || jsvIsEmptyString(receiveData)) {
@@ -756,7 +791,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
   }
   jsvUnLock(arr);
 
-  return hadSockets;
+  return net->wakesOnSocketData ? hadActivity : hadSockets;
 }
 
 
@@ -767,6 +802,7 @@ bool socketIdle(JsNetwork *net) {
     return false;
   }
   bool hadSockets = false;
+  bool hadActivity = false;
   JsVar *arr = socketGetArray(HTTP_ARRAY_HTTP_SERVERS,false);
   if (arr) {
     JsvObjectIterator it;
@@ -784,6 +820,7 @@ bool socketIdle(JsNetwork *net) {
           theClient = netAccept(net, sckt);
       }
       if (theClient >= 0) { // We have a new connection
+        hadActivity = true;
         if ((socketType&ST_TYPE_MASK) == ST_HTTP) {
           JsVar *req = jspNewObject(0, "httpSRq");
           JsVar *res = jspNewObject(0, "httpSRs");
@@ -830,6 +867,7 @@ bool socketIdle(JsNetwork *net) {
     jsvUnLock(arr);
   }
 
+  if (net->wakesOnSocketData) hadSockets = hadActivity; // we only need to report that we're busy if something happened
   if (socketServerConnectionsIdle(net)) hadSockets = true;
   if (socketClientConnectionsIdle(net)) hadSockets = true;
   netCheckError(net);
@@ -35,17 +35,18 @@ JshEventCallbackCallback jshEventCallbacks[EV_EXTI_MAX+1-EV_EXTI0];
 // ----------------------------------------------------------------------------
 //                                                         DATA TRANSMIT BUFFER
 
-/// A single character to be transmitted.
+/** A FIFO of bytes to transmit on one device, to be read from IRQ. A ring is
+ * given to a device when it has data to send, and can be given to a different
+ * device once it's empty. */
 typedef struct {
-  IOEventFlags flags; //!< Where this data should be transmitted
-  unsigned char data; //!< data to transmit
-} PACKED_FLAGS TxBufferItem;
+  volatile IOEventFlags device; //!< Where this data should be transmitted (EV_NONE if unused)
+  volatile unsigned char head;  //!< Data is added here
+  volatile unsigned char tail;  //!< Data is removed from here (by IRQ)
+  volatile unsigned char data[TXBUFFERMASK+1]; //!< data to transmit
+} TxRing;
 
-/// A FIFO of items to transmit, to be read from IRQ
-volatile TxBufferItem txBuffer[TXBUFFERMASK+1];
-
-/// The head and tail of the list.
-volatile unsigned char txHead=0, txTail=0;
+/// Buffers for data waiting to be transmitted
+TxRing txRings[TXRINGCOUNT];
 
 typedef enum {
   SDS_NONE,
@@ -104,6 +105,9 @@ volatile uint8_t ioBuffer[IOBUFFERMASK+1];
 /// The head and tail of the list.
 volatile IOBufferIdx ioHead=0, ioLastHead=0, ioTail=0;
 
+/// Statistics about ioBuffer, see jshGetIOEventStats
+volatile JshIOEventStats ioStats;
+
 // ----------------------------------------------------------------------------
 
 
@@ -205,16 +209,126 @@ void jshResetDevices() {
 
 // ----------------------------------------------------------------------------
 
-/**
- * Queue a character for transmission.
- */
-void jshTransmit(
-    IOEventFlags device, //!< The device to be used for transmission.
-    unsigned char data   //!< The character to transmit.
-  ) {
+/// Get the ring that data for this device is in (or 0)
+static TxRing *jshTransmitGetRing(IOEventFlags device) {
+  for (int i=0;i<TXRINGCOUNT;i++)
+    if (txRings[i].device == device)
+      return &txRings[i];
+  return 0;
+}
+
+/// How many bytes are waiting in this ring?
+static ALWAYS_INLINE unsigned int jshTransmitRingUsed(TxRing *ring) {
+  return (unsigned int)((ring->head - ring->tail) & TXBUFFERMASK);
+}
+
+/** Get the ring for this device, or give it one that's empty. Returns 0 if they're all in use.
+ * Must be called with interrupts off, and the ring only used until they're turned back on - if it
+ * empties, an IRQ could give it to another device. */
+static TxRing *jshTransmitGetOrClaimRing(IOEventFlags device) {
+  TxRing *ring = jshTransmitGetRing(device);
+  if (ring) return ring;
+#if TXRINGCOUNT>1
+  /* If the console has nothing waiting, keep an empty ring for it - otherwise devices
+  that aren't sending (eg. they've had XOFF) could stop console output altogether */
+  IOEventFlags console = jsiGetConsoleDevice();
+  TxRing *consoleRing = (device!=console) ? jshTransmitGetRing(console) : 0;
+  bool keepForConsole = device!=console && (!consoleRing || consoleRing->head == consoleRing->tail);
+  int emptyCount = 0;
+  for (int i=0;i<TXRINGCOUNT;i++) {
+    if (txRings[i].head == txRings[i].tail) {
+      emptyCount++;
+      if (!ring && &txRings[i]!=consoleRing) ring = &txRings[i];
+    }
+  }
+  if (keepForConsole && emptyCount<2) return 0;
+#else
+  if (txRings[0].head == txRings[0].tail) ring = &txRings[0];
+#endif
+  if (ring) ring->device = device;
+  return ring;
+}
+
+/** Copy up to 'length' bytes into the transmit ring for 'device' (claiming a ring if needed).
+ * This is done with interrupts off so that the ring can't be given to another device (by an IRQ
+ * that transmits) between us finding it and adding our data. Returns the number of bytes copied,
+ * which is 0 if there's no space */
+static unsigned int jshTransmitToRing(IOEventFlags device, const unsigned char *data, unsigned int length) {
+  unsigned int n = 0;
+  jshInterruptOff();
+  TxRing *ring = jshTransmitGetOrClaimRing(device);
+  if (ring) {
+    // copy as much as we can - up to the end of the buffer if we're about to wrap around
+    unsigned char head = ring->head;
+    n = TXBUFFERMASK - jshTransmitRingUsed(ring);
+    if (n > (unsigned int)(TXBUFFERMASK+1-head)) n = (unsigned int)(TXBUFFERMASK+1-head);
+    if (n > length) n = length;
+    memcpy((unsigned char*)&ring->data[head], data, n);
+    ring->head = (unsigned char)((head+n)&TXBUFFERMASK);
+  }
+  jshInterruptOn();
+  return n;
+}
+
+/// Does 'device' have (or could it claim) a ring with space in it?
+static bool jshTransmitHasSpace(IOEventFlags device) {
+  jshInterruptOff();
+  TxRing *ring = jshTransmitGetOrClaimRing(device);
+  bool space = ring && jshTransmitRingUsed(ring)<TXBUFFERMASK;
+  jshInterruptOn();
+  return space;
+}
+
+/** Wait until there's space to transmit on 'device' (because the device's
+ * buffer, or all buffers, are full). Returns false if we couldn't wait because
+ * we're in an IRQ. 'device' may be changed if it was EV_LIMBO (see below) */
+static bool jshTransmitWaitForSpace(IOEventFlags *device) {
+  // The buffer is full. What we do next is to wait for space to free up.
+  jsiSetBusy(BUSY_TRANSMIT, true);
+  bool wasConsoleLimbo = *device==EV_LIMBO && jsiGetConsoleDevice()==EV_LIMBO;
+#ifdef USE_SWDCON
+  int loopCount=0; // for recovery inside swdconBusyIdle
+#endif
+  while (!jshTransmitHasSpace(*device)) {
+    // wait for send to finish as buffer is about to overflow
+    if (jshIsInInterrupt()) {
+      // if we're printing from an IRQ, don't wait - it's unlikely TX will ever finish
+      jsErrorFlags |= JSERR_BUFFER_FULL;
+      jsiSetBusy(BUSY_TRANSMIT, false);
+      return false;
+    }
+    jshBusyIdle();
+#ifdef USE_SWDCON
+    loopCount++;
+    extern bool swdconBusyIdle(int);
+    if (*device == EV_SWDCON) swdconBusyIdle(loopCount);
+#endif
+#ifdef USB
+    // just in case USB was unplugged while we were waiting!
+    if (!jshIsUSBSERIALConnected()) jshTransmitClearDevice(EV_USBSERIAL);
+#endif
+    if (wasConsoleLimbo && jsiGetConsoleDevice()!=EV_LIMBO) {
+      /* It was 'Limbo', but now it's not - see jsiOneSecondAfterStartup.
+      Basically we must have printed a bunch of stuff to LIMBO and blocked
+      with our output buffer full. But then jsiOneSecondAfterStartup
+      switches to the right console device and swaps everything we wrote
+      over to that device too. Only we're now here, still writing to the
+      old device when really we should be writing to the new one. */
+      *device = jsiGetConsoleDevice();
+      wasConsoleLimbo = false;
+    }
+  }
+  jsiSetBusy(BUSY_TRANSMIT, false);
+  return true;
+}
+
+/** Handle devices that don't use the transmit buffer (or that we can't
+ * send to). Returns true if the data has been dealt with. */
+static bool jshTransmitDirect(IOEventFlags device, const unsigned char *data, unsigned int length) {
   if (device==EV_LOOPBACKA || device==EV_LOOPBACKB) {
-    jshPushIOCharEvent(device==EV_LOOPBACKB ? EV_LOOPBACKA : EV_LOOPBACKB, (char)data);
-    return;
+    while (length--)
+      jshPushIOCharEvent(device==EV_LOOPBACKB ? EV_LOOPBACKA : EV_LOOPBACKB, (char)*(data++));
+    return true;
   }
   //if (device==EV_USBSERIAL)
   //  jshTransmitPrintf(DEFAULT_CONSOLE_DEVICE, "=> %d\n", data);
@@ -222,90 +336,79 @@ void jshTransmit(
   if (device == EV_TELNET) {
     // gross hack to avoid deadlocking on the network here
     extern void telnetSendChar(char c);
-    telnetSendChar((char)data);
-    return;
+    while (length--) telnetSendChar((char)*(data++));
+    return true;
   }
 #endif
 #ifdef USE_TERMINAL
   if (device==EV_TERMINAL) {
     extern void terminalSendChar(char c);
-    terminalSendChar((char)data);
-    return;
+    while (length--) terminalSendChar((char)*(data++));
+    return true;
   }
 #endif
 #ifndef LINUX
 #ifdef USB
   if (device==EV_USBSERIAL && !jshIsUSBSERIALConnected()) {
     jshTransmitClearDevice(EV_USBSERIAL); // clear out stuff already waiting
-    return;
+    return true;
   }
 #endif
 #ifdef BLUETOOTH
   if (device==EV_BLUETOOTH && !jsble_has_peripheral_connection()) {
     jshTransmitClearDevice(EV_BLUETOOTH); // clear out stuff already waiting
-    return;
+    return true;
   }
 #endif
 #else // if PC, just put to stdout
   if (device==DEFAULT_CONSOLE_DEVICE) {
-    fputc(data, stdout);
+    fwrite(data, 1, length, stdout);
     fflush(stdout);
-    return;
+    return true;
   }
 #endif
   // If the device is EV_NONE then there is nowhere to send the data.
-  if (device==EV_NONE) return;
-
-  // The txHead global points to the current item in the txBuffer.  Since we are adding a new
-  // character, we increment the head pointer.   If it has caught up with the tail, then that means
-  // we have filled the array backing the list.  What we do next is to wait for space to free up.
-  unsigned char txHeadNext = (unsigned char)((txHead+1)&TXBUFFERMASK);
-  if (txHeadNext==txTail) {
-    jsiSetBusy(BUSY_TRANSMIT, true);
-    bool wasConsoleLimbo = device==EV_LIMBO && jsiGetConsoleDevice()==EV_LIMBO;
-#ifdef USE_SWDCON
-    int loopCount=0; // for recovery inside swdconBusyIdle
-#endif
-    while (txHeadNext==txTail) {
-      // wait for send to finish as buffer is about to overflow
-      if (jshIsInInterrupt()) {
-        // if we're printing from an IRQ, don't wait - it's unlikely TX will ever finish
-        jsErrorFlags |= JSERR_BUFFER_FULL;
-        return;
-      }
-      jshBusyIdle();
-#ifdef USE_SWDCON
-      loopCount++;
-      extern bool swdconBusyIdle(int);
-      if (device == EV_SWDCON) swdconBusyIdle(loopCount);
-#endif
-#ifdef USB
-      // just in case USB was unplugged while we were waiting!
-      if (!jshIsUSBSERIALConnected()) jshTransmitClearDevice(EV_USBSERIAL);
-#endif
-    }
-    if (wasConsoleLimbo && jsiGetConsoleDevice()!=EV_LIMBO) {
-      /* It was 'Limbo', but now it's not - see jsiOneSecondAfterStartup.
-      Basically we must have printed a bunch of stuff to LIMBO and blocked
-      with our output buffer full. But then jsiOneSecondAfterStartup
-      switches to the right console device and swaps everything we wrote
-      over to that device too. Only we're now here, still writing to the
-      old device when really we should be writing to the new one. */
-      device = jsiGetConsoleDevice();
-    }
-    jsiSetBusy(BUSY_TRANSMIT, false);
-  }
-  // Save the device and data for the new character to be transmitted.
-  txBuffer[txHead].flags = device;
-  txBuffer[txHead].data = data;
-  txHead = txHeadNext;
+  return device==EV_NONE;
+}
 
+/**
+ * Queue a character for transmission.
+ */
+void jshTransmit(
+    IOEventFlags device, //!< The device to be used for transmission.
+    unsigned char data   //!< The character to transmit.
+  ) {
+  if (jshTransmitDirect(device, &data, 1)) return;
+  while (!jshTransmitToRing(device, &data, 1))
+    if (!jshTransmitWaitForSpace(&device)) return;
   jshUSARTKick(device); // set up interrupts if required
 }
 
+/**
+ * Queue a block of data for transmission. This is copied straight into the
+ * device's buffer rather than going through jshTransmit a byte at a time.
+ */
+void jshTransmitBuf(
+    IOEventFlags device,       //!< The device to be used for transmission.
+    const unsigned char *data, //!< The data to transmit.
+    unsigned int length        //!< The number of bytes to transmit.
+  ) {
+  if (jshTransmitDirect(device, data, length)) return;
+  while (length) {
+    unsigned int n = jshTransmitToRing(device, data, length);
+    if (!n) {
+      if (!jshTransmitWaitForSpace(&device)) return;
+      continue;
+    }
+    data += n;
+    length -= n;
+    jshUSARTKick(device); // set up interrupts if required
+  }
+}
+
 static void jshTransmitPrintfCallback(const char *str, void *user_data) {
   IOEventFlags device = (IOEventFlags)user_data;
-  while (*str) jshTransmit(device, (unsigned char)*(str++));
+  jshTransmitBuf(device, (const unsigned char *)str, (unsigned int)strlen(str));
 }
 
 void jshTransmitPrintf(IOEventFlags device, const char *fmt, ...) {
@@ -315,10 +418,12 @@ void jshTransmitPrintf(IOEventFlags device, const char *fmt, ...) {
   va_end(argp);
 }
 
-// Return the device at the top of the transmit queue (or EV_NONE)
+// Return a device that has data waiting to be transmitted (or EV_NONE)
 IOEventFlags jshGetDeviceToTransmit() {
-  if (!jshHasTransmitData()) return EV_NONE;
-  return IOEVENTFLAGS_GETTYPE(txBuffer[txTail].flags);
+  for (int i=0;i<TXRINGCOUNT;i++)
+    if (txRings[i].head != txRings[i].tail)
+      return IOEVENTFLAGS_GETTYPE(txRings[i].device);
+  return EV_NONE;
 }
 
 /**
@@ -338,26 +443,59 @@ int jshGetCharToTransmit(IOEventFlags device) {
     }
   }
 
-  unsigned char tempTail = txTail;
-  while (txHead != tempTail) {
-    if (IOEVENTFLAGS_GETTYPE(txBuffer[tempTail].flags) == device) {
-      unsigned char data = txBuffer[tempTail].data;
-      if (tempTail != txTail) { // so we weren't right at the back of the queue
-        // we need to work back from tempTail (until we hit tail), shifting everything forwards
-        unsigned char this = tempTail;
-        unsigned char last = (unsigned char)((this+TXBUFFERMASK)&TXBUFFERMASK);
-        while (this!=txTail) { // if this==txTail, then last is before it, so stop here
-          txBuffer[this] = txBuffer[last];
-          this = last;
-          last = (unsigned char)((this+TXBUFFERMASK)&TXBUFFERMASK);
-        }
-      }
-      txTail = (unsigned char)((txTail+1)&TXBUFFERMASK); // advance the tail
-      return data; // return data
-    }
-    tempTail = (unsigned char)((tempTail+1)&TXBUFFERMASK);
+  TxRing *ring = jshTransmitGetRing(device);
+  if (!ring) return -1; // no data :(
+  unsigned char tail = ring->tail;
+  if (tail == ring->head) return -1; // no data :(
+  unsigned char data = ring->data[tail];
+  ring->tail = (unsigned char)((tail+1)&TXBUFFERMASK); // advance the tail
+  return data; // return data
+}
+
+/** Get a pointer to the next contiguous block of data waiting to be
+ * transmitted on a device, so it can be sent (or DMA'd) without copying.
+ * Returns the number of bytes (0 if none). Once sent, call
+ * jshTransmitSpanDone with the number of bytes that were used.
+ *
+ * This doesn't return XON/XOFF characters, so devices with software flow
+ * control should use jshGetDataToTransmit or jshGetCharToTransmit. */
+unsigned int jshGetTransmitSpan(IOEventFlags device, const unsigned char **data) {
+  TxRing *ring = jshTransmitGetRing(device);
+  if (!ring) return 0;
+  unsigned char head = ring->head;
+  unsigned char tail = ring->tail;
+  if (head == tail) return 0;
+  *data = (const unsigned char *)&ring->data[tail];
+  return (head > tail) ? (unsigned int)(head - tail) : (unsigned int)(TXBUFFERMASK+1-tail);
+}
+
+/// Remove 'length' bytes from the data returned by jshGetTransmitSpan
+void jshTransmitSpanDone(IOEventFlags device, unsigned int length) {
+  TxRing *ring = jshTransmitGetRing(device);
+  if (!ring) return;
+  unsigned int used = jshTransmitRingUsed(ring);
+  if (length > used) length = used; // the device might have been cleared
+  ring->tail = (unsigned char)((ring->tail+length)&TXBUFFERMASK);
+}
+
+/** Copy up to maxLength bytes of data to transmit on a device into 'data',
+ * removing them from the transmit buffer. Returns the number of bytes copied */
+unsigned int jshGetDataToTransmit(IOEventFlags device, unsigned char *data, unsigned int maxLength) {
+  unsigned int length = 0;
+  // XON/XOFF come first
+  if (DEVICE_HAS_DEVICE_STATE(device) && maxLength &&
+      (jshSerialDeviceStates[TO_SERIAL_DEVICE_STATE(device)]&(SDS_XOFF_PENDING|SDS_XON_PENDING)))
+    data[length++] = (unsigned char)jshGetCharToTransmit(device);
+  while (length < maxLength) {
+    const unsigned char *span;
+    unsigned int n = jshGetTransmitSpan(device, &span);
+    if (!n) break;
+    if (n > maxLength-length) n = maxLength-length;
+    memcpy(&data[length], span, n);
+    jshTransmitSpanDone(device, n);
+    length += n;
   }
-  return -1; // no data :(
+  return length;
 }
 
 /// Wait for all data in the transmit queue to be written
@@ -370,19 +508,9 @@ void jshTransmitFlush() {
 /// Wait for all data in the transmit queue to be written for a specific device - this can hang if the device isn't being emptied!
 void jshTransmitFlushDevice(IOEventFlags device) {
   jsiSetBusy(BUSY_TRANSMIT, true);
-  bool deviceHasData = false;
-  do {
-    deviceHasData = false;
-    // Check TX queue to see if there is any data to send
-    unsigned char tempTail = txTail;
-    while (txHead != tempTail) {
-      if (IOEVENTFLAGS_GETTYPE(txBuffer[tempTail].flags) == device) {
-        deviceHasData = true;
-        break;
-      }
-      tempTail = (unsigned char)((tempTail+1)&TXBUFFERMASK);
-    }
-  } while (deviceHasData);
+  TxRing *ring;
+  // Check TX queue to see if there is any data to send
+  while ((ring = jshTransmitGetRing(device)) && ring->head != ring->tail) ;
   jsiSetBusy(BUSY_TRANSMIT, false);
 }
 
@@ -392,7 +520,11 @@ void jshTransmitFlushDevice(IOEventFlags device) {
 void jshTransmitClearDevice(
     IOEventFlags device //!< The device to be cleared.
   ) {
-  // Keep requesting a character to transmit until there are no further characters.
+  jshInterruptOff();
+  TxRing *ring = jshTransmitGetRing(device);
+  if (ring) ring->tail = ring->head;
+  jshInterruptOn();
+  // Get rid of any XON/XOFF that was waiting too
   while (jshGetCharToTransmit(device)>=0);
 }
 
@@ -407,14 +539,28 @@ void jshTransmitMove(IOEventFlags from, IOEventFlags to) {
       c = jshGetCharToTransmit(from);
     }
   } else {
-    // Otherwise just rename the contents of the buffer
     jshInterruptOff();
-    unsigned char tempTail = txTail;
-    while (tempTail != txHead) {
-      if (IOEVENTFLAGS_GETTYPE(txBuffer[tempTail].flags) == from) {
-        txBuffer[tempTail].flags = (txBuffer[tempTail].flags&~EV_TYPE_MASK) | to;
+    TxRing *fromRing = jshTransmitGetRing(from);
+    if (fromRing && fromRing->head != fromRing->tail) {
+      TxRing *toRing = jshTransmitGetRing(to);
+      if (!toRing || toRing->head == toRing->tail) {
+        // Nothing waiting for 'to', so just give it our buffer
+        if (toRing) toRing->device = EV_NONE;
+        fromRing->device = to;
+      } else {
+        // Otherwise add our data to the end of what's there
+        while (fromRing->head != fromRing->tail) {
+          unsigned char headNext = (unsigned char)((toRing->head+1)&TXBUFFERMASK);
+          if (headNext == toRing->tail) {
+            jsErrorFlags |= JSERR_BUFFER_FULL;
+            break;
+          }
+          toRing->data[toRing->head] = fromRing->data[fromRing->tail];
+          toRing->head = headNext;
+          fromRing->tail = (unsigned char)((fromRing->tail+1)&TXBUFFERMASK);
+        }
+        fromRing->tail = fromRing->head; // anything that didn't fit is lost
       }
-      tempTail = (unsigned char)((tempTail+1)&TXBUFFERMASK);
     }
     jshInterruptOn();
   }
@@ -425,23 +571,34 @@ void jshTransmitMove(IOEventFlags from, IOEventFlags to) {
  * \return True if we have data to transmit and false otherwise.
  */
 bool jshHasTransmitData() {
-  return txHead != txTail;
+  for (int i=0;i<TXRINGCOUNT;i++)
+    if (txRings[i].head != txRings[i].tail)
+      return true;
+  return false;
 }
 
 /** Returns the number of bytes currently used in the transmit buffer */
 int jshGetTransmitBufferUsage() {
-  if (txHead > txTail)
-    return (TXBUFFERMASK+1) - (txHead - txTail);
-  else
-    return txTail - txHead;
+  unsigned int used = 0;
+  for (int i=0;i<TXRINGCOUNT;i++)
+    used += jshTransmitRingUsed(&txRings[i]);
+  return (int)used;
 }
 
 /**
- * flag that the buffer has overflowed.
+ * flag that the buffer has overflowed, and that 'count' events (or characters) were lost for 'channel'
  */
-void CALLED_FROM_INTERRUPT jshIOEventOverflowed() {
+static void CALLED_FROM_INTERRUPT jshIOEventOverflowed(IOEventFlags channel, unsigned int count) {
   // Error here - just set flag so we don't dump a load of data out
   jsErrorFlags |= JSERR_RX_FIFO_FULL;
+  unsigned int drops = ioStats.drops[IOEVENTFLAGS_GETTYPE(channel)] + count;
+  ioStats.drops[IOEVENTFLAGS_GETTYPE(channel)] = (uint16_t)((drops>0xFFFF) ? 0xFFFF : drops);
+}
+
+/// Update the high water mark of ioBuffer - call after adding data
+static ALWAYS_INLINE void jshIOEventUpdateHighWater() {
+  IOBufferIdx used = (IOBufferIdx)((ioHead-ioTail) & IOBUFFERMASK);
+  if (used > ioStats.highWater) ioStats.highWater = used;
 }
 
 /// Push an IO event (max IOEVENT_MAX_LEN) into the ioBuffer (designed to be called from IRQ), returns true on success, Calls jshHadEvent();
@@ -459,7 +616,7 @@ bool CALLED_FROM_INTERRUPT jshPushEvent(IOEventFlags evt, uint8_t *data, unsigne
   jshInterruptOff();
   if (jshGetIOCharEventsFree() < (int)length+2) {
     jshInterruptOn();
-    jshIOEventOverflowed();
+    jshIOEventOverflowed(evt, DEVICE_IS_SERIAL(IOEVENTFLAGS_GETTYPE(evt)) ? length : 1);
     return false; // queue full - dump this event!
   }
   IOBufferIdx idx = ioHead;
@@ -473,6 +630,7 @@ bool CALLED_FROM_INTERRUPT jshPushEvent(IOEventFlags evt, uint8_t *data, unsigne
   }
   ioLastHead = ioHead;
   ioHead = idx;
+  jshIOEventUpdateHighWater();
   jshInterruptOn();
   jshHadEvent();
   return true;
@@ -513,6 +671,7 @@ void jshPushIOCharEvents(IOEventFlags channel, const char *data, unsigned int co
       ioBuffer[ioHead] = (uint8_t)data[i];
       ioHead = (ioHead+1) & IOBUFFERMASK;
     }
+    jshIOEventUpdateHighWater();
   } else {
     // Push the event (split into IOEVENT_MAX_LEN chunks just in case)
     while (count) {
@@ -610,6 +769,58 @@ IOEventFlags jshPopIOEvent(uint8_t *data, unsigned int *length) {
   return evt;
 }
 
+/** Pop as many whole events as will fit into 'data' (which must be
+IOEVENT_BATCH_LEN bytes). Events are stored in the same format as ioBuffer
+(length, flags, then data) but without wrapping around, and consecutive
+character events for the same device are joined into one event (of up to
+255 bytes). Sets *length to the number of bytes written to 'data', and
+returns the number of bytes that were freed in ioBuffer (0 if no events). */
+unsigned int jshPopIOEvents(uint8_t *data, unsigned int *length) {
+  *length = 0;
+  // Work out how many events we can take
+  jshInterruptOff();
+  IOBufferIdx tail = ioTail;
+  IOBufferIdx end = tail;
+  unsigned int count = 0;
+  while (end != ioHead) {
+    unsigned int eventSize = (unsigned int)ioBuffer[end]+2;
+    if (count+eventSize > IOEVENT_BATCH_LEN) break;
+    count += eventSize;
+    end = (IOBufferIdx)((end+eventSize) & IOBUFFERMASK);
+  }
+  /* If jshPushIOCharEvents could append characters to an event we're
+  taking, stop it (it'll start a new event instead) */
+  if (ioLastHead!=ioHead && ((ioLastHead-tail)&IOBUFFERMASK) < count)
+    ioLastHead = ioHead;
+  jshInterruptOn();
+  if (!count) return 0;
+  // Copy the data out (in 2 parts if it wraps around)
+  unsigned int firstPart = IOBUFFERMASK+1-(unsigned int)tail;
+  if (firstPart > count) firstPart = count;
+  memcpy(data, (uint8_t*)&ioBuffer[tail], firstPart);
+  memcpy(&data[firstPart], (uint8_t*)&ioBuffer[0], count-firstPart);
+  ioTail = end;
+  // Join consecutive character events for the same device
+  unsigned int in = 0, out = 0, last = 0;
+  while (in < count) {
+    unsigned int eventLen = data[in];
+    IOEventFlags evt = (IOEventFlags)data[in+1];
+    if (out && data[last+1]==evt && DEVICE_IS_SERIAL(IOEVENTFLAGS_GETTYPE(evt)) &&
+        data[last]+eventLen <= 255) {
+      memmove(&data[out], &data[in+2], eventLen);
+      data[last] = (uint8_t)(data[last]+eventLen);
+      out += eventLen;
+    } else {
+      if (in!=out) memmove(&data[out], &data[in], eventLen+2);
+      last = out;
+      out += eventLen+2;
+    }
+    in += eventLen+2;
+  }
+  *length = out;
+  return count;
+}
+
 // pop an IO event of type eventType, returns event type on success,EV_NONE on failure. data must be IOEVENT_MAX_LEN bytes
 IOEventFlags jshPopIOEventOfType(IOEventFlags eventType, uint8_t *data, unsigned int *length) {
   IOBufferIdx i = ioTail;
@@ -675,6 +886,14 @@ int jshGetEventsUsed() {
   return spaceUsed;
 }
 
+/// Get statistics about the IO event buffer (and reset them if 'reset' is true)
+void jshGetIOEventStats(JshIOEventStats *stats, bool reset) {
+  jshInterruptOff();
+  memcpy(stats, (JshIOEventStats*)&ioStats, sizeof(JshIOEventStats));
+  if (reset) memset((JshIOEventStats*)&ioStats, 0, sizeof(JshIOEventStats));
+  jshInterruptOn();
+}
+
 int jshGetIOCharEventsFree() {
   int spaceLeft = IOBUFFERMASK+1-jshGetEventsUsed();
   return spaceLeft-4; // be sensible - leave a little spare
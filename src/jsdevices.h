@@ -185,6 +185,17 @@ typedef enum {
 #define IOEVENT_MAX_LEN (NRF_SDH_BLE_GATT_MAX_MTU_SIZE+3)
 #endif
 
+#ifndef IOEVENT_BATCH_LEN
+/// How many bytes of events jshPopIOEvents can return at once (must be at least IOEVENT_MAX_LEN+2)
+#define IOEVENT_BATCH_LEN (2*(IOEVENT_MAX_LEN+2))
+#endif
+
+/// Statistics about the IO event buffer (see E.getIOStats)
+typedef struct {
+  uint16_t highWater; ///< The most bytes that have been used in the IO event buffer
+  uint16_t drops[EV_TYPE_MASK+1]; ///< For each device, the number of events (or characters for serial devices) lost because the buffer was full
+} JshIOEventStats;
+
 #include "jspin.h"
 
 /// Push an IO event (max IOEVENT_MAX_LEN) into the ioBuffer (designed to be called from IRQ), returns true on success, Calls jshHadEvent();
@@ -207,6 +218,9 @@ void jshDumpIOEvents();
 IOEventFlags jshPopIOEvent(uint8_t *data, unsigned int *length);
 // pop an IO event of type eventType, returns event type on success,EV_NONE on failure. data must be IOEVENT_MAX_LEN bytes
 IOEventFlags jshPopIOEventOfType(IOEventFlags eventType, uint8_t *data, unsigned int *length);
+/** pop as many events as will fit into data (IOEVENT_BATCH_LEN bytes) with character events for the same device joined.
+ * Sets length to the bytes written to data and returns the bytes freed in the event buffer (0 if no events) */
+unsigned int jshPopIOEvents(uint8_t *data, unsigned int *length);
 /// Do we have any events pending? Will jshPopIOEvent return true?
 bool jshHasEvents();
 /// Check if the top event is for the given device
@@ -219,6 +233,8 @@ int jshGetEventsUsed();
 bool jshHasEventSpaceForChars(int n);
 /// How many characters can we write?
 int jshGetIOCharEventsFree();
+/// Get statistics about the IO event buffer (and reset them if 'reset' is true)
+void jshGetIOEventStats(JshIOEventStats *stats, bool reset);
 
 const char *jshGetDeviceString(IOEventFlags device);
 IOEventFlags jshFromDeviceString(const char *device);
@@ -228,8 +244,15 @@ JsVar *jshGetDeviceObject(IOEventFlags device);
 
 // ----------------------------------------------------------------------------
 //                                                         DATA TRANSMIT BUFFER
+#ifndef TXRINGCOUNT
+/** How many devices can have data waiting to be transmitted at once (each gets TXBUFFERMASK+1 bytes).
+ * If the console has nothing waiting, one ring is always kept free for it */
+#define TXRINGCOUNT 2
+#endif
 /// Queue a character for transmission
 void jshTransmit(IOEventFlags device, unsigned char data);
+/// Queue a block of data for transmission
+void jshTransmitBuf(IOEventFlags device, const unsigned char *data, unsigned int length);
 // Queue a formatted string for transmission
 void jshTransmitPrintf(IOEventFlags device, const char *fmt, ...);
 /// Wait for transmit to finish
@@ -244,10 +267,16 @@ void jshTransmitMove(IOEventFlags from, IOEventFlags to);
 bool jshHasTransmitData();
 /** Returns the number of bytes currently used in the transmit buffer */
 int jshGetTransmitBufferUsage();
-// Return the device at the top of the transmit queue (or EV_NONE)
+// Return a device that has data waiting to be transmitted (or EV_NONE)
 IOEventFlags jshGetDeviceToTransmit();
 /// Try and get a character for transmission - could just return -1 if nothing
 int jshGetCharToTransmit(IOEventFlags device);
+/// Get a pointer to the next contiguous block of data to transmit on a device and return its length (0 if none). Doesn't include XON/XOFF
+unsigned int jshGetTransmitSpan(IOEventFlags device, const unsigned char **data);
+/// Remove 'length' bytes returned by jshGetTransmitSpan from the transmit buffer, once they have been sent
+void jshTransmitSpanDone(IOEventFlags device, unsigned int length);
+/// Copy up to maxLength bytes of data to transmit on a device (including XON/XOFF) into 'data', returning the amount copied
+unsigned int jshGetDataToTransmit(IOEventFlags device, unsigned char *data, unsigned int maxLength);
 
 
 /// Set whether the host should transmit or not
@@ -41,6 +41,9 @@
 #ifndef SAVE_ON_FLASH
 #include "compress_heatshrink.h" // for allowing transfer of compressed packets
 #endif
+#ifdef USE_GRAPHICS
+#include "glyph_cache.h" // glyphCacheFree
+#endif
 
 #ifdef ARM
 #define CHAR_DELETE_SEND 0x08
@@ -112,6 +115,30 @@ Espruino.Core.Serial.write("\x10\x01\x80\x0Bhello world")
 JsVar *events = 0; // Array of events to execute
 JsVar *timerArray = 0; // Linked List of timers to check and run
 JsVar *watchArray = 0; // Linked List of input watches to check and run
+
+/// An entry in the timer queue - when a timer in timerArray is due
+typedef struct {
+  JsSysTime time; ///< The timer's "time" when this entry was added. If the timer's time has changed since, this entry is stale
+  JsVarInt id;    ///< The timer's index in timerArray
+} PACKED_FLAGS JsiTimerQueueEntry;
+static JsVar *timerQueue = 0; ///< Flat string containing a binary heap of JsiTimerQueueEntry, earliest first
+static unsigned int timerQueueCount = 0; ///< How many entries are in timerQueue
+/// When jsiLastIdleTime gets this far past jsiTimerBaseTime we make the timers' times relative to it again
+#define JSI_TIMER_REBASE_TIME jshGetTimeFromMilliseconds(60*1000)
+
+/// A watch in watchArray, with the settings we need when an event comes in for its pin
+typedef struct {
+  JsVarRef watch;    ///< The watch object. This is locked while it's in watchTable
+  Pin pin;
+  signed char edge;  ///< 1 = rising, -1 = falling, 0 = both
+  bool recur;        ///< Does the watch repeat?
+  JsVarInt debounce; ///< Debounce time (in JsSysTime units) or 0
+} PACKED_FLAGS JsiWatchRecord;
+#define JSI_WATCH_CHANNELS (EV_EXTI_MAX+1-EV_EXTI0)
+static JsVar *watchTable = 0; ///< Flat string of JsiWatchRecord, grouped by the EV_EXTIx channel that they're for
+static uint16_t watchTableStart[JSI_WATCH_CHANNELS+1]; ///< Index of the first record in watchTable for each channel
+static bool watchTableChanged = true; ///< watchArray has changed since watchTable was built
+static bool watchTableInUse = false; ///< We're dispatching an event with watchTable, so it can't be freed
 // ----------------------------------------------------------------------------
 IOEventFlags consoleDevice = DEFAULT_CONSOLE_DEVICE; ///< The console device for user interaction
 #ifndef SAVE_ON_FLASH
@@ -120,6 +147,7 @@ Pin pinSleepIndicator = DEFAULT_SLEEP_PIN_INDICATOR;
 #endif
 JsiStatus jsiStatus = 0;
 JsSysTime jsiLastIdleTime;  ///< The last time we went around the idle loop - use this for timers
+JsSysTime jsiTimerBaseTime; ///< Timers' "time" is relative to this, so it doesn't need changing every time around the idle loop
 #ifndef EMBEDDED
 uint32_t jsiTimeSinceCtrlC; ///< When was Ctrl-C last pressed. We use this so we quit on desktop when we do Ctrl-C + Ctrl-C
 #endif
@@ -492,6 +520,193 @@ void jsiSetSleep(JsiSleepType isSleep) {
 }
 
 // Used when recovering after being flashed
+// ----------------------------------------------------------------------------
+/* To avoid looking at every timer each time around the idle loop we keep a
+ * binary heap of when each timer in timerArray is due. Entries aren't removed
+ * when a timer is cleared or changed - instead, when an entry gets to the top
+ * of the heap we check it still matches the timer's "time" and discard it if
+ * not. The heap isn't saved - it is rebuilt from timerArray when we start. */
+
+static ALWAYS_INLINE JsiTimerQueueEntry *jsiTimerQueueGetEntries() {
+  return (JsiTimerQueueEntry*)jsvGetFlatStringPointer(timerQueue);
+}
+
+static unsigned int jsiTimerQueueGetCapacity() {
+  if (!timerQueue) return 0;
+  return (unsigned int)(jsvGetCharactersInVar(timerQueue) / sizeof(JsiTimerQueueEntry));
+}
+
+/// Is a due before b? Timers due at the same time run in the order they were added
+static ALWAYS_INLINE bool jsiTimerQueueIsBefore(const JsiTimerQueueEntry *a, const JsiTimerQueueEntry *b) {
+  return a->time < b->time || (a->time == b->time && a->id < b->id);
+}
+
+/// Add an entry to the heap - there must be space for it
+static void jsiTimerQueuePushEntry(JsVarInt id, JsSysTime time) {
+  JsiTimerQueueEntry *entries = jsiTimerQueueGetEntries();
+  JsiTimerQueueEntry entry = { .time = time, .id = id };
+  unsigned int i = timerQueueCount++;
+  while (i) {
+    unsigned int parent = (i-1)>>1;
+    if (!jsiTimerQueueIsBefore(&entry, &entries[parent])) break;
+    entries[i] = entries[parent];
+    i = parent;
+  }
+  entries[i] = entry;
+}
+
+/// Remove the first entry from the heap
+static void jsiTimerQueuePop() {
+  JsiTimerQueueEntry *entries = jsiTimerQueueGetEntries();
+  JsiTimerQueueEntry entry = entries[--timerQueueCount];
+  unsigned int i = 0;
+  while (true) {
+    unsigned int child = i*2+1;
+    if (child >= timerQueueCount) break;
+    if (child+1 < timerQueueCount && jsiTimerQueueIsBefore(&entries[child+1], &entries[child]))
+      child++;
+    if (!jsiTimerQueueIsBefore(&entries[child], &entry)) break;
+    entries[i] = entries[child];
+    i = child;
+  }
+  entries[i] = entry;
+}
+
+/// Rebuild the heap from timerArray (dropping stale entries), with space for at least 'extra' more
+static void jsiTimerQueueRebuild(unsigned int extra) {
+  timerQueueCount = 0;
+  if (!timerArray) return;
+  unsigned int needed = (unsigned int)jsvGetChildren(timerArray) + extra;
+  unsigned int capacity = 8;
+  while (capacity < needed*2) capacity <<= 1; // leave room for stale entries
+  unsigned int oldCapacity = jsiTimerQueueGetCapacity();
+  if (oldCapacity < capacity || oldCapacity > capacity*4) {
+    jsvUnLock(timerQueue);
+    timerQueue = jsvNewFlatStringOfLength((unsigned int)(capacity*sizeof(JsiTimerQueueEntry)));
+    // if this fails, jsiIdle will try again
+    if (!timerQueue) return;
+  }
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, timerArray);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
+    JsVarInt id = jsvGetIntegerAndUnLock(jsvObjectIteratorGetKey(&it));
+    JsSysTime timerTime = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time"));
+    jsiTimerQueuePushEntry(id, timerTime);
+    jsvUnLock(timerPtr);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+}
+
+/// Add an entry to the heap for the timer at index 'id' in timerArray, which is now due at 'time'
+static void jsiTimerQueueAdd(JsVarInt id, JsSysTime time) {
+  if (timerQueueCount >= jsiTimerQueueGetCapacity()) {
+    // the rebuilt heap will already contain this timer if it's in timerArray, but a duplicate does no harm
+    jsiTimerQueueRebuild(1);
+    if (timerQueueCount >= jsiTimerQueueGetCapacity()) return; // out of memory
+  }
+  jsiTimerQueuePushEntry(id, time);
+}
+
+/// Make timers' "time" relative to jsiLastIdleTime again, so the values stay small (and are right when saved)
+static void jsiTimersRebase() {
+  JsSysTime offset = jsiLastIdleTime - jsiTimerBaseTime;
+  jsiTimerBaseTime = jsiLastIdleTime;
+  if (!offset) return;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, timerArray);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
+    JsSysTime timerTime = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time"));
+    jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(timerTime - offset));
+    jsvUnLock(timerPtr);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  // everything moves by the same amount, so the heap stays in order
+  JsiTimerQueueEntry *entries = jsiTimerQueueGetEntries();
+  for (unsigned int i=0;i<timerQueueCount;i++)
+    entries[i].time -= offset;
+}
+
+static ALWAYS_INLINE JsiWatchRecord *jsiWatchTableGetRecords() {
+  return (JsiWatchRecord*)jsvGetFlatStringPointer(watchTable);
+}
+
+/// Free watchTable, unlocking all the watches in it
+static void jsiWatchTableFree() {
+  if (watchTable) {
+    JsiWatchRecord *records = jsiWatchTableGetRecords();
+    for (unsigned int i=0;i<watchTableStart[JSI_WATCH_CHANNELS];i++)
+      jsvUnLock(_jsvGetAddressOf(records[i].watch));
+    jsvUnLock(watchTable);
+    watchTable = 0;
+  }
+  memset(watchTableStart, 0, sizeof(watchTableStart));
+}
+
+/// Return the EV_EXTIx channel (from 0) that events for this pin will come in on, or -1
+static int jsiWatchGetChannel(Pin pin) {
+  for (int channel=0;channel<JSI_WATCH_CHANNELS;channel++)
+    if (jshIsEventForPin((IOEventFlags)(EV_EXTI0+channel), pin))
+      return channel;
+  return -1;
+}
+
+/// Rebuild watchTable from watchArray
+static void jsiWatchTableRebuild() {
+  jsiWatchTableFree();
+  watchTableChanged = false;
+  if (!watchArray) return;
+  // count how many watches there are for each channel
+  uint16_t counts[JSI_WATCH_CHANNELS];
+  memset(counts, 0, sizeof(counts));
+  unsigned int count = 0;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, watchArray);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *watchPtr = jsvObjectIteratorGetValue(&it);
+    int channel = jsiWatchGetChannel(jshGetPinFromVarAndUnLock(jsvObjectGetChildIfExists(watchPtr, "pin")));
+    if (channel>=0) {
+      counts[channel]++;
+      count++;
+    }
+    jsvUnLock(watchPtr);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  if (!count) return;
+  watchTable = jsvNewFlatStringOfLength((unsigned int)(count*sizeof(JsiWatchRecord)));
+  if (!watchTable) {
+    watchTableChanged = true; // try again next time
+    return;
+  }
+  // work out where each channel starts, then fill in the records
+  for (int channel=0;channel<JSI_WATCH_CHANNELS;channel++)
+    watchTableStart[channel+1] = (uint16_t)(watchTableStart[channel] + counts[channel]);
+  uint16_t next[JSI_WATCH_CHANNELS];
+  memcpy(next, watchTableStart, sizeof(next));
+  JsiWatchRecord *records = jsiWatchTableGetRecords();
+  jsvObjectIteratorNew(&it, watchArray);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *watchPtr = jsvObjectIteratorGetValue(&it);
+    Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChildIfExists(watchPtr, "pin"));
+    int channel = jsiWatchGetChannel(pin);
+    if (channel>=0) {
+      JsiWatchRecord *record = &records[next[channel]++];
+      record->watch = jsvGetRef(jsvLockAgain(watchPtr)); // keep it locked while it's in the table
+      record->pin = pin;
+      record->edge = (signed char)jsvObjectGetIntegerChild(watchPtr, "edge");
+      record->recur = jsvObjectGetBoolChild(watchPtr, "recur");
+      record->debounce = jsvObjectGetIntegerChild(watchPtr, "debounce");
+    }
+    jsvUnLock(watchPtr);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+}
+
 // 'claim' anything we are using
 void jsiSoftInit(bool hasBeenReset) {
   jsErrorFlags = 0;
@@ -515,6 +730,9 @@ void jsiSoftInit(bool hasBeenReset) {
   // Make sure we set up lastIdleTime, as this could be used
   // when adding an interval from onInit (called below)
   jsiLastIdleTime = jshGetSystemTime();
+  // Saved timers' times are relative to when we last went around the idle loop
+  jsiTimerBaseTime = jsiLastIdleTime;
+  jsiTimerQueueRebuild(0);
 #ifndef EMBEDDED
   jsiTimeSinceCtrlC = 0xFFFFFFFF;
 #endif
@@ -800,9 +1018,13 @@ void jsiSoftKill() {
     events=0;
   }
   if (timerArray) {
+    jsiTimersRebase(); // so timers' times are relative to jsiLastIdleTime when saved
     jsvUnLock(timerArray);
     timerArray=0;
   }
+  jsvUnLock(timerQueue);
+  timerQueue = 0;
+  timerQueueCount = 0;
   if (watchArray) {
     // Check any existing watches and disable interrupts for them
     JsvObjectIterator it;
@@ -818,6 +1040,8 @@ void jsiSoftKill() {
     jsvUnLock(watchArray);
     watchArray=0;
   }
+  jsiWatchTableFree();
+  watchTableChanged = true;
   // Save flags if required
   if (jsFlags)
     jsvObjectSetIntChild(execInfo.hiddenRoot, JSI_JSFLAGS_NAME, jsFlags);
@@ -1051,6 +1275,10 @@ bool jsiFreeMoreMemory() {
 #ifdef USE_DEBUGGER
   // remove debug history first
   jsvObjectRemoveChild(execInfo.hiddenRoot, JSI_DEBUG_HISTORY_NAME);
+#endif
+#if defined(USE_GRAPHICS) && defined(GRAPHICS_GLYPH_CACHE_SIZE)
+  // the glyph cache only makes text faster, and is recreated when needed
+  if (glyphCacheFree()) return true;
 #endif
   // delete history one item at a time
   JsVar *history = jsvObjectGetChildIfExists(execInfo.hiddenRoot, JSI_HISTORY_NAME);
@@ -2236,6 +2464,13 @@ bool jsiIsWatchingPin(Pin pin) {
   return isWatched;
 }
 
+void jsiWatchesChanged() {
+  watchTableChanged = true;
+  /* Free the table now rather than when the next pin event comes in (which may be never),
+   * so removed watches (and their callbacks) aren't kept locked */
+  if (!watchTableInUse) jsiWatchTableFree();
+}
+
 void jsiCtrlC() {
   // If password protected or currently uploading a packet, don't let Ctrl-C break out of running code!
   if (jsiPasswordProtected() || IS_PACKET_TRANSFER(inputState))
@@ -2269,13 +2504,33 @@ void jsiIdle() {
   // Handle hardware-related idle stuff (like checking for pin events)
   bool wasBusy = false;
   IOEventFlags eventFlags;
-  uint8_t eventData[IOEVENT_MAX_LEN];
-  unsigned int eventLen;
+  /* Static rather than on the stack, as JS callbacks for the events run from here and need all
+   * the stack they can get. jsiIdle is only called from jsiLoop, so is never re-entered */
+  static uint8_t eventBatch[IOEVENT_BATCH_LEN];
+  static uint32_t eventDataAligned[(IOEVENT_MAX_LEN+3)/4]; // so event handlers can read words from the data
+  uint8_t *eventData;
+  unsigned int eventLen, batchLen = 0, batchIdx = 0;
   // ensure we can't get totally swamped by having more events than we can process.
   // Just process what was in the event queue at the start
   int maxEvents = jshGetEventsUsed();
 
-  while ((maxEvents--)>0 && ((eventFlags=jshPopIOEvent(eventData, &eventLen))!=EV_NONE)) {
+  while (true) {
+    if (batchIdx >= batchLen) { // get the next batch of events
+      if (maxEvents<=0) break;
+      unsigned int eventBytes = jshPopIOEvents(eventBatch, &batchLen);
+      if (!eventBytes) break;
+      maxEvents -= (int)eventBytes;
+      batchIdx = 0;
+    }
+    eventLen = eventBatch[batchIdx];
+    eventFlags = (IOEventFlags)eventBatch[batchIdx+1];
+    eventData = &eventBatch[batchIdx+2];
+    batchIdx += eventLen+2;
+    // Character data is used where it is, but copy everything else so it's aligned
+    if (!DEVICE_IS_SERIAL(IOEVENTFLAGS_GETTYPE(eventFlags))) {
+      memcpy(eventDataAligned, eventData, eventLen);
+      eventData = (uint8_t*)eventDataAligned;
+    }
     jsiSetBusy(BUSY_INTERACTIVE, true);
     wasBusy = true;
 
@@ -2290,7 +2545,7 @@ void jsiIdle() {
       // ------------------------------------------------------------------------ SERIAL CALLBACK
       JsVar *usartClass = jsvSkipNameAndUnLock(jsiGetClassNameFromDevice(eventType));
       if (jsvIsObject(usartClass)) {
-        maxEvents -= jsiHandleIOEventForSerial(usartClass, eventFlags, eventData, eventLen);
+        jsiHandleIOEventForSerial(usartClass, eventFlags, eventData, eventLen);
       }
       jsvUnLock(usartClass);
 #if ESPR_USART_COUNT>0
@@ -2312,7 +2567,7 @@ void jsiIdle() {
       jswOnCustomEvent(eventFlags, eventData, eventLen);
 #ifdef BLUETOOTH
     } else if (eventType == EV_BLUETOOTH_PENDING) {
-      maxEvents -= jsble_exec_pending(eventData, eventLen);
+      jsble_exec_pending(eventData, (int)eventLen);
 #endif
 #ifdef BANGLEJS
     } else if (eventType == EV_BANGLEJS) {
@@ -2338,124 +2593,141 @@ void jsiIdle() {
 #endif
     } else if (DEVICE_IS_EXTI(eventType)) { // ---------------------------------------------------------------- PIN WATCH
       // we have an event... find out what it was for...
-      // Check everything in our Watch array
-      JsvObjectIterator it;
-      jsvObjectIteratorNew(&it, watchArray);
-      while (jsvObjectIteratorHasValue(&it)) {
-        bool hasDeletedWatch = false;
-        JsVar *watchPtr = jsvObjectIteratorGetValue(&it);
-        Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChildIfExists(watchPtr, "pin"));
-
-        if (jshIsEventForPin(eventFlags, pin)) {
-          /** Work out event time. Events time is only stored in 32 bits, so we need to
-           * use the correct 'high' 32 bits from the current time.
-           *
-           * We know that the current time is always newer than the event time, so
-           * if the bottom 32 bits of the current time is less than the bottom
-           * 32 bits of the event time, we need to subtract a full 32 bits worth
-           * from the current time.
-           */
-          JsSysTime time = jshGetSystemTime();
-          uint32_t eventTime32 = *(uint32_t*)eventData;
-          if (((uint32_t)time) < eventTime32)
-            time = time - 0x100000000LL;
-          // finally, mask in the event's time
-          JsSysTime eventTime = (time & ~0xFFFFFFFFLL) | (JsSysTime)eventTime32;
-
-          // Now actually process the event
-          bool pinIsHigh = (eventFlags&EV_EXTI_IS_HIGH)!=0;
-          bool ignoreEvent = false;
+      if (watchTableChanged && !watchTableInUse)
+        jsiWatchTableRebuild();
+      /* Callbacks may add or remove watches, but watchTable isn't freed
+       * while watchTableInUse, so the records (and the watches they lock)
+       * stay valid until we're done with them. */
+      bool wasInUse = watchTableInUse;
+      watchTableInUse = true;
+      unsigned int channel = (unsigned int)(eventType - EV_EXTI0);
+      for (unsigned int recordIdx=watchTableStart[channel];recordIdx<watchTableStart[channel+1];recordIdx++) {
+        JsiWatchRecord record = jsiWatchTableGetRecords()[recordIdx];
+        Pin pin = record.pin;
+        JsVar *watchPtr = jsvLock(record.watch);
+        if (watchTableChanged) {
+          // a callback changed the watches - make sure this one wasn't removed
+          JsVar *watchNamePtr = jsvGetIndexOf(watchArray, watchPtr, true);
+          jsvUnLock(watchNamePtr);
+          if (!watchNamePtr) {
+            jsvUnLock(watchPtr);
+            continue;
+          }
+        }
+
+        /** Work out event time. Events time is only stored in 32 bits, so we need to
+         * use the correct 'high' 32 bits from the current time.
+         *
+         * We know that the current time is always newer than the event time, so
+         * if the bottom 32 bits of the current time is less than the bottom
+         * 32 bits of the event time, we need to subtract a full 32 bits worth
+         * from the current time.
+         */
+        JsSysTime time = jshGetSystemTime();
+        uint32_t eventTime32 = *(uint32_t*)eventData;
+        if (((uint32_t)time) < eventTime32)
+          time = time - 0x100000000LL;
+        // finally, mask in the event's time
+        JsSysTime eventTime = (time & ~0xFFFFFFFFLL) | (JsSysTime)eventTime32;
+
+        // Now actually process the event
+        bool pinIsHigh = (eventFlags&EV_EXTI_IS_HIGH)!=0;
+        bool ignoreEvent = false;
 #ifdef BANGLEJS
-          /* This is a bodge for Bangle.js. We want to get events for any button press here so
-          we can keep our debounce state machine up to date, but for some button presses we
-          may not want to actually forward them to user-facing code. */
-          ignoreEvent = (eventFlags&EV_EXTI_DATA_PIN_HIGH)!=0;
-#endif
-
-          bool executeNow = false;
-          JsVarInt debounce = jsvObjectGetIntegerChild(watchPtr, "debounce");
-          if (debounce<=0) {
-            executeNow = !ignoreEvent;
-            jsvObjectSetBoolChild(watchPtr, "state", pinIsHigh); // set the state anyway
-          } else { // Debouncing - use timeouts to ensure we only fire at the right time
-            // store the current state of the pin
-            bool oldWatchState = jsvObjectGetBoolChild(watchPtr, "state");
-            JsVar *timeout = jsvObjectGetChildIfExists(watchPtr, "timeout");
-            if (timeout) { // if we had a timeout, update the callback time
-              JsSysTime timeoutTime = jsiLastIdleTime + (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timeout, "time"));
-              jsvUnLock(jsvObjectSetChild(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiLastIdleTime) + debounce)));
-              jsvObjectSetBoolChild(timeout, "state", pinIsHigh);
-              if (ignoreEvent || ((eventTime > timeoutTime) && (pinIsHigh!=oldWatchState))) {
-                // timeout should have fired, but we didn't get around to executing it!
-                // Do it now (with the old timeout time)
-                executeNow = !ignoreEvent;
-                eventTime = timeoutTime - debounce;
-                jsvObjectSetBoolChild(watchPtr, "state", pinIsHigh);
-                // Remove the timeout
-                jsiClearTimeout(timeout);
-                jsvObjectRemoveChild(watchPtr, "timeout");
-              }
-            } else if (!ignoreEvent && pinIsHigh!=oldWatchState) { // else create a new timeout
-              timeout = jsvNewObject();
-              if (timeout) {
-                jsvObjectSetChild(timeout, "watch", watchPtr); // no unlock
-                jsvObjectSetChildAndUnLock(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiLastIdleTime) + debounce));
-                jsvObjectSetChildAndUnLock(timeout, "cb", jsvObjectGetChildIfExists(watchPtr, "cb"));
-                jsvObjectSetChildAndUnLock(timeout, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
-                jsvObjectSetPinChild(timeout, "pin", pin);
-                jsvObjectSetBoolChild(timeout, "state", pinIsHigh);
-                // Add to timer array
-                jsiTimerAdd(timeout);
-                // Add to our watch
-                jsvObjectSetChild(watchPtr, "timeout", timeout); // no unlock
-              }
-            } else if (ignoreEvent) {
+        /* This is a bodge for Bangle.js. We want to get events for any button press here so
+        we can keep our debounce state machine up to date, but for some button presses we
+        may not want to actually forward them to user-facing code. */
+        ignoreEvent = (eventFlags&EV_EXTI_DATA_PIN_HIGH)!=0;
+#endif
+
+        bool executeNow = false;
+        JsVarInt debounce = record.debounce;
+        if (debounce<=0) {
+          executeNow = !ignoreEvent;
+          jsvObjectSetBoolChild(watchPtr, "state", pinIsHigh); // set the state anyway
+        } else { // Debouncing - use timeouts to ensure we only fire at the right time
+          // store the current state of the pin
+          bool oldWatchState = jsvObjectGetBoolChild(watchPtr, "state");
+          JsVar *timeout = jsvObjectGetChildIfExists(watchPtr, "timeout");
+          if (timeout) { // if we had a timeout, update the callback time
+            JsSysTime timeoutTime = jsiTimerBaseTime + (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timeout, "time"));
+            JsVar *timeoutName = jsvGetIndexOf(timerArray, timeout, true);
+            if (timeoutName)
+              jsiTimerSetTime(timeout, jsvGetInteger(timeoutName), (JsSysTime)(eventTime - jsiTimerBaseTime) + debounce);
+            jsvUnLock(timeoutName);
+            jsvObjectSetBoolChild(timeout, "state", pinIsHigh);
+            if (ignoreEvent || ((eventTime > timeoutTime) && (pinIsHigh!=oldWatchState))) {
+              // timeout should have fired, but we didn't get around to executing it!
+              // Do it now (with the old timeout time)
+              executeNow = !ignoreEvent;
+              eventTime = timeoutTime - debounce;
               jsvObjectSetBoolChild(watchPtr, "state", pinIsHigh);
+              // Remove the timeout
+              jsiClearTimeout(timeout);
+              jsvObjectRemoveChild(watchPtr, "timeout");
             }
-            jsvUnLock(timeout);
+          } else if (!ignoreEvent && pinIsHigh!=oldWatchState) { // else create a new timeout
+            timeout = jsvNewObject();
+            if (timeout) {
+              jsvObjectSetChild(timeout, "watch", watchPtr); // no unlock
+              jsvObjectSetChildAndUnLock(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiTimerBaseTime) + debounce));
+              jsvObjectSetChildAndUnLock(timeout, "cb", jsvObjectGetChildIfExists(watchPtr, "cb"));
+              jsvObjectSetChildAndUnLock(timeout, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
+              jsvObjectSetPinChild(timeout, "pin", pin);
+              jsvObjectSetBoolChild(timeout, "state", pinIsHigh);
+              // Add to timer array
+              jsiTimerAdd(timeout);
+              // Add to our watch
+              jsvObjectSetChild(watchPtr, "timeout", timeout); // no unlock
+            }
+          } else if (ignoreEvent) {
+            jsvObjectSetBoolChild(watchPtr, "state", pinIsHigh);
           }
+          jsvUnLock(timeout);
+        }
 
-          // If we want to execute this watch right now...
-          if (executeNow) {
-            JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(eventTime)/1000);
-            if (jsiShouldExecuteWatch(watchPtr, pinIsHigh)) { // edge triggering
-              JsVar *watchCallback = jsvObjectGetChildIfExists(watchPtr, "cb");
-              bool watchRecurring = jsvObjectGetBoolChild(watchPtr,  "recur");
-              JsVar *data = jsvNewObject();
-              if (data) {
-                jsvObjectSetBoolChild(data, "state", pinIsHigh);
-                jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
-                // set both data.time, and watch.lastTime in one go
-                jsvObjectSetChild(data, "time", timePtr); // no unlock
-                jsvObjectSetPinChild(data, "pin", pin);
-                Pin dataPin = jshGetEventDataPin(eventType);
-                if (jshIsPinValid(dataPin))
-                  jsvObjectSetBoolChild(data, "data", (eventFlags&EV_EXTI_DATA_PIN_HIGH)!=0);
-              }
-              if (!jsiExecuteEventCallback(0, watchCallback, 1, &data) && watchRecurring) {
-                jsError("Ctrl-C while processing watch - removing it.");
-                jsErrorFlags |= JSERR_CALLBACK;
-                watchRecurring = false;
-              }
-              jsvUnLock(data);
-              if (!watchRecurring) {
-                // free all
-                jsvObjectIteratorRemoveAndGotoNext(&it, watchArray);
-                hasDeletedWatch = true;
-                if (!jsiIsWatchingPin(pin))
-                  jshPinWatch(pin, false, JSPW_NONE);
-              }
-              jsvUnLock(watchCallback);
+        // If we want to execute this watch right now...
+        if (executeNow) {
+          JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(eventTime)/1000);
+          if (record.edge==0 || (pinIsHigh && record.edge>0) || (!pinIsHigh && record.edge<0)) { // edge triggering
+            JsVar *watchCallback = jsvObjectGetChildIfExists(watchPtr, "cb");
+            bool watchRecurring = record.recur;
+            JsVar *data = jsvNewObject();
+            if (data) {
+              jsvObjectSetBoolChild(data, "state", pinIsHigh);
+              jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
+              // set both data.time, and watch.lastTime in one go
+              jsvObjectSetChild(data, "time", timePtr); // no unlock
+              jsvObjectSetPinChild(data, "pin", pin);
+              Pin dataPin = jshGetEventDataPin(eventType);
+              if (jshIsPinValid(dataPin))
+                jsvObjectSetBoolChild(data, "data", (eventFlags&EV_EXTI_DATA_PIN_HIGH)!=0);
             }
-            jsvObjectSetChildAndUnLock(watchPtr, "lastTime", timePtr);
+            if (!jsiExecuteEventCallback(0, watchCallback, 1, &data) && watchRecurring) {
+              jsError("Ctrl-C while processing watch - removing it.");
+              jsErrorFlags |= JSERR_CALLBACK;
+              watchRecurring = false;
+            }
+            jsvUnLock(data);
+            if (!watchRecurring) {
+              // free all
+              JsVar *watchNamePtr = jsvGetIndexOf(watchArray, watchPtr, true);
+              if (watchNamePtr)
+                jsvRemoveChildAndUnLock(watchArray, watchNamePtr);
+              jsiWatchesChanged();
+              if (!jsiIsWatchingPin(pin))
+                jshPinWatch(pin, false, JSPW_NONE);
+            }
+            jsvUnLock(watchCallback);
           }
+          jsvObjectSetChildAndUnLock(watchPtr, "lastTime", timePtr);
         }
 
         jsvUnLock(watchPtr);
-        if (!hasDeletedWatch)
-          jsvObjectIteratorNext(&it);
       }
-      jsvObjectIteratorFree(&it);
+      watchTableInUse = wasInUse;
+      if (watchTableChanged && !watchTableInUse)
+        jsiWatchTableFree(); // a callback changed the watches
     }
   }
 
@@ -2477,129 +2749,128 @@ void jsiIdle() {
     jsiTimeSinceCtrlC = 0xFFFFFFFF;
 #endif
 
-  JsvObjectIterator it;
-  // Go through all intervals and decrement time
-  jsvObjectIteratorNew(&it, timerArray);
-  while (jsvObjectIteratorHasValue(&it)) {
-    JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
-    JsSysTime timerTime = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time"));
-    JsSysTime timeUntilNext = timerTime - timePassed;
-    jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(timeUntilNext));
-    jsvUnLock(timerPtr);
-    jsvObjectIteratorNext(&it);
-  }
-  jsvObjectIteratorFree(&it);
-  // Now go through intervals and execute if needed
-  do {
-    jsiStatus = jsiStatus & ~JSIS_TIMERS_CHANGED;
-    jsvObjectIteratorNew(&it, timerArray);
-    while (jsvObjectIteratorHasValue(&it) && !(jsiStatus & JSIS_TIMERS_CHANGED)) {
-      bool hasDeletedTimer = false;
-      JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
-      JsSysTime timerTime = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time"));
-      if (timerTime<=0) {
-        // we're now doing work
-        jsiSetBusy(BUSY_INTERACTIVE, true);
-        wasBusy = true;
-        JsVar *timerCallback = jsvObjectGetChildIfExists(timerPtr, "cb");
-        JsVar *watchPtr = jsvObjectGetChildIfExists(timerPtr, "watch"); // for debounce - may be undefined
-        bool exec = true;
-        JsVar *data = 0;
-        if (watchPtr) {
-          bool watchState = jsvObjectGetBoolChild(watchPtr, "state");
-          bool timerState = jsvObjectGetBoolChild(timerPtr, "state");
-          jsvObjectSetBoolChild(watchPtr, "state", timerState);
-          exec = false;
-          if (watchState!=timerState) {
-            // Create the 'time' variable that will be passed to the user and stored as last time
-            JsVarInt delay = jsvObjectGetIntegerChild(watchPtr, "debounce");
-            JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(jsiLastIdleTime+timerTime-delay)/1000);
-            // If it's the right edge...
-            if (jsiShouldExecuteWatch(watchPtr, timerState)) {
-              data = jsvNewObject();
-              // if we were from a watch then we were delayed by the debounce time...
-              if (data) {
-                exec = true;
-                // if it was a watch, set the last state up
-                jsvObjectSetBoolChild(data, "state", timerState);
-                // set up the lastTime variable of data to what was in the watch
-                jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
-                // set up the watches lastTime to this one
-                jsvObjectSetChild(data, "time", timePtr); // don't unlock - use this later
-                jsvObjectSetChildAndUnLock(data, "pin", jsvObjectGetChildIfExists(watchPtr, "pin"));
-              }
-            }
-            // Update lastTime regardless of which edge we're watching
-            jsvObjectSetChildAndUnLock(watchPtr, "lastTime", timePtr);
-          }
-        }
-        bool removeTimer = false;
-        if (exec) {
-          bool execResult;
+  // Keep the numbers in timers' "time" small
+  if (jsiLastIdleTime - jsiTimerBaseTime > JSI_TIMER_REBASE_TIME)
+    jsiTimersRebase();
+  // If we couldn't allocate the timer queue before, try again
+  if (!timerQueue && !jsvArrayIsEmpty(timerArray))
+    jsiTimerQueueRebuild(0);
+  JsSysTime timerNow = jsiLastIdleTime - jsiTimerBaseTime;
+  // Now execute any timers that are due, earliest first
+  while (timerQueueCount) {
+    JsiTimerQueueEntry next = jsiTimerQueueGetEntries()[0];
+    if (next.time > timerNow) break; // nothing else is due yet
+    jsiTimerQueuePop();
+    JsVar *timerName = jsvGetArrayIndex(timerArray, next.id);
+    JsVar *timerPtr = timerName ? jsvSkipName(timerName) : 0;
+    JsSysTime timerTime = timerPtr ? (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time")) : 0;
+    if (!timerPtr || timerTime!=next.time) {
+      // the timer was removed or changed after this entry was added
+      jsvUnLock2(timerPtr, timerName);
+      continue;
+    }
+    bool isBehind = false;
+    // we're now doing work
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    wasBusy = true;
+    JsVar *timerCallback = jsvObjectGetChildIfExists(timerPtr, "cb");
+    JsVar *watchPtr = jsvObjectGetChildIfExists(timerPtr, "watch"); // for debounce - may be undefined
+    bool exec = true;
+    JsVar *data = 0;
+    if (watchPtr) {
+      bool watchState = jsvObjectGetBoolChild(watchPtr, "state");
+      bool timerState = jsvObjectGetBoolChild(timerPtr, "state");
+      jsvObjectSetBoolChild(watchPtr, "state", timerState);
+      exec = false;
+      if (watchState!=timerState) {
+        // Create the 'time' variable that will be passed to the user and stored as last time
+        JsVarInt delay = jsvObjectGetIntegerChild(watchPtr, "debounce");
+        JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(jsiTimerBaseTime+timerTime-delay)/1000);
+        // If it's the right edge...
+        if (jsiShouldExecuteWatch(watchPtr, timerState)) {
+          data = jsvNewObject();
+          // if we were from a watch then we were delayed by the debounce time...
           if (data) {
-            execResult = jsiExecuteEventCallback(0, timerCallback, 1, &data);
-          } else {
-            JsVar *argsArray = jsvObjectGetChildIfExists(timerPtr, "args");
-            execResult = jsiExecuteEventCallbackArgsArray(0, timerCallback, argsArray);
-            jsvUnLock(argsArray);
-          }
-          if (!execResult) {
-            JsVar *interval = jsvObjectGetChildIfExists(timerPtr, "intr");
-            if (interval) { // if interval then it's setInterval not setTimeout
-              jsvUnLock(interval);
-              jsError("Ctrl-C while processing interval - removing it.");
-              jsErrorFlags |= JSERR_CALLBACK;
-              removeTimer = true;
-            }
+            exec = true;
+            // if it was a watch, set the last state up
+            jsvObjectSetBoolChild(data, "state", timerState);
+            // set up the lastTime variable of data to what was in the watch
+            jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChildIfExists(watchPtr, "lastTime"));
+            // set up the watches lastTime to this one
+            jsvObjectSetChild(data, "time", timePtr); // don't unlock - use this later
+            jsvObjectSetChildAndUnLock(data, "pin", jsvObjectGetChildIfExists(watchPtr, "pin"));
           }
         }
-        jsvUnLock(data);
-        if (watchPtr) { // if we had a watch pointer, be sure to remove us from it
-          jsvObjectRemoveChild(watchPtr, "timeout");
-          // Deal with non-recurring watches
-          if (exec) {
-            bool watchRecurring = jsvObjectGetBoolChild(watchPtr,  "recur");
-            if (!watchRecurring) {
-              JsVar *watchNamePtr = jsvGetIndexOf(watchArray, watchPtr, true);
-              if (watchNamePtr) {
-                jsvRemoveChildAndUnLock(watchArray, watchNamePtr);
-              }
-              Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChildIfExists(watchPtr, "pin"));
-              if (!jsiIsWatchingPin(pin))
-                jshPinWatch(pin, false, JSPW_NONE);
-            }
-          }
-          jsvUnLock(watchPtr);
-        }
-        // Load interval *after* executing code, in case it has changed
+        // Update lastTime regardless of which edge we're watching
+        jsvObjectSetChildAndUnLock(watchPtr, "lastTime", timePtr);
+      }
+    }
+    bool removeTimer = false;
+    if (exec) {
+      bool execResult;
+      if (data) {
+        execResult = jsiExecuteEventCallback(0, timerCallback, 1, &data);
+      } else {
+        JsVar *argsArray = jsvObjectGetChildIfExists(timerPtr, "args");
+        execResult = jsiExecuteEventCallbackArgsArray(0, timerCallback, argsArray);
+        jsvUnLock(argsArray);
+      }
+      if (!execResult) {
         JsVar *interval = jsvObjectGetChildIfExists(timerPtr, "intr");
-        if (!removeTimer && interval) {
-          timerTime = timerTime + jsvGetLongInteger(interval);
-          jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(timerTime));
-        } else {
-          // free
-          // Beware... may have already been removed!
-          jsvObjectIteratorRemoveAndGotoNext(&it, timerArray);
-          hasDeletedTimer = true;
-          timerTime = -1;
+        if (interval) { // if interval then it's setInterval not setTimeout
+          jsvUnLock(interval);
+          jsError("Ctrl-C while processing interval - removing it.");
+          jsErrorFlags |= JSERR_CALLBACK;
+          removeTimer = true;
         }
-        jsvUnLock2(timerCallback,interval);
       }
-      // update the time until the next timer
-      if (timerTime>=0 && timerTime < minTimeUntilNext)
-        minTimeUntilNext = timerTime;
-      // update the timer's time
-      if (!hasDeletedTimer)
-        jsvObjectIteratorNext(&it);
-      jsvUnLock(timerPtr);
     }
-    jsvObjectIteratorFree(&it);
-  } while (jsiStatus & JSIS_TIMERS_CHANGED);
-  /* We might have left the timers loop with stuff to do because the contents of it
-   * changed. It's not a big deal because it could only have changed because a timer
-   * got executed - so `wasBusy` got set and we know we're going to go around the
-   * loop again before sleeping.
-   */
+    jsvUnLock(data);
+    if (watchPtr) { // if we had a watch pointer, be sure to remove us from it
+      jsvObjectRemoveChild(watchPtr, "timeout");
+      // Deal with non-recurring watches
+      if (exec) {
+        bool watchRecurring = jsvObjectGetBoolChild(watchPtr,  "recur");
+        if (!watchRecurring) {
+          JsVar *watchNamePtr = jsvGetIndexOf(watchArray, watchPtr, true);
+          if (watchNamePtr) {
+            jsvRemoveChildAndUnLock(watchArray, watchNamePtr);
+          }
+          jsiWatchesChanged();
+          Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChildIfExists(watchPtr, "pin"));
+          if (!jsiIsWatchingPin(pin))
+            jshPinWatch(pin, false, JSPW_NONE);
+        }
+      }
+      jsvUnLock(watchPtr);
+    }
+    // Beware... the callback may have removed or changed this timer!
+    JsVar *currentTimerName = jsvGetArrayIndex(timerArray, next.id);
+    if (currentTimerName == timerName &&
+        timerTime == (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time"))) {
+      // Load interval *after* executing code, in case it has changed
+      JsVar *interval = jsvObjectGetChildIfExists(timerPtr, "intr");
+      if (!removeTimer && interval) {
+        timerTime = timerTime + jsvGetLongInteger(interval);
+        jsiTimerSetTime(timerPtr, next.id, timerTime);
+        // If we're so far behind it's due again, leave it (and any others) for the next time around the loop
+        isBehind = timerTime <= timerNow;
+      } else {
+        jsvRemoveChild(timerArray, timerName);
+      }
+      jsvUnLock(interval);
+    } else if (removeTimer && currentTimerName == timerName) {
+      // changeInterval was called, but we still want to remove it because of Ctrl-C
+      jsvRemoveChild(timerArray, timerName);
+    }
+    jsvUnLock4(currentTimerName, timerCallback, timerPtr, timerName);
+    if (isBehind) break;
+  }
+  // update the time until the next timer
+  if (timerQueueCount) {
+    minTimeUntilNext = jsiTimerQueueGetEntries()[0].time - timerNow;
+    if (minTimeUntilNext < 0) minTimeUntilNext = 0;
+  }
 
   // Check for events that might need to be processed from other libraries
   if (jswIdle()) wasBusy = true;
@@ -2675,6 +2946,17 @@ void jsiIdle() {
   if (jsiStatus & JSIS_WATCHDOG_AUTO)
     jshKickWatchDog();
 
+#ifndef ESPR_NO_INCREMENTAL_GC
+  /* If we're part way through an incremental Garbage Collection, do
+   * the next step. Each step is short so it doesn't delay timers
+   * or events much - and we don't sleep until it's finished. */
+  if (jsvGarbageCollectIsRunning()) {
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    jsvGarbageCollectStep(JSV_GC_STEP_BUDGET);
+    jsiSetBusy(BUSY_INTERACTIVE, false);
+    return;
+  }
+#endif
   /* if we've been around this loop, there is nothing to do, and
    * we have a spare 10ms then let's do some Garbage Collection
    * if we think we need to */
@@ -2682,13 +2964,41 @@ void jsiIdle() {
       minTimeUntilNext > jshGetTimeFromMilliseconds(10) &&
       !jsvMoreFreeVariablesThan(JS_VARS_BEFORE_IDLE_GC)) {
     jsiSetBusy(BUSY_INTERACTIVE, true);
+#ifndef ESPR_NO_INCREMENTAL_GC
+    jsvGarbageCollectStep(JSV_GC_STEP_BUDGET);
+#else
     jsvGarbageCollect();
+#endif
     jsiSetBusy(BUSY_INTERACTIVE, false);
     /* Return here so we run around the idle loop again
      * and check whether any events came in during GC. If not
      * then we'll sleep. */
     return;
   }
+#ifndef ESPR_NO_NURSERY
+  /* If the nursery that numbers get allocated from has filled up, move
+   * whatever is still in it out to main memory so it's free again */
+  if (loopsIdling==1 && jsvNurseryNeedsPromote()) {
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    jsvNurseryPromote();
+    jsiSetBusy(BUSY_INTERACTIVE, false);
+    return;
+  }
+#endif
+#ifndef ESPR_NO_AUTO_DEFRAG
+  /* If free memory is so fragmented that big flat strings (for Graphics,
+   * Typed Arrays, etc) can't be allocated, compact it a few blocks at a time.
+   * Not while the utility timer runs, as its tasks may reference buffers */
+  if (loopsIdling>=1 &&
+      minTimeUntilNext > jshGetTimeFromMilliseconds(10) &&
+      !jstUtilTimerIsRunning() &&
+      jsvDefragmentNeeded()) {
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    jsvDefragmentStep(JSV_DEFRAG_STEP_BLOCKS);
+    jsiSetBusy(BUSY_INTERACTIVE, false);
+    return;
+  }
+#endif
 
   // Go to sleep!
   if (loopsIdling>=1 && // once around the idle loop without having done any work already (just in case)
@@ -2813,7 +3123,8 @@ void jsiDumpState(vcbprintf_callback user_callback, void *user_data) {
     JsVar *timerInterval = jsvObjectGetChildIfExists(timer, "intr");
     user_callback(timerInterval ? "setInterval(" : "setTimeout(", user_data);
     jsiDumpJSON(user_callback, user_data, timerCallback, 0);
-    cbprintf(user_callback, user_data, ", %f); // %v\n", jshGetMillisecondsFromTime(timerInterval ? jsvGetLongInteger(timerInterval) : jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timer, "time"))), timerNumber);
+    JsSysTime timerTime = timerInterval ? jsvGetLongInteger(timerInterval) : (jsiTimerBaseTime + jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timer, "time")) - jsiLastIdleTime);
+    cbprintf(user_callback, user_data, ", %f); // %v\n", jshGetMillisecondsFromTime(timerTime), timerNumber);
     jsvUnLock3(timerInterval, timerCallback, timerNumber);
     // next
     jsvUnLock(timer);
@@ -2857,11 +3168,19 @@ void jsiDumpState(vcbprintf_callback user_callback, void *user_data) {
 }
 
 JsVarInt jsiTimerAdd(JsVar *timerPtr) {
-  return jsvArrayAddToEnd(timerArray, timerPtr, 1) - 1;
+  JsVarInt id = jsvArrayAddToEnd(timerArray, timerPtr, 1) - 1;
+  jsiTimerQueueAdd(id, (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChildIfExists(timerPtr, "time")));
+  return id;
+}
+
+void jsiTimerSetTime(JsVar *timerPtr, JsVarInt id, JsSysTime time) {
+  jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(time));
+  jsiTimerQueueAdd(id, time);
 }
 
-void jsiTimersChanged() {
-  jsiStatus |= JSIS_TIMERS_CHANGED;
+void jsiSetLastIdleTime(JsSysTime time) {
+  jsiTimerBaseTime += time - jsiLastIdleTime;
+  jsiLastIdleTime = time;
 }
 
 #ifdef USE_DEBUGGER
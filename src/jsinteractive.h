@@ -154,7 +154,6 @@ typedef enum {
   JSIS_NONE,
   JSIS_ECHO_OFF           = 1<<0, ///< do we provide any user feedback? OFF=no
   JSIS_ECHO_OFF_FOR_LINE  = 1<<1, ///< Echo is off just for one line, then back on
-  JSIS_TIMERS_CHANGED     = 1<<2,
 #ifdef USE_DEBUGGER
   JSIS_IN_DEBUGGER        = 1<<3, ///< We're inside the debug loop
   JSIS_EXIT_DEBUGGER      = 1<<4, ///< we've been asked to exit the debug loop
@@ -186,6 +185,9 @@ extern Pin pinBusyIndicator;
 extern Pin pinSleepIndicator;
 #endif
 extern JsSysTime jsiLastIdleTime; ///< The last time we went around the idle loop - use this for timers
+extern JsSysTime jsiTimerBaseTime; ///< Timers' "time" is relative to this
+/// Set jsiLastIdleTime without timers seeing the time pass (eg. because the system time was changed or we were asleep)
+void jsiSetLastIdleTime(JsSysTime time);
 
 void jsiDumpJSON(vcbprintf_callback user_callback, void *user_data, JsVar *data, JsVar *existing);
 void jsiDumpState(vcbprintf_callback user_callback, void *user_data);
@@ -194,8 +196,9 @@ void jsiDumpState(vcbprintf_callback user_callback, void *user_data);
 extern JsVar *timerArray; // Linked List of timers to check and run
 extern JsVar *watchArray; // Linked List of input watches to check and run
 
-extern JsVarInt jsiTimerAdd(JsVar *timerPtr);
-extern void jsiTimersChanged(); // Flag timers changed so we can skip out of the loop if needed
+extern JsVarInt jsiTimerAdd(JsVar *timerPtr); // Add a timer (with "time" already set) and return its id
+extern void jsiTimerSetTime(JsVar *timerPtr, JsVarInt id, JsSysTime time); // Change when the timer with the given id is due
+extern void jsiWatchesChanged(); // Call after adding/removing items in watchArray so the table used to dispatch pin events is rebuilt
 // end for jswrap_interactive/io.c ------------------------------------------------
 
 #ifdef USE_DEBUGGER
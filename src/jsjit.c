@@ -34,8 +34,26 @@ void jsjBlockOrStatement();
 // ----------------------------------------------------------------------------
 // These are helper functions that get called FROM the JITed code
 
-/// Look up 'parent.a[index]'. Utility function called from JIT code
-uint64_t _jsjxObjectLookup(JsVar *index, JsVar *parent, JsVar *a) {
+#ifdef JSJ_X86_64
+/// Two values - returned in rax:rdx, which jsjcCall puts in r0:r1
+typedef struct { size_t r0, r1; } JsjxPair;
+#else
+/// Two 32 bit values packed into 64 bits, so they're returned in r0:r1
+typedef uint64_t JsjxPair;
+#endif
+
+/// Make a JsjxPair, so a helper can return values in both r0 and r1
+static ALWAYS_INLINE JsjxPair jsjxPair(size_t r0, size_t r1) {
+#ifdef JSJ_X86_64
+  JsjxPair r = { r0, r1 };
+  return r;
+#else
+  return ((uint64_t)r0) | (((uint64_t)r1)<<32);
+#endif
+}
+
+/// Look up 'parent.a[index]'. Utility function called from JIT code. Returns (a,parent)
+JsjxPair _jsjxObjectLookup(JsVar *index, JsVar *parent, JsVar *a) {
   JsVar *resultParent = jsvSkipNameWithParent(a,true,parent);
   jsvUnLock2(a, parent);
   JsVar *resultA = 0;
@@ -51,7 +69,7 @@ uint64_t _jsjxObjectLookup(JsVar *index, JsVar *parent, JsVar *a) {
     }
   }
   jsvUnLock(index);
-  return ((uint64_t)(size_t)resultA) | (((uint64_t)(size_t)resultParent)<<32);
+  return jsjxPair((size_t)resultA, (size_t)resultParent);
 }
 
 // Like jspeFunctionCall but we unlock ALL the vars supplied
@@ -142,6 +160,13 @@ NO_INLINE void _jsxArrayNewElement(JsVar *array, uint32_t index, JsVar *value) {
   jsvUnLock(value);
 }
 
+// Create a float from its raw bits (so we don't depend on how each ABI passes doubles)
+NO_INLINE JsVar *_jsxNewFromFloatBits(uint64_t bits) {
+  JsVarFloat f;
+  memcpy(&f, &bits, sizeof(f));
+  return jsvNewFromFloat(f);
+}
+
 // Return a locked 'this' variable
 NO_INLINE JsVar *_jsxGetThis() {
   return jsvLockAgain( execInfo.thisVar ? execInfo.thisVar : execInfo.root );
@@ -168,6 +193,99 @@ NO_INLINE JsVar *_jsxConstructorEnd(JsVar *returnVal, JsVar *thisObj) {
   }
   return thisObj;
 }
+// Convert a tagged value to a locked JsVar (the JsVar in a tagged value is already locked)
+NO_INLINE JsVar *_jsxTaggedToJsVar(size_t t) {
+  if (JSJ_TAGGED_IS_INT(t)) return jsvNewFromInteger(JSJ_TAGGED_GET_INT(t));
+  return t ? _jsvGetAddressOf((JsVarRef)(t>>1)) : 0;
+}
+
+// Convert a JsVar value to a tagged value - if it's a small int it's unlocked and a tagged int is returned
+NO_INLINE size_t _jsxToTagged(JsVar *v) {
+  if (jsvIsInt(v)) {
+    JsVarInt i = jsvGetInteger(v);
+    if (JSJ_TAGGED_INT_FITS(i)) {
+      jsvUnLock(v);
+      return JSJ_TAGGED_FROM_INT(i);
+    }
+  }
+  return v ? ((size_t)jsvGetRef(v))<<1 : 0;
+}
+
+// Convert an int to a tagged value
+NO_INLINE size_t _jsxIntToTagged(JsVarInt i) {
+  if (JSJ_TAGGED_INT_FITS(i)) return JSJ_TAGGED_FROM_INT(i);
+  return _jsxToTagged(jsvNewFromInteger(i));
+}
+
+// Lock a tagged value again (if it's a JsVar) and return it
+NO_INLINE size_t _jsxTaggedLockAgain(size_t t) {
+  if (t && !JSJ_TAGGED_IS_INT(t)) jsvLockAgain(_jsvGetAddressOf((JsVarRef)(t>>1)));
+  return t;
+}
+
+// Unlock a tagged value (if it's a JsVar)
+NO_INLINE void _jsxTaggedUnLock(size_t t) {
+  if (!JSJ_TAGGED_IS_INT(t)) jsvUnLock(_jsxTaggedToJsVar(t));
+}
+
+// Get a tagged value as a boolean (and unlock it)
+NO_INLINE bool _jsxTaggedGetBool(size_t t) {
+  if (JSJ_TAGGED_IS_INT(t)) return JSJ_TAGGED_GET_INT(t)!=0;
+  return jsvGetBoolAndUnLock(_jsxTaggedToJsVar(t));
+}
+
+// Is the given operator a comparison (which returns a bool)?
+static bool jsjIsCompareOp(int op) {
+  return op==LEX_EQUAL || op==LEX_NEQUAL || op==LEX_TYPEEQUAL || op==LEX_NTYPEEQUAL ||
+         op=='<' || op=='>' || op==LEX_LEQUAL || op==LEX_GEQUAL;
+}
+
+/* Maths on two tagged values - this is the slow path when the JIT's inline code
+can't handle them (eg. they're not ints, or the result would overflow). Unlocks a and b.
+Returns a bool for comparisons, or a tagged value */
+NO_INLINE size_t _jsxTaggedMathsOp(size_t a, size_t b, int op) {
+  if (JSJ_TAGGED_IS_INT(a) && JSJ_TAGGED_IS_INT(b)) {
+    // handle the simple cases the JIT doesn't do inline without allocating (same maths as jsvMathsOp)
+    JsVarInt ia = JSJ_TAGGED_GET_INT(a), ib = JSJ_TAGGED_GET_INT(b);
+    long long r = 0;
+    bool isShift = op==LEX_LSHIFT || op==LEX_RSHIFT || op==LEX_RSHIFTUNSIGNED;
+    bool handled = !isShift || (ib>=0 && ib<32);
+    if (handled) switch (op) {
+      case '*': r = (long long)ia * (long long)ib; break;
+      case '%': if (ib<0) ib=-ib;
+                handled = ib!=0; if (handled) r = ia % ib; break;
+      case LEX_LSHIFT: r = (JsVarInt)(ia << ib); break;
+      case LEX_RSHIFT: r = ia >> ib; break;
+      case LEX_RSHIFTUNSIGNED: r = ((JsVarIntUnsigned)ia) >> ib; break;
+      default: handled = false;
+    }
+    if (handled && JSJ_TAGGED_INT_FITS(r))
+      return JSJ_TAGGED_FROM_INT(r);
+  }
+  JsVar *av = _jsxTaggedToJsVar(a);
+  JsVar *bv = _jsxTaggedToJsVar(b);
+  JsVar *r = jsvMathsOp(av, bv, op);
+  jsvUnLock2(av, bv);
+  if (jsjIsCompareOp(op))
+    return jsvGetBoolAndUnLock(r);
+  return _jsxToTagged(r);
+}
+
+/* ++ and -- on a tagged value (the slow path). Unlocks t and returns (new value, result)
+where result is the value before the inc/dec for postfix, or after for prefix */
+NO_INLINE JsjxPair _jsxTaggedIncDec(size_t t, int op, bool isPrefix) {
+  JsVar *oldValue = jsvAsNumberAndUnLock(_jsxTaggedToJsVar(t));
+  JsVar *one = jsvNewFromInteger(1);
+  size_t newValue = _jsxToTagged(jsvMathsOp(oldValue, one, op));
+  jsvUnLock(one);
+  size_t result;
+  if (isPrefix) {
+    jsvUnLock(oldValue);
+    result = _jsxTaggedLockAgain(newValue);
+  } else
+    result = _jsxToTagged(oldValue);
+  return jsjxPair(newValue, result);
+}
 // ----------------------------------------------------------------------------
 
 /// Pop a var off the stack - we assume vars on the stack are locked
@@ -192,16 +310,176 @@ void jsjPopAsBool(int reg) {
   JsjValueType varType = jsjcGetTopType();
   if (varType == JSJVT_BOOL || varType == JSJVT_INT || varType == JSJVT_UNDEFINED) {
     jsjcPop(reg); // easy - just pass through
+  } else if (varType == JSJVT_TAGGED) {
+    jsjcPop(0);
+    jsjcCall(_jsxTaggedGetBool);
+    jsjcExtendBool();
+    if (reg != 0) jsjcMov(reg, 0);
   } else { // JsVar - pop off and convert
     jsjPopNoName(0);
     jsjcCall(jsvGetBoolAndUnLock); // optimisation: we should know if we have a var or a name here, so can skip jsvSkipNameAndUnLock sometimes
+    jsjcExtendBool();
     if (reg != 0) jsjcMov(reg, 0);
   }
 }
 
+/// r0 contains a tagged value - if it's a JsVar (not a tagged int) call fn(r0), leaving the result in r0
+void jsjCallIfTaggedJsVar(void *fn) {
+  jsjcTestBit0(0);
+  JsVar *oldBlock = jsjcStartBlock();
+  jsjcCall(fn);
+  JsVar *callBlock = jsjcStopBlock(oldBlock);
+  jsjcBranchConditionalRelative(JSJAC_NE, jsvGetStringLength(callBlock), JSJC_NONE); // skip if it's an int
+  jsjcEmitBlock(callBlock);
+  jsvUnLock(callBlock);
+}
+
 void jsjPopAndUnLock() {
   JsjValueType t = jsjcPop(0); // a -> r0
   if (JSJVT_NEEDS_UNLOCK(t)) jsjcCall(jsvUnLock); // we're throwing this away now - unlock if needed
+  else if (t == JSJVT_TAGGED) jsjCallIfTaggedJsVar(_jsxTaggedUnLock);
+}
+
+/// Pop a value off the stack as a tagged value. Clobbers r0-r3
+void jsjPopAsTagged(int reg) {
+  JsjValueType varType = jsjcGetTopType();
+  if (varType == JSJVT_TAGGED || varType == JSJVT_UNDEFINED) { // undefined is just a null JsVar
+    jsjcPop(reg);
+    return;
+  }
+  if (varType == JSJVT_INT) {
+    jsjcPop(0);
+    jsjcCall(_jsxIntToTagged);
+  } else { // bools become JsVars
+    jsjPopNoName(0);
+    jsjcCall(_jsxToTagged);
+  }
+  if (reg != 0) jsjcMov(reg, 0);
+}
+
+/// Get the offset from the stack pointer of local var 'varIndex'
+int jsjLocalOffset(int varIndex) {
+  return (jit->stackDepth - (varIndex+1)) * JSJ_WORD_SIZE;
+}
+
+/// Push the value of tagged local var 'varIndex' onto the stack (locking it if it's a JsVar)
+void jsjLocalPush(int varIndex) {
+  jsjcLoadImm(0, JSJAR_SP, jsjLocalOffset(varIndex));
+  jsjCallIfTaggedJsVar(_jsxTaggedLockAgain);
+  jsjcPush(0, JSJVT_TAGGED);
+  jsjcSetTopLocal(varIndex); // so we can assign to it
+}
+
+/// Store the tagged value in reg (r4-r7) into local var 'varIndex', unlocking what was there. Clobbers r0-r3
+void jsjLocalStore(int varIndex, int reg) {
+  jsjcLoadImm(0, JSJAR_SP, jsjLocalOffset(varIndex));
+  jsjCallIfTaggedJsVar(_jsxTaggedUnLock);
+  jsjcStoreImm(reg, JSJAR_SP, jsjLocalOffset(varIndex));
+}
+
+/// Set r0 to 1 if the condition flags match 'cond', or 0 otherwise
+void jsjConditionToBool(JsjAsmCondition cond) {
+  JsVar *oldBlock = jsjcStartBlock();
+  jsjcLiteral8(0, 0);
+  JsVar *falseBlock = jsjcStopBlock(oldBlock);
+  oldBlock = jsjcStartBlock();
+  jsjcLiteral8(0, 1);
+  JsVar *trueBlock = jsjcStopBlock(oldBlock);
+  int trueBlockLen = (int)jsvGetStringLength(trueBlock);
+  jsjcBranchConditionalRelative(cond, (int)jsvGetStringLength(falseBlock) + jsjcGetBranchRelativeLength(trueBlockLen), JSJC_NONE);
+  jsjcEmitBlock(falseBlock);
+  jsjcBranchRelative(trueBlockLen, JSJC_NONE);
+  jsjcEmitBlock(trueBlock);
+  jsvUnLock2(trueBlock, falseBlock);
+}
+
+/* Emit code for a fast path with a fallback, after jsjcTestBit0 has been called: if JSJAC_EQ
+we run 'slow', otherwise 'fastA' then (if checkOverflow and the overflow flag is set) 'slow' again,
+or 'fastB'. All blocks are unlocked */
+void jsjEmitFastSlow(JsVar *fastA, bool checkOverflow, JsVar *fastB, JsVar *slow) {
+  int slowLen = (int)jsvGetStringLength(slow);
+  int afterOverflowLen = (int)jsvGetStringLength(fastB) + jsjcGetBranchRelativeLength(slowLen);
+  int overflowLen = checkOverflow ? jsjcGetBranchConditionalRelativeLength(afterOverflowLen) : 0;
+  jsjcBranchConditionalRelative(JSJAC_EQ, (int)jsvGetStringLength(fastA) + overflowLen + afterOverflowLen, JSJC_NONE);
+  jsjcEmitBlock(fastA);
+  if (checkOverflow)
+    jsjcBranchConditionalRelative(JSJAC_VS, afterOverflowLen, JSJC_NONE);
+  jsjcEmitBlock(fastB);
+  jsjcBranchRelative(slowLen, JSJC_NONE);
+  jsjcEmitBlock(slow);
+  jsvUnLock3(fastA, fastB, slow);
+}
+
+/* Tagged values a (r0) and b (r1) - do maths and push the result. If both are tagged ints,
+simple operations are done inline, and otherwise we call _jsxTaggedMathsOp */
+void jsjTaggedMathsOp(int op) {
+  bool isCompare = jsjIsCompareOp(op);
+  JsVar *oldBlock = jsjcStartBlock();
+  jsjcLiteral32(2, (uint32_t)op);
+  jsjcCall(_jsxTaggedMathsOp); // unlocks a and b
+  JsVar *slow = jsjcStopBlock(oldBlock);
+  bool hasFastPath = isCompare || op=='+' || op=='-' || op=='&' || op=='|' || op=='^';
+  if (hasFastPath) {
+    bool checkOverflow = op=='+' || op=='-';
+    oldBlock = jsjcStartBlock();
+    switch (op) { // tagged ints are (i<<1)|1
+      case '+': jsjcAdd(2, 1, -1); jsjcAddReg(2, 0, 2); break;
+      case '-': jsjcSubReg(2, 0, 1); break;
+      case '&': jsjcAND(0, 1); break;
+      case '|': jsjcORR(0, 1); break;
+      case '^': jsjcEOR(0, 1); jsjcAdd(0, 0, 1); break;
+      case LEX_EQUAL: case LEX_TYPEEQUAL: jsjcCompare(0, 1); jsjConditionToBool(JSJAC_EQ); break;
+      case LEX_NEQUAL: case LEX_NTYPEEQUAL: jsjcCompare(0, 1); jsjConditionToBool(JSJAC_NE); break;
+      case '<': jsjcCompare(0, 1); jsjConditionToBool(JSJAC_LT); break;
+      case '>': jsjcCompare(0, 1); jsjConditionToBool(JSJAC_GT); break;
+      case LEX_LEQUAL: jsjcCompare(0, 1); jsjConditionToBool(JSJAC_LE); break;
+      case LEX_GEQUAL: jsjcCompare(0, 1); jsjConditionToBool(JSJAC_GE); break;
+    }
+    JsVar *fastA = jsjcStopBlock(oldBlock);
+    oldBlock = jsjcStartBlock(); // after the overflow check
+    if (op=='+') jsjcMov(0, 2);
+    if (op=='-') jsjcAdd(0, 2, 1);
+    JsVar *fastB = jsjcStopBlock(oldBlock);
+    DEBUG_JIT("; Tagged maths - check for ints\n");
+    jsjcMov(2, 0);
+    jsjcAND(2, 1);
+    jsjcTestBit0(2); // both have bit 0 set?
+    jsjEmitFastSlow(fastA, checkOverflow, fastB, slow);
+  } else { // no fast path
+    jsjcEmitBlock(slow);
+    jsvUnLock(slow);
+  }
+  jsjcPush(0, isCompare ? JSJVT_BOOL : JSJVT_TAGGED);
+}
+
+/// ++/-- of tagged local var 'varIndex', whose value is on the top of the stack. Pushes the result
+void jsjLocalIncDec(int varIndex, int op, bool isPrefix) {
+  int regOld = jsjcClaimFreeReg();
+  jsjcPop(regOld);
+  // slow path
+  JsVar *oldBlock = jsjcStartBlock();
+  jsjcMov(0, regOld);
+  jsjcLiteral8(1, (uint8_t)op);
+  jsjcLiteral8(2, isPrefix);
+  jsjcCall(_jsxTaggedIncDec); // r0 = new value, r1 = result
+  int regNew = jsjcClaimFreeReg();
+  jsjcMov(regOld, 1);
+  jsjcMov(regNew, 0);
+  jsjLocalStore(varIndex, regNew);
+  jsjcReturnFreeReg(regNew);
+  JsVar *slow = jsjcStopBlock(oldBlock);
+  // fast path - it's an int in regOld, so the var itself holds an int too
+  oldBlock = jsjcStartBlock();
+  jsjcAdd(0, regOld, (op=='+') ? 2 : -2);
+  JsVar *fastA = jsjcStopBlock(oldBlock);
+  oldBlock = jsjcStartBlock();
+  jsjcStoreImm(0, JSJAR_SP, jsjLocalOffset(varIndex));
+  if (isPrefix) jsjcMov(regOld, 0);
+  JsVar *fastB = jsjcStopBlock(oldBlock);
+  jsjcTestBit0(regOld);
+  jsjEmitFastSlow(fastA, true, fastB, slow);
+  jsjcPush(regOld, JSJVT_TAGGED);
+  jsjcReturnFreeReg(regOld);
 }
 
 // Write the code to create variable 'var' in register 'reg'. Clobbers r0-r3
@@ -225,6 +503,7 @@ void jsjJsVar(int reg, JsVar *var) {
 void jsjFunctionStart() {
   DEBUG_JIT("; Function start\n");
   jsjcPushAll(); // Function start - push all registers since we're not meant to mess with r4..r7
+  jsjcLoadConstPoolAddress(); // function addresses are loaded from the constant pool after our code
 }
 
 /// Code to add right at the end of the function (or when we return)
@@ -233,12 +512,19 @@ void jsjFunctionReturn(bool isReturnStatement) {
   int oldStackDepth = jit->stackDepth;
   if (jit->varCount) {
     jsjcMov(4, 0); // save r0 (return value)
+    for (int i=0;i<jit->stackDepth;i++) { // we don't want to be trying to unlock ints!
+      assert(jit->typeStack[i]==JSJVT_JSVAR || jit->typeStack[i]==JSJVT_JSVAR_NO_NAME || jit->typeStack[i]==JSJVT_TAGGED);
+      if (jit->typeStack[i]==JSJVT_TAGGED) { // unlock tagged local vars, and leave undefined for jsvUnLockMany
+        jsjcLoadImm(0, JSJAR_SP, jsjLocalOffset(i));
+        jsjCallIfTaggedJsVar(_jsxTaggedUnLock);
+        jsjcLiteral32(0, 0);
+        jsjcStoreImm(0, JSJAR_SP, jsjLocalOffset(i));
+      }
+    }
     jsjcMov(1, JSJAR_SP);
     jsjcLiteral32(0, jit->stackDepth);
-    for (int i=0;i<jit->stackDepth;i++) // we don't want to be trying to unlock ints!
-      assert(jit->typeStack[i]==JSJVT_JSVAR || jit->typeStack[i]==JSJVT_JSVAR_NO_NAME);
     jsjcCall(jsvUnLockMany);
-    jsjcAddSP(4*jit->varCount); // pop off anything on the stack
+    jsjcAddSP(JSJ_WORD_SIZE*jit->varCount); // pop off anything on the stack
     jsjcMov(0, 4); // restore r0
   }
   // actual stack depth is stackDepth but at this point varCount==stackDepth we hope
@@ -253,11 +539,14 @@ void jsjFunctionReturn(bool isReturnStatement) {
 /* Called when we encounter an ID. This checks if it's in our 'jit->vars'
 list and if not either creates (creationOp==LEX_R_VAR/LET/CONST) or
 tries to find it (creationOp==LEX_ID) it in our global scope.
+Locals created with VAR/LET are kept on the stack as tagged values (JSJVT_TAGGED)
+rather than JsVars in a scope, so small ints in them never need allocating.
 hasInitialiser=true if an initial value is already on the stack.
 If the ID was something built-in, its value is returned (we pass this into FactorMember) */
 JsVar *jsjFactorIDAndUnLock(JsVar *name, LEX_TYPES creationOp) {
   const int VARINDEX_MASK = 0xFFFF; // mask to return the actual var index
   const int VARINDEX_NO_NAME = 0x10000; // flag set if we're sure there is no name
+  const int VARINDEX_TAGGED = 0x20000; // flag set if this is a local var stored as a tagged value
   // search for var in our list...
   JsVar *varIndex = jsvFindChildFromVar(jit->vars, name, true/*addIfNotFound*/);
   JsVar *varIndexVal = jsvSkipName(varIndex);
@@ -276,7 +565,7 @@ JsVar *jsjFactorIDAndUnLock(JsVar *name, LEX_TYPES creationOp) {
       /*if (jsvIsNativeFunction(builtin)) { // it's a built-in function - just create it in place rather than searching
         // we can't do this because of #2690 - eg `NRF.emit` needs to use the 'real' NRF as 'this'
         DEBUG_JIT("; Native Function %j\n", name);
-        jsjcLiteral32(0, (uint32_t)builtin->varData.native.ptr);
+        jsjcLiteralPointer(0, builtin->varData.native.ptr);
         jsjcLiteral32(1, (uint16_t)builtin->varData.native.argTypes);
         jsjcCall(jsvNewNativeFunction); // JsVar *jsvNewNativeFunction(void (*ptr)(void), unsigned short argTypes)
         varType = JSJVT_JSVAR_NO_NAME;
@@ -290,6 +579,11 @@ JsVar *jsjFactorIDAndUnLock(JsVar *name, LEX_TYPES creationOp) {
         jsjcLiteralString(0, name, true); // null terminated string in r0
         jsjcCall(jspGetNamedVariable); // Find the var in the current scopes (always returns something even if it's jsvNewChild)
       }
+    } else if ((creationOp==LEX_R_VAR || creationOp==LEX_R_LET) &&
+               jit->varCount<255 && jit->stackDepth<JSJ_TYPE_STACK_SIZE) {
+      DEBUG_JIT("; Tagged local Variable Decl %j\n", name);
+      jsjcLiteral32(0, 0); // starts off undefined
+      varType = JSJVT_TAGGED;
     } else if (creationOp==LEX_R_VAR || creationOp==LEX_R_LET || creationOp==LEX_R_CONST) {
       DEBUG_JIT("; Variable Decl %j\n", name);
       jsjcLiteralString(0, name, true); // null terminated string in r0
@@ -301,18 +595,23 @@ JsVar *jsjFactorIDAndUnLock(JsVar *name, LEX_TYPES creationOp) {
     int varIndexNumber = jit->varCount++;
     if (varType == JSJVT_JSVAR_NO_NAME)
       varIndexNumber |= VARINDEX_NO_NAME; // if we're sure there's no name
+    if (varType == JSJVT_TAGGED)
+      varIndexNumber |= VARINDEX_TAGGED;
     varIndexVal = jsvNewFromInteger(varIndexNumber);
     jsvSetValueOfName(varIndex, varIndexVal);
   }
   // Now, we have the var already - just reference it
   int varIndexI = jsvGetIntegerAndUnLock(varIndexVal);
-  if (jit->phase == JSJP_EMIT) {
+  if (jit->phase == JSJP_EMIT && (varIndexI & VARINDEX_TAGGED)) {
+    DEBUG_JIT("; Reference tagged local var %j\n", name);
+    jsjLocalPush(varIndexI & VARINDEX_MASK);
+  } else if (jit->phase == JSJP_EMIT) {
     JsjValueType varType = JSJVT_JSVAR;
     if (varIndexI & VARINDEX_NO_NAME) // decode varType from the flags
       varType = JSJVT_JSVAR_NO_NAME;
     varIndexI &= VARINDEX_MASK;
     DEBUG_JIT("; Reference var %j\n", name);
-    jsjcLoadImm(0, JSJAR_SP, (jit->stackDepth - (varIndexI+1)) * 4);
+    jsjcLoadImm(0, JSJAR_SP, jsjLocalOffset(varIndexI));
     jsjcCall(jsvLockAgain);
     jsjcPush(0, varType); // Push, with the type we got from the varIndex flags
   }
@@ -423,6 +722,9 @@ JsVar *jsjFactor() {
         jsjcLiteral64(0, (uint64_t)v);
         jsjcCall(jsvNewFromLongInteger);
         jsjcPush(0, JSJVT_JSVAR_NO_NAME); // a value, not a NAME, FIXME - push an int and convert later
+      } else if (JSJ_TAGGED_INT_FITS(v)) {
+        jsjcLiteral32(0, (uint32_t)JSJ_TAGGED_FROM_INT(v));
+        jsjcPush(0, JSJVT_TAGGED);
       } else {
         jsjcLiteral32(0, (uint32_t)v);
         jsjcPush(0, JSJVT_INT);
@@ -433,7 +735,7 @@ JsVar *jsjFactor() {
     JSP_ASSERT_MATCH(LEX_FLOAT);
     if (jit->phase == JSJP_EMIT) {
       jsjcLiteral64(0, *((uint64_t*)&v));
-      jsjcCall(jsvNewFromFloat);
+      jsjcCall(_jsxNewFromFloatBits);
       jsjcPush(0, JSJVT_JSVAR_NO_NAME); // a value, not a NAME
     }
   } else if (lex->tk=='(') {
@@ -564,7 +866,9 @@ bool jsjFactorMember(JsVar *builtin) {
                 } else DEBUG_JIT_EMIT("; FUNCTION CALL NATIVE\n");
                 jsjFactorFunctionIgnoreRemainingArguments();
                 // void this.fn()
-                int argReg = hasThis ? 1 : 0;
+                // getting the parent can call functions that clobber r0-r3, so keep the argument in a free reg
+                int argReg = jsjcClaimFreeReg();
+                int thisReg = hasThis ? jsjcClaimFreeReg() : 0;
                 if (arg1Type) {
                   if (arg1Type == JSWAT_JSVAR) jsjPopNoName(argReg);
                   else if (arg1Type == JSWAT_BOOL) jsjPopAsBool(argReg);
@@ -574,10 +878,13 @@ bool jsjFactorMember(JsVar *builtin) {
                   }
                 }
                 if (hasThis) {
-                  jsjPopNoName(0); // parent
-                } else jsjPopAndUnLock(); // FIXME this'll clobber r0 :(
+                  jsjPopNoName(thisReg); // parent
+                  jsjcMov(0, thisReg);
+                } else jsjPopAndUnLock();
+                if (arg1Type) jsjcMov(hasThis ? 1 : 0, argReg);
                 jsjcCall(fn->varData.native.ptr);
                 JsnArgumentType returnType = fn->varData.native.argTypes&JSWAT_MASK;
+                if (returnType == JSWAT_BOOL) jsjcExtendBool();
                 if (returnType == JSWAT_VOID) {
                   jsjcLiteral32(0, 0); // ensure we push 'undefined' for void
                   jsjcPush(0, JSJVT_UNDEFINED);
@@ -592,10 +899,21 @@ bool jsjFactorMember(JsVar *builtin) {
                   assert(returnType==JSWAT_JSVAR);
                   jsjcPush(0, JSJVT_JSVAR_NO_NAME);
                 }
+                // native functions don't unlock their arguments
+                if (arg1Type == JSWAT_JSVAR) {
+                  jsjcMov(0, argReg);
+                  jsjcCall(jsvUnLock);
+                }
+                if (hasThis) {
+                  jsjcMov(0, thisReg);
+                  jsjcCall(jsvUnLock);
+                  jsjcReturnFreeReg(thisReg);
+                }
+                jsjcReturnFreeReg(argReg);
               } else {
                 int regTmp = jsjcClaimFreeReg();
                 jsjPopNoName(regTmp); // parent
-                jsjcLiteral32(0, (uint32_t)fn->varData.native.ptr);
+                jsjcLiteralPointer(0, fn->varData.native.ptr);
                 jsjcLiteral32(1, (uint16_t)fn->varData.native.argTypes);
                 jsjcCall(jsvNewNativeFunction); // JsVar *jsvNewNativeFunction(void (*ptr)(void), unsigned short argTypes)
                 jsjcPush(0, JSJVT_JSVAR); // the function itself
@@ -634,10 +952,17 @@ bool jsjFactorMember(JsVar *builtin) {
       assert(0);
     }
     if (doLookup && jit->phase == JSJP_EMIT) {
-      // r0 currently = index
-      if (parentOnStack) jsjPopAsVar(1); // r1 = parent
-      else jsjcLiteral32(1, 0);
+      // r0 currently = index - but converting the variable (eg. if it's tagged) could clobber r0-r3
+      int regIndex = jsjcClaimFreeReg();
+      jsjcMov(regIndex, 0);
+      int regParent = jsjcClaimFreeReg();
+      if (parentOnStack) jsjPopAsVar(regParent); // parent
+      else jsjcLiteral32(regParent, 0);
       jsjPopAsVar(2); // r2 = the variable itself
+      jsjcMov(1, regParent); // r1 = parent
+      jsjcMov(0, regIndex); // r0 = index
+      jsjcReturnFreeReg(regParent);
+      jsjcReturnFreeReg(regIndex);
       jsjcCall(_jsjxObjectLookup); // (a,parent) = _jsjxObjectLookup(index, parent, a)
       jsjcPush(0, JSJVT_JSVAR); // a
       jsjcPush(1, JSJVT_JSVAR); // parent
@@ -720,8 +1045,8 @@ void jsjFactorFunctionCall() {
       if (argCount>1) {
         DEBUG_JIT("; FUNCTION CALL reverse arguments\n");
         for (int i=0;i<argCount/2;i++) {
-          int a1 = i*4;
-          int a2 = (argCount-(i+1))*4;
+          int a1 = i*JSJ_WORD_SIZE;
+          int a2 = (argCount-(i+1))*JSJ_WORD_SIZE;
           jsjcLoadImm(0, 7, a1); // r0 = memory[argPtr+a1]
           jsjcLoadImm(1, 7, a2); // ...
           jsjcStoreImm(0, 7, a2);
@@ -733,17 +1058,17 @@ void jsjFactorFunctionCall() {
       DEBUG_JIT("; FUNCTION CALL jspeFunctionCall\n");
       // Get function var and parent (r7 == SP)
       if (parentOnStack) { // parent
-        jsjcLoadImm(0, 7, 4*(argCount+1)); // r0 = funcName
-        jsjcLoadImm(1, 7, 4*(argCount));
+        jsjcLoadImm(0, 7, JSJ_WORD_SIZE*(argCount+1)); // r0 = funcName
+        jsjcLoadImm(1, 7, JSJ_WORD_SIZE*(argCount));
       } else { // no parent
-        jsjcLoadImm(0, 7, 4*argCount); // r0 = funcName
+        jsjcLoadImm(0, 7, JSJ_WORD_SIZE*argCount); // r0 = funcName
         jsjcLiteral32(1, 0);
       }
       jsjcLiteral32(2, 0); // isParsing = false
       jsjcLiteral32(3, argCount); // argCount 4th arg
       jsjcCall(_jsjxFunctionCallAndUnLock); // a = _jsjxFunctionCallAndUnLock(funcName, thisArg/parent, isParsing, argCount, argPtr[on stack]);
       DEBUG_JIT("; FUNCTION CALL cleanup stack\n");
-      jsjcAddSP(4*(2+argCount+(parentOnStack?1:0))); // pop off argPtr + all the arguments + funcName + parent
+      jsjcAddSP(JSJ_WORD_SIZE*(2+argCount+(parentOnStack?1:0))); // pop off argPtr + all the arguments + funcName + parent
       parentOnStack = false;
       if (isConstructor) {
         jsjcMov(1, regObject); // r1 = thisObj
@@ -768,7 +1093,9 @@ void __jsjPostfixExpression() {
   while (lex->tk==LEX_PLUSPLUS || lex->tk==LEX_MINUSMINUS) {
     int op = lex->tk; // POSFIX expression =>  i++, i--
     JSP_ASSERT_MATCH(op);
-    if (jit->phase == JSJP_EMIT) {
+    if (jit->phase == JSJP_EMIT && jsjcGetTopLocal()>=0) {
+      jsjLocalIncDec(jsjcGetTopLocal(), op==LEX_PLUSPLUS ? '+' : '-', false);
+    } else if (jit->phase == JSJP_EMIT) {
       jsjPopAsVar(0); // old value -> r0
       jsjcLiteral32(1, op==LEX_PLUSPLUS ? '+' : '-'); // add the operation
       jsjcCall(_jsxPostfixIncDec); // JsVar *_jsxPostfixIncDec(JsVar *var, char op)
@@ -783,7 +1110,9 @@ void jsjPostfixExpression() {
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
     jsjPostfixExpression(); // recurse to get our var...
-    if (jit->phase == JSJP_EMIT) {
+    if (jit->phase == JSJP_EMIT && jsjcGetTopLocal()>=0) {
+      jsjLocalIncDec(jsjcGetTopLocal(), op==LEX_PLUSPLUS ? '+' : '-', true);
+    } else if (jit->phase == JSJP_EMIT) {
       jsjPopAsVar(0); // old value -> r0
       jsjcLiteral32(1, op==LEX_PLUSPLUS ? '+' : '-'); // add the operation
       jsjcCall(_jsxPrefixIncDec); // JsVar *_jsxPrefixIncDec(JsVar *var, char op)
@@ -803,6 +1132,7 @@ void jsjUnaryExpression() {
       jsjPopNoName(0); // value -> r0 (but ensure it's not a name)
       if (op=='!') { // logical not
         jsjcCall(jsvGetBoolAndUnLock);
+        jsjcExtendBool();
         jsjcMVN(0,0); // ~
         jsjcLiteral32(1, 1);
         jsjcAND(0,1); // &1   -> convert it back to a boolean
@@ -880,6 +1210,7 @@ void __jsjBinaryExpression(unsigned int lastPrecedence) {
         jsjPopNoName(0); // value -> r0 (but ensure it's not a name)
         jsjcPush(0, JSJVT_JSVAR_NO_NAME); // put value back
         jsjcCall(jsvGetBool); // now we have it as a boolean in r0
+        jsjcExtendBool();
         jsjcCompareImm(0,  0); // compare with 0
       }
       // parse second argument
@@ -938,7 +1269,17 @@ void __jsjBinaryExpression(unsigned int lastPrecedence) {
           }
         }
         jsvUnLock2(av, bv);
-      } else */if (jit->phase == JSJP_EMIT) {  // --------------------------------------------- NORMAL
+      } else */if (jit->phase == JSJP_EMIT && op!=LEX_R_INSTANCEOF &&
+                   (jsjcGetTopType()==JSJVT_TAGGED ||
+                    (jit->stackDepth<=JSJ_TYPE_STACK_SIZE && jit->typeStack[jit->stackDepth-2]==JSJVT_TAGGED))) {
+        // --------------------------------------------- TAGGED - ints can be handled inline
+        int regTmp = jsjcClaimFreeReg();
+        jsjPopAsTagged(regTmp); // b -> rT
+        jsjPopAsTagged(0); // a -> r0
+        jsjcMov(1, regTmp); // b -> r1
+        jsjcReturnFreeReg(regTmp);
+        jsjTaggedMathsOp(op);
+      } else if (jit->phase == JSJP_EMIT) {  // --------------------------------------------- NORMAL
         int regTmp = jsjcClaimFreeReg();
         jsjPopAsVar(regTmp); // b -> rT
         jsjPopAsVar(0); // a -> r0
@@ -998,6 +1339,23 @@ void jsjConditionalExpression() {
   }
 }
 
+// Get the maths operation for an assignment operator like '+='
+int jsjGetMathsAssignmentOp(int op) {
+  if (op==LEX_PLUSEQUAL) return '+';
+  if (op==LEX_MINUSEQUAL) return '-';
+  if (op==LEX_MULEQUAL) return '*';
+  if (op==LEX_DIVEQUAL) return '/';
+  if (op==LEX_MODEQUAL) return '%';
+  if (op==LEX_ANDEQUAL) return '&';
+  if (op==LEX_OREQUAL) return '|';
+  if (op==LEX_XOREQUAL) return '^';
+  if (op==LEX_RSHIFTEQUAL) return LEX_RSHIFT;
+  if (op==LEX_LSHIFTEQUAL) return LEX_LSHIFT;
+  if (op==LEX_RSHIFTUNSIGNEDEQUAL) return LEX_RSHIFTUNSIGNED;
+  assert(0);
+  return op;
+}
+
 NO_INLINE void jsjAssignmentExpression() {
   // parse LHS
   jsjConditionalExpression();
@@ -1010,9 +1368,25 @@ NO_INLINE void jsjAssignmentExpression() {
 
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
+    // Are we assigning to a tagged local var?
+    int local = (jit->phase == JSJP_EMIT) ? jsjcGetTopLocal() : -1;
 
     jsjAssignmentExpression();
-    if (jit->phase == JSJP_EMIT) {
+    if (jit->phase == JSJP_EMIT && local>=0) {
+      int regTmp = jsjcClaimFreeReg();
+      jsjPopAsTagged(regTmp); // pop RHS to regTmp
+      if (op=='=') {
+        jsjPopAndUnLock(); // we don't need the old value of the LHS
+      } else {
+        jsjcPop(0); // old value of LHS to r0 (it's tagged)
+        jsjcMov(1, regTmp); // RHS -> r1
+        jsjTaggedMathsOp(jsjGetMathsAssignmentOp(op));
+        jsjcPop(regTmp);
+      }
+      jsjLocalStore(local, regTmp);
+      jsjcReturnFreeReg(regTmp);
+      jsjLocalPush(local); // push the result (LHS) back on
+    } else if (jit->phase == JSJP_EMIT) {
       int regTmp = jsjcClaimFreeReg();
       jsjPopAsVar(regTmp); // pop RHS to regTmp
       jsjPopAsVar(0); // pop LHS to r0
@@ -1022,19 +1396,7 @@ NO_INLINE void jsjAssignmentExpression() {
         // this is like jsvReplaceWithOrAddToRoot but it unlocks the RHS for us
         jsjcCall(_jsxAssignment); // JsVar *_jsxAssignment(JsVar *dst, JsVar *src)
       } else {
-        if (op==LEX_PLUSEQUAL) op='+';
-        else if (op==LEX_MINUSEQUAL) op='-';
-        else if (op==LEX_MULEQUAL) op='*';
-        else if (op==LEX_DIVEQUAL) op='/';
-        else if (op==LEX_MODEQUAL) op='%';
-        else if (op==LEX_ANDEQUAL) op='&';
-        else if (op==LEX_OREQUAL) op='|';
-        else if (op==LEX_XOREQUAL) op='^';
-        else if (op==LEX_RSHIFTEQUAL) op=LEX_RSHIFT;
-        else if (op==LEX_LSHIFTEQUAL) op=LEX_LSHIFT;
-        else if (op==LEX_RSHIFTUNSIGNEDEQUAL) op=LEX_RSHIFTUNSIGNED;
-        else assert(0);
-        jsjcLiteral8(2, op);
+        jsjcLiteral8(2, (uint8_t)jsjGetMathsAssignmentOp(op));
         jsjcCall(_jsxMathAssignment); // JsVar *_jsxMathAssignment(JsVar *var, JsVar *rhs, char op)
       }
       jsjcPush(0, JSJVT_JSVAR); // push the result (LHS) back on
@@ -1085,13 +1447,22 @@ void jsjStatementVar() {
     bool hasInitialiser = lex->tk == '=';
     /* create the variable locally, and in our var table. If we're emitting now
     and there's no initial value, we don't need to do anything */
-    if (hasInitialiser || jit->phase != JSJP_EMIT)
+    int local = -1; // if it's a tagged local var, this is its index
+    if (hasInitialiser || jit->phase != JSJP_EMIT) {
       jsvUnLock(jsjFactorIDAndUnLock(name, declType));
+      if (jit->phase == JSJP_EMIT) local = jsjcGetTopLocal();
+    } else jsvUnLock(name);
     if (hasInitialiser) { // sort out initialiser
       DEBUG_JIT_EMIT("; Variable's initialiser\n");
       JSP_ASSERT_MATCH('=');
       jsjAssignmentExpression();
-      if (jit->phase == JSJP_EMIT) {
+      if (jit->phase == JSJP_EMIT && local>=0) {
+        int regTmp = jsjcClaimFreeReg();
+        jsjPopAsTagged(regTmp); // initial value
+        jsjPopAndUnLock(); // value from jsjFactorIDAndUnLock
+        jsjLocalStore(local, regTmp);
+        jsjcReturnFreeReg(regTmp);
+      } else if (jit->phase == JSJP_EMIT) {
         // _jsxVarInitialAssign(r0:var, r1:isConstant, r2:initialValue)
         jsjPopAsVar(4); // r2 -> initial value
         jsjPopAsVar(0); // r0 -> variable (from jsjFactorIDAndUnLock)
@@ -1187,14 +1558,14 @@ void jsjStatementFor() {
   DEBUG_JIT_EMIT("; Branch OVER main block to END\n");
   // Now figure out the jump length and jump (if condition is false)
   if (jit->phase == JSJP_EMIT) {
-    jsjcBranchConditionalRelative(JSJAC_EQ, jsvGetStringLength(iteratorBlock) + jsvGetStringLength(mainBlock) + 4, JSJC_FORCE_4BYTE);
+    jsjcBranchConditionalRelative(JSJAC_EQ, jsvGetStringLength(iteratorBlock) + jsvGetStringLength(mainBlock) + JSJ_BRANCH_LONG_LENGTH, JSJC_FORCE_4BYTE);
     DEBUG_JIT_EMIT("; FOR Main block\n");
     jsjcEmitBlock(mainBlock);
     DEBUG_JIT_EMIT("; FOR Iterator block\n");
     jsjcEmitBlock(iteratorBlock);
     // after the iterator, jump back to condition
     DEBUG_JIT_EMIT("; FOR jump back to condition\n");
-    jsjcBranchRelative(codePosCondition - (jsjcGetByteCount()+4), JSJC_FORCE_4BYTE);
+    jsjcBranchRelative(codePosCondition - (jsjcGetByteCount()+JSJ_BRANCH_LONG_LENGTH), JSJC_FORCE_4BYTE);
     DEBUG_JIT_EMIT("; FOR end\n");
   }
   jsvUnLock2(mainBlock, iteratorBlock);
@@ -1219,11 +1590,11 @@ void jsjStatementDoOrWhile(bool isWhile) {
     JsVar *mainBlock = jsjcStopBlock(oldBlock);
     if (jit->phase == JSJP_EMIT) {
       DEBUG_JIT_EMIT("; WHILE condition jump\n");
-      jsjcBranchConditionalRelative(JSJAC_EQ, jsvGetStringLength(mainBlock) + 4, JSJC_FORCE_4BYTE);
+      jsjcBranchConditionalRelative(JSJAC_EQ, jsvGetStringLength(mainBlock) + JSJ_BRANCH_LONG_LENGTH, JSJC_FORCE_4BYTE);
       DEBUG_JIT_EMIT("; WHILE Main block\n");
       jsjcEmitBlock(mainBlock);
       DEBUG_JIT_EMIT("; WHILE jump back to condition\n");
-      jsjcBranchRelative(codePosStart - (jsjcGetByteCount()+4), JSJC_FORCE_4BYTE);
+      jsjcBranchRelative(codePosStart - (jsjcGetByteCount()+JSJ_BRANCH_LONG_LENGTH), JSJC_FORCE_4BYTE);
     }
     jsvUnLock(mainBlock);
   } else { // do..while loop
@@ -1238,7 +1609,7 @@ void jsjStatementDoOrWhile(bool isWhile) {
     if (jit->phase == JSJP_EMIT) {
       jsjPopAsBool(0);
       jsjcCompareImm(0, 0);
-      jsjcBranchConditionalRelative(JSJAC_NE, codePosStart - (jsjcGetByteCount()+4), JSJC_FORCE_4BYTE);
+      jsjcBranchConditionalRelative(JSJAC_NE, codePosStart - (jsjcGetByteCount()+JSJ_BRANCH_CONDITIONAL_LONG_LENGTH), JSJC_FORCE_4BYTE);
     }
   }
 }
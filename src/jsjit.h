@@ -19,6 +19,16 @@
 #define DEBUG_JIT_CALLS
 #endif
 
+#if defined(__x86_64__)
+// Emit x86-64 code rather than ARM Thumb (so JIT can be run and benchmarked on Linux)
+#define JSJ_X86_64
+// Address to call to run the code in a JIT function's flat string
+#define JSJ_CODE_ENTRY(ptr) (ptr)
+#else
+// Address to call to run the code in a JIT function's flat string (+1 = Thumb)
+#define JSJ_CODE_ENTRY(ptr) ((ptr)+1)
+#endif
+
 #include "jsparse.h"
 
 JsVar *jsjEvaluateVar(JsVar *str);
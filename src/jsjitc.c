@@ -43,6 +43,7 @@ const char *jsjcGetTypeName(JsjValueType t) {
     case JSJVT_INT: return "int";
     case JSJVT_JSVAR: return "JsVar";
     case JSJVT_JSVAR_NO_NAME: return "JsVar-value";
+    case JSJVT_TAGGED: return "tagged";
     default: return "unknown";
   }
 }
@@ -62,13 +63,22 @@ void jsjcDebugPrintf(const char *fmt, ...) {
   }
 }
 
+#ifdef JSJ_X86_64
+#define JSJ_LAST_CODE_BYTES 1 // we only hold back 'PUSH rdi' (1 byte) for peephole optimisations
+#else
+#define JSJ_LAST_CODE_BYTES 2
+#endif
+
+// Write the offset from the instruction at 'code' (emitted by jsjcLoadConstPoolAddress) to the constant pool
+static void jsjcPatchConstPoolAddress(char *code, int poolOffset);
+
 // flush any previously stored code (for peephole optimisations)
 static void jsjcFlushCode() {
   if (jit->hasLastCode) {
     char *bytes = (char *)&jit->lastCode;
     //jsvAppendStringBuf(jit->code, bytes, 2);
-    jsvStringIteratorAppend(&jit->codeIt, bytes[0]);
-    jsvStringIteratorAppend(&jit->codeIt, bytes[1]);
+    for (int i=0;i<JSJ_LAST_CODE_BYTES;i++)
+      jsvStringIteratorAppend(&jit->codeIt, bytes[i]);
     jit->lastCode = 0;
     jit->hasLastCode = false;
   }
@@ -86,6 +96,9 @@ void jsjcStart(JsjInfo *_jit) {
   jit->varCount = 0;
   jit->stackDepth = 0;
   jit->regsInUse = 0;
+  jit->constPool = jsvNewFromEmptyString();
+  jit->constPoolLoadPos = -1;
+  jit->constPoolSaved = 0;
 }
 
 JsVar *jsjcStop() {
@@ -103,10 +116,15 @@ JsVar *jsjcStop() {
   if (cPtr) fwrite(cPtr, 1, cLen, f);
   fclose(f);
 #endif
-  // Like AsFlatString but we need to concat two blocks instead
+  // Like AsFlatString but we need to concat two blocks (and the constant pool) instead
   jsjcFlushCode();
-  size_t len = jsvGetStringLength(jit->code) + jsvGetStringLength(jit->initCode);
-  JsVar *flat = jsvNewFlatStringOfLength((unsigned int)len);
+  size_t initLen = jsvGetStringLength(jit->initCode);
+  size_t codeLen = initLen + jsvGetStringLength(jit->code);
+  size_t poolOffset = (codeLen + JSJ_WORD_SIZE - 1) & ~(size_t)(JSJ_WORD_SIZE - 1); // word align the pool
+  size_t poolLen = jsvGetStringLength(jit->constPool);
+  int poolBytes = (int)(poolLen + poolOffset - codeLen);
+  DEBUG_JIT("; Constant pool: %d entries (%d bytes), saved %d bytes of code (%d bytes overall)\n", (int)(poolLen/JSJ_WORD_SIZE), poolBytes, jit->constPoolSaved, jit->constPoolSaved - poolBytes);
+  JsVar *flat = jsvNewFlatStringOfLength((unsigned int)(poolOffset + poolLen));
   if (flat) {
     JsvStringIterator src;
     JsvStringIterator dst;
@@ -121,13 +139,25 @@ JsVar *jsjcStop() {
       jsvStringIteratorSetCharAndNext(&dst, jsvStringIteratorGetCharAndNext(&src));
     }
     jsvStringIteratorFree(&src);
+    for (size_t i=codeLen;i<poolOffset;i++)
+      jsvStringIteratorSetCharAndNext(&dst, 0);
+    jsvStringIteratorNew(&src, jit->constPool, 0);
+    while (jsvStringIteratorHasChar(&src)) {
+      jsvStringIteratorSetCharAndNext(&dst, jsvStringIteratorGetCharAndNext(&src));
+    }
+    jsvStringIteratorFree(&src);
     jsvStringIteratorFree(&dst);
+    // now we know where the pool is, point the pool address load at it
+    if (jit->constPoolLoadPos>=0)
+      jsjcPatchConstPoolAddress(jsvGetFlatStringPointer(flat) + initLen + jit->constPoolLoadPos, (int)(poolOffset - (initLen + (size_t)jit->constPoolLoadPos)));
   }
   jsvStringIteratorFree(&jit->codeIt);
   jsvUnLock(jit->code);
   jit->code = 0;
   jsvUnLock(jit->initCode);
   jit->code = 0;
+  jsvUnLock(jit->constPool);
+  jit->constPool = 0;
   jit = NULL;
   return flat;
 }
@@ -169,6 +199,110 @@ JsVar *jsjcStopBlock(JsVar *oldBlock) {
   return v;
 }
 
+// Emit a whole block of code
+void jsjcEmitBlock(JsVar *block) {
+  DEBUG_JIT("... code block ...\n");
+  jsjcFlushCode();
+  jsvStringIteratorAppendString(&jit->codeIt, block, 0, JSVAPPENDSTRINGVAR_MAXLENGTH);
+}
+
+int jsjcGetByteCount() {
+  return jsvGetStringLength(jit->code) + (jit->hasLastCode?JSJ_LAST_CODE_BYTES:0);
+}
+
+/* Get the byte offset of 'value' in the constant pool (relative to the pool
+address loaded by jsjcLoadConstPoolAddress), adding it if it's not there. Each value
+is only stored once, so every call to a helper function shares the same entry.
+Returns -1 if it can't be used, in which case the literal should be emitted inline */
+static int jsjcGetConstPoolOffset(size_t value) {
+  if (jit->constPoolLoadPos<0) return -1;
+  int offset = 0;
+  bool found = false;
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, jit->constPool, 0);
+  while (!found && jsvStringIteratorHasChar(&it)) {
+    size_t v = 0;
+    for (int i=0;i<JSJ_WORD_SIZE;i++)
+      v |= ((size_t)(unsigned char)jsvStringIteratorGetCharAndNext(&it)) << (i*8);
+    if (v==value) found = true;
+    else offset += JSJ_WORD_SIZE;
+  }
+  jsvStringIteratorFree(&it);
+  if (!found) {
+    if (offset<=JSJ_CONST_POOL_MAX) {
+      char bytes[JSJ_WORD_SIZE];
+      for (int i=0;i<JSJ_WORD_SIZE;i++)
+        bytes[i] = (char)(value >> (i*8));
+      jsvAppendStringBuf(jit->constPool, bytes, JSJ_WORD_SIZE);
+    } else offset = -1;
+  }
+  return offset;
+}
+
+// Convert the var type in the given reg to a JsVar
+JsjValueType jsjcConvertToJsVar(int reg, JsjValueType varType) {
+  if (varType==JSJVT_UNDEFINED)
+    return JSJVT_JSVAR_NO_NAME;
+  if (varType==JSJVT_JSVAR || varType==JSJVT_JSVAR_NO_NAME)
+    return varType; // no conversion needed
+  if (varType==JSJVT_BOOL) {
+    if (reg) jsjcMov(0, reg);
+    jsjcCall(jsvNewFromBool); // FIXME: what about clobbering r1-r3? Do a push/pop?
+    if (reg) jsjcMov(reg, 0);
+    return JSJVT_JSVAR_NO_NAME;
+  }
+  if (varType==JSJVT_INT) {
+    if (reg) jsjcMov(0, reg);
+    jsjcCall(jsvNewFromInteger); // FIXME: what about clobbering r1-r3? Do a push/pop?
+    if (reg) jsjcMov(reg, 0);
+    return JSJVT_JSVAR_NO_NAME;
+  }
+  if (varType==JSJVT_TAGGED) {
+    if (reg) jsjcMov(0, reg);
+    jsjcCall(_jsxTaggedToJsVar);
+    if (reg) jsjcMov(reg, 0);
+    return JSJVT_JSVAR_NO_NAME;
+  }
+  assert(0);
+  return JSJVT_UNDEFINED;
+}
+
+// Store the type of an item that's about to be pushed from 'reg' - converting it to a JsVar if we're out of type stack
+static void jsjcPushType(int reg, JsjValueType type) {
+  if (jit->stackDepth>=JSJ_TYPE_STACK_SIZE) { // not enough space on type stack
+    DEBUG_JIT("!!! not enough space on type stack - converting to JsVar\n");
+    jsjcConvertToJsVar(reg, type);
+  } else {
+    jit->typeStack[jit->stackDepth] = type;
+    jit->localStack[jit->stackDepth] = 0;
+  }
+  jit->stackDepth++;
+}
+
+// Get the type of the variable on the top of the stack
+JsjValueType jsjcGetTopType() {
+  assert(jit->stackDepth>0);
+  if (jit->stackDepth==0) return JSJVT_UNDEFINED; // Error!
+  if (jit->stackDepth>JSJ_TYPE_STACK_SIZE) return JSJVT_JSVAR; // If too many types, assume JSVAR (we convert when we push)
+  return jit->typeStack[jit->stackDepth-1];
+}
+
+// Mark the item on the top of the stack as having just been read from tagged local var 'varIndex'
+void jsjcSetTopLocal(int varIndex) {
+  assert(varIndex>=0 && varIndex<255);
+  if (jit->stackDepth>0 && jit->stackDepth<=JSJ_TYPE_STACK_SIZE)
+    jit->localStack[jit->stackDepth-1] = (uint8_t)(varIndex+1);
+}
+
+// If the item on the top of the stack was just read from a tagged local var, return its index - or -1
+int jsjcGetTopLocal() {
+  if (jit->stackDepth==0 || jit->stackDepth>JSJ_TYPE_STACK_SIZE) return -1;
+  return jit->localStack[jit->stackDepth-1] - 1;
+}
+
+#ifndef JSJ_X86_64
+// ============================================================================ ARM Thumb-2
+
 void jsjcEmit16(uint16_t v) {
   if (jit->hasLastCode) {
     if (jit->lastCode==0b1011010000000001 && v==0b1011110000000001) {
@@ -187,17 +321,6 @@ void jsjcEmit16(uint16_t v) {
   jit->lastCode = v;
 }
 
-// Emit a whole block of code
-void jsjcEmitBlock(JsVar *block) {
-  DEBUG_JIT("... code block ...\n");
-  jsjcFlushCode();
-  jsvStringIteratorAppendString(&jit->codeIt, block, 0, JSVAPPENDSTRINGVAR_MAXLENGTH);
-}
-
-int jsjcGetByteCount() {
-  return jsvGetStringLength(jit->code) + (jit->hasLastCode?2:0);
-}
-
 void jsjcLiteral8(int reg, uint8_t data) {
   assert(reg<8);
   // https://web.eecs.umich.edu/~prabal/teaching/eecs373-f11/readings/ARMv7-M_ARM.pdf page 347
@@ -223,10 +346,17 @@ void jsjcLiteral32(int reg, uint32_t data) {
   DEBUG_JIT("MOV r%d,#0x%08x\n", reg,data);
   // bit shifted 8 bits? https://developer.arm.com/documentation/ddi0308/d/Thumb-Instructions/Immediate-constants/Encoding?lang=en
   // https://developer.arm.com/documentation/ddi0308/d/Thumb-Instructions/Alphabetical-list-of-Thumb-instructions/MOVT
+  int poolOffset;
   if (data<256) {
     jsjcLiteral8(reg, (uint8_t)data);
   } else if (data<65536) {
     jsjcLiteral16(reg, false, (uint16_t)data);
+  } else if ((poolOffset = jsjcGetConstPoolOffset(data)) >= 0) {
+    // LDR.W from the constant pool is 4 bytes rather than 8 for MOVW+MOVT
+    DEBUG_JIT("LDR.W r%d,[r8,#%d]\n", reg, poolOffset);
+    jsjcEmit16((uint16_t)(0b1111100011010000 | 8/*Rn*/));
+    jsjcEmit16((uint16_t)((reg<<12) | poolOffset));
+    jit->constPoolSaved += 4;
   } else {
     // FIXME - what about signed values?
     jsjcLiteral16(reg, false, (uint16_t)data);
@@ -239,6 +369,14 @@ void jsjcLiteral64(int reg, uint64_t data) {
   jsjcLiteral32(reg+1, (uint32_t)(data>>32));
 }
 
+void jsjcLiteralPointer(int reg, void *data) {
+  jsjcLiteral32(reg, (uint32_t)(size_t)data);
+}
+
+void jsjcExtendBool() {
+  // AAPCS says the callee has already zero-extended bools to 32 bits
+}
+
 int jsjcLiteralString(int reg, JsVar *str, bool nullTerminate) {
   /* We store the String data here in-line, so store the PC location then jump forward over the data. */
   int len = (int)jsvGetStringLength(str);
@@ -377,11 +515,32 @@ void jsjcMov(int regTo, int regFrom) {
 
 void jsjcAdd(int regTo, int regFrom, int lit) {
   // https://developer.arm.com/documentation/ddi0308/d/Thumb-Instructions/Alphabetical-list-of-Thumb-instructions/ADD--immediate-
-  DEBUG_JIT("ADD r%d <- r%d + #%d\n", regTo, regFrom, lit);
   assert(regTo>=0 && regTo<8);
   assert(regFrom>=0 && regFrom<8);
-  assert(lit>=0 && lit<8);
-  jsjcEmit16((uint16_t)(0b0001110000000000 | (lit<<6) | (regFrom<<3) | (regTo)));
+  assert(lit>-8 && lit<8);
+  if (lit<0) { // SUBS
+    DEBUG_JIT("SUBS r%d <- r%d - #%d\n", regTo, regFrom, -lit);
+    jsjcEmit16((uint16_t)(0b0001111000000000 | ((-lit)<<6) | (regFrom<<3) | (regTo)));
+  } else {
+    DEBUG_JIT("ADDS r%d <- r%d + #%d\n", regTo, regFrom, lit);
+    jsjcEmit16((uint16_t)(0b0001110000000000 | (lit<<6) | (regFrom<<3) | (regTo)));
+  }
+}
+
+void jsjcAddReg(int regTo, int regA, int regB) {
+  DEBUG_JIT("ADDS r%d <- r%d + r%d\n", regTo, regA, regB);
+  assert(regTo>=0 && regTo<8);
+  assert(regA>=0 && regA<8);
+  assert(regB>=0 && regB<8);
+  jsjcEmit16((uint16_t)(0b0001100000000000 | (regB<<6) | (regA<<3) | (regTo)));
+}
+
+void jsjcSubReg(int regTo, int regA, int regB) {
+  DEBUG_JIT("SUBS r%d <- r%d - r%d\n", regTo, regA, regB);
+  assert(regTo>=0 && regTo<8);
+  assert(regA>=0 && regA<8);
+  assert(regB>=0 && regB<8);
+  jsjcEmit16((uint16_t)(0b0001101000000000 | (regB<<6) | (regA<<3) | (regTo)));
 }
 
 // Move negated register
@@ -400,49 +559,46 @@ void jsjcAND(int regTo, int regFrom) {
   jsjcEmit16((uint16_t)(0b0100000000000000 | (regFrom<<3) | (regTo)));
 }
 
-// Convert the var type in the given reg to a JsVar
-JsjValueType jsjcConvertToJsVar(int reg, JsjValueType varType) {
-  if (varType==JSJVT_UNDEFINED)
-    return JSJVT_JSVAR_NO_NAME;
-  if (varType==JSJVT_JSVAR || varType==JSJVT_JSVAR_NO_NAME)
-    return varType; // no conversion needed
-  if (varType==JSJVT_BOOL) {
-    if (reg) jsjcMov(0, reg);
-    jsjcCall(jsvNewFromBool); // FIXME: what about clobbering r1-r3? Do a push/pop?
-    if (reg) jsjcMov(reg, 0);
-    return JSJVT_JSVAR_NO_NAME;
-  }
-  if (varType==JSJVT_INT) {
-    if (reg) jsjcMov(0, reg);
-    jsjcCall(jsvNewFromInteger); // FIXME: what about clobbering r1-r3? Do a push/pop?
-    if (reg) jsjcMov(reg, 0);
-    return JSJVT_JSVAR_NO_NAME;
-  }
-  assert(0);
-  return JSJVT_UNDEFINED;
+// regTo = regTo | regFrom
+void jsjcORR(int regTo, int regFrom) {
+  DEBUG_JIT("ORRS r%d <- r%d\n", regTo, regFrom);
+  assert(regTo>=0 && regTo<8);
+  assert(regFrom>=0 && regFrom<8);
+  jsjcEmit16((uint16_t)(0b0100001100000000 | (regFrom<<3) | (regTo)));
+}
+
+// regTo = regTo ^ regFrom
+void jsjcEOR(int regTo, int regFrom) {
+  DEBUG_JIT("EORS r%d <- r%d\n", regTo, regFrom);
+  assert(regTo>=0 && regTo<8);
+  assert(regFrom>=0 && regFrom<8);
+  jsjcEmit16((uint16_t)(0b0100000001000000 | (regFrom<<3) | (regTo)));
+}
+
+// Compare two registers. jsjcBranchConditionalRelative can then be called
+void jsjcCompare(int regA, int regB) {
+  DEBUG_JIT("CMP r%d,r%d\n", regA, regB);
+  assert(regA>=0 && regA<8);
+  assert(regB>=0 && regB<8);
+  jsjcEmit16((uint16_t)(0b0100001010000000 | (regB<<3) | (regA)));
+}
+
+// Test bit 0 of a register - afterwards JSJAC_EQ means it was 0
+void jsjcTestBit0(int reg) {
+  // https://developer.arm.com/documentation/ddi0308/d/Thumb-Instructions/Alphabetical-list-of-Thumb-instructions/TST--immediate-
+  DEBUG_JIT("TST r%d,#1\n", reg);
+  assert(reg>=0 && reg<8);
+  jsjcEmit16((uint16_t)(0b1111000000010000 | reg));
+  jsjcEmit16((uint16_t)(0b0000111100000001));
 }
 
 void jsjcPush(int reg, JsjValueType type) {
   DEBUG_JIT("PUSH {r%d}   (%s => stack depth %d)\n", reg, jsjcGetTypeName(type), jit->stackDepth+1);
-  if (jit->stackDepth>=JSJ_TYPE_STACK_SIZE) { // not enough space on type stack
-    DEBUG_JIT("!!! not enough space on type stack - converting to JsVar\n");
-    jsjcConvertToJsVar(reg, type);
-    type = JSJVT_JSVAR;
-  } else
-    jit->typeStack[jit->stackDepth] = type;
-  jit->stackDepth++;
+  jsjcPushType(reg, type);
   assert(reg>=0 && reg<8);
   jsjcEmit16((uint16_t)(0b1011010000000000 | (1<<reg)));
 }
 
-// Get the type of the variable on the top of the stack
-JsjValueType jsjcGetTopType() {
-  assert(jit->stackDepth>0);
-  if (jit->stackDepth==0) return JSJVT_UNDEFINED; // Error!
-  if (jit->stackDepth>JSJ_TYPE_STACK_SIZE) return JSJVT_JSVAR; // If too many types, assume JSVAR (we convert when we push)
-  return jit->typeStack[jit->stackDepth-1];
-}
-
 JsjValueType jsjcPop(int reg) {
   JsjValueType varType = jsjcGetTopType();
   jit->stackDepth--;
@@ -470,10 +626,10 @@ void jsjcLoadImm(int reg, int regAddr, int offset) {
   assert((offset&3)==0 && offset>=0);
   // https://developer.arm.com/documentation/ddi0308/d/Thumb-Instructions/Alphabetical-list-of-Thumb-instructions/LDR--immediate-
   if (regAddr == JSJAR_SP) {
-    assert(reg<2);
-    assert(offset<4096);
+    assert(reg<8);
+    assert(offset<1024);
     DEBUG_JIT("LDR r%d,[SP,#%d]\n", reg, offset);
-    jsjcEmit16((uint16_t)(0b1001100000000000 | (offset>>2) | (reg<<10)));
+    jsjcEmit16((uint16_t)(0b1001100000000000 | (offset>>2) | (reg<<8)));
   } else {
     assert(reg<8);
     assert(regAddr<8);
@@ -484,21 +640,505 @@ void jsjcLoadImm(int reg, int regAddr, int offset) {
 }
 
 void jsjcStoreImm(int reg, int regAddr, int offset) {
-  assert((offset&3)==0 && offset>=0 && offset<128);
+  assert((offset&3)==0 && offset>=0);
   assert(reg<8);
-  assert(regAddr<8);
-  DEBUG_JIT("STR r%d,r%d,#%d\n", reg, regAddr, offset);
-  jsjcEmit16((uint16_t)(0b0110000000000000 | ((offset>>2)<<6) | (regAddr<<3) | reg));
+  if (regAddr == JSJAR_SP) {
+    assert(offset<1024);
+    DEBUG_JIT("STR r%d,[SP,#%d]\n", reg, offset);
+    jsjcEmit16((uint16_t)(0b1001000000000000 | (offset>>2) | (reg<<8)));
+  } else {
+    assert(regAddr<8);
+    assert(offset<128);
+    DEBUG_JIT("STR r%d,r%d,#%d\n", reg, regAddr, offset);
+    jsjcEmit16((uint16_t)(0b0110000000000000 | ((offset>>2)<<6) | (regAddr<<3) | reg));
+  }
 }
 
 void jsjcPushAll() {
-  DEBUG_JIT("PUSH {r4,r5,r6,r7,lr}\n");
-  jsjcEmit16(0xb5f0);
+  // r8 holds the constant pool address - see jsjcLoadConstPoolAddress
+  DEBUG_JIT("PUSH.W {r4,r5,r6,r7,r8,lr}\n");
+  jsjcEmit16(0xe92d);
+  jsjcEmit16(0x41f0);
 }
 void jsjcPopAllAndReturn() {
-  DEBUG_JIT("POP {r4,r5,r6,r7,pc}\n");
-  jsjcEmit16(0xbdf0);
+  DEBUG_JIT("POP.W {r4,r5,r6,r7,r8,pc}\n");
+  jsjcEmit16(0xe8bd);
+  jsjcEmit16(0x81f0);
+  jit->constPoolSaved -= 2; // POP.W is 2 bytes more than POP
+}
+
+void jsjcLoadConstPoolAddress() {
+  assert(jit->blockCount==0);
+  jit->constPoolLoadPos = jsjcGetByteCount();
+  // the offset is filled in by jsjcPatchConstPoolAddress once we know how big the code is
+  jsjcLiteral16(8, false, 0);
+  DEBUG_JIT("ADD r8,pc\n");
+  jsjcEmit16(0x44f8);
+  jit->constPoolSaved -= 8; // MOVW+ADD, and PUSH.W being 2 bytes more than PUSH
+}
+
+static void jsjcPatchConstPoolAddress(char *code, int poolOffset) {
+  poolOffset -= 8; // PC reads as the address of the ADD (4 bytes after MOVW) plus 4
+  if (poolOffset>=65536) {
+    jsExceptionHere(JSET_ERROR, "JIT: Function too large");
+    return;
+  }
+  // MOVW r8,#poolOffset - see jsjcLiteral16
+  uint16_t hw[2] = {
+    (uint16_t)(0b1111001001000000 | (((poolOffset>>11)&1)<<10) | ((poolOffset>>12)&15)),
+    (uint16_t)((((poolOffset>>8)&7)<<12) | (poolOffset&255) | (8<<8))
+  };
+  memcpy(code, hw, sizeof(hw));
+}
+
+#else // JSJ_X86_64
+// ============================================================================ x86-64
+/* x86-64 register numbers for each of our registers. r0-r3 are the SysV argument
+registers so no shuffling is needed before a call, and r4-r7 are callee-saved
+just like on ARM. rax (return value), r8 (5th argument) and r11 (call address)
+are only ever used as scratch registers inside a single primitive */
+static const uint8_t JSJ_X86_REGS[16] = {
+  7/*rdi*/, 6/*rsi*/, 2/*rdx*/, 1/*rcx*/, 3/*rbx*/, 12/*r12*/, 13/*r13*/, 14/*r14*/,
+  255, 255, 255, 255, 255, 4/*rsp*/, 255, 255
+};
+static const char *JSJ_X86_REG_NAMES = "rax\0\0rcx\0\0rdx\0\0rbx\0\0rsp\0\0rbp\0\0rsi\0\0rdi\0\0r8\0\0\0r9\0\0\0r10\0\0r11\0\0r12\0\0r13\0\0r14\0\0r15";
+static const char *JSJ_X86_REG_NAMES32 = "eax\0\0ecx\0\0edx\0\0ebx\0\0esp\0\0ebp\0\0esi\0\0edi\0\0r8d\0\0r9d\0\0r10d\0r11d\0r12d\0r13d\0r14d\0r15d";
+// x86 condition code for each JsjAsmCondition (EQ,NE,CS,CC,MI,PL,VS,VC,HI,LI,GE,LT,GT,LE)
+static const uint8_t JSJ_X86_CONDITIONS[14] = { 0x4,0x5,0x3,0x2,0x8,0x9,0x0,0x1,0x7,0x6,0xD,0xC,0xF,0xE };
+
+#define JSJ_X86_RAX 0
+#define JSJ_X86_RDX 2
+#define JSJ_X86_RSP 4
+#define JSJ_X86_RBP 5
+#define JSJ_X86_RDI 7
+#define JSJ_X86_R11 11
+#define JSJ_X86_PUSH_RDI 0x57
+
+// Get the x86 register number for one of our registers
+static int jsjcX86Reg(int reg) {
+  assert(reg>=0 && reg<16 && JSJ_X86_REGS[reg]!=255);
+  return JSJ_X86_REGS[reg];
+}
+
+static const char *jsjcX86RegName(int x86reg) {
+  return &JSJ_X86_REG_NAMES[x86reg*5];
+}
+
+static const char *jsjcX86RegName32(int x86reg) {
+  return &JSJ_X86_REG_NAMES32[x86reg*5];
+}
+
+static void jsjcEmit8(uint8_t v) {
+  jsjcFlushCode();
+  jsvStringIteratorAppend(&jit->codeIt, (char)v);
+}
+
+static void jsjcEmit32(uint32_t v) {
+  for (int i=0;i<4;i++)
+    jsjcEmit8((uint8_t)(v>>(i*8)));
+}
+
+// Emit a REX prefix (if needed). r is the register in ModRM.reg, b is the one in ModRM.rm
+static void jsjcEmitREX(bool is64, int r, int b) {
+  uint8_t rex = (uint8_t)(0x40 | (is64?8:0) | ((r&8)?4:0) | ((b&8)?1:0));
+  if (rex!=0x40) jsjcEmit8(rex);
+}
+
+// ModRM for a register-register operation
+static void jsjcEmitModRMReg(int r, int b) {
+  jsjcEmit8((uint8_t)(0xC0 | ((r&7)<<3) | (b&7)));
+}
+
+// ModRM for a [base+offset] memory access
+static void jsjcEmitModRMMem(int r, int base, int offset) {
+  bool isByte = offset>=-128 && offset<128;
+  // we always include an offset so we never hit the special cases for rbp/r13
+  jsjcEmit8((uint8_t)((isByte?0x40:0x80) | ((r&7)<<3) | (base&7)));
+  if ((base&7)==JSJ_X86_RSP) jsjcEmit8(0x24); // SIB byte needed for rsp/r12
+  if (isByte) jsjcEmit8((uint8_t)offset);
+  else jsjcEmit32((uint32_t)offset);
+}
+
+// x86reg = x86reg2 (64 bit)
+static void jsjcX86Mov(int x86RegTo, int x86RegFrom) {
+  DEBUG_JIT("MOV %s,%s\n", jsjcX86RegName(x86RegTo), jsjcX86RegName(x86RegFrom));
+  jsjcEmitREX(true, x86RegFrom, x86RegTo);
+  jsjcEmit8(0x89);
+  jsjcEmitModRMReg(x86RegFrom, x86RegTo);
+}
+
+// add or subtract a constant to RSP
+static void jsjcX86AddRSP(int amt) {
+  DEBUG_JIT("%s rsp,#%d\n", (amt<0)?"SUB":"ADD", (amt<0)?-amt:amt);
+  int op = (amt<0) ? 5 : 0; // ADD is /0, SUB is /5
+  if (amt<0) amt = -amt;
+  jsjcEmitREX(true, 0, JSJ_X86_RSP);
+  jsjcEmit8((amt<128) ? 0x83 : 0x81);
+  jsjcEmitModRMReg(op, JSJ_X86_RSP);
+  if (amt<128) jsjcEmit8((uint8_t)amt);
+  else jsjcEmit32((uint32_t)amt);
+}
+
+void jsjcLiteral8(int reg, uint8_t data) {
+  jsjcLiteral32(reg, data);
+}
+
+void jsjcLiteral16(int reg, bool hi16, uint16_t data) {
+  assert(!hi16); // only used for ARM's MOVT
+  jsjcLiteral32(reg, data);
+}
+
+void jsjcLiteral32(int reg, uint32_t data) {
+  int r = jsjcX86Reg(reg);
+  DEBUG_JIT("MOV %s,#0x%08x\n", jsjcX86RegName32(r), data);
+  // 32 bit MOV zero-extends to 64 bits - like we'd get on ARM
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8((uint8_t)(0xB8 | (r&7)));
+  jsjcEmit32(data);
+}
+
+void jsjcLiteral64(int reg, uint64_t data) {
+  if (!(data>>32)) {
+    jsjcLiteral32(reg, (uint32_t)data);
+    return;
+  }
+  int r = jsjcX86Reg(reg);
+  int poolOffset = jsjcGetConstPoolOffset((size_t)data);
+  if (poolOffset>=0) {
+    DEBUG_JIT("MOV %s,[rbp+%d]\n", jsjcX86RegName(r), poolOffset);
+    jsjcEmitREX(true, r, JSJ_X86_RBP);
+    jsjcEmit8(0x8B);
+    jsjcEmitModRMMem(r, JSJ_X86_RBP, poolOffset);
+    jit->constPoolSaved += (poolOffset<128) ? 6 : 3; // vs 10 bytes for MOVABS
+    return;
+  }
+  DEBUG_JIT("MOVABS %s,#0x%08x%08x\n", jsjcX86RegName(r), (uint32_t)(data>>32), (uint32_t)data);
+  jsjcEmitREX(true, 0, r);
+  jsjcEmit8((uint8_t)(0xB8 | (r&7)));
+  jsjcEmit32((uint32_t)data);
+  jsjcEmit32((uint32_t)(data>>32));
+}
+
+void jsjcLiteralPointer(int reg, void *data) {
+  jsjcLiteral64(reg, (uint64_t)(size_t)data);
+}
+
+void jsjcExtendBool() {
+  // SysV only defines the bottom 8 bits of a bool return value. jsjcCall has copied rax to rdi
+  DEBUG_JIT("MOVZX edi,al\n");
+  jsjcEmit8(0x0F);
+  jsjcEmit8(0xB6);
+  jsjcEmitModRMReg(JSJ_X86_RDI, JSJ_X86_RAX);
+}
+
+int jsjcLiteralString(int reg, JsVar *str, bool nullTerminate) {
+  /* We store the String data here in-line, so get the RIP-relative address then jump forward over the data. */
+  int len = (int)jsvGetStringLength(str);
+  int realLen = len + (nullTerminate?1:0);
+  int branchLen = jsjcGetBranchRelativeLength(realLen);
+  int r = jsjcX86Reg(reg);
+  DEBUG_JIT("LEA %s,[rip+%d]\n", jsjcX86RegName(r), branchLen);
+  jsjcEmitREX(true, r, 0);
+  jsjcEmit8(0x8D);
+  jsjcEmit8((uint8_t)(0x05 | ((r&7)<<3))); // RIP-relative
+  jsjcEmit32((uint32_t)branchLen);
+  // jump over the data
+  jsjcBranchRelative(realLen, JSJC_NONE);
+  // write the data
+  DEBUG_JIT("... %d bytes data (%q) ...\n", (uint32_t)(realLen), str);
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, str, 0);
+  for (int i=0;i<realLen;i++)
+    jsjcEmit8((uint8_t)jsvStringIteratorGetCharAndNext(&it));
+  jsvStringIteratorFree(&it);
+  return len;
+}
+
+// Compare a register with a literal. jsjcBranchConditionalRelative can then be called
+void jsjcCompareImm(int reg, int literal) {
+  int r = jsjcX86Reg(reg);
+  DEBUG_JIT("CMP %s,#%d\n", jsjcX86RegName32(r), literal);
+  bool isByte = literal>=-128 && literal<128;
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8(isByte ? 0x83 : 0x81);
+  jsjcEmitModRMReg(7, r); // CMP is /7
+  if (isByte) jsjcEmit8((uint8_t)literal);
+  else jsjcEmit32((uint32_t)literal);
+}
+
+// Get length of jsjcBranchRelative in bytes
+int jsjcGetBranchRelativeLength(int bytes) {
+  if (bytes<-128 || bytes>=128)
+    return JSJ_BRANCH_LONG_LENGTH;
+  return 2;
+}
+
+// Jump a number of bytes forward or back, return number of bytes used for op
+int jsjcBranchRelative(int bytes, JsjsEmitOptions options) {
+  // 'bytes' is relative to the end of this instruction, which is what x86 does anyway
+  if (jsjcGetBranchRelativeLength(bytes)==2 && !(options&JSJC_FORCE_4BYTE)) {
+    DEBUG_JIT("JMP %s%d (addr 0x%04x)\n", (bytes>=0)?"+":"", (uint32_t)(bytes), jsjcGetByteCount()+2+bytes);
+    jsjcEmit8(0xEB);
+    jsjcEmit8((uint8_t)bytes);
+    return 2;
+  } else {
+    DEBUG_JIT("JMP.32 %s%d (addr 0x%04x)\n", (bytes>=0)?"+":"", (uint32_t)(bytes), jsjcGetByteCount()+JSJ_BRANCH_LONG_LENGTH+bytes);
+    jsjcEmit8(0xE9);
+    jsjcEmit32((uint32_t)bytes);
+    return JSJ_BRANCH_LONG_LENGTH;
+  }
+}
+
+// Get length of jsjcBranchConditionalRelative in bytes
+int jsjcGetBranchConditionalRelativeLength(int bytes) {
+  if (bytes<-128 || bytes>=128)
+    return JSJ_BRANCH_CONDITIONAL_LONG_LENGTH;
+  return 2;
+}
+
+// Jump a number of bytes forward or back, based on condition flags, return number of bytes used for op
+int jsjcBranchConditionalRelative(JsjAsmCondition cond, int bytes, JsjsEmitOptions options) {
+  assert(cond<14); // JSJAC_AL has a special meaning for these instructions
+  uint8_t cc = JSJ_X86_CONDITIONS[cond];
+  if (jsjcGetBranchConditionalRelativeLength(bytes)==2 && !(options&JSJC_FORCE_4BYTE)) {
+    DEBUG_JIT("J<%s> %s%d (addr 0x%04x)\n", &JSJAC_STRINGS[cond*3], (bytes>=0)?"+":"", (uint32_t)(bytes), jsjcGetByteCount()+2+bytes);
+    jsjcEmit8((uint8_t)(0x70 | cc));
+    jsjcEmit8((uint8_t)bytes);
+    return 2;
+  } else {
+    DEBUG_JIT("J<%s>.32 %s%d (addr 0x%04x)\n", &JSJAC_STRINGS[cond*3], (bytes>=0)?"+":"", (uint32_t)(bytes), jsjcGetByteCount()+JSJ_BRANCH_CONDITIONAL_LONG_LENGTH+bytes);
+    jsjcEmit8(0x0F);
+    jsjcEmit8((uint8_t)(0x80 | cc));
+    jsjcEmit32((uint32_t)bytes);
+    return JSJ_BRANCH_CONDITIONAL_LONG_LENGTH;
+  }
+}
+
+#ifdef DEBUG_JIT_CALLS
+void _jsjcCall(void *c, const char *name) {
+#else
+void jsjcCall(void *c) {
+#endif
+  /* We know exactly what's on the stack - PushAll leaves it 16 byte aligned, so
+  we just need to realign if we have an odd number of things pushed */
+  bool realign = jit->stackDepth&1;
+  // The 5th argument is on the top of the stack as per ARM - SysV wants it in r8
+  DEBUG_JIT("MOV r8,[rsp]\n");
+  jsjcEmit8(0x4C);
+  jsjcEmit8(0x8B);
+  jsjcEmitModRMMem(8, JSJ_X86_RSP, 0);
+  if (realign) jsjcX86AddRSP(-8);
+  uint64_t addr = (uint64_t)(size_t)c;
+  int poolOffset = jsjcGetConstPoolOffset((size_t)addr);
+  if (poolOffset>=0) {
+#ifdef DEBUG_JIT_CALLS
+    DEBUG_JIT("CALL [rbp+%d] (%s)\n", poolOffset, name);
+#else
+    DEBUG_JIT("CALL [rbp+%d]\n", poolOffset);
+#endif
+    jsjcEmit8(0xFF);
+    jsjcEmitModRMMem(2, JSJ_X86_RBP, poolOffset); // CALL is /2
+    jit->constPoolSaved += (poolOffset<128) ? 10 : 7; // vs 13 bytes for MOVABS+CALL
+  } else {
+    DEBUG_JIT("MOVABS r11,#0x%08x%08x\n", (uint32_t)(addr>>32), (uint32_t)addr);
+    jsjcEmitREX(true, 0, JSJ_X86_R11);
+    jsjcEmit8((uint8_t)(0xB8 | (JSJ_X86_R11&7)));
+    jsjcEmit32((uint32_t)addr);
+    jsjcEmit32((uint32_t)(addr>>32));
+#ifdef DEBUG_JIT_CALLS
+    DEBUG_JIT("CALL r11 (%s)\n", name);
+#else
+    DEBUG_JIT("CALL r11\n");
+#endif
+    jsjcEmitREX(false, 0, JSJ_X86_R11);
+    jsjcEmit8(0xFF);
+    jsjcEmitModRMReg(2, JSJ_X86_R11); // CALL is /2
+  }
+  if (realign) jsjcX86AddRSP(8);
+  // Return values come back in rax:rdx - put them in r0:r1 like ARM
+  jsjcX86Mov(JSJ_X86_RDI, JSJ_X86_RAX);
+  jsjcX86Mov(jsjcX86Reg(1), JSJ_X86_RDX);
+}
+
+void jsjcMov(int regTo, int regFrom) {
+  jsjcX86Mov(jsjcX86Reg(regTo), jsjcX86Reg(regFrom));
+}
+
+// 32 bit ALU op on two registers: x86RegTo = x86RegTo op x86RegFrom (opcode is the 'r/m32, r32' form)
+static void jsjcX86Op32(uint8_t opcode, const char *name, int x86RegTo, int x86RegFrom) {
+  DEBUG_JIT("%s %s,%s\n", name, jsjcX86RegName32(x86RegTo), jsjcX86RegName32(x86RegFrom));
+  jsjcEmitREX(false, x86RegFrom, x86RegTo);
+  jsjcEmit8(opcode);
+  jsjcEmitModRMReg(x86RegFrom, x86RegTo);
+}
+
+void jsjcAdd(int regTo, int regFrom, int lit) {
+  assert(lit>=-128 && lit<128);
+  if (regTo!=regFrom) jsjcMov(regTo, regFrom);
+  int r = jsjcX86Reg(regTo);
+  DEBUG_JIT("%s %s,#%d\n", (lit<0)?"SUB":"ADD", jsjcX86RegName32(r), (lit<0)?-lit:lit);
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8(0x83);
+  jsjcEmitModRMReg((lit<0) ? 5 : 0, r); // ADD is /0, SUB is /5
+  jsjcEmit8((uint8_t)((lit<0)?-lit:lit));
+}
+
+void jsjcAddReg(int regTo, int regA, int regB) {
+  if (regTo==regB) { // addition is commutative
+    regB = regA;
+  } else if (regTo!=regA) jsjcMov(regTo, regA);
+  jsjcX86Op32(0x01, "ADD", jsjcX86Reg(regTo), jsjcX86Reg(regB));
+}
+
+void jsjcSubReg(int regTo, int regA, int regB) {
+  assert(regTo!=regB || regTo==regA);
+  if (regTo!=regA) jsjcMov(regTo, regA);
+  jsjcX86Op32(0x29, "SUB", jsjcX86Reg(regTo), jsjcX86Reg(regB));
+}
+
+// Move negated register
+void jsjcMVN(int regTo, int regFrom) {
+  if (regTo!=regFrom) jsjcMov(regTo, regFrom);
+  int r = jsjcX86Reg(regTo);
+  DEBUG_JIT("NOT %s\n", jsjcX86RegName32(r));
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8(0xF7);
+  jsjcEmitModRMReg(2, r); // NOT is /2
+}
+
+// regTo = regTo & regFrom
+void jsjcAND(int regTo, int regFrom) {
+  jsjcX86Op32(0x21, "AND", jsjcX86Reg(regTo), jsjcX86Reg(regFrom));
+}
+
+// regTo = regTo | regFrom
+void jsjcORR(int regTo, int regFrom) {
+  jsjcX86Op32(0x09, "OR", jsjcX86Reg(regTo), jsjcX86Reg(regFrom));
+}
+
+// regTo = regTo ^ regFrom
+void jsjcEOR(int regTo, int regFrom) {
+  jsjcX86Op32(0x31, "XOR", jsjcX86Reg(regTo), jsjcX86Reg(regFrom));
+}
+
+// Compare two registers. jsjcBranchConditionalRelative can then be called
+void jsjcCompare(int regA, int regB) {
+  jsjcX86Op32(0x39, "CMP", jsjcX86Reg(regA), jsjcX86Reg(regB));
+}
+
+// Test bit 0 of a register - afterwards JSJAC_EQ means it was 0
+void jsjcTestBit0(int reg) {
+  int r = jsjcX86Reg(reg);
+  DEBUG_JIT("TEST %s,#1\n", jsjcX86RegName32(r));
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8(0xF7);
+  jsjcEmitModRMReg(0, r); // TEST is /0
+  jsjcEmit32(1);
+}
+
+void jsjcPush(int reg, JsjValueType type) {
+  int r = jsjcX86Reg(reg);
+  DEBUG_JIT("PUSH %s   (%s => stack depth %d)\n", jsjcX86RegName(r), jsjcGetTypeName(type), jit->stackDepth+1);
+  jsjcPushType(reg, type);
+  if (r==JSJ_X86_RDI) { // hold this back in case the next thing is a POP
+    jsjcFlushCode();
+    jit->hasLastCode = true;
+    jit->lastCode = JSJ_X86_PUSH_RDI;
+    return;
+  }
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8((uint8_t)(0x50 | (r&7)));
+}
+
+JsjValueType jsjcPop(int reg) {
+  JsjValueType varType = jsjcGetTopType();
+  jit->stackDepth--;
+  int r = jsjcX86Reg(reg);
+  if (jit->hasLastCode && jit->lastCode==JSJ_X86_PUSH_RDI) {
+    jit->hasLastCode = false;
+    if (r==JSJ_X86_RDI) {
+      DEBUG_JIT("PEEPHOLE: PUSH rdi + POP rdi => nop\n");
+    } else {
+      DEBUG_JIT("PEEPHOLE: PUSH rdi + POP %s => MOV\n", jsjcX86RegName(r));
+      jsjcX86Mov(r, JSJ_X86_RDI);
+    }
+    return varType;
+  }
+  DEBUG_JIT("POP %s   (%s <= stack depth %d)\n", jsjcX86RegName(r), jsjcGetTypeName(varType), jit->stackDepth);
+  jsjcEmitREX(false, 0, r);
+  jsjcEmit8((uint8_t)(0x58 | (r&7)));
+  return varType;
+}
+
+void jsjcAddSP(int amt) {
+  assert((amt&(JSJ_WORD_SIZE-1))==0 && amt>0);
+  jit->stackDepth -= amt/JSJ_WORD_SIZE; // stack grows down -> negate
+  jsjcX86AddRSP(amt);
+}
+
+void jsjcSubSP(int amt) {
+  assert((amt&(JSJ_WORD_SIZE-1))==0 && amt>0);
+  jit->stackDepth += amt/JSJ_WORD_SIZE;
+  jsjcX86AddRSP(-amt);
+}
+
+// reg = mem[regAddr + offset] (64 bit)
+void jsjcLoadImm(int reg, int regAddr, int offset) {
+  int r = jsjcX86Reg(reg), ra = jsjcX86Reg(regAddr);
+  DEBUG_JIT("MOV %s,[%s+%d]\n", jsjcX86RegName(r), jsjcX86RegName(ra), offset);
+  jsjcEmitREX(true, r, ra);
+  jsjcEmit8(0x8B);
+  jsjcEmitModRMMem(r, ra, offset);
+}
+
+// mem[regAddr + offset] = reg (64 bit)
+void jsjcStoreImm(int reg, int regAddr, int offset) {
+  int r = jsjcX86Reg(reg), ra = jsjcX86Reg(regAddr);
+  DEBUG_JIT("MOV [%s+%d],%s\n", jsjcX86RegName(ra), offset, jsjcX86RegName(r));
+  jsjcEmitREX(true, r, ra);
+  jsjcEmit8(0x89);
+  jsjcEmitModRMMem(r, ra, offset);
+}
+
+void jsjcPushAll() {
+  // rbp holds the constant pool address (see jsjcLoadConstPoolAddress), and pushing 5 registers keeps the stack 16 byte aligned for calls
+  DEBUG_JIT("PUSH rbp,rbx,r12,r13,r14\n");
+  jsjcEmit8(0x55);
+  jsjcEmit8(0x53);
+  jsjcEmit8(0x41); jsjcEmit8(0x54);
+  jsjcEmit8(0x41); jsjcEmit8(0x55);
+  jsjcEmit8(0x41); jsjcEmit8(0x56);
+}
+
+void jsjcPopAllAndReturn() {
+  jsjcX86Mov(JSJ_X86_RAX, JSJ_X86_RDI); // return value
+  DEBUG_JIT("POP r14,r13,r12,rbx,rbp\n");
+  jsjcEmit8(0x41); jsjcEmit8(0x5E);
+  jsjcEmit8(0x41); jsjcEmit8(0x5D);
+  jsjcEmit8(0x41); jsjcEmit8(0x5C);
+  jsjcEmit8(0x5B);
+  jsjcEmit8(0x5D);
+  DEBUG_JIT("RET\n");
+  jsjcEmit8(0xC3);
+}
+
+void jsjcLoadConstPoolAddress() {
+  assert(jit->blockCount==0);
+  jit->constPoolLoadPos = jsjcGetByteCount();
+  // the offset is filled in by jsjcPatchConstPoolAddress once we know how big the code is
+  DEBUG_JIT("LEA rbp,[rip+constpool]\n");
+  jsjcEmitREX(true, JSJ_X86_RBP, 0);
+  jsjcEmit8(0x8D);
+  jsjcEmit8((uint8_t)(0x05 | ((JSJ_X86_RBP&7)<<3))); // RIP-relative
+  jsjcEmit32(0);
+  jit->constPoolSaved -= 7;
+}
+
+static void jsjcPatchConstPoolAddress(char *code, int poolOffset) {
+  uint32_t rel = (uint32_t)(poolOffset - 7); // relative to the end of the 7 byte LEA
+  memcpy(&code[3], &rel, 4);
 }
+#endif // JSJ_X86_64
 
 /*void jsjcReturn() {
   DEBUG_JIT("BX LR\n");
@@ -34,16 +34,40 @@ void jsjcDebugPrintf(const char *fmt, ...);
 
 #define JSJ_TYPE_STACK_SIZE 64 // Most amount of types stored on stack
 
+#ifdef JSJ_X86_64
+#define JSJ_WORD_SIZE 8 // Bytes used by each item pushed on the stack
+#define JSJ_BRANCH_LONG_LENGTH 5 // Length of jsjcBranchRelative with JSJC_FORCE_4BYTE (JMP rel32)
+#define JSJ_BRANCH_CONDITIONAL_LONG_LENGTH 6 // Length of jsjcBranchConditionalRelative with JSJC_FORCE_4BYTE (Jcc rel32)
+#define JSJ_CONST_POOL_MAX 0x7FFFFFFF // Largest byte offset of an item in the constant pool
+#else
+#define JSJ_WORD_SIZE 4 // Bytes used by each item pushed on the stack
+#define JSJ_BRANCH_LONG_LENGTH 4 // Length of jsjcBranchRelative with JSJC_FORCE_4BYTE
+#define JSJ_BRANCH_CONDITIONAL_LONG_LENGTH 4 // Length of jsjcBranchConditionalRelative with JSJC_FORCE_4BYTE
+#define JSJ_CONST_POOL_MAX 4092 // Largest byte offset of an item in the constant pool (LDR.W has a 12 bit offset)
+#endif
+
 typedef enum {
   JSJVT_UNDEFINED,
   JSJVT_BOOL,
   JSJVT_INT,
   JSJVT_JSVAR,        ///< A JsVar
-  JSJVT_JSVAR_NO_NAME ///< A JsVar, and we know it's not a name so it doesn't need SkipName
+  JSJVT_JSVAR_NO_NAME, ///< A JsVar, and we know it's not a name so it doesn't need SkipName
+  JSJVT_TAGGED        ///< Either a tagged int (bit 0 set) or a JsVar value (not a name) - see JSJ_TAGGED_*
 } PACKED_FLAGS JsjValueType;
 
 #define JSJVT_NEEDS_UNLOCK(t) (((t)==JSJVT_JSVAR) || ((t)==JSJVT_JSVAR_NO_NAME))
 
+/* Tagged values are used for local variables so that small ints don't need a JsVar. If
+bit 0 is set, the other 31 bits are a signed integer. Otherwise the value is a locked
+JsVarRef shifted left by 1 (so 0 is undefined) - JsVar pointers can't be used as they
+aren't always aligned. Only the bottom 32 bits of a tagged int are used (even on x86-64) */
+#define JSJ_TAGGED_INT_FITS(i) ((i)>=-(1<<30) && (i)<(1<<30))
+#define JSJ_TAGGED_FROM_INT(i) ((size_t)((((uint32_t)(i))<<1)|1))
+#define JSJ_TAGGED_GET_INT(t) (((int32_t)(uint32_t)(t))>>1)
+#define JSJ_TAGGED_IS_INT(t) (((t)&1)!=0)
+// Convert a tagged value to a locked JsVar (defined in jsjit.c, called from JIT code)
+JsVar *_jsxTaggedToJsVar(size_t t);
+
 typedef enum {
   JSJAC_EQ, // Equal / equals zero
   JSJAC_NE, // Not equal
@@ -64,6 +88,9 @@ typedef enum {
 } JsjAsmCondition;
 #define JSJAC_STRING "EQ\0NE\0CS\0CC\0MI\0PL\0VS\0VC\0HI\0LI\0GE\0LT\0GT\0LE\0AL"
 
+/* Registers as used by the JIT. On x86-64 these are mapped onto real registers
+ such that r0-r3 are the first 4 arguments (rdi,rsi,rdx,rcx) and r4-r7 are
+ callee-saved (rbx,r12,r13,r14) - see jsjcX86Reg */
 typedef enum {
   JSJAR_r0,
   JSJAR_r1,
@@ -84,7 +111,7 @@ typedef enum {
 typedef struct {
   /// Which compilation phase are we in?
   JsjPhase phase;
-  /// The ARM Thumb-2 code we're in the process of creating
+  /// The ARM Thumb-2 (or x86-64) code we're in the process of creating
   JsVar *code;
   /// An iterator to increase write speed for code
   JsvStringIterator codeIt;
@@ -104,8 +131,16 @@ typedef struct {
   int stackDepth;
   /// For each item on the stack, we store its type
   JsjValueType typeStack[JSJ_TYPE_STACK_SIZE];
+  /// For each item on the stack, if it was just read from a tagged local var this is the var's index+1, or 0 - see jsjcSetTopLocal
+  uint8_t localStack[JSJ_TYPE_STACK_SIZE];
   /// A bit mask of registers that are currently in use (r4..r7) - see jsjcClaimFreeReg jsjcReturnFreeReg
   uint8_t regsInUse;
+  /// Constant pool (function addresses/large literals, JSJ_WORD_SIZE bytes each) that goes after the code - see jsjcGetConstPoolOffset
+  JsVar *constPool;
+  /// Byte offset in 'code' of the instruction that loads the constant pool's address (patched in jsjcStop), or -1
+  int constPoolLoadPos;
+  /// How many bytes of code we've saved by using the constant pool (for jitDebug)
+  int constPoolSaved;
 } JsjInfo;
 
 // JIT state
@@ -137,8 +172,10 @@ void jsjcLiteral8(int reg, uint8_t data);
 void jsjcLiteral16(int reg, bool hi16, uint16_t data);
 // Add 32 bit literal
 void jsjcLiteral32(int reg, uint32_t data);
-// Add 64 bit literal in reg,reg+1
+// Add 64 bit literal in reg,reg+1 (or just reg on x86-64) - as needed for a 64 bit function argument
 void jsjcLiteral64(int reg, uint64_t data);
+// Add a pointer literal (eg. a function address)
+void jsjcLiteralPointer(int reg, void *data);
 // Call a function
 #ifdef DEBUG_JIT_CALLS
 void _jsjcCall(void *c, const char *name);
@@ -146,6 +183,8 @@ void _jsjcCall(void *c, const char *name);
 #else
 void jsjcCall(void *c);
 #endif
+// A function returning bool has just been called - ensure all of r0 is valid (only needed on x86-64)
+void jsjcExtendBool();
 // Store a string of data and put the address in a register. Returns the length
 int jsjcLiteralString(int reg, JsVar *str, bool nullTerminate);
 // Compare a register with a literal. jsjcBranchConditionalRelative can then be called
@@ -160,18 +199,34 @@ int jsjcGetBranchConditionalRelativeLength(int bytes);
 int jsjcBranchConditionalRelative(JsjAsmCondition cond, int bytes, JsjsEmitOptions options);
 // Move one register to another
 void jsjcMov(int regTo, int regFrom);
-// Add a literal to a number
+// regTo = regFrom + lit (32 bit, lit is -7..7) and set the condition flags
 void jsjcAdd(int regTo, int regFrom, int lit);
+// regTo = regA + regB (32 bit) and set the condition flags
+void jsjcAddReg(int regTo, int regA, int regB);
+// regTo = regA - regB (32 bit) and set the condition flags. regTo can't be regB unless it's also regA
+void jsjcSubReg(int regTo, int regA, int regB);
 // Move negated register
 void jsjcMVN(int regTo, int regFrom);
 // regTo = regTo & regFrom
 void jsjcAND(int regTo, int regFrom);
+// regTo = regTo | regFrom
+void jsjcORR(int regTo, int regFrom);
+// regTo = regTo ^ regFrom
+void jsjcEOR(int regTo, int regFrom);
+// Compare two registers (32 bit, regA-regB). jsjcBranchConditionalRelative can then be called
+void jsjcCompare(int regA, int regB);
+// Test bit 0 of a register - afterwards JSJAC_EQ means it was 0, JSJAC_NE means it was 1
+void jsjcTestBit0(int reg);
 // Convert the var type in the given reg to a JsVar
 JsjValueType jsjcConvertToJsVar(int reg, JsjValueType varType);
 // Push a register onto the stack
 void jsjcPush(int reg, JsjValueType type);
 // Get the type of the variable on the top of the stack
 JsjValueType jsjcGetTopType();
+// Mark the item on the top of the stack as having just been read from tagged local var 'varIndex'
+void jsjcSetTopLocal(int varIndex);
+// If the item on the top of the stack was just read from a tagged local var, return its index - or -1
+int jsjcGetTopLocal();
 // Pop off the stack to a register
 JsjValueType jsjcPop(int reg);
 // Add a value to the stack pointer (only multiple of 4)
@@ -185,6 +240,8 @@ void jsjcStoreImm(int reg, int regAddr, int offset);
 
 void jsjcPushAll();
 void jsjcPopAllAndReturn();
+// Load the address of the constant pool into a register (r8, or rbp on x86-64) - call right after jsjcPushAll
+void jsjcLoadConstPoolAddress();
 
 /// Get the number of a register that we're free to use (or error is none free) and mark as in use
 int jsjcClaimFreeReg();
@@ -629,6 +629,8 @@ void jslGetNextToken() {
   }
   // record beginning of this token
   lex->tokenLastStart = lex->tokenStart;
+  lex->tokenLastBlockEnd = lex->tokenBlockEnd;
+  lex->tokenBlockEnd = 0;
   unsigned char jumpCh = (unsigned char)lex->currCh;
   if (jumpCh > jslJumpTableEnd) jumpCh = 0; // which also happens to be JSLJT_SINGLE_CHAR - what we want. Could be pretokenised too
   jslGetNextToken_start:
@@ -664,6 +666,13 @@ void jslGetNextToken() {
           value |= ((char)lex->currCh)<<8;
           jslGetNextCh();
           lex->tokenValue = jsvNewFromInteger(value);
+        } else if (lex->tk == LEX_RAW_BLOCK) {
+          lex->tk = '{';
+          size_t offset = (unsigned char)lex->currCh & 127;
+          jslGetNextCh();
+          offset |= ((size_t)((unsigned char)lex->currCh & 127))<<7;
+          jslGetNextCh();
+          if (offset) lex->tokenBlockEnd = jsvStringIteratorGetIndex(&lex->it) - 1 + offset;
         }
       }
       break;
@@ -941,10 +950,12 @@ static JSLEX_INLINE void jslPreload() {
 void jslInit(JsVar *var) {
   assert(jsvIsString(var));
   lex->sourceVar = jsvLockAgain(var);
+  jsvShapeEpoch++; // names looked up by position in the last source are no longer valid
   // reset stuff
   lex->tk = 0;
   lex->tokenStart = 0;
   lex->tokenLastStart = 0;
+  lex->tokenBlockEnd = 0;
   lex->tokenl = 0;
   lex->tokenValue = 0;
   lex->functionName = NULL;
@@ -973,6 +984,7 @@ void jslSeekTo(size_t seekToChar) {
   jsvUnLock(lex->it.var); // see jslGetNextCh
   lex->tokenStart = 0;
   lex->tokenLastStart = 0;
+  lex->tokenBlockEnd = 0;
   lex->tk = LEX_EOF;
   jslPreload();
 }
@@ -985,6 +997,7 @@ void jslSeekToP(JslCharPos *seekToChar) {
   lex->currCh = seekToChar->currCh;
   lex->tokenStart = 0;
   lex->tokenLastStart = 0;
+  lex->tokenBlockEnd = 0;
   lex->tk = LEX_EOF;
   jslGetNextToken();
 }
@@ -1200,6 +1213,9 @@ bool jslMatch(int expected_tk) {
 }
 
 #ifndef ESPR_NO_PRETOKENISE
+/// How deeply nested blocks can be and still have LEX_RAW_BLOCK written for them when pretokenising
+#define JSLEX_BLOCK_STACK_SIZE 16
+
 // When minifying/pretokenising, do we need to insert a space between these tokens?
 static bool jslPreserveSpaceBetweenTokens(int lastTk, int newTk) {
   // spaces between numbers/IDs
@@ -1234,6 +1250,8 @@ static size_t _jslNewTokenisedStringFromLexer(JsvStringIterator *dstit, JsVar *d
   size_t length = 0;
   int lastTk = LEX_EOF;
   int atobChecker = 0; // we increment this to see if we've got the `atob("...")` pattern. 0=nothing, 2='atob('
+  size_t blockStarts[JSLEX_BLOCK_STACK_SIZE]; // where each LEX_RAW_BLOCK we're inside was written
+  int blockDepth = 0;
   while (lex->tk!=LEX_EOF && jsvStringIteratorGetIndex(&lex->it)<=charTo+1) {
     if (jslPreserveSpaceBetweenTokens(lastTk, lex->tk)) {
       length++;
@@ -1309,12 +1327,33 @@ static size_t _jslNewTokenisedStringFromLexer(JsvStringIterator *dstit, JsVar *d
         atobChecker = 0;
       // copy in string verbatim
       _jslNewTokenisedStringFromLexerCopyString(&length, dstit, &it, itch);
+    } else if (lex->tk=='{' && blockDepth<JSLEX_BLOCK_STACK_SIZE) { // ---------------------------------  token = '{', store as LEX_RAW_BLOCK
+      atobChecker = 0;
+      blockStarts[blockDepth++] = length;
+      // the offset to the matching '}' is filled in when we get to it
+      if (dstit) {
+        jsvStringIteratorSetCharAndNext(dstit, (char)LEX_RAW_BLOCK);
+        jsvStringIteratorSetCharAndNext(dstit, (char)0x80);
+        jsvStringIteratorSetCharAndNext(dstit, (char)0x80);
+      }
+      length += 3;
     } else { // ---------------------------------  token = single char
       // check for `atob("...")` pattern
       if (atobChecker==1 && lex->tk=='(')
         atobChecker = 2;
       else
         atobChecker = 0;
+      if (lex->tk=='{') blockDepth++; // too deep for LEX_RAW_BLOCK
+      if (lex->tk=='}' && blockDepth>0) {
+        blockDepth--;
+        if (blockDepth<JSLEX_BLOCK_STACK_SIZE) {
+          size_t offset = length - (blockStarts[blockDepth]+3);
+          if (dstit && offset < 16384) {
+            jsvSetCharInString(dstVar, blockStarts[blockDepth]+1, (char)(0x80|(offset&127)), false);
+            jsvSetCharInString(dstVar, blockStarts[blockDepth]+2, (char)(0x80|(offset>>7)), false);
+          }
+        }
+      }
       // copy in char verbatim
       if (dstit)
         jsvStringIteratorSetCharAndNext(dstit, (char)lex->tk);
@@ -1458,6 +1497,11 @@ static int jslPrintTokenisedChar(JsvStringIterator *it, unsigned char *lastch, v
     charsParsed++; // just one char for zero
     user_callback("0", user_data);
     return charsParsed;
+  } else if (ch==LEX_RAW_BLOCK) {
+    jsvStringIteratorNext(it); // skip the offset to the end of the block
+    jsvStringIteratorNext(it);
+    charsParsed += 2;
+    ch = '{';
   } else if (ch==LEX_RAW_INT8 || ch==LEX_RAW_INT16) {
     int16_t value = (unsigned char)jsvStringIteratorGetCharAndNext(it);
     charsParsed += 2;
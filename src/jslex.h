@@ -124,6 +124,7 @@ _LEX_OPERATOR2_START = _LEX_R_LIST_END+10, // padding for adding new symbols in
     LEX_RAW_INT0, //< the integer value 0 stored as 0xD3
     LEX_RAW_INT8, //< an integer value stored as 0xD4,value
     LEX_RAW_INT16, //< an integer value stored as 0xD5,value_hi,value_lo
+    LEX_RAW_BLOCK, //< a '{' stored as 0xD6,0x80|(offset&127),0x80|(offset>>7) where offset is the distance from the end of this to the matching '}' (or 0 if unknown)
 _LEX_OPERATOR2_END = LEX_NULLISH,
 
 _LEX_TOKENS_END = _LEX_OPERATOR2_END, /* always the last entry for symbols */
@@ -152,6 +153,8 @@ typedef struct JsLex
 
   size_t tokenStart; ///< Position in the data of the first character of this token
   size_t tokenLastStart; ///< Position in the data of the first character of the last token
+  size_t tokenBlockEnd; ///< If this token is a pretokenised '{', the position of the matching '}' (or 0)
+  size_t tokenLastBlockEnd; ///< tokenBlockEnd for the last token
   char token[JSLEX_MAX_TOKEN_LENGTH]; ///< Data contained in the token we have here
   JsVar *tokenValue; ///< JsVar containing the current token - used only for strings/regex
   unsigned char tokenl; ///< the current length of token
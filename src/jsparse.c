@@ -646,7 +646,7 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
       JsVar *functionCode = 0;
       JsVar *functionInternalName = 0;
 #ifdef ESPR_JIT
-      bool functionIsJIT = false; // is functionCode actually Thumb Assembly (for JS)
+      bool functionIsJIT = false; // is functionCode actually native code (for JS)
 #endif
 
       /** NOTE: We expect that the function object will have:
@@ -768,7 +768,7 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
           if (functionIsJIT) {
             void *nativePtr = jsvGetFlatStringPointer(functionCode);
             if (nativePtr)
-              returnVar = jsnCallFunction(nativePtr+1/*thumb*/, JSWAT_JSVAR/*JS Variable as return type*/, thisVar, NULL, 0);
+              returnVar = jsnCallFunction(JSJ_CODE_ENTRY(nativePtr), JSWAT_JSVAR/*JS Variable as return type*/, thisVar, NULL, 0);
           } else
 #endif
           /* we just want to execute the block, but something could
@@ -927,6 +927,44 @@ JsVar *jspGetNamedVariable(const char *tokenName) {
   return a;
 }
 
+#ifndef ESPR_NO_NAME_CACHE
+/* Cache of which name each identifier in the code resolved to last time, keyed on the
+ * identifier's position in the source. An entry can only be used if no child has been
+ * added to or removed from anything and no new lexer has been started since (jsvShapeEpoch),
+ * and we're in the same scopes. */
+typedef struct {
+  JsVar *source; ///< lex->sourceVar when the name was found
+  size_t tokenStart; ///< lex->tokenStart when the name was found
+  JsVar *scopes; ///< execInfo.scopesVar when the name was found
+  JsVar *name; ///< The name we found
+  unsigned int epoch; ///< jsvShapeEpoch when the name was found
+} JspNameCacheEntry;
+static JspNameCacheEntry jspNameCache[JSP_NAME_CACHE_SIZE];
+
+/// Like jspGetNamedVariable, but for the identifier at the current lexer position
+static JsVar *jspGetNamedVariableAtToken(const char *tokenName) {
+  if (!JSP_SHOULD_EXECUTE) return 0;
+  JspNameCacheEntry *entry = &jspNameCache[((size_t)lex->sourceVar/sizeof(JsVar) + lex->tokenStart) & (JSP_NAME_CACHE_SIZE-1)];
+  if (entry->epoch == jsvShapeEpoch &&
+      entry->tokenStart == lex->tokenStart &&
+      entry->source == lex->sourceVar &&
+      entry->scopes == execInfo.scopesVar)
+    return jsvLockAgain(entry->name);
+  JsVar *a = jspGetNamedVariable(tokenName);
+  // only cache names that are actually in a scope (not new/builtin ones)
+  if (jsvIsName(a) && jsvGetRefs(a)) {
+    entry->source = lex->sourceVar;
+    entry->tokenStart = lex->tokenStart;
+    entry->scopes = execInfo.scopesVar;
+    entry->name = a;
+    entry->epoch = jsvShapeEpoch;
+  }
+  return a;
+}
+#else
+#define jspGetNamedVariableAtToken jspGetNamedVariable
+#endif
+
 /// Used by jspGetNamedField / jspGetVarNamedField
 static NO_INLINE JsVar *jspGetNamedFieldInParents(JsVar *object, const char* name, bool returnName) {
   // Now look in prototypes
@@ -1754,7 +1792,7 @@ NO_INLINE JsVar *jspeClassDefinition(bool parseNamedClass) {
 
 NO_INLINE JsVar *jspeFactor() {
   if (lex->tk==LEX_ID) {
-    JsVar *a = jspGetNamedVariable(jslGetTokenValueAsString());
+    JsVar *a = jspGetNamedVariableAtToken(jslGetTokenValueAsString());
     JSP_ASSERT_MATCH(LEX_ID);
 #ifndef ESPR_NO_TEMPLATE_LITERAL
     if (lex->tk==LEX_TEMPLATE_LITERAL)
@@ -1889,13 +1927,17 @@ NO_INLINE JsVar *__jspePostfixExpression(JsVar *a) {
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
     if (JSP_SHOULD_EXECUTE) {
-      JsVar *one = jsvNewFromInteger(1);
-      JsVar *oldValue = jsvAsNumberAndUnLock(jsvSkipName(a)); // keep the old value (but convert to number)
-      JsVar *res = jsvMathsOpSkipNames(oldValue, one, op==LEX_PLUSPLUS ? '+' : '-');
-      jsvUnLock(one);
-      // in-place add/subtract
-      jsvReplaceWith(a, res);
-      jsvUnLock(res);
+      JsVar *oldValue;
+      // if 'a' is the only reference to a number, just change it (only the old value needs allocating)
+      if (!jsvIncrementInPlace(a, op==LEX_PLUSPLUS ? 1 : -1, &oldValue)) {
+        JsVar *one = jsvNewFromInteger(1);
+        oldValue = jsvAsNumberAndUnLock(jsvSkipName(a)); // keep the old value (but convert to number)
+        JsVar *res = jsvMathsOpSkipNames(oldValue, one, op==LEX_PLUSPLUS ? '+' : '-');
+        jsvUnLock(one);
+        // in-place add/subtract
+        jsvReplaceWith(a, res);
+        jsvUnLock(res);
+      }
       // but then use the old value
       jsvUnLock(a);
       a = oldValue;
@@ -1912,7 +1954,7 @@ NO_INLINE JsVar *jspePostfixExpression() {
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
     a = jspePostfixExpression();
-    if (JSP_SHOULD_EXECUTE) {
+    if (JSP_SHOULD_EXECUTE && !jsvIncrementInPlace(a, op==LEX_PLUSPLUS ? 1 : -1, NULL)) {
       JsVar *one = jsvNewFromInteger(1);
       JsVar *res = jsvMathsOpSkipNames(a, one, op==LEX_PLUSPLUS ? '+' : '-');
       jsvUnLock(one);
@@ -1984,6 +2026,31 @@ unsigned int jspeGetBinaryExpressionPrecedence(int op) {
   }
 }
 
+/** For `name = name + b`, where the first operand of the right hand side is 'av'. If av is a
+ * String that only 'name' references, append b to it rather than copying it (which is what
+ * makes building up a String this way slow). Returns 0 (doing nothing) if we can't. We're only
+ * called if the '+' is the last thing on the right hand side, so nothing can see the change
+ * before av is assigned back to 'name' anyway */
+static JsVar *jspeAppendInPlace(JsVar *name, JsVar *av, JsVar *bv) {
+  // only simple values for b, so converting it to a String can't run any code
+  if (!jsvIsBasicString(av) || av==bv ||
+      !(jsvIsString(bv) || jsvIsNumeric(bv) || jsvIsNull(bv) || jsvIsUndefined(bv)) ||
+      jsvIsUTF8String(bv) || jsvGetRefs(av)!=1 || jsvGetLocks(av)!=1)
+    return 0;
+  // the assignment must be one that can't fail or be intercepted (see jsvReplaceWith)
+  if (!jsvIsName(name) || jsvIsArrayBufferName(name) || jsvIsConstant(name)) return 0;
+  /* don't use jsvSkipName - it'd call a getter, and av could then be the getter's
+   * result, which the assignment would pass to the setter rather than storing */
+  JsVar *value = jsvGetValueOfName(name);
+  jsvUnLock(value);
+  if (value!=av) return 0; // av's reference isn't from 'name'
+  JsVar *str = jsvAsString(bv);
+  if (!str) return 0;
+  jsvAppendStringVarComplete(av, str);
+  jsvUnLock(str);
+  return jsvLockAgain(av);
+}
+
 NO_INLINE JsVar *__jspeBinaryExpression(JsVar *a, unsigned int lastPrecedence) {
   /* This one's a bit strange. Basically all the ops have their own precedence, it's not
    * like & and | share the same precedence. We don't want to recurse for each one,
@@ -1993,6 +2060,12 @@ NO_INLINE JsVar *__jspeBinaryExpression(JsVar *a, unsigned int lastPrecedence) {
    * than the current one, otherwise we stick in the while loop.
    */
   unsigned int precedence = jspeGetBinaryExpressionPrecedence(lex->tk);
+  /* Is 'a' the single token that starts the right hand side of `name = ...`? If so,
+   * remember the name so `name = name + str` can append in place */
+  JsVar *assignName = 0;
+  if (!lastPrecedence && execInfo.assignName && execInfo.assignLex==lex &&
+      execInfo.assignStart==lex->tokenLastStart)
+    assignName = execInfo.assignName;
   while (precedence && precedence>lastPrecedence) {
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
@@ -2098,7 +2171,12 @@ NO_INLINE JsVar *__jspeBinaryExpression(JsVar *a, unsigned int lastPrecedence) {
           JsVar *pb = jsvSkipName(b);
           JsVar *av = jsvGetValueOfAndUnLock(a);
           JsVar *bv = jsvGetValueOfAndUnLock(pb);
-          JsVar *res = jsvMathsOp(av,bv,op);
+          JsVar *res = 0;
+          // the '+' must be the last thing before the assignment (not `s = s + a + b` or `s = s + a ? b : c`)
+          if (assignName && op=='+' && (lex->tk==';' || lex->tk==')' || lex->tk==']' || lex->tk=='}' ||
+              lex->tk==',' || lex->tk==LEX_EOF || lex->tk==LEX_ID))
+            res = jspeAppendInPlace(assignName, av, bv);
+          if (!res) res = jsvMathsOp(av,bv,op);
           jsvUnLock2(av,bv);
           a = res;
         }
@@ -2160,7 +2238,17 @@ NO_INLINE JsVar *__jspeAssignmentExpression(JsVar *lhs) {
 
     int op = lex->tk;
     JSP_ASSERT_MATCH(op);
+    // for `name = name + str` (see jspeAppendInPlace)
+    JsVar *oldAssignName = execInfo.assignName;
+    JsLex *oldAssignLex = execInfo.assignLex;
+    size_t oldAssignStart = execInfo.assignStart;
+    execInfo.assignName = (op=='=' && jsvIsName(lhs)) ? lhs : 0;
+    execInfo.assignLex = lex;
+    execInfo.assignStart = lex->tokenStart;
     rhs = jspeAssignmentExpression();
+    execInfo.assignName = oldAssignName;
+    execInfo.assignLex = oldAssignLex;
+    execInfo.assignStart = oldAssignStart;
     rhs = jsvSkipNameAndUnLock(rhs); // ensure we get rid of any references on the RHS
 
     if (JSP_SHOULD_EXECUTE) {
@@ -2182,7 +2270,11 @@ NO_INLINE JsVar *__jspeAssignmentExpression(JsVar *lhs) {
         else if (op==LEX_RSHIFTEQUAL) op=LEX_RSHIFT;
         else if (op==LEX_LSHIFTEQUAL) op=LEX_LSHIFT;
         else if (op==LEX_RSHIFTUNSIGNEDEQUAL) op=LEX_RSHIFTUNSIGNED;
-        if (op=='+' && jsvIsName(lhs)) {
+        if (lhs && jsvMathsOpInPlace(lhs, rhs, op)) {
+          /* If lhs is the only use of a number, write the result straight
+           * into it rather than allocating a new var */
+          op = 0;
+        } else if (op=='+' && jsvIsName(lhs)) {
           JsVar *currentValue = jsvSkipName(lhs);
           if (jsvIsBasicString(currentValue) && jsvGetRefs(currentValue)==1 && rhs!=currentValue) {
             /* A special case for string += where this is the only use of the string
@@ -2232,6 +2324,13 @@ NO_INLINE JsVar *jspeExpression() {
 
 /** Parse a block `{ ... }` */
 NO_INLINE void jspeSkipBlock() {
+  /* If the '{' we just matched was pretokenised, we know where the
+   * block ends so can just jump straight there */
+  if (lex->tokenLastBlockEnd) {
+    jslSeekTo(lex->tokenLastBlockEnd);
+    assert(lex->tk=='}');
+    return;
+  }
   // fast skip of blocks
   int brackets = 1;
   // set execFlags to no, which means we won't try and parse strings into vars
@@ -3188,6 +3287,7 @@ void jspSoftInit() {
   execInfo.hiddenRoot = jsvObjectGetChild(execInfo.root, JS_HIDDEN_CHAR_STR, JSV_OBJECT);
   execInfo.execute = EXEC_YES;
   execInfo.scopesVar = 0;
+  execInfo.assignName = 0;
 #ifndef ESPR_NO_LET_SCOPING
   execInfo.baseScope = execInfo.root;
   execInfo.blockScope = 0;
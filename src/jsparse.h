@@ -156,6 +156,13 @@ typedef struct {
   JsVar *currentClassConstructor;
 #endif
 
+  /** While executing the right hand side of `name = ...`, the name (not locked) and the
+   * lexer and position where the right hand side starts, so `name = name + str` can append to
+   * the String in place (see jspeAppendInPlace) */
+  JsVar *assignName;
+  JsLex *assignLex;
+  size_t assignStart;
+
   volatile JsExecFlags execute; //!< Should we be executing, do we have errors, etc
 } JsExecInfo;
 
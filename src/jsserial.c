@@ -22,6 +22,11 @@ void jsserialHardwareFunc(int data, serial_sender_data *info) {
   jshTransmit(device, (unsigned char)data);
 }
 
+void jsserialHardwareBufferFunc(unsigned char *data, unsigned int len, void *info) {
+  IOEventFlags device = *(IOEventFlags*)info;
+  jshTransmitBuf(device, data, len);
+}
+
 #ifndef ESPR_NO_SOFTWARE_SERIAL
 /**
  * Send a single byte through Serial.
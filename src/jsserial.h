@@ -20,6 +20,11 @@
 typedef JshUSARTInfo serial_sender_data; // the larger of JshSPIInfo or IOEventFlags
 typedef void (*serial_sender)(int data, serial_sender_data *info);
 
+/// Send a single byte to a hardware device (info is the IOEventFlags)
+void jsserialHardwareFunc(int data, serial_sender_data *info);
+/// Send a block of data to a hardware device (info is the IOEventFlags) - for use with jsvIterateBufferCallback
+void jsserialHardwareBufferFunc(unsigned char *data, unsigned int len, void *info);
+
 bool jsserialPopulateUSARTInfo(JshUSARTInfo *inf, JsVar *baud,  JsVar *options);
 
 // Get the correct Serial send function (and the data to send to it).
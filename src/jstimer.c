@@ -459,6 +459,20 @@ bool jstGetLastBufferTimerTask(JsVar *var, UtilTimerTask *task) {
   JsVarRef ref = jsvGetRef(var);
   return utilTimerGetLastTask(jstBufferTaskChecker, (void*)&ref, task);
 }
+
+// data = *JsVarRef
+static bool jstBufferTaskUsesVarChecker(UtilTimerTask *task, void *data) {
+  if (!UET_IS_BUFFER_EVENT(task->type)) return false;
+  JsVarRef ref = *(JsVarRef*)data;
+  return task->data.buffer.currentBuffer==ref || task->data.buffer.nextBuffer==ref ||
+         task->data.buffer.var==_jsvGetAddressOf(ref);
+}
+
+/** Return true if a buffer timer task references this variable or is currently reading/writing
+ * it (via its raw pointer), so it mustn't be moved in memory. Call with interrupts off */
+bool jstIsBufferTimerTaskVar(JsVarRef ref) {
+  return utilTimerFindTask(jstBufferTaskUsesVarChecker, (void*)&ref) >= 0;
+}
 #endif
 
 bool jstPinOutputAtTime(JsSysTime time, uint32_t *timerOffset, Pin *pins, int pinCount, uint8_t value) {
@@ -150,6 +150,10 @@ bool jstGetLastPinTimerTask(Pin pin, UtilTimerTask *task);
 /// Return true if a timer task for the given variable exists (and set 'task' to it)
 bool jstGetLastBufferTimerTask(JsVar *var, UtilTimerTask *task);
 
+/** Return true if a buffer timer task references this variable or is currently reading/writing
+ * it, so it mustn't be moved in memory. Call with interrupts off */
+bool jstIsBufferTimerTaskVar(JsVarRef ref);
+
 /** returns false if timer queue was full... Changes the state of one or more pins at a certain time in the future (using a timer)
  * See utilTimerInsertTask for notes on timerOffset
  */
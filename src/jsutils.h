@@ -58,6 +58,11 @@
 #endif
 #define ESPR_NO_REGEX_OPTIMISE 1
 #define ESPR_NO_PASSWORD 1
+#define ESPR_NO_INCREMENTAL_GC 1
+#define ESPR_NO_PROPERTY_HASH 1
+#define ESPR_NO_NAME_CACHE 1
+#define ESPR_NO_NURSERY 1
+#define ESPR_NO_AUTO_DEFRAG 1
 #endif // SAVE_ON_FLASH
 #ifdef SAVE_ON_FLASH_EXTREME
 #define ESPR_NO_BLUETOOTH_MESSAGES 1
@@ -325,6 +330,58 @@ typedef int64_t JsSysTime;
 #define JS_VARS_BEFORE_IDLE_GC 32
 #endif
 
+#ifndef ESPR_NO_INCREMENTAL_GC
+/* Amount of work (roughly, blocks visited) done by each step of the incremental
+ * garbage collector when it is run from the idle loop */
+#ifndef JSV_GC_STEP_BUDGET
+#define JSV_GC_STEP_BUDGET 512
+#endif
+/// Number of entries in the incremental GC's mark stack. If this overflows, memory is rescanned
+#ifndef JSV_GC_MARK_STACK_SIZE
+#define JSV_GC_MARK_STACK_SIZE 32
+#endif
+#endif
+
+#ifndef ESPR_NO_PROPERTY_HASH
+/// Objects with at least this many children get a hash index for jsvFindChildFromString/Var
+#ifndef JSV_HASH_INDEX_THRESHOLD
+#define JSV_HASH_INDEX_THRESHOLD 16
+#endif
+/// How many objects can have a hash index at once
+#ifndef JSV_HASH_INDEX_COUNT
+#define JSV_HASH_INDEX_COUNT 4
+#endif
+#endif
+
+#ifndef ESPR_NO_NURSERY
+/* Number of blocks at the end of memory that are kept for numbers (which are usually
+ * temporary values), so they don't fragment the rest of memory. This is limited to
+ * 1/16th of the available blocks */
+#ifndef JSV_NURSERY_SIZE
+#define JSV_NURSERY_SIZE 64
+#endif
+#endif
+
+#ifndef ESPR_NO_AUTO_DEFRAG
+/* When idle, if the largest run of free blocks (the biggest flat string that could be
+ * allocated) is smaller than this, memory is compacted a few blocks at a time.
+ * Can be changed with E.setDefragThreshold */
+#ifndef JSV_DEFRAG_THRESHOLD
+#define JSV_DEFRAG_THRESHOLD 256
+#endif
+/// Maximum number of blocks moved by each step of the idle-time memory compactor
+#ifndef JSV_DEFRAG_STEP_BLOCKS
+#define JSV_DEFRAG_STEP_BLOCKS 32
+#endif
+#endif
+
+#ifndef ESPR_NO_NAME_CACHE
+/// Number of entries in the parser's cache of where identifiers were found (a power of 2)
+#ifndef JSP_NAME_CACHE_SIZE
+#define JSP_NAME_CACHE_SIZE 64
+#endif
+#endif
+
 // javascript specific names
 #define JSPARSE_RETURN_VAR JS_HIDDEN_CHAR_STR"rtn" // variable name used for returning function results
 #define JSPARSE_PROTOTYPE_VAR "prototype"
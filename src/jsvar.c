@@ -22,6 +22,7 @@
 #include "jswrap_arraybuffer.h" // for jsvNewTypedArray
 #include "jswrap_dataview.h" // for jsvNewDataViewWithData
 #include "jswrap_functions.h" // jswrap_console_trace
+#include "jstimer.h" // jstIsBufferTimerTaskVar
 #if defined(ESPR_JIT) && defined(LINUX)
 #include <sys/mman.h>
 #endif
@@ -65,6 +66,65 @@ typedef enum {
 volatile bool touchedFreeList = false;
 volatile JsVarRef jsVarFirstEmpty; ///< reference of first unused variable (variables are in a linked list)
 volatile MemBusyType isMemoryBusy; ///< Are we doing garbage collection or similar, so can't access memory?
+unsigned int jsvShapeEpoch = 0; ///< See jsvar.h
+static JsSysTime jsvGCMaxPause = 0; ///< The longest time we've spent in one garbage collection (or one incremental GC step)
+
+#ifndef ESPR_NO_NURSERY
+/* The nursery is a range of blocks at the end of memory with its own free list. Numbers
+ * (which are mostly temporary results of expressions) are allocated from it first so they
+ * don't get scattered through the main free list and break up the space that flat
+ * strings need. If main memory runs out we allocate from the nursery (and vice versa), so
+ * any block may still be in either free list - we just put blocks back in the nursery's list
+ * when they're freed. Anything that's still in use when the nursery fills up is moved out
+ * into main memory by jsvNurseryPromote */
+static volatile JsVarRef jsVarNurseryFirstEmpty; ///< reference of first unused variable in the nursery
+static JsVarRef jsvNurseryFirst, jsvNurseryLast; ///< The range of refs in the nursery
+static unsigned int jsvNurseryHits, jsvNurseryMisses, jsvNurseryPromoted; ///< Statistics for process.memory()
+static unsigned int jsvNurseryMissesAtPromote; ///< jsvNurseryMisses when we last promoted
+#define JSV_IS_NURSERY_REF(ref) ((ref)>=jsvNurseryFirst && (ref)<=jsvNurseryLast)
+/// Numbers are allocated from the nursery
+#define JSV_IS_NURSERY_TYPE(flags) (((flags)&JSV_VARTYPEMASK)==JSV_INTEGER || ((flags)&JSV_VARTYPEMASK)==JSV_FLOAT || ((flags)&JSV_VARTYPEMASK)==JSV_BOOLEAN)
+/// Is this block outside the nursery (where flat strings can be allocated)?
+#define JSV_IS_MAIN_MEMORY_REF(ref) (!JSV_IS_NURSERY_REF(ref))
+#else
+#define JSV_IS_MAIN_MEMORY_REF(ref) true
+#endif
+
+#ifndef ESPR_NO_AUTO_DEFRAG
+static unsigned int jsvDefragThreshold = JSV_DEFRAG_THRESHOLD; ///< Compact memory when idle if the largest free run is smaller than this (0=never)
+static bool jsvDefragRunning; ///< Is the idle-time compactor part way through compacting memory?
+static JsSysTime jsvDefragLastCheck; ///< When jsvDefragmentNeeded last scanned memory
+#endif
+
+#ifndef ESPR_NO_INCREMENTAL_GC
+typedef enum {
+  JSV_GC_IDLE,  ///< No incremental garbage collection in progress
+  JSV_GC_INIT,  ///< Setting JSV_GARBAGE_COLLECT on all used vars
+  JSV_GC_MARK,  ///< Clearing JSV_GARBAGE_COLLECT on anything reachable from a locked var
+  JSV_GC_SWEEP, ///< Freeing anything that still has JSV_GARBAGE_COLLECT set
+} PACKED_FLAGS JsvGCPhase;
+
+static volatile JsvGCPhase jsvGCPhase = JSV_GC_IDLE; ///< What is the incremental garbage collector doing?
+static unsigned int jsvGCCursor; ///< The next var that the current incremental GC phase will look at
+/** Vars that have been marked as used, but whose children haven't been scanned yet. This
+ * is instead of the recursion in jsvGarbageCollectMarkUsed */
+static JsVarRef jsvGCMarkStack[JSV_GC_MARK_STACK_SIZE];
+static unsigned char jsvGCMarkStackSize;
+static bool jsvGCMarkOverflow; ///< Was something marked when the mark stack was full? If so we have to rescan
+static bool jsvGCMarkRescan; ///< Are we scanning all used vars for unmarked children (after an overflow)?
+static unsigned char jsvGCMarkRescans; ///< How many times have we had to rescan in this GC cycle?
+/** Vars freed by the sweep are kept in their own list until the sweep finishes. If they were
+ * reused straight away, something still to be swept could end up pointing at a new var */
+static JsVarRef jsvGCSweptFirst, jsvGCSweptLast;
+
+static void jsvGarbageCollectWriteBarrier(JsVar *v);
+static void jsvGarbageCollectNewFlatString(JsVarRef ref, unsigned int count);
+#endif
+
+#ifndef ESPR_NO_PROPERTY_HASH
+static void jsvHashIndexRemove(JsVar *parent);
+static void jsvHashIndexClear(bool unlock);
+#endif
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
@@ -78,9 +138,17 @@ JsVarRefSigned jsvGetFirstChildSigned(const JsVar *v) {
 JsVarRef jsvGetLastChild(const JsVar *v) { return v->varData.ref.lastChild; }
 JsVarRef jsvGetNextSibling(const JsVar *v) { return v->varData.ref.nextSibling; }
 JsVarRef jsvGetPrevSibling(const JsVar *v) { return v->varData.ref.prevSibling; }
+#ifndef ESPR_NO_INCREMENTAL_GC
+/* If an incremental GC is marking, anything we link into an already-marked var has to
+ * be scanned, or the GC could decide that it's unreachable. See jsvGarbageCollectWriteBarrier */
+void jsvSetFirstChild(JsVar *v, JsVarRef r) { v->varData.ref.firstChild = r; if (jsvGCPhase==JSV_GC_MARK) jsvGarbageCollectWriteBarrier(v); }
+void jsvSetLastChild(JsVar *v, JsVarRef r) { v->varData.ref.lastChild = r; if (jsvGCPhase==JSV_GC_MARK) jsvGarbageCollectWriteBarrier(v); }
+void jsvSetNextSibling(JsVar *v, JsVarRef r) { v->varData.ref.nextSibling = r; if (jsvGCPhase==JSV_GC_MARK) jsvGarbageCollectWriteBarrier(v); }
+#else
 void jsvSetFirstChild(JsVar *v, JsVarRef r) { v->varData.ref.firstChild = r; }
 void jsvSetLastChild(JsVar *v, JsVarRef r) { v->varData.ref.lastChild = r; }
 void jsvSetNextSibling(JsVar *v, JsVarRef r) { v->varData.ref.nextSibling = r; }
+#endif
 void jsvSetPrevSibling(JsVar *v, JsVarRef r) { v->varData.ref.prevSibling = r; }
 
 JsVarRefCounter jsvGetRefs(JsVar *v) { return v->varData.ref.refs; }
@@ -262,28 +330,61 @@ void jsvSetMaxVarsUsed(unsigned int size) {
 
 }
 
+/* When rebuilding the free lists in order, add var 'i' to the end of the list it belongs
+ * in. lastEmpty/lastNurseryEmpty are the current ends of the lists (or 0 if empty) */
+static void jsvFreeListAppend(JsVarRef i, JsVar *var, JsVar **lastEmpty, JsVar **lastNurseryEmpty) {
+#ifndef ESPR_NO_NURSERY
+  if (JSV_IS_NURSERY_REF(i)) {
+    if (*lastNurseryEmpty) jsvSetNextSibling(*lastNurseryEmpty, i);
+    else jsVarNurseryFirstEmpty = i;
+    *lastNurseryEmpty = var;
+    return;
+  }
+#else
+  NOT_USED(lastNurseryEmpty);
+#endif
+  if (*lastEmpty) jsvSetNextSibling(*lastEmpty, i);
+  else jsVarFirstEmpty = i;
+  *lastEmpty = var;
+}
+
+/// Terminate the free lists built with jsvFreeListAppend
+static void jsvFreeListEnd(JsVar *lastEmpty, JsVar *lastNurseryEmpty) {
+  if (lastEmpty) jsvSetNextSibling(lastEmpty, 0);
+  if (lastNurseryEmpty) jsvSetNextSibling(lastNurseryEmpty, 0);
+}
+
 // maps the empty variables in...
 void jsvCreateEmptyVarList() {
   assert(!isMemoryBusy);
+  jsvGarbageCollectAbort();
+#ifndef ESPR_NO_PROPERTY_HASH
+  jsvHashIndexClear(false); // variables may have been replaced
+#endif
+  jsvShapeEpoch++;
   isMemoryBusy = MEMBUSY_SYSTEM;
   jsVarFirstEmpty = 0;
-  JsVar firstVar; // temporary var to simplify code in the loop below
-  jsvSetNextSibling(&firstVar, 0);
-  JsVar *lastEmpty = &firstVar;
+#ifndef ESPR_NO_NURSERY
+  // the nursery is the last few blocks in memory
+  unsigned int nurserySize = JSV_NURSERY_SIZE;
+  if (nurserySize > jsVarsSize/16) nurserySize = jsVarsSize/16;
+  jsvNurseryFirst = (JsVarRef)(jsVarsSize+1-nurserySize);
+  jsvNurseryLast = (JsVarRef)jsVarsSize;
+  jsVarNurseryFirstEmpty = 0;
+#endif
+  JsVar *lastEmpty = 0, *lastNurseryEmpty = 0;
 
   JsVarRef i;
   for (i=1;i<=jsVarsSize;i++) {
     JsVar *var = jsvGetAddressOf(i);
     if ((var->flags&JSV_VARTYPEMASK) == JSV_UNUSED) {
-      jsvSetNextSibling(lastEmpty, i);
-      lastEmpty = var;
+      jsvFreeListAppend(i, var, &lastEmpty, &lastNurseryEmpty);
     } else if (jsvIsFlatString(var)) {
       // skip over used blocks for flat strings
       i = (JsVarRef)(i+jsvGetFlatStringBlocks(var));
     }
   }
-  jsvSetNextSibling(lastEmpty, 0);
-  jsVarFirstEmpty = jsvGetNextSibling(&firstVar);
+  jsvFreeListEnd(lastEmpty, lastNurseryEmpty);
   isMemoryBusy = MEM_NOT_BUSY;
 }
 
@@ -292,8 +393,15 @@ void jsvCreateEmptyVarList() {
  for storage. */
 void jsvClearEmptyVarList() {
   assert(!isMemoryBusy);
+  jsvGarbageCollectAbort();
+#ifndef ESPR_NO_PROPERTY_HASH
+  jsvHashIndexClear(true); // so we don't save hash indexes
+#endif
   isMemoryBusy = MEMBUSY_SYSTEM;
   jsVarFirstEmpty = 0;
+#ifndef ESPR_NO_NURSERY
+  jsVarNurseryFirstEmpty = 0;
+#endif
   JsVarRef i;
   for (i=1;i<=jsVarsSize;i++) {
     JsVar *var = jsvGetAddressOf(i);
@@ -338,6 +446,9 @@ static JsVarRef jsvInitJsVars(JsVarRef start, unsigned int count) {
 
 void jsvReset() {
   jsVarFirstEmpty = 0; // jsvCreateEmptyVarList in jsvSoftInit sets this
+#ifndef ESPR_NO_NURSERY
+  jsVarNurseryFirstEmpty = 0;
+#endif
 #ifdef RESIZABLE_JSVARS
   unsigned int i;
   for (i=0;i<jsVarsSize>>JSVAR_BLOCK_SHIFT;i++) {
@@ -379,6 +490,11 @@ void jsvInit(unsigned int size) {
 }
 
 void jsvKill() {
+  jsvGarbageCollectAbort();
+#ifndef ESPR_NO_PROPERTY_HASH
+  jsvHashIndexClear(false);
+#endif
+  jsvShapeEpoch++;
 #ifdef RESIZABLE_JSVARS
   unsigned int i;
   for (i=0;i<jsVarsSize>>JSVAR_BLOCK_SHIFT;i++) {
@@ -448,8 +564,15 @@ void jsvSetMemoryTotal(unsigned int jsNewVarCount) {
   jsVarBlocks = realloc(jsVarBlocks, sizeof(JsVar*)*newBlockCount);
   // allocate more blocks
   unsigned int i;
-  for (i=oldBlockCount;i<newBlockCount;i++)
+  for (i=oldBlockCount;i<newBlockCount;i++) {
+#if defined(ESPR_JIT) && defined(LINUX)
+    // JIT code is stored in flat strings, so every block must be executable
+    jsVarBlocks[i] = (JsVar *)mmap(NULL, sizeof(JsVar) * JSVAR_BLOCK_SIZE, PROT_EXEC | PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+#else
     jsVarBlocks[i] = malloc(sizeof(JsVar) * JSVAR_BLOCK_SIZE);
+#endif
+  }
   /** and now reset all the newly allocated vars. We know jsVarFirstEmpty
    * is 0 (because jsiFreeMoreMemory returned 0) so we can just assign it.  */
   assert(!jsVarFirstEmpty);
@@ -491,11 +614,21 @@ bool jsvMoreFreeVariablesThan(unsigned int vars) {
     if (!vars--) return true;
     r = jsvGetNextSibling(jsvGetAddressOf(r));
   }
+#ifndef ESPR_NO_NURSERY
+  r = jsVarNurseryFirstEmpty;
+  while (r) {
+    if (!vars--) return true;
+    r = jsvGetNextSibling(jsvGetAddressOf(r));
+  }
+#endif
   return false;
 }
 
 /// Get whether memory is full or not
 bool jsvIsMemoryFull() {
+#ifndef ESPR_NO_NURSERY
+  if (jsVarNurseryFirstEmpty) return false;
+#endif
   return !jsVarFirstEmpty;
 }
 
@@ -594,6 +727,11 @@ void jsvResetVariable(JsVar *v, JsVarFlags flags) {
       ((uint8_t*)v)[i] = 0;
   }
   v->flags = flags | JSV_LOCK_ONE;
+#ifndef ESPR_NO_INCREMENTAL_GC
+  // If the incremental GC is still flagging vars, this one must be flagged too so it gets scanned
+  if (jsvGCPhase==JSV_GC_INIT)
+    v->flags |= JSV_GARBAGE_COLLECT;
+#endif
   // This code really *should* be faster as it really does just
   // create a handful of stores and the ARM assembly looks great.
   // Somehow it's slower though!
@@ -610,6 +748,18 @@ JsVar *jsvNewWithFlags(JsVarFlags flags) {
   }
   JsVar *v = 0;
   jshInterruptOff(); // to allow this to be used from an IRQ
+#ifndef ESPR_NO_NURSERY
+  bool fromNursery = JSV_IS_NURSERY_TYPE(flags);
+  if (fromNursery) {
+    if (jsVarNurseryFirstEmpty) jsvNurseryHits++;
+    else jsvNurseryMisses++;
+  }
+  // use the nursery if we're a number, or if there's nothing left in main memory
+  if (jsVarNurseryFirstEmpty && (fromNursery || !jsVarFirstEmpty)) {
+    v = jsvGetAddressOf(jsVarNurseryFirstEmpty); // jsvResetVariable will lock
+    jsVarNurseryFirstEmpty = jsvGetNextSibling(v); // move our reference to the next in the free list
+  } else
+#endif
   if (jsVarFirstEmpty!=0) {
     v = jsvGetAddressOf(jsVarFirstEmpty); // jsvResetVariable will lock
     jsVarFirstEmpty = jsvGetNextSibling(v); // move our reference to the next in the free list
@@ -672,6 +822,15 @@ static void jsvFreePtrInternal(JsVar *var) {
   var->flags = JSV_UNUSED;
   // add this to our free list
   jshInterruptOff(); // to allow this to be used from an IRQ
+#ifndef ESPR_NO_NURSERY
+  JsVarRef ref = jsvGetRef(var);
+  if (JSV_IS_NURSERY_REF(ref)) {
+    jsvSetNextSibling(var, jsVarNurseryFirstEmpty);
+    jsVarNurseryFirstEmpty = ref;
+    jshInterruptOn();
+    return;
+  }
+#endif
   // OPT: would a small amount of sorting here when inserting (curRef>jsVarFirstEmpty) help to reduce fragmentation?
   jsvSetNextSibling(var, jsVarFirstEmpty);
   jsVarFirstEmpty = jsvGetRef(var);
@@ -777,6 +936,9 @@ ALWAYS_INLINE void jsvFreePtr(JsVar *var) {
     can be ints or strings */
 
   if (jsvHasChildren(var)) {
+#ifndef ESPR_NO_PROPERTY_HASH
+    jsvHashIndexRemove(var);
+#endif
     JsVarRef childref = jsvGetLastChild(var);
 #ifdef CLEAR_MEMORY_ON_FREE
     jsvSetFirstChild(var, 0);
@@ -826,12 +988,22 @@ JsVarRef jsvGetRef(JsVar *var) {
 #endif
 }
 
+#ifndef ESPR_NO_INCREMENTAL_GC
+static void jsvGarbageCollectMarkGrey(JsVar *var);
+/* A locked var is a GC root, so if we lock something the incremental GC hasn't
+ * reached yet, we must mark it ourselves */
+#define JSV_GC_LOCK_BARRIER(var) if ((var->flags & JSV_GARBAGE_COLLECT) && jsvGCPhase==JSV_GC_MARK) jsvGarbageCollectMarkGrey(var);
+#else
+#define JSV_GC_LOCK_BARRIER(var)
+#endif
+
 /// Lock this reference and return a pointer - UNSAFE for null refs
 JsVar *jsvLock(JsVarRef ref) {
   JsVar *var = jsvGetAddressOf(ref);
   //var->locks++;
   if ((var->flags & JSV_LOCK_MASK)!=JSV_LOCK_MASK) // if we hit the max amount of locks, don't exceed it (see https://github.com/espruino/Espruino/issues/2616)
     var->flags += JSV_LOCK_ONE;
+  JSV_GC_LOCK_BARRIER(var);
   return var;
 }
 
@@ -846,6 +1018,7 @@ JsVar *jsvLockAgain(JsVar *var) {
   assert(var);
   if ((var->flags & JSV_LOCK_MASK)!=JSV_LOCK_MASK) // if we hit the max amount of locks, don't exceed it (see https://github.com/espruino/Espruino/issues/2616)
     var->flags += JSV_LOCK_ONE;
+  JSV_GC_LOCK_BARRIER(var);
   return var;
 }
 
@@ -957,8 +1130,9 @@ JsVarRef jsvUnRefRef(JsVarRef ref) {
   return 0;
 }
 
-JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
-  bool firstRun = true;
+/// Allocate a flat string - if we can't find space and tryGC is set, garbage collect and try again
+static JsVar *_jsvNewFlatStringOfLength(unsigned int byteLength, bool tryGC) {
+  bool firstRun = tryGC;
   // Work out how many blocks we need. One for the header, plus some for the characters
   size_t requiredBlocks = 1 + ((byteLength+sizeof(JsVar)-1) / sizeof(JsVar));
   JsVar *flatString = 0;
@@ -1037,6 +1211,10 @@ JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
     jsvGarbageCollect();
   };
   if (!flatString) return 0;
+#ifndef ESPR_NO_INCREMENTAL_GC
+  if (jsvGCPhase!=JSV_GC_IDLE)
+    jsvGarbageCollectNewFlatString(jsvGetRef(flatString), (unsigned int)requiredBlocks);
+#endif
   /* We now have the string! All that's left is to clear it */
   // clear data
   memset((char*)&flatString[1], 0, sizeof(JsVar)*(requiredBlocks-1));
@@ -1048,6 +1226,10 @@ JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
   return flatString;
 }
 
+JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
+  return _jsvNewFlatStringOfLength(byteLength, true);
+}
+
 static JsVar *jsvNewNameOrString(const char *str, bool isName) {
   // Create a var
   JsVar *first = jsvNewWithFlags(isName ? JSV_NAME_STRING_0 : JSV_STRING_0);
@@ -1964,14 +2146,17 @@ void jsvAppendStringVar(JsVar *var, const JsVar *str, size_t stridx, size_t maxL
   JsvStringIterator dst;
   jsvStringIteratorNew(&dst, var, 0);
   jsvStringIteratorGotoEnd(&dst);
-  // now start appending
-  /* This isn't as fast as something single-purpose, but it's not that bad,
-     * and is less likely to break :) */
+  // now start appending, a block of the source string at a time
   JsvStringIterator it;
   jsvStringIteratorNewConst(&it, str, stridx);
-  while (jsvStringIteratorHasChar(&it) && (maxLength-->0)) {
-    char ch = jsvStringIteratorGetCharAndNext(&it);
-    jsvStringIteratorAppend(&dst, ch);
+  while (jsvStringIteratorHasChar(&it) && maxLength) {
+    size_t n = it.charsInVar - it.charIdx;
+    if (n > maxLength) n = maxLength;
+    jsvStringIteratorAppendBuf(&dst, &it.ptr[it.charIdx], n);
+    maxLength -= n;
+    // move on only after copying - Flash Strings are read into a buffer in the iterator
+    it.charIdx += n-1;
+    jsvStringIteratorNext(&it);
   }
   jsvStringIteratorFree(&it);
   jsvStringIteratorFree(&dst);
@@ -2500,6 +2685,26 @@ JsVar *jsvGetArrayBufferBackingString(JsVar *arrayBuffer, uint32_t *offset) {
   return arrayBuffer;
 }
 
+/** If the elements of this ArrayBuffer are stored in one contiguous block of memory, return a
+ * pointer to the first element and set `length` to the number of elements. Otherwise return 0.
+ * The pointer may not be aligned for the element type. If `writable`, native Strings (which may
+ * point to read-only flash) aren't used. */
+char *jsvGetArrayBufferDataPointer(JsVar *arrayBuffer, size_t *length, bool writable) {
+  assert(jsvIsArrayBuffer(arrayBuffer) && length);
+  size_t elementSize = JSV_ARRAYBUFFER_GET_SIZE(arrayBuffer->varData.arraybuffer.type);
+  if (!elementSize || (elementSize & (elementSize-1))) return 0; // no 24 bit
+  uint32_t offset;
+  JsVar *s = jsvGetArrayBufferBackingString(arrayBuffer, &offset);
+  size_t len = 0;
+  char *ptr = 0;
+  if (!(writable && jsvIsNativeString(s)))
+    ptr = jsvGetDataPointer(s, &len);
+  jsvUnLock(s);
+  *length = arrayBuffer->varData.arraybuffer.length;
+  if (!ptr || offset + *length*elementSize > len) return 0;
+  return ptr + offset;
+}
+
 /** Get the item at the given location in the array buffer and return the result */
 JsVar *jsvArrayBufferGet(JsVar *arrayBuffer, size_t idx) {
   JsvArrayBufferIterator it;
@@ -2917,9 +3122,197 @@ JsVar *jsvCopy(JsVar *src, bool copyChildren) {
   return dst;
 }
 
+#ifndef ESPR_NO_PROPERTY_HASH
+/* Objects with lots of children get a hash index, so that jsvFindChildFromString/Var
+ * don't have to walk the whole list of children. The index is an open-addressed table
+ * of refs to the object's string-named children, stored in a locked flat string. It's
+ * only a cache: it's checked against the object's first and last child before use, and
+ * is thrown away when the object is freed or we run a full garbage collection. */
+typedef struct {
+  JsVar *parent; ///< The object that is indexed, or 0 if unused
+  JsVarRef firstChild, lastChild; ///< parent's first and last child when the index was last updated
+  JsVar *table; ///< Locked flat string of JsVarRef[size], or 0 if we couldn't allocate one
+  unsigned int size; ///< Number of entries in table (a power of 2)
+  unsigned int count; ///< Number of names in table
+} JsvHashIndex;
+
+static JsvHashIndex jsvHashIndexes[JSV_HASH_INDEX_COUNT];
+static unsigned char jsvHashIndexLast; ///< The last index we created, so we replace them in turn
+
+/// FNV-1a hash of a name
+static uint32_t jsvHashIndexHashString(const char *name) {
+  uint32_t hash = 2166136261u;
+  while (*name)
+    hash = (hash ^ (unsigned char)*(name++)) * 16777619u;
+  return hash;
+}
+
+/// FNV-1a hash of a name (the same as jsvHashIndexHashString)
+static uint32_t jsvHashIndexHashVar(JsVar *name) {
+  uint32_t hash = 2166136261u;
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, name, 0);
+  int ch;
+  while ((ch = jsvStringIteratorGetCharOrMinusOne(&it)) >= 0) {
+    hash = (hash ^ (unsigned int)ch) * 16777619u;
+    jsvStringIteratorNext(&it);
+  }
+  jsvStringIteratorFree(&it);
+  return hash;
+}
+
+static ALWAYS_INLINE JsVarRef *jsvHashIndexGetTable(JsvHashIndex *idx) {
+  return (JsVarRef*)jsvGetFlatStringPointer(idx->table);
+}
+
+static void jsvHashIndexDrop(JsvHashIndex *idx) {
+  JsVar *table = idx->table;
+  idx->parent = 0;
+  idx->table = 0;
+  jsvUnLock(table);
+}
+
+/// Drop all hash indexes. If unlock is false, variables have been replaced so we just forget them
+static void jsvHashIndexClear(bool unlock) {
+  for (int i=0;i<JSV_HASH_INDEX_COUNT;i++) {
+    if (unlock) jsvHashIndexDrop(&jsvHashIndexes[i]);
+    else jsvHashIndexes[i].table = jsvHashIndexes[i].parent = 0;
+  }
+}
+
+/// Drop any hash index for this object (because it is being freed)
+static void jsvHashIndexRemove(JsVar *parent) {
+  for (int i=0;i<JSV_HASH_INDEX_COUNT;i++)
+    if (jsvHashIndexes[i].parent == parent)
+      jsvHashIndexDrop(&jsvHashIndexes[i]);
+}
+
+/// Get the index for this object, or 0. If the index is out of date it is dropped
+static JsvHashIndex *jsvHashIndexFind(JsVar *parent) {
+  for (int i=0;i<JSV_HASH_INDEX_COUNT;i++) {
+    JsvHashIndex *idx = &jsvHashIndexes[i];
+    if (idx->parent == parent) {
+      if (idx->firstChild == jsvGetFirstChild(parent) &&
+          idx->lastChild == jsvGetLastChild(parent))
+        return idx;
+      // children have been changed without us knowing about it
+      jsvHashIndexDrop(idx);
+      return 0;
+    }
+  }
+  return 0;
+}
+
+static void jsvHashIndexInsert(JsvHashIndex *idx, JsVar *name) {
+  JsVarRef *table = jsvHashIndexGetTable(idx);
+  unsigned int mask = idx->size-1;
+  unsigned int i = jsvHashIndexHashVar(name) & mask;
+  while (table[i])
+    i = (i+1) & mask;
+  table[i] = jsvGetRef(name);
+  idx->count++;
+}
+
+/// Remove a name from the table, moving back any entries after it that would no longer be found
+static void jsvHashIndexDelete(JsvHashIndex *idx, JsVar *name) {
+  JsVarRef *table = jsvHashIndexGetTable(idx);
+  JsVarRef ref = jsvGetRef(name);
+  unsigned int mask = idx->size-1;
+  unsigned int i = jsvHashIndexHashVar(name) & mask;
+  while (table[i] != ref) {
+    if (!table[i]) return; // not in the table
+    i = (i+1) & mask;
+  }
+  unsigned int j = i;
+  while (true) {
+    j = (j+1) & mask;
+    if (!table[j]) break;
+    unsigned int k = jsvHashIndexHashVar(jsvGetAddressOf(table[j])) & mask;
+    // if k is cyclically between i and j, table[j] can still be found where it is
+    if ((i<=j) ? (i<k && k<=j) : (i<k || k<=j)) continue;
+    table[i] = table[j];
+    i = j;
+  }
+  table[i] = 0;
+  idx->count--;
+}
+
+/// Create a hash index for this object (called when we've had to search through lots of its children)
+static void jsvHashIndexBuild(JsVar *parent) {
+  if (!(jsvIsObject(parent) || jsvIsFunction(parent)) || jshIsInInterrupt())
+    return;
+  unsigned int count = 0;
+  JsVarRef childref = jsvGetFirstChild(parent);
+  while (childref) {
+    JsVar *child = jsvGetAddressOf(childref);
+    if (jsvIsString(child)) count++;
+    childref = jsvGetNextSibling(child);
+  }
+  unsigned int size = JSV_HASH_INDEX_THRESHOLD*2;
+  while (size < count*2) size <<= 1;
+
+  jsvHashIndexLast = (unsigned char)((jsvHashIndexLast+1) % JSV_HASH_INDEX_COUNT);
+  JsvHashIndex *idx = &jsvHashIndexes[jsvHashIndexLast];
+  jsvHashIndexDrop(idx);
+  idx->parent = parent;
+  idx->firstChild = jsvGetFirstChild(parent);
+  idx->lastChild = jsvGetLastChild(parent);
+  idx->size = size;
+  idx->count = 0;
+  /* Don't GC if there's no space - if we can't make the index we leave
+   * idx->table=0, which stops us trying again until a child is added */
+  idx->table = _jsvNewFlatStringOfLength((unsigned int)(size*sizeof(JsVarRef)), false);
+  if (!idx->table) return;
+  childref = jsvGetFirstChild(parent);
+  while (childref) {
+    JsVar *child = jsvGetAddressOf(childref);
+    if (jsvIsString(child))
+      jsvHashIndexInsert(idx, child);
+    childref = jsvGetNextSibling(child);
+  }
+}
+
+/// Look up a child using the index - name or nameVar should be set
+static JsVar *jsvHashIndexLookup(JsvHashIndex *idx, const char *name, JsVar *nameVar) {
+  JsVarRef *table = jsvHashIndexGetTable(idx);
+  unsigned int mask = idx->size-1;
+  unsigned int i = (name ? jsvHashIndexHashString(name) : jsvHashIndexHashVar(nameVar)) & mask;
+  while (table[i]) {
+    JsVar *child = jsvGetAddressOf(table[i]);
+    if (name ? jsvIsStringEqual(child, name) : jsvIsBasicVarEqual(child, nameVar))
+      return jsvLockAgain(child);
+    i = (i+1) & mask;
+  }
+  return 0;
+}
+
+/// Update the index after namedChild was added to or removed from parent
+static void jsvHashIndexUpdate(JsvHashIndex *idx, JsVar *parent, JsVar *namedChild, bool added) {
+  if (!idx->table) { // we couldn't allocate before - try again next time
+    jsvHashIndexDrop(idx);
+    return;
+  }
+  if (jsvIsString(namedChild)) {
+    if (!added) {
+      jsvHashIndexDelete(idx, namedChild);
+    } else if ((idx->count+1)*2 > idx->size) {
+      jsvHashIndexDrop(idx); // too full - we'll make a bigger one next time we need it
+      return;
+    } else
+      jsvHashIndexInsert(idx, namedChild);
+  }
+  idx->firstChild = jsvGetFirstChild(parent);
+  idx->lastChild = jsvGetLastChild(parent);
+}
+#endif
+
 void jsvAddName(JsVar *parent, JsVar *namedChild) {
   namedChild = jsvRef(namedChild); // ref here VERY important as adding to structure!
   assert(jsvIsName(namedChild));
+  jsvShapeEpoch++;
+#ifndef ESPR_NO_PROPERTY_HASH
+  JsvHashIndex *idx = jsvHashIndexFind(parent);
+#endif
 
   // update array length
   if (jsvIsArray(parent) && jsvIsInt(namedChild)) {
@@ -2970,6 +3363,9 @@ void jsvAddName(JsVar *parent, JsVar *namedChild) {
     jsvSetFirstChild(parent, r);
     jsvSetLastChild(parent, r);
   }
+#ifndef ESPR_NO_PROPERTY_HASH
+  if (idx) jsvHashIndexUpdate(idx, parent, namedChild, true);
+#endif
 }
 
 JsVar *jsvAddNamedChild(JsVar *parent, JsVar *value, const char *name) {
@@ -3061,17 +3457,29 @@ JsVar *jsvFindChildFromString(JsVar *parent, const char *name) {
   }
 
   assert(jsvHasChildren(parent));
+#ifndef ESPR_NO_PROPERTY_HASH
+  JsvHashIndex *idx = jsvHashIndexFind(parent);
+  if (idx && idx->table)
+    return jsvHashIndexLookup(idx, name, 0);
+#endif
   JsVarRef childref = jsvGetFirstChild(parent);
+  JsVar *found = 0;
+#ifndef ESPR_NO_PROPERTY_HASH
+  unsigned int childCount = 0;
+#endif
   if (!superFastCheck) { // more than 4 chars so we MUST use stringequal
     while (childref) {
       // Don't Lock here, just use GetAddressOf - to try and speed up the finding
       JsVar *child = jsvGetAddressOf(childref);
       if (jsvFastPrefixEqual(fastCheck, child->varData.str) && // speedy check of first 4 bytes
           jsvIsStringEqual(child, name)) {
-        // found it! unlock parent but leave child locked
-        return jsvLockAgain(child);
+        found = child;
+        break;
       }
       childref = jsvGetNextSibling(child);
+#ifndef ESPR_NO_PROPERTY_HASH
+      childCount++;
+#endif
     }
   } else { // 4 or less chars, so if 4 chars match, there is no StringExt + length matches, then we're good without jsvIsStringEqual
     size_t charsInName = 0;
@@ -3082,13 +3490,22 @@ JsVar *jsvFindChildFromString(JsVar *parent, const char *name) {
       if (jsvFastPrefixEqual(fastCheck, child->varData.str) &&
           !child->varData.ref.lastChild &&
           jsvGetCharactersInVar(child)==charsInName) { // no extra stringexts - so it really is that small
-        // found it! unlock parent but leave child locked
-        return jsvLockAgain(child);
+        found = child;
+        break;
       }
       childref = jsvGetNextSibling(child);
+#ifndef ESPR_NO_PROPERTY_HASH
+      childCount++;
+#endif
     }
   }
-  return 0;
+  // found it! unlock parent but leave child locked
+  found = jsvLockAgainSafe(found);
+#ifndef ESPR_NO_PROPERTY_HASH
+  if (childCount >= JSV_HASH_INDEX_THRESHOLD && !idx)
+    jsvHashIndexBuild(parent);
+#endif
+  return found;
 }
 
 JsVar *jsvFindOrAddChildFromString(JsVar *parent, const char *name) {
@@ -3153,6 +3570,16 @@ JsVar *jsvAsName(JsVar *var) {
 JsVar *jsvFindChildFromVar(JsVar *parent, JsVar *childName, bool addIfNotFound) {
   JsVar *child;
   JsVarRef childref = jsvGetFirstChild(parent);
+#ifndef ESPR_NO_PROPERTY_HASH
+  // we only index names that are strings
+  JsvHashIndex *idx = jsvIsString(childName) ? jsvHashIndexFind(parent) : 0;
+  if (idx && idx->table) {
+    childref = 0; // don't search
+    child = jsvHashIndexLookup(idx, 0, childName);
+    if (child) return child;
+  }
+  unsigned int childCount = 0;
+#endif
 
   // TODO: could split this into separate loops looking for Numeric/String
 
@@ -3164,8 +3591,15 @@ JsVar *jsvFindChildFromVar(JsVar *parent, JsVar *childName, bool addIfNotFound)
     }
     childref = jsvGetNextSibling(child);
     jsvUnLock(child);
+#ifndef ESPR_NO_PROPERTY_HASH
+    childCount++;
+#endif
   }
 
+#ifndef ESPR_NO_PROPERTY_HASH
+  if (childCount >= JSV_HASH_INDEX_THRESHOLD && !idx && jsvIsString(childName))
+    jsvHashIndexBuild(parent);
+#endif
   child = 0;
   if (addIfNotFound && childName) {
     child = jsvAsName(childName);
@@ -3182,6 +3616,10 @@ void jsvRemoveChild(JsVar *parent, JsVar *child) {
 #endif
   JsVarRef childref = jsvGetRef(child);
   bool wasChild = false;
+  jsvShapeEpoch++;
+#ifndef ESPR_NO_PROPERTY_HASH
+  JsvHashIndex *idx = jsvHashIndexFind(parent);
+#endif
   // unlink from parent
   if (jsvGetFirstChild(parent) == childref) {
     jsvSetFirstChild(parent, jsvGetNextSibling(child));
@@ -3219,6 +3657,9 @@ void jsvRemoveChild(JsVar *parent, JsVar *child) {
 
   jsvSetPrevSibling(child, 0);
   jsvSetNextSibling(child, 0);
+#ifndef ESPR_NO_PROPERTY_HASH
+  if (idx && wasChild) jsvHashIndexUpdate(idx, parent, child, false);
+#endif
   if (wasChild)
     jsvUnRef(child);
 }
@@ -3739,6 +4180,7 @@ JsVar *jsvArrayPop(JsVar *arr) {
 JsVar *jsvArrayPopFirst(JsVar *arr) {
   assert(jsvIsArray(arr));
   if (jsvGetFirstChild(arr)) {
+    jsvShapeEpoch++;
     JsVar *child = jsvLock(jsvGetFirstChild(arr));
     if (jsvGetFirstChild(arr) == jsvGetLastChild(arr))
       jsvSetLastChild(arr, 0); // if 1 item in array
@@ -3819,6 +4261,7 @@ void jsvArrayInsertBefore(JsVar *arr, JsVar *beforeIndex, JsVar *element) {
   if (beforeIndex) {
     JsVar *idxVar = jsvMakeIntoVariableName(jsvNewFromInteger(0), element);
     if (!idxVar) return; // out of memory
+    jsvShapeEpoch++;
 
     JsVarRef idxRef = jsvGetRef(jsvRef(idxVar));
     JsVarRef prev = jsvGetPrevSibling(beforeIndex);
@@ -3843,12 +4286,28 @@ void jsvArrayInsertBefore(JsVar *arr, JsVar *beforeIndex, JsVar *element) {
  * and go to what they point to. Also handle the case where
  * they may be objects with valueOf functions. */
 JsVar *jsvMathsOpSkipNames(JsVar *a, JsVar *b, int op) {
-  JsVar *pa = jsvSkipName(a);
-  JsVar *pb = jsvSkipName(b);
-  JsVar *oa = jsvGetValueOfAndUnLock(pa);
-  JsVar *ob = jsvGetValueOfAndUnLock(pb);
+  /* Names that store an int literal would need a new var allocating for
+   * their value. jsvMathsOp only reads ints, so instead we just use
+   * an unlocked temporary on the stack */
+  JsVar ta, tb;
+  JsVar *oa, *ob;
+  JsVarFlags fa = a ? (a->flags&JSV_VARTYPEMASK) : 0;
+  JsVarFlags fb = b ? (b->flags&JSV_VARTYPEMASK) : 0;
+  bool aIsInt = JSV_IS_NAME_INT(fa);
+  bool bIsInt = JSV_IS_NAME_INT(fb);
+  if (aIsInt) {
+    ta.flags = JSV_INTEGER;
+    ta.varData.integer = (JsVarInt)jsvGetFirstChildSigned(a);
+    oa = &ta;
+  } else oa = jsvGetValueOfAndUnLock(jsvSkipName(a));
+  if (bIsInt) {
+    tb.flags = JSV_INTEGER;
+    tb.varData.integer = (JsVarInt)jsvGetFirstChildSigned(b);
+    ob = &tb;
+  } else ob = jsvGetValueOfAndUnLock(jsvSkipName(b));
   JsVar *res = jsvMathsOp(oa,ob,op);
-  jsvUnLock2(oa, ob);
+  if (!aIsInt) jsvUnLock(oa);
+  if (!bIsInt) jsvUnLock(ob);
   return res;
 }
 
@@ -4039,6 +4498,118 @@ JsVar *jsvMathsOp(JsVar *a, JsVar *b, int op) {
   }
 }
 
+/* Can the number in name 'a' be updated in place? This is true either if it's
+ * an int stored as a literal in the name itself (*value=0) or if it's an int or
+ * float that only 'a' references (*value is set and locked) */
+static bool jsvGetInPlaceNumber(JsVar *a, JsVar **value) {
+  *value = 0;
+  if (!jsvIsName(a) || jsvIsArrayBufferName(a) || jsvIsConstant(a) || jsvIsNewChild(a))
+    return false;
+  JsVarFlags f = a->flags & JSV_VARTYPEMASK;
+  if (JSV_IS_NAME_INT(f)) return true;
+  if (jsvIsNameWithValue(a)) return false; // a boolean
+  JsVar *v = jsvLockSafe(jsvGetFirstChild(a));
+  f = v ? (v->flags & JSV_VARTYPEMASK) : 0;
+  if ((f==JSV_INTEGER || f==JSV_FLOAT) && jsvGetRefs(v)==1 && jsvGetLocks(v)==1) {
+    *value = v;
+    return true;
+  }
+  jsvUnLock(v);
+  return false;
+}
+
+/* Store the result of an in-place maths op back into the name/value from
+ * jsvGetInPlaceNumber, and unlock the value */
+static void jsvSetInPlaceNumber(JsVar *a, JsVar *v, bool isInt, long long i, JsVarFloat f) {
+  if (isInt && (i<-2147483648LL || i>2147483647LL)) {
+    isInt = false;
+    f = (JsVarFloat)i;
+  }
+  if (v) {
+    v->flags = (JsVarFlags)((v->flags & ~JSV_VARTYPEMASK) | (isInt ? JSV_INTEGER : JSV_FLOAT));
+    if (isInt) v->varData.integer = (JsVarInt)i;
+    else v->varData.floating = f;
+    jsvUnLock(v);
+  } else if (isInt && i>=JSVARREF_MIN && i<=JSVARREF_MAX) {
+    jsvSetFirstChild(a, (JsVarRef)i); // still fits in the name
+  } else { // too big to be a literal in the name - we have to allocate
+    v = isInt ? jsvNewFromInteger((JsVarInt)i) : jsvNewFromFloat(f);
+    if (v) jsvSetValueOfName(a, v);
+    jsvUnLock(v);
+  }
+}
+
+/** Perform 'a op= b' by writing the result straight into name 'a' (or the number it
+ * references) without allocating a new JsVar. This is only done if a's value is an int or
+ * float that only 'a' references, and 'b' is an int or float. Returns false (doing nothing)
+ * otherwise, in which case jsvMathsOpSkipNames+jsvReplaceWith should be used */
+bool jsvMathsOpInPlace(JsVar *a, JsVar *b, int op) {
+  JsVarFlags fb = b ? (b->flags & JSV_VARTYPEMASK) : 0;
+  if (fb!=JSV_INTEGER && fb!=JSV_FLOAT) return false;
+  JsVar *v;
+  if (!jsvGetInPlaceNumber(a, &v)) return false;
+  bool isInt = true;
+  long long ri = 0;
+  JsVarFloat rf = 0;
+  if ((!v || jsvIsInt(v)) && fb==JSV_INTEGER && op!='/') {
+    JsVarInt da = v ? v->varData.integer : (JsVarInt)jsvGetFirstChildSigned(a);
+    JsVarInt db = b->varData.integer;
+    switch (op) {
+    case '+': ri = (long long)da + (long long)db; break;
+    case '-': ri = (long long)da - (long long)db; break;
+    case '*': ri = (long long)da * (long long)db; break;
+    case '&': ri = da&db; break;
+    case '|': ri = da|db; break;
+    case '^': ri = da^db; break;
+    case '%': if (db<0) db=-db; // fix SIGFPE
+              if (db) ri = da%db;
+              else { isInt = false; rf = NAN; }
+              break;
+    case LEX_LSHIFT: ri = (JsVarInt)(da << db); break;
+    case LEX_RSHIFT: ri = da >> db; break;
+    case LEX_RSHIFTUNSIGNED: ri = ((JsVarIntUnsigned)da) >> db; break;
+    default: op = 0;
+    }
+  } else {
+    JsVarFloat da = v ? jsvGetFloat(v) : (JsVarFloat)jsvGetFirstChildSigned(a);
+    JsVarFloat db = jsvGetFloat(b);
+    isInt = false;
+    switch (op) {
+    case '+': rf = da+db; break;
+    case '-': rf = da-db; break;
+    case '*': rf = da*db; break;
+    case '/': rf = da/db; break;
+    case '%': rf = jswrap_math_mod(da, db); break;
+    default: op = 0; // bitwise ops on floats need ToInt32 - leave to jsvMathsOp
+    }
+  }
+  if (!op) {
+    jsvUnLock(v);
+    return false;
+  }
+  jsvSetInPlaceNumber(a, v, isInt, ri, rf);
+  return true;
+}
+
+/** Add 'delta' to the number in name 'a' in place (for ++/--), see jsvMathsOpInPlace.
+ * If oldValue is set, it is filled in with a new var containing the value before the increment */
+bool jsvIncrementInPlace(JsVar *a, JsVarInt delta, JsVar **oldValue) {
+  JsVar *v;
+  if (!jsvGetInPlaceNumber(a, &v)) return false;
+  bool isInt = !v || jsvIsInt(v);
+  long long i = !v ? jsvGetFirstChildSigned(a) : (isInt ? v->varData.integer : 0);
+  JsVarFloat f = (v && !isInt) ? v->varData.floating : 0;
+  if (oldValue) {
+    *oldValue = isInt ? jsvNewFromInteger((JsVarInt)i) : jsvNewFromFloat(f);
+    if (!*oldValue) { // out of memory
+      jsvUnLock(v);
+      return false;
+    }
+  }
+  jsvSetInPlaceNumber(a, v, isInt, i+delta, f+(JsVarFloat)delta);
+  return true;
+}
+
 JsVar *jsvNegateAndUnLock(JsVar *v) {
   JsVar *zero = jsvNewFromInteger(0);
   JsVar *res = jsvMathsOpSkipNames(zero, v, '-');
@@ -4292,9 +4863,30 @@ static bool jsvGarbageCollectMarkUsed(JsVar *var) {
   return true;
 }
 
+/// Keep track of the longest time we've spent garbage collecting
+static void jsvGarbageCollectUpdatePause(JsSysTime startTime) {
+  JsSysTime t = jshGetSystemTime() - startTime;
+  if (t > jsvGCMaxPause) jsvGCMaxPause = t;
+}
+
+static int _jsvGarbageCollect();
+
 /** Run a garbage collection sweep - return nonzero if things have been freed */
 int jsvGarbageCollect() {
   if (isMemoryBusy) return 0;
+  // a full GC does everything an incremental one would have done
+  jsvGarbageCollectAbort();
+#ifndef ESPR_NO_PROPERTY_HASH
+  // Objects freed by the GC don't go through jsvFreePtr, and this gives us some memory back
+  jsvHashIndexClear(true);
+#endif
+  JsSysTime startTime = jshGetSystemTime();
+  int freedCount = _jsvGarbageCollect();
+  jsvGarbageCollectUpdatePause(startTime);
+  return freedCount;
+}
+
+static int _jsvGarbageCollect() {
   isMemoryBusy = MEMBUSY_GC;
   JsVarRef i;
   // Add GC flags to anything that is currently used
@@ -4329,7 +4921,10 @@ int jsvGarbageCollect() {
    * hopefully helps compact everything towards the start. */
   unsigned int freedCount = 0;
   jsVarFirstEmpty = 0;
-  JsVar *lastEmpty = 0;
+#ifndef ESPR_NO_NURSERY
+  jsVarNurseryFirstEmpty = 0;
+#endif
+  JsVar *lastEmpty = 0, *lastNurseryEmpty = 0;
   for (i=1;i<=jsVarsSize;i++)  {
     JsVar *var = jsvGetAddressOf(i);
     if (var->flags & JSV_GARBAGE_COLLECT) {
@@ -4340,18 +4935,14 @@ int jsvGarbageCollect() {
         // Free the first block
         var->flags = JSV_UNUSED;
         // add this to our free list
-        if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
-        else jsVarFirstEmpty = i;
-        lastEmpty = var;
+        jsvFreeListAppend(i, var, &lastEmpty, &lastNurseryEmpty);
         // free subsequent blocks
         while (count-- > 0) {
           i++;
           var = jsvGetAddressOf((JsVarRef)(i));
           var->flags = JSV_UNUSED;
           // add this to our free list
-          if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
-          else jsVarFirstEmpty = i;
-          lastEmpty = var;
+          jsvFreeListAppend(i, var, &lastEmpty, &lastNurseryEmpty);
         }
       } else {
         // otherwise just free 1 block
@@ -4391,9 +4982,7 @@ int jsvGarbageCollect() {
         // free!
         var->flags = JSV_UNUSED;
         // add this to our free list
-        if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
-        else jsVarFirstEmpty = i;
-        lastEmpty = var;
+        jsvFreeListAppend(i, var, &lastEmpty, &lastNurseryEmpty);
         freedCount++;
       }
     } else if (jsvIsFlatString(var)) {
@@ -4401,16 +4990,285 @@ int jsvGarbageCollect() {
       i = (JsVarRef)(i+jsvGetFlatStringBlocks(var));
     } else if (var->flags == JSV_UNUSED) {
       // this is already free - add it to the free list
-      if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
-      else jsVarFirstEmpty = i;
-      lastEmpty = var;
+      jsvFreeListAppend(i, var, &lastEmpty, &lastNurseryEmpty);
     }
   }
-  if (lastEmpty) jsvSetNextSibling(lastEmpty, 0);
+  jsvFreeListEnd(lastEmpty, lastNurseryEmpty);
   isMemoryBusy = MEM_NOT_BUSY;
   return (int)freedCount;
 }
 
+/// Get the longest time we've spent in one garbage collection (or one step of an incremental one)
+JsSysTime jsvGarbageCollectGetMaxPause() {
+  return jsvGCMaxPause;
+}
+
+#ifndef ESPR_NO_INCREMENTAL_GC
+/// Add a var to the mark stack so its children get scanned. If there's no space, we'll have to rescan
+static void jsvGarbageCollectPush(JsVar *var) {
+  JsVarRef ref = jsvGetRef(var);
+  if (!ref) return;
+  if (jsvGCMarkStackSize && jsvGCMarkStack[jsvGCMarkStackSize-1]==ref)
+    return; // already waiting to be scanned
+  if (jsvGCMarkStackSize < JSV_GC_MARK_STACK_SIZE)
+    jsvGCMarkStack[jsvGCMarkStackSize++] = ref;
+  else
+    jsvGCMarkOverflow = true;
+}
+
+/** Called when a flat string is allocated during an incremental GC. The blocks
+ * now used for its data may have been queued for scanning before they were freed,
+ * and we mustn't look at them as if they were vars when we next step */
+static void jsvGarbageCollectNewFlatString(JsVarRef ref, unsigned int count) {
+  for (unsigned int i=0;i<jsvGCMarkStackSize;i++)
+    if (jsvGCMarkStack[i]>=ref && jsvGCMarkStack[i]<ref+count)
+      jsvGCMarkStack[i] = 0;
+  // the header has been set up for whatever phase we're in, so just skip the data
+  if (jsvGCCursor>ref && jsvGCCursor<ref+count)
+    jsvGCCursor = ref+count;
+}
+
+/// Mark a var as used, and queue it so that its children get marked too
+static void jsvGarbageCollectMarkGrey(JsVar *var) {
+  var->flags &= (JsVarFlags)~JSV_GARBAGE_COLLECT;
+  jsvGarbageCollectPush(var);
+}
+
+/// Mark the var with the given ref if it hasn't been already
+static void jsvGarbageCollectMarkRef(JsVarRef ref) {
+  if (!ref) return;
+  JsVar *var = jsvGetAddressOf(ref);
+  if (var->flags & JSV_GARBAGE_COLLECT)
+    jsvGarbageCollectMarkGrey(var);
+}
+
+/** Called when a reference is written into 'v' while we're marking. If 'v' has
+ * been marked already and now links to something that hasn't, we need to scan
+ * 'v' again. We don't mark the linked var directly as we can't be sure the value
+ * written was actually a reference (and not string/number data) */
+static void jsvGarbageCollectWriteBarrier(JsVar *v) {
+  if ((v->flags & JSV_GARBAGE_COLLECT) || (v->flags&JSV_VARTYPEMASK)==JSV_UNUSED)
+    return; // not marked yet - it'll be scanned anyway
+  JsVarRef refs[3] = { v->varData.ref.firstChild, v->varData.ref.nextSibling, v->varData.ref.lastChild };
+  for (int i=0;i<3;i++) {
+    if (refs[i] && refs[i]<=jsVarsSize && (jsvGetAddressOf(refs[i])->flags & JSV_GARBAGE_COLLECT)) {
+      jsvGarbageCollectPush(v);
+      return;
+    }
+  }
+}
+
+/** Mark everything directly referenced by the given var. Unlike jsvGarbageCollectMarkUsed
+ * this doesn't recurse - names are linked via nextSibling so we follow those rather than
+ * pushing every child of an object. Returns the amount of work done. */
+static unsigned int jsvGarbageCollectScan(JsVar *var) {
+  unsigned int work = 1;
+  if (jsvHasStringExt(var)) {
+    // non-recursively scan strings
+    JsVarRef child = jsvGetLastChild(var);
+    while (child) {
+      JsVar *childVar = jsvGetAddressOf(child);
+      childVar->flags &= (JsVarFlags)~JSV_GARBAGE_COLLECT;
+      child = jsvGetLastChild(childVar);
+      work++;
+    }
+  }
+  /* Push the next sibling before the child, so we scan the child first. The
+   * mark stack then only grows with how deeply things are nested */
+  if (jsvIsName(var))
+    jsvGarbageCollectMarkRef(jsvGetNextSibling(var));
+  if (jsvHasSingleChild(var) || jsvHasChildren(var))
+    jsvGarbageCollectMarkRef(jsvGetFirstChild(var));
+  return work;
+}
+
+/// Add vars freed by the sweep back into the free list
+static void jsvGarbageCollectReleaseSwept() {
+  if (!jsvGCSweptFirst) return;
+  jshInterruptOff(); // to allow the free list to be used from an IRQ
+#ifndef ESPR_NO_NURSERY
+  // anything from the nursery goes back into the nursery's free list
+  JsVarRef ref = jsvGCSweptFirst;
+  jsvGCSweptFirst = 0;
+  jsvGCSweptLast = 0;
+  while (ref) {
+    JsVar *var = jsvGetAddressOf(ref);
+    JsVarRef next = jsvGetNextSibling(var);
+    if (JSV_IS_NURSERY_REF(ref)) {
+      jsvSetNextSibling(var, jsVarNurseryFirstEmpty);
+      jsVarNurseryFirstEmpty = ref;
+    } else {
+      jsvSetNextSibling(var, 0);
+      if (jsvGCSweptLast) jsvSetNextSibling(jsvGetAddressOf(jsvGCSweptLast), ref);
+      else jsvGCSweptFirst = ref;
+      jsvGCSweptLast = ref;
+    }
+    ref = next;
+  }
+  if (jsvGCSweptFirst) {
+    jsvSetNextSibling(jsvGetAddressOf(jsvGCSweptLast), jsVarFirstEmpty);
+    jsVarFirstEmpty = jsvGCSweptFirst;
+  }
+#else
+  jsvSetNextSibling(jsvGetAddressOf(jsvGCSweptLast), jsVarFirstEmpty);
+  jsVarFirstEmpty = jsvGCSweptFirst;
+#endif
+  touchedFreeList = true;
+  jshInterruptOn();
+  jsvGCSweptFirst = 0;
+  jsvGCSweptLast = 0;
+}
+
+/// Abort any incremental garbage collection in progress
+void jsvGarbageCollectAbort() {
+  /* JSV_GARBAGE_COLLECT may be left set on some vars, but that isn't a
+   * problem as the next GC sets it on everything anyway */
+  jsvGCPhase = JSV_GC_IDLE;
+  jsvGCMarkStackSize = 0;
+  jsvGarbageCollectReleaseSwept();
+}
+
+/// Is an incremental garbage collection in progress?
+bool jsvGarbageCollectIsRunning() {
+  return jsvGCPhase != JSV_GC_IDLE;
+}
+
+/// Mark a var as unused and add it to the list of swept vars
+static void jsvGarbageCollectFreeSwept(JsVarRef ref) {
+  JsVar *var = jsvGetAddressOf(ref);
+  var->flags = JSV_UNUSED;
+  jsvSetNextSibling(var, 0);
+  if (jsvGCSweptLast) jsvSetNextSibling(jsvGetAddressOf(jsvGCSweptLast), ref);
+  else jsvGCSweptFirst = ref;
+  jsvGCSweptLast = ref;
+}
+
+/** Free a var that the incremental GC found was unreachable. This is the same as
+ * the sweep in jsvGarbageCollect, except the free list may have been modified since
+ * we started so we add to a separate list rather than rebuilding it */
+static unsigned int jsvGarbageCollectSweepVar(JsVar *var) {
+  JsVarRef ref = jsvGetRef(var);
+  if (jsvIsFlatString(var)) {
+    unsigned int count = (unsigned int)jsvGetFlatStringBlocks(var);
+    for (unsigned int i=0;i<=count;i++)
+      jsvGarbageCollectFreeSwept((JsVarRef)(ref+i));
+    return count+1;
+  }
+#ifndef ESPR_NO_PROPERTY_HASH
+  if (jsvHasChildren(var))
+    jsvHashIndexRemove(var);
+#endif
+  if (jsvHasSingleChild(var)) {
+    // Unref any child that isn't going to be freed (see jsvGarbageCollect)
+    JsVarRef ch = jsvGetFirstChild(var);
+    if (ch) {
+      JsVar *child = jsvGetAddressOf(ch); // not locked
+      if (child->flags!=JSV_UNUSED && // not already GC'd!
+          !(child->flags&JSV_GARBAGE_COLLECT)) // not marked for GC
+        jsvUnRef(child);
+    }
+  }
+  jsvGarbageCollectFreeSwept(ref);
+  return 1;
+}
+
+/** Do part of an incremental garbage collection. This does roughly 'budget' blocks
+ * worth of work, starting a new GC if one wasn't in progress. Between steps
+ * jsvSetFirstChild/jsvSetNextSibling/jsvSetLastChild and jsvLock make sure that
+ * nothing that is reachable gets freed. Returns true if the GC is still in progress. */
+bool jsvGarbageCollectStep(unsigned int budget) {
+  if (isMemoryBusy) return jsvGarbageCollectIsRunning();
+  JsSysTime startTime = jshGetSystemTime();
+  isMemoryBusy = MEMBUSY_GC;
+  if (jsvGCPhase == JSV_GC_IDLE) {
+    jsvGCPhase = JSV_GC_INIT;
+    jsvGCCursor = 1;
+    jsvGCMarkStackSize = 0;
+    jsvGCMarkOverflow = false;
+    jsvGCMarkRescan = false;
+    jsvGCMarkRescans = 0;
+    jsvGCSweptFirst = 0;
+    jsvGCSweptLast = 0;
+  }
+  while (budget && jsvGCPhase != JSV_GC_IDLE) {
+    if (jsvGCPhase == JSV_GC_INIT) {
+      // Add GC flags to anything that is currently used
+      if (jsvGCCursor > jsVarsSize) {
+        jsvGCPhase = JSV_GC_MARK;
+        jsvGCCursor = 1;
+        continue;
+      }
+      JsVar *var = jsvGetAddressOf((JsVarRef)jsvGCCursor);
+      if ((var->flags&JSV_VARTYPEMASK) != JSV_UNUSED) {
+        var->flags |= (JsVarFlags)JSV_GARBAGE_COLLECT;
+        if (jsvIsFlatString(var))
+          jsvGCCursor += (unsigned int)jsvGetFlatStringBlocks(var);
+      }
+      jsvGCCursor++;
+      budget--;
+    } else if (jsvGCPhase == JSV_GC_MARK) {
+      if (jsvGCMarkStackSize) {
+        // scan the children of something we have marked
+        JsVarRef ref = jsvGCMarkStack[--jsvGCMarkStackSize];
+        JsVar *var = (ref && ref<=jsVarsSize) ? jsvGetAddressOf(ref) : 0;
+        unsigned int work = 1;
+        if (var && (var->flags&JSV_VARTYPEMASK) != JSV_UNUSED) // it may have been freed since
+          work = jsvGarbageCollectScan(var);
+        budget = (work < budget) ? budget-work : 0;
+      } else if (jsvGCCursor <= jsVarsSize) {
+        /* Look for locked vars to use as roots - or if the mark stack overflowed,
+         * for anything marked whose children might not have been */
+        JsVar *var = jsvGetAddressOf((JsVarRef)jsvGCCursor);
+        if ((var->flags&JSV_VARTYPEMASK) != JSV_UNUSED) {
+          if (jsvIsFlatString(var)) {
+            if ((var->flags & JSV_GARBAGE_COLLECT) && jsvGetLocks(var))
+              var->flags &= (JsVarFlags)~JSV_GARBAGE_COLLECT;
+            jsvGCCursor += (unsigned int)jsvGetFlatStringBlocks(var);
+          } else if (jsvGCMarkRescan) {
+            if (!(var->flags & JSV_GARBAGE_COLLECT))
+              jsvGarbageCollectScan(var);
+          } else if ((var->flags & JSV_GARBAGE_COLLECT) && jsvGetLocks(var)) {
+            jsvGarbageCollectMarkGrey(var);
+          }
+        }
+        jsvGCCursor++;
+        budget--;
+      } else if (jsvGCMarkOverflow) {
+        // we ran out of mark stack - go around again looking for what we missed
+        jsvGCMarkOverflow = false;
+        jsvGCMarkRescan = true;
+        jsvGCCursor = 1;
+        /* If we keep overflowing (because code running between steps keeps
+         * modifying things) just finish off in this step */
+        if (++jsvGCMarkRescans > 4)
+          budget = (unsigned int)-1;
+      } else {
+        // Everything reachable has been marked
+        jsvGCPhase = JSV_GC_SWEEP;
+        jsvGCCursor = 1;
+      }
+    } else { // JSV_GC_SWEEP
+      if (jsvGCCursor > jsVarsSize) {
+        jsvGCPhase = JSV_GC_IDLE;
+        jsvGarbageCollectReleaseSwept();
+        break;
+      }
+      JsVar *var = jsvGetAddressOf((JsVarRef)jsvGCCursor);
+      if (var->flags & JSV_GARBAGE_COLLECT) {
+        jsvGCCursor += jsvGarbageCollectSweepVar(var)-1;
+      } else if (jsvIsFlatString(var)) {
+        jsvGCCursor += (unsigned int)jsvGetFlatStringBlocks(var);
+      }
+      jsvGCCursor++;
+      budget--;
+    }
+  }
+  isMemoryBusy = MEM_NOT_BUSY;
+  jsvGarbageCollectUpdatePause(startTime);
+  return jsvGarbageCollectIsRunning();
+}
+#endif
+
 #ifndef SAVE_ON_FLASH
 static void _jsvDefragment_moveReferences(JsVarRef defragFromRef, JsVarRef defragToRef, unsigned int lastAllocated) {
   // find references!
@@ -4442,6 +5300,9 @@ void jsvDefragment() {
   // garbage collect - removes cruft, also puts free list in order
   if (isMemoryBusy) return;
   jsvGarbageCollect();
+#ifndef ESPR_NO_PROPERTY_HASH
+  jsvHashIndexClear(true); // unlock the index tables, or they'd stay locked when jsvCreateEmptyVarList forgets them
+#endif
   // Set memory busy so nobody can allocate, and we can defrag with IRQ on
   isMemoryBusy = MEMBUSY_DEFRAG;
   const unsigned int minMove = 20; // don't move vars back less than this or we're just wasting CPU time
@@ -4554,6 +5415,256 @@ void jsvDefragment() {
 }
 #endif
 
+/// Count the free blocks in main memory (not the nursery), and find the longest contiguous run of them
+static void jsvGetFreeRuns(unsigned int *largestRun, unsigned int *freeBlocks) {
+  unsigned int largest = 0, run = 0, free = 0;
+  for (JsVarRef i=1;i<=jsVarsSize;i++) {
+#ifdef RESIZABLE_JSVARS
+    if (((i-1)&(JSVAR_BLOCK_SIZE-1))==0) run = 0; // blocks of vars aren't contiguous
+#endif
+    JsVar *v = jsvGetAddressOf(i);
+    if ((v->flags&JSV_VARTYPEMASK) == JSV_UNUSED && JSV_IS_MAIN_MEMORY_REF(i)) {
+      free++;
+      run++;
+      if (run>largest) largest = run;
+    } else {
+      run = 0;
+      if (jsvIsFlatString(v))
+        i = (JsVarRef)(i+jsvGetFlatStringBlocks(v)); // skip forward
+    }
+  }
+  *largestRun = largest;
+  if (freeBlocks) *freeBlocks = free;
+}
+
+/// Get the largest number of contiguous free blocks - roughly the biggest flat string that can be allocated
+unsigned int jsvGetLargestFreeRun() {
+  unsigned int largest;
+  jsvGetFreeRuns(&largest, NULL);
+  return largest;
+}
+
+#ifndef ESPR_NO_AUTO_DEFRAG
+/// If 'ref' is one of the 'count' vars in fromRefs (sorted highest first), return where it was moved to
+static JsVarRef jsvDefragmentRemapRef(JsVarRef ref, const JsVarRef *fromRefs, const JsVarRef *toRefs, unsigned int count) {
+  if (!ref || ref < fromRefs[count-1]) return ref; // lower than anything we moved
+  for (unsigned int i=0;i<count;i++)
+    if (fromRefs[i]==ref) return toRefs[i];
+  return ref;
+}
+
+/* Find the first run of 'blocks' free blocks at or after 'ref' and before 'before' (so
+ * moving there moves a var down in memory), or return 0. Flat strings must start so their
+ * data is 4 byte aligned (https://github.com/espruino/Espruino/issues/2726) */
+static JsVarRef jsvDefragmentFindFree(JsVarRef ref, unsigned int blocks, JsVarRef before) {
+  unsigned int run = 0;
+  for (;ref+blocks-run<=before;ref++) {
+#ifdef RESIZABLE_JSVARS
+    if (((ref-1)&(JSVAR_BLOCK_SIZE-1))==0) run = 0; // blocks of vars aren't contiguous
+#endif
+    JsVar *v = jsvGetAddressOf(ref);
+    if ((v->flags&JSV_VARTYPEMASK) != JSV_UNUSED || !JSV_IS_MAIN_MEMORY_REF(ref)) {
+      run = 0;
+      if (jsvIsFlatString(v))
+        ref = (JsVarRef)(ref+jsvGetFlatStringBlocks(v)); // skip forward
+    } else if (run || blocks==1 || !(((size_t)jsvGetAddressOf(ref+1))&3)) {
+      if (++run == blocks) return (JsVarRef)(ref+1-blocks);
+    }
+  }
+  return 0;
+}
+
+/** Do one step of compacting memory: move unlocked vars (up to maxMoves blocks, at most
+ * JSV_DEFRAG_STEP_BLOCKS) from the end of main memory into the first free space, then update
+ * references to them in one pass. Unlike jsvDefragment this doesn't garbage collect first and
+ * only scans memory a few times, so it's quick enough to run from idle. Returns true if
+ * there may be more that could be moved */
+bool jsvDefragmentStep(unsigned int maxMoves) {
+  if (isMemoryBusy) return false;
+  if (maxMoves > JSV_DEFRAG_STEP_BLOCKS) maxMoves = JSV_DEFRAG_STEP_BLOCKS;
+  if (!maxMoves) return false;
+  jsvGarbageCollectAbort(); // the incremental GC's mark stack contains refs
+#ifndef ESPR_NO_PROPERTY_HASH
+  jsvHashIndexClear(true);
+#endif
+  isMemoryBusy = MEMBUSY_DEFRAG;
+  JsVarRef fromRefs[JSV_DEFRAG_STEP_BLOCKS]; // the last movable vars (a ring buffer while scanning)
+  unsigned int fromCount = 0;
+  JsVarRef firstFree = 0;
+  /* We can't scan backwards through memory because flat strings' data
+   * may look like vars - so scan forwards, remembering the last vars we found */
+  for (JsVarRef i=1;i<=jsVarsSize;i++) {
+    JsVar *v = jsvGetAddressOf(i);
+    if ((v->flags&JSV_VARTYPEMASK) == JSV_UNUSED) {
+      if (!firstFree && JSV_IS_MAIN_MEMORY_REF(i)) firstFree = i;
+      continue;
+    }
+    if (firstFree && !jsvGetLocks(v) && JSV_IS_MAIN_MEMORY_REF(i))
+      fromRefs[(fromCount++)%maxMoves] = i;
+    if (jsvIsFlatString(v))
+      i = (JsVarRef)(i+jsvGetFlatStringBlocks(v)); // skip forward
+  }
+  // Move the highest vars first, each to the first space that'll fit it
+  JsVarRef movedFrom[JSV_DEFRAG_STEP_BLOCKS], movedTo[JSV_DEFRAG_STEP_BLOCKS]; // movedFrom is highest first
+  unsigned int moved = 0, blocksMoved = 0;
+  unsigned int count = fromCount<maxMoves ? fromCount : maxMoves;
+  jshInterruptOff(); // IRQ off while moving - jstimer might be reading vars
+  for (unsigned int i=0;i<count && blocksMoved<maxMoves;i++) {
+    JsVarRef fromRef = fromRefs[(fromCount-1-i)%maxMoves];
+#ifndef SAVE_ON_FLASH
+    /* Timer tasks (eg. Waveform) hold refs and raw pointers to their buffers that
+     * we can't update, and the buffers aren't locked while playing */
+    if (jstIsBufferTimerTaskVar(fromRef)) continue;
+#endif
+    JsVar *from = jsvGetAddressOf(fromRef);
+    unsigned int blocks = jsvIsFlatString(from) ? 1+(unsigned int)jsvGetFlatStringBlocks(from) : 1;
+    if (blocksMoved+blocks > maxMoves) continue; // too big to move this time
+    JsVarRef toRef = jsvDefragmentFindFree(firstFree, blocks, fromRef);
+    if (!toRef) continue; // no space below it
+    memmove(jsvGetAddressOf(toRef), from, sizeof(JsVar)*blocks);
+    memset(from, 0, sizeof(JsVar)*blocks); // set flags to 0=unused
+    movedFrom[moved] = fromRef;
+    movedTo[moved] = toRef;
+    moved++;
+    blocksMoved += blocks;
+    if (blocks==1) firstFree = (JsVarRef)(toRef+1); // everything before toRef is used now
+  }
+  if (moved) { // update all references in one pass
+    for (JsVarRef vr=1;vr<=jsVarsSize;vr++) {
+      JsVar *v = jsvGetAddressOf(vr);
+      if ((v->flags&JSV_VARTYPEMASK)==JSV_UNUSED) continue;
+      if (jsvIsFlatString(v)) { // flat string -> doesn't contain references to other things
+        vr = (JsVarRef)(vr+jsvGetFlatStringBlocks(v)); // skip forward
+        continue;
+      }
+      if (jsvHasSingleChild(v) || jsvHasChildren(v))
+        jsvSetFirstChild(v, jsvDefragmentRemapRef(jsvGetFirstChild(v), movedFrom, movedTo, moved));
+      if (jsvHasStringExt(v) || jsvHasChildren(v))
+        jsvSetLastChild(v, jsvDefragmentRemapRef(jsvGetLastChild(v), movedFrom, movedTo, moved));
+      if (jsvIsName(v)) {
+        jsvSetNextSibling(v, jsvDefragmentRemapRef(jsvGetNextSibling(v), movedFrom, movedTo, moved));
+        jsvSetPrevSibling(v, jsvDefragmentRemapRef(jsvGetPrevSibling(v), movedFrom, movedTo, moved));
+      }
+    }
+  }
+  jshInterruptOn();
+  isMemoryBusy = MEM_NOT_BUSY;
+  // rebuild free var list (in order, so flat strings can find the space we've made)
+  if (moved) jsvCreateEmptyVarList();
+  if (!moved) jsvDefragRunning = false; // nothing else we can move
+  return moved!=0;
+}
+
+/// Set the largest free run below which memory is compacted when idle (0 disables it)
+void jsvDefragmentSetThreshold(unsigned int blocks) {
+  jsvDefragThreshold = blocks;
+  jsvDefragRunning = false;
+  jsvDefragLastCheck = 0; // check again next time we're idle
+}
+
+/** Should jsvDefragmentStep be called from idle? This scans memory at most once a second
+ * unless compaction is in progress */
+bool jsvDefragmentNeeded() {
+  if (!jsvDefragThreshold) return false;
+  JsSysTime now = jshGetSystemTime();
+  if (!jsvDefragRunning) {
+    if (jsvDefragLastCheck && now-jsvDefragLastCheck < jshGetTimeFromMilliseconds(1000))
+      return false;
+  }
+  jsvDefragLastCheck = now;
+  unsigned int largest, free;
+  jsvGetFreeRuns(&largest, &free);
+  // only bother if there's enough free memory for compacting to help
+  jsvDefragRunning = largest<jsvDefragThreshold && free>=jsvDefragThreshold+jsvDefragThreshold/2;
+  return jsvDefragRunning;
+}
+#endif
+
+#ifndef ESPR_NO_NURSERY
+/// Has the nursery (where numbers are allocated) filled up since we last called jsvNurseryPromote?
+bool jsvNurseryNeedsPromote() {
+  return jsvNurseryMisses != jsvNurseryMissesAtPromote;
+}
+
+/// If 'ref' is in the nursery and has been moved, return where it's been moved to
+static ALWAYS_INLINE JsVarRef jsvNurseryRemapRef(JsVarRef ref, const JsVarRef *newRefs) {
+  if (JSV_IS_NURSERY_REF(ref) && newRefs[ref-jsvNurseryFirst])
+    return newRefs[ref-jsvNurseryFirst];
+  return ref;
+}
+
+/** Move anything in the nursery that isn't locked (so must be referenced from something
+ * longer-lived) out into main memory. Returns the number of vars moved */
+unsigned int jsvNurseryPromote() {
+  jsvNurseryMissesAtPromote = jsvNurseryMisses;
+  if (isMemoryBusy) return 0;
+  jsvGarbageCollectAbort(); // the incremental GC's mark stack contains refs
+  isMemoryBusy = MEMBUSY_DEFRAG;
+  JsVarRef newRefs[JSV_NURSERY_SIZE]; // where each var in the nursery has moved to (or 0)
+  memset(newRefs, 0, sizeof(newRefs));
+  unsigned int moved = 0;
+  jshInterruptOff(); // IRQ off while moving - jstimer might be reading vars
+  // Move vars, like jsvDefragment does...
+  for (JsVarRef ref=jsvNurseryFirst;ref && ref<=jsvNurseryLast && jsVarFirstEmpty;ref++) {
+    JsVar *from = jsvGetAddressOf(ref);
+    if ((from->flags&JSV_VARTYPEMASK) == JSV_UNUSED) continue;
+    if (jsvIsFlatString(from)) { // we only got here because main memory was full - leave it
+      ref = (JsVarRef)(ref+jsvGetFlatStringBlocks(from));
+      continue;
+    }
+    if (jsvGetLocks(from)) continue; // something is still using it
+    JsVarRef toRef = jsVarFirstEmpty;
+    JsVar *to = jsvGetAddressOf(toRef);
+    jsVarFirstEmpty = jsvGetNextSibling(to);
+    *to = *from;
+    from->flags = JSV_UNUSED;
+    jsvSetNextSibling(from, jsVarNurseryFirstEmpty);
+    jsVarNurseryFirstEmpty = ref;
+    newRefs[ref-jsvNurseryFirst] = toRef;
+    moved++;
+  }
+  // ... then update all the references to them in one pass
+  if (moved) {
+    for (JsVarRef vr=1;vr<=jsVarsSize;vr++) {
+      JsVar *v = jsvGetAddressOf(vr);
+      if ((v->flags&JSV_VARTYPEMASK)==JSV_UNUSED) continue;
+      if (jsvIsFlatString(v)) { // flat string -> doesn't contain references to other things
+        vr = (JsVarRef)(vr+jsvGetFlatStringBlocks(v)); // skip forward
+        continue;
+      }
+      if (jsvHasSingleChild(v) || jsvHasChildren(v))
+        jsvSetFirstChild(v, jsvNurseryRemapRef(jsvGetFirstChild(v), newRefs));
+      if (jsvHasStringExt(v) || jsvHasChildren(v))
+        jsvSetLastChild(v, jsvNurseryRemapRef(jsvGetLastChild(v), newRefs));
+      if (jsvIsName(v)) {
+        jsvSetNextSibling(v, jsvNurseryRemapRef(jsvGetNextSibling(v), newRefs));
+        jsvSetPrevSibling(v, jsvNurseryRemapRef(jsvGetPrevSibling(v), newRefs));
+      }
+    }
+    touchedFreeList = true;
+  }
+  jshInterruptOn();
+  isMemoryBusy = MEM_NOT_BUSY;
+  if (moved) {
+    jsvNurseryPromoted += moved;
+    // anything that remembered where a var was is now out of date
+#ifndef ESPR_NO_PROPERTY_HASH
+    jsvHashIndexClear(true);
+#endif
+    jsvShapeEpoch++;
+  }
+  return moved;
+}
+
+/// Get the size of the nursery, and how many allocations did (hits) and didn't (misses) fit in it
+void jsvNurseryGetStats(unsigned int *size, unsigned int *hits, unsigned int *misses, unsigned int *promoted) {
+  *size = (unsigned int)(jsvNurseryLast+1-jsvNurseryFirst);
+  *hits = jsvNurseryHits;
+  *misses = jsvNurseryMisses;
+  *promoted = jsvNurseryPromoted;
+}
+#endif
+
 // Dump any locked variables that aren't referenced from `global` - for debugging memory leaks
 void jsvDumpLockedVars() {
   jsvGarbageCollect();
@@ -610,6 +610,8 @@ void jsvReplaceWithOrAddToRoot(JsVar *dst, JsVar *src);
 size_t jsvGetArrayBufferLength(const JsVar *arrayBuffer);
 /** Get the String the contains the data for this arrayBuffer. Is ok with being passed a String in the first place. Offset is the offset in the backing string of this arraybuffer. */
 JsVar *jsvGetArrayBufferBackingString(JsVar *arrayBuffer, uint32_t *offset);
+/** If the elements of this ArrayBuffer are in one contiguous block of memory, return a (maybe unaligned) pointer to the first (and set length to the number of elements). Otherwise return 0 */
+char *jsvGetArrayBufferDataPointer(JsVar *arrayBuffer, size_t *length, bool writable);
 /** Get the item at the given location in the array buffer and return the result */
 JsVar *jsvArrayBufferGet(JsVar *arrayBuffer, size_t index);
 /** Set the item at the given location in the array buffer */
@@ -678,6 +680,10 @@ JsVar *jsvAsName(JsVar *var);
 JsVar *jsvMathsOpSkipNames(JsVar *a, JsVar *b, int op);
 bool jsvMathsOpTypeEqual(JsVar *a, JsVar *b);
 JsVar *jsvMathsOp(JsVar *a, JsVar *b, int op);
+/// Perform 'a op= b' in place on a's numeric value (no allocation). Returns false if it couldn't be done
+bool jsvMathsOpInPlace(JsVar *a, JsVar *b, int op);
+/// Perform 'a += delta' in place on a's numeric value, optionally returning a copy of the old value. Returns false if it couldn't be done
+bool jsvIncrementInPlace(JsVar *a, JsVarInt delta, JsVar **oldValue);
 /// Negates an integer/double value
 JsVar *jsvNegateAndUnLock(JsVar *v);
 
@@ -703,6 +709,10 @@ JsVar *jsvFindChildFromVar(JsVar *parent, JsVar *childName, bool addIfNotFound);
 
 /// Remove a child - note that the child MUST ACTUALLY BE A CHILD! and should be a name, not a value.
 void jsvRemoveChild(JsVar *parent, JsVar *child);
+/** Incremented whenever a child is added to or removed from any object or array, memory is
+ * reset or a new lexer is started, so anything that has looked up a name can tell if it might
+ * now find a different one */
+extern unsigned int jsvShapeEpoch;
 /// See jsvRemoveChild (this just unlocks child after)
 void jsvRemoveChildAndUnLock(JsVar *parent, JsVar *child);
 void jsvRemoveAllChildren(JsVar *parent);
@@ -777,9 +787,47 @@ void jsvTrace(JsVar *var, int indent);
 /** Run a garbage collection sweep - return nonzero if things have been freed */
 int jsvGarbageCollect();
 
+/// Get the longest time we've spent in one garbage collection (or one step of an incremental one)
+JsSysTime jsvGarbageCollectGetMaxPause();
+
+#ifndef ESPR_NO_INCREMENTAL_GC
+/** Do part of an incremental garbage collection. This does roughly 'budget' blocks
+ * worth of work, starting a new GC if one wasn't in progress. Returns true if the GC is still in progress. */
+bool jsvGarbageCollectStep(unsigned int budget);
+/// Is an incremental garbage collection in progress?
+bool jsvGarbageCollectIsRunning();
+/// Abort any incremental garbage collection in progress
+void jsvGarbageCollectAbort();
+#else
+static ALWAYS_INLINE void jsvGarbageCollectAbort() {}
+#endif
+
 /** Defragement memory - this could take a while with interrupts turned off! */
 void jsvDefragment();
 
+/// Get the largest number of contiguous free blocks - roughly the biggest flat string that can be allocated
+unsigned int jsvGetLargestFreeRun();
+
+#ifndef ESPR_NO_AUTO_DEFRAG
+/** Do one step of compacting memory: move up to maxMoves (at most JSV_DEFRAG_STEP_BLOCKS)
+ * unlocked vars from the end of main memory into the first free blocks. Returns true if there is more that could be moved */
+bool jsvDefragmentStep(unsigned int maxMoves);
+/// Set the largest free run below which memory is compacted when idle (0 disables it)
+void jsvDefragmentSetThreshold(unsigned int blocks);
+/// Should jsvDefragmentStep be called from idle? This scans memory at most once a second unless compaction is in progress
+bool jsvDefragmentNeeded();
+#endif
+
+#ifndef ESPR_NO_NURSERY
+/// Has the nursery (where numbers are allocated) filled up since we last called jsvNurseryPromote?
+bool jsvNurseryNeedsPromote();
+/** Move anything in the nursery that isn't locked (so must be referenced from something
+ * longer-lived) out into main memory. Returns the number of vars moved */
+unsigned int jsvNurseryPromote();
+/// Get the size of the nursery, and how many allocations did (hits) and didn't (misses) fit in it
+void jsvNurseryGetStats(unsigned int *size, unsigned int *hits, unsigned int *misses, unsigned int *promoted);
+#endif
+
 // Dump any locked variables that aren't referenced from `global` - for debugging memory leaks
 void jsvDumpLockedVars();
 // Dump the free list - in order
@@ -153,10 +153,10 @@ bool jsvIterateBufferCallback(
     JsvStringIterator it;
     jsvStringIteratorNew(&it, data, 0);
     while (jsvStringIteratorHasChar(&it) && ok) {
-      unsigned char *data;
-      unsigned int len;
-      jsvStringIteratorGetPtrAndNext(&it,&data,&len);
-      callback(data, len, callbackData);
+      // Call back *before* moving on - Flash Strings are read into a buffer in the iterator that moving on overwrites
+      callback((unsigned char *)&it.ptr[it.charIdx], (unsigned int)(it.charsInVar - it.charIdx), callbackData);
+      it.charIdx = it.charsInVar - 1; // jsvStringIteratorNext will increment
+      jsvStringIteratorNext(&it);
     }
     jsvStringIteratorFree(&it);
   }
@@ -412,12 +412,18 @@ void jsvStringIteratorGetPtrAndNext(JsvStringIterator *it, unsigned char **data,
 
 void jsvStringIteratorGotoEnd(JsvStringIterator *it) {
   assert(it->var);
-  while (jsvGetLastChild(it->var)) {
-    JsVar *next = jsvLock(jsvGetLastChild(it->var));
+  if (jsvGetLastChild(it->var)) {
+    /* Walk the StringExts without locking each one (nothing can be freed or moved
+     * while we do this) and just lock the last one */
+    JsVar *last = it->var;
+    while (jsvGetLastChild(last)) {
+      it->varIndex += it->charsInVar;
+      last = _jsvGetAddressOf(jsvGetLastChild(last));
+      it->charsInVar = jsvGetCharactersInVar(last);
+    }
+    jsvLockAgain(last);
     jsvUnLock(it->var);
-    it->var = next;
-    it->varIndex += it->charsInVar;
-    it->charsInVar = jsvGetCharactersInVar(it->var);
+    it->var = last;
   }
   it->ptr = &it->var->varData.str[0];
   if (it->charsInVar) it->charIdx = it->charsInVar-1;
@@ -487,6 +493,26 @@ void jsvStringIteratorAppend(JsvStringIterator *it, char ch) {
   jsvSetCharactersInVar(it->var, it->charsInVar);
 }
 
+void jsvStringIteratorAppendBuf(JsvStringIterator *it, const char *buf, size_t len) {
+  while (len) {
+    // append one char (which adds a new StringExt if needed)...
+    jsvStringIteratorAppend(it, *(buf++));
+    len--;
+    if (!it->var) return; // out of memory
+    // ... then copy as much as will fit into the rest of this block
+    size_t maxChars = jsvGetMaxCharactersInVar(it->var);
+    if (maxChars <= it->charsInVar) continue; // full (or flat string, where maxChars is wrong)
+    size_t n = maxChars - it->charsInVar;
+    if (n > len) n = len;
+    memcpy(&it->ptr[it->charsInVar], buf, n);
+    buf += n;
+    len -= n;
+    it->charsInVar += n;
+    it->charIdx = it->charsInVar-1;
+    jsvSetCharactersInVar(it->var, it->charsInVar);
+  }
+}
+
 void jsvStringIteratorAppendString(JsvStringIterator *it, JsVar *str, size_t startIdx, int maxLength) {
   JsvStringIterator sit;
   jsvStringIteratorNew(&sit, str, startIdx);
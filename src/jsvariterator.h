@@ -189,6 +189,9 @@ void jsvStringIteratorGotoUTF8(JsvStringIterator *it, JsVar *str, size_t idx);
 /// Append a character TO THE END of a string iterator
 void jsvStringIteratorAppend(JsvStringIterator *it, char ch);
 
+/// Append a buffer of characters TO THE END of a string iterator, filling each block in one go
+void jsvStringIteratorAppendBuf(JsvStringIterator *it, const char *buf, size_t len);
+
 /// Append an entire JsVar string TO THE END of a string iterator
 void jsvStringIteratorAppendString(JsvStringIterator *it, JsVar *str, size_t startIdx, int maxLength);
 
@@ -786,6 +786,241 @@ JsVar *jswrap_arraybufferview_subarray(JsVar *parent, JsVarInt begin, JsVar *end
 }
 
 
+// -----------------------------------------------------------------------------------------------------
+//                                                     Typed kernels for data in one flat block of memory
+// -----------------------------------------------------------------------------------------------------
+
+/// The element type of an ArrayBuffer, ignoring clamping and the plain ArrayBuffer flag
+#define TYPEDARRAY_KERNEL_TYPE(T) ((T)&(ARRAYBUFFERVIEW_MASK_SIZE|ARRAYBUFFERVIEW_SIGNED|ARRAYBUFFERVIEW_FLOAT))
+
+#ifndef SAVE_ON_FLASH
+
+/* Backing data isn't necessarily aligned (JsVars aren't a multiple of 8 bytes on
+ * many builds), so access elements through types the compiler knows may be unaligned */
+typedef uint16_t __attribute__((aligned(1))) typedarray_uint16;
+typedef int16_t __attribute__((aligned(1))) typedarray_int16;
+typedef uint32_t __attribute__((aligned(1))) typedarray_uint32;
+typedef int32_t __attribute__((aligned(1))) typedarray_int32;
+typedef float __attribute__((aligned(1))) typedarray_float32;
+typedef double __attribute__((aligned(1))) typedarray_float64;
+
+#define TYPEDARRAY_LESS_INT(A,B) ((A)<(B))
+// -0 sorts before +0. NaNs have already been moved to the end so are never compared
+#define TYPEDARRAY_LESS_FLOAT(A,B) ((A)<(B) || ((A)==0 && (B)==0 && signbit(A) && !signbit(B)))
+
+/* Introsort: quicksort with a median-of-three pivot, falling back to heapsort
+ * if we recurse too deeply and insertion sort for small partitions. We only
+ * recurse into the smaller partition so stack use is O(log n). */
+#define TYPEDARRAY_SORT(NAME, TYPE, LESS)                                       \
+static void _typedarray_heapsort_##NAME(TYPE *a, size_t n) {                   \
+  size_t start = n/2, end = n;                                                  \
+  while (end > 1) {                                                             \
+    if (start > 0) start--;                                                     \
+    else { end--; TYPE t = a[0]; a[0] = a[end]; a[end] = t; }                   \
+    size_t root = start;                                                        \
+    while (true) {                                                              \
+      size_t child = root*2+1;                                                  \
+      if (child >= end) break;                                                  \
+      if (child+1 < end && LESS(a[child], a[child+1])) child++;                 \
+      if (!LESS(a[root], a[child])) break;                                      \
+      TYPE t = a[root]; a[root] = a[child]; a[child] = t;                       \
+      root = child;                                                             \
+    }                                                                           \
+  }                                                                             \
+}                                                                               \
+static void _typedarray_sort_##NAME(TYPE *a, size_t n, int depth) {            \
+  while (n > 16) {                                                              \
+    if (depth-- <= 0) {                                                         \
+      _typedarray_heapsort_##NAME(a, n);                                        \
+      return;                                                                   \
+    }                                                                           \
+    TYPE t, *lo = a, *mid = a+n/2, *hi = a+n-1;                                 \
+    if (LESS(*mid, *lo)) { t = *mid; *mid = *lo; *lo = t; }                     \
+    if (LESS(*hi, *mid)) {                                                      \
+      t = *hi; *hi = *mid; *mid = t;                                            \
+      if (LESS(*mid, *lo)) { t = *mid; *mid = *lo; *lo = t; }                   \
+    }                                                                           \
+    TYPE pivot = *mid;                                                          \
+    /* a[0] and a[n-1] act as sentinels, so neither scan can run off the end */ \
+    size_t i = 0, j = n-1;                                                      \
+    while (true) {                                                              \
+      do i++; while (LESS(a[i], pivot));                                        \
+      do j--; while (LESS(pivot, a[j]));                                        \
+      if (i >= j) break;                                                        \
+      t = a[i]; a[i] = a[j]; a[j] = t;                                          \
+    }                                                                           \
+    /* a[0..i) <= pivot <= a[i..n) */                                           \
+    if (i < n-i) {                                                              \
+      _typedarray_sort_##NAME(a, i, depth);                                     \
+      a += i; n -= i;                                                           \
+    } else {                                                                    \
+      _typedarray_sort_##NAME(a+i, n-i, depth);                                 \
+      n = i;                                                                    \
+    }                                                                           \
+  }                                                                             \
+  for (size_t i=1;i<n;i++) {                                                    \
+    TYPE v = a[i];                                                              \
+    size_t j = i;                                                               \
+    while (j>0 && LESS(v, a[j-1])) { a[j] = a[j-1]; j--; }                      \
+    a[j] = v;                                                                   \
+  }                                                                             \
+}
+
+TYPEDARRAY_SORT(uint8, uint8_t, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(int8, int8_t, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(uint16, typedarray_uint16, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(int16, typedarray_int16, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(uint32, typedarray_uint32, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(int32, typedarray_int32, TYPEDARRAY_LESS_INT)
+TYPEDARRAY_SORT(float32, typedarray_float32, TYPEDARRAY_LESS_FLOAT)
+TYPEDARRAY_SORT(float64, typedarray_float64, TYPEDARRAY_LESS_FLOAT)
+
+/// Move all NaNs to the end of the array (where JS sorts them) and return the number of other elements
+#define TYPEDARRAY_SKIP_NAN(TYPE, A, N) {                                       \
+  TYPE *a = (TYPE*)(A);                                                         \
+  size_t i = 0;                                                                 \
+  while (i < N) {                                                               \
+    if (isnan(a[i])) { N--; TYPE t = a[i]; a[i] = a[N]; a[N] = t; }             \
+    else i++;                                                                   \
+  }                                                                             \
+}
+
+/// Counting sort for 8 bit types - 'bias' is added to map the values onto 0..255
+static bool _typedarray_countsort8(unsigned char *a, size_t n, unsigned char bias) {
+  uint32_t counts[256];
+  if (sizeof(counts)+256 > jsuGetFreeStack()) return false;
+  memset(counts, 0, sizeof(counts));
+  for (size_t i=0;i<n;i++) counts[(unsigned char)(a[i]+bias)]++;
+  for (unsigned int v=0;v<256;v++) {
+    memset(a, (unsigned char)(v-bias), counts[v]);
+    a += counts[v];
+  }
+  return true;
+}
+
+/// Sort n elements of the given type at 'data' in JS's default numeric order. Returns false if the type isn't handled
+static bool _typedarray_sort(JsVarDataArrayBufferViewType type, char *data, size_t n) {
+  int depth = 0;
+  for (size_t i=n;i>1;i>>=1) depth+=2;
+  switch (TYPEDARRAY_KERNEL_TYPE(type)) {
+    case ARRAYBUFFERVIEW_UINT8:
+      if (n<64 || !_typedarray_countsort8((unsigned char*)data, n, 0))
+        _typedarray_sort_uint8((uint8_t*)data, n, depth);
+      return true;
+    case ARRAYBUFFERVIEW_INT8:
+      if (n<64 || !_typedarray_countsort8((unsigned char*)data, n, 128))
+        _typedarray_sort_int8((int8_t*)data, n, depth);
+      return true;
+    case ARRAYBUFFERVIEW_UINT16: _typedarray_sort_uint16((typedarray_uint16*)data, n, depth); return true;
+    case ARRAYBUFFERVIEW_INT16: _typedarray_sort_int16((typedarray_int16*)data, n, depth); return true;
+    case ARRAYBUFFERVIEW_UINT32: _typedarray_sort_uint32((typedarray_uint32*)data, n, depth); return true;
+    case ARRAYBUFFERVIEW_INT32: _typedarray_sort_int32((typedarray_int32*)data, n, depth); return true;
+    case ARRAYBUFFERVIEW_FLOAT32:
+      TYPEDARRAY_SKIP_NAN(typedarray_float32, data, n);
+      _typedarray_sort_float32((typedarray_float32*)data, n, depth);
+      return true;
+    case ARRAYBUFFERVIEW_FLOAT64:
+      TYPEDARRAY_SKIP_NAN(typedarray_float64, data, n);
+      _typedarray_sort_float64((typedarray_float64*)data, n, depth);
+      return true;
+    default: return false;
+  }
+}
+
+#define TYPEDARRAY_FIND(TYPE, TEST) {                                           \
+  const TYPE *a = (const TYPE*)data;                                            \
+  for (size_t i=start;i<n;i++) if (TEST) return (JsVarInt)i;                    \
+  return -1;                                                                    \
+}
+#define TYPEDARRAY_FIND_INT(TYPE) {                                              \
+  TYPE v = (TYPE)value;                                                         \
+  TYPEDARRAY_FIND(TYPE, a[i]==v);                                               \
+}
+
+/* Search a typed array whose data is in one flat block for the given value (as
+ * with `===`, or SameValueZero if matchNaN). Returns the index, -1 if not
+ * found, or -2 if the data isn't flat and the caller must use an iterator.
+ * Values no element could equal return -1 whether or not the data is flat,
+ * so the iterator only ever has to compare valid values. */
+static JsVarInt _typedarray_find(JsVar *array, JsVar *valueVar, JsVarInt startIdx, bool matchNaN) {
+  JsVarDataArrayBufferViewType type = TYPEDARRAY_KERNEL_TYPE(array->varData.arraybuffer.type);
+  if (!jsvIsInt(valueVar) && !jsvIsFloat(valueVar)) return -1; // elements are only ever numbers
+  JsVarFloat value = jsvGetFloat(valueVar);
+  if (JSV_ARRAYBUFFER_IS_FLOAT(type)) {
+    if (isnan(value) && !matchNaN) return -1;
+  } else {
+    unsigned int bits = 8*(unsigned int)JSV_ARRAYBUFFER_GET_SIZE(type);
+    JsVarFloat min = JSV_ARRAYBUFFER_IS_SIGNED(type) ? -ldexp(1, (int)bits-1) : 0;
+    JsVarFloat max = JSV_ARRAYBUFFER_IS_SIGNED(type) ? ldexp(1, (int)bits-1)-1 : ldexp(1, (int)bits)-1;
+    if (isnan(value) || value<min || value>max || value!=floor(value))
+      return -1; // not an integer that any element could hold
+  }
+  size_t n;
+  char *data = jsvGetArrayBufferDataPointer(array, &n, false);
+  if (!data) return -2;
+  if (startIdx<0) startIdx += (JsVarInt)n;
+  if (startIdx<0) startIdx = 0;
+  size_t start = (size_t)startIdx;
+  if (JSV_ARRAYBUFFER_IS_FLOAT(type)) {
+    if (isnan(value)) {
+      if (type==ARRAYBUFFERVIEW_FLOAT32) TYPEDARRAY_FIND(typedarray_float32, isnan(a[i]))
+      else TYPEDARRAY_FIND(typedarray_float64, isnan(a[i]))
+    }
+    if (type==ARRAYBUFFERVIEW_FLOAT32) TYPEDARRAY_FIND(typedarray_float32, a[i]==value)
+    else TYPEDARRAY_FIND(typedarray_float64, a[i]==value)
+  }
+  switch (type) {
+    case ARRAYBUFFERVIEW_UINT8:
+    case ARRAYBUFFERVIEW_INT8: {
+      if (start>=n) return -1;
+      char *p = memchr(data+start, (unsigned char)(int)value, n-start);
+      return p ? (JsVarInt)(p-data) : -1;
+    }
+    case ARRAYBUFFERVIEW_UINT16: TYPEDARRAY_FIND_INT(typedarray_uint16)
+    case ARRAYBUFFERVIEW_INT16: TYPEDARRAY_FIND_INT(typedarray_int16)
+    case ARRAYBUFFERVIEW_UINT32: TYPEDARRAY_FIND_INT(typedarray_uint32)
+    case ARRAYBUFFERVIEW_INT32: TYPEDARRAY_FIND_INT(typedarray_int32)
+    default: return -2;
+  }
+}
+
+#define TYPEDARRAY_SUM(TYPE, ACC) {                                             \
+  const TYPE *a = (const TYPE*)data;                                            \
+  if (squared) {                                                                \
+    for (size_t i=0;i<n;i++) { JsVarFloat v = (JsVarFloat)a[i]-mean; sum += v*v; } \
+  } else {                                                                      \
+    ACC s = 0;                                                                  \
+    for (size_t i=0;i<n;i++) s += a[i];                                         \
+    sum = (JsVarFloat)s;                                                        \
+  }                                                                             \
+  break;                                                                        \
+}
+
+/* Sum the elements of a typed array (or if 'squared', the squares of their
+ * differences from 'mean') straight from its data. Returns false if the data
+ * isn't in one flat block and the caller must use an iterator. */
+bool jswrap_arraybufferview_sum(JsVar *array, JsVarFloat mean, bool squared, JsVarFloat *result) {
+  size_t n;
+  char *data = jsvGetArrayBufferDataPointer(array, &n, false);
+  if (!data) return false;
+  JsVarFloat sum = 0;
+  switch (TYPEDARRAY_KERNEL_TYPE(array->varData.arraybuffer.type)) {
+    // integer sums are exact, so they can be vectorised
+    case ARRAYBUFFERVIEW_UINT8: TYPEDARRAY_SUM(uint8_t, uint32_t)
+    case ARRAYBUFFERVIEW_INT8: TYPEDARRAY_SUM(int8_t, int32_t)
+    case ARRAYBUFFERVIEW_UINT16: TYPEDARRAY_SUM(typedarray_uint16, uint64_t)
+    case ARRAYBUFFERVIEW_INT16: TYPEDARRAY_SUM(typedarray_int16, int64_t)
+    case ARRAYBUFFERVIEW_UINT32: TYPEDARRAY_SUM(typedarray_uint32, uint64_t)
+    case ARRAYBUFFERVIEW_INT32: TYPEDARRAY_SUM(typedarray_int32, int64_t)
+    case ARRAYBUFFERVIEW_FLOAT32: TYPEDARRAY_SUM(typedarray_float32, JsVarFloat)
+    case ARRAYBUFFERVIEW_FLOAT64: TYPEDARRAY_SUM(typedarray_float64, JsVarFloat)
+    default: return false;
+  }
+  *result = sum;
+  return true;
+}
+#endif
+
 // -----------------------------------------------------------------------------------------------------
 //                                                                      Steal Array's methods for this
 // -----------------------------------------------------------------------------------------------------
@@ -807,6 +1042,10 @@ Return the index of the value in the array, or `-1`
 JsVar *jswrap_arraybufferview_indexOf(JsVar *array, JsVar *valueVar, JsVarInt startIdx) {
 #ifndef SAVE_ON_FLASH
   if (!jsvIsArrayBuffer(array)) return 0;
+  JsVarInt idx = _typedarray_find(array, valueVar, startIdx, false);
+  if (idx!=-2) return jsvNewFromInteger(idx);
+  if (startIdx<0) startIdx += (JsVarInt)jsvGetArrayBufferLength(array);
+  if (startIdx<0) startIdx = 0;
   if (!JSV_ARRAYBUFFER_IS_FLOAT(array->varData.arraybuffer.type)) {
     // fast path for integer-based arraybuffers
     JsVarInt value = jsvGetInteger(valueVar);
@@ -831,7 +1070,7 @@ JsVar *jswrap_arraybufferview_indexOf(JsVar *array, JsVar *valueVar, JsVarInt st
   "class" : "ArrayBufferView",
   "name" : "includes",
   "ifndef" : "SAVE_ON_FLASH",
-  "generate" : "jswrap_array_includes",
+  "generate" : "jswrap_arraybufferview_includes",
   "params" : [
     ["value","JsVar","The value to check for"],
     ["startIndex","int","[optional] the index to search from, or 0 if not specified"]
@@ -841,6 +1080,14 @@ JsVar *jswrap_arraybufferview_indexOf(JsVar *array, JsVar *valueVar, JsVarInt st
 }
 Return `true` if the array includes the value, `false` otherwise
  */
+#ifndef SAVE_ON_FLASH
+bool jswrap_arraybufferview_includes(JsVar *array, JsVar *valueVar, JsVarInt startIdx) {
+  if (!jsvIsArrayBuffer(array)) return false;
+  JsVarInt idx = _typedarray_find(array, valueVar, startIdx, true);
+  if (idx!=-2) return idx>=0;
+  return jswrap_array_includes(array, valueVar, startIdx);
+}
+#endif
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
@@ -868,9 +1115,13 @@ between them. e.g. ```[1,2,3].join(' ')=='1 2 3'```
   "return_object" : "ArrayBufferView",
   "typescript" : "sort(compareFn?: (a: number, b: number) => number): this;"
 }
-Do an in-place quicksort of the array
+Do an in-place sort of the array. With no compare function, elements are
+sorted numerically (with `NaN` last).
  */
 static JsVarFloat _jswrap_arraybufferview_sort_float(JsVarFloat a, JsVarFloat b) {
+  // NaN sorts last, and -0 before +0
+  if (isnan(a) || isnan(b)) return (JsVarFloat)(!!isnan(a) - !!isnan(b));
+  if (a==0 && b==0) return (JsVarFloat)(!!signbit(b) - !!signbit(a));
   return a-b;
 }
 static JsVarInt _jswrap_arraybufferview_sort_int(JsVarInt a, JsVarInt b) {
@@ -882,6 +1133,15 @@ JsVar *jswrap_arraybufferview_sort(JsVar *array, JsVar *compareFn) {
   bool isFloat = JSV_ARRAYBUFFER_IS_FLOAT(array->varData.arraybuffer.type);
   if (compareFn)
     return jswrap_array_sort(array, compareFn);
+#ifndef SAVE_ON_FLASH
+  size_t n;
+  char *data = jsvGetArrayBufferDataPointer(array, &n, true);
+  if (data && _typedarray_sort(array->varData.arraybuffer.type, data, n))
+    return jsvLockAgain(array);
+#endif
+  // Uint32 values don't fit in an int32, so compare them as floats
+  if (TYPEDARRAY_KERNEL_TYPE(array->varData.arraybuffer.type)==ARRAYBUFFERVIEW_UINT32)
+    isFloat = true;
   compareFn = isFloat ?
       jsvNewNativeFunction(
           (void (*)(void))_jswrap_arraybufferview_sort_float,
@@ -992,13 +1252,32 @@ doesn't returns `true` for any element.
   "class" : "ArrayBufferView",
   "name" : "reverse",
   "ifndef" : "SAVE_ON_FLASH",
-  "generate" : "jswrap_array_reverse",
+  "generate" : "jswrap_arraybufferview_reverse",
   "return" : ["JsVar","This array"],
   "return_object" : "ArrayBufferView",
   "typescript" : "reverse(): T"
 }
 Reverse the contents of this `ArrayBufferView` in-place
  */
+#ifndef SAVE_ON_FLASH
+JsVar *jswrap_arraybufferview_reverse(JsVar *array) {
+  if (!jsvIsArrayBuffer(array)) return 0;
+  size_t n;
+  unsigned char *data = (unsigned char*)jsvGetArrayBufferDataPointer(array, &n, true);
+  if (!data) return jswrap_array_reverse(array);
+  if (n<2) return jsvLockAgain(array);
+  size_t size = JSV_ARRAYBUFFER_GET_SIZE(array->varData.arraybuffer.type);
+  unsigned char *a = data, *b = data + (n-1)*size;
+  while (a<b) {
+    for (size_t i=0;i<size;i++) {
+      unsigned char t = a[i]; a[i] = b[i]; b[i] = t;
+    }
+    a += size;
+    b -= size;
+  }
+  return jsvLockAgain(array);
+}
+#endif
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
@@ -24,6 +24,9 @@ void jswrap_arraybufferview_set(JsVar *parent, JsVar *arr, int offset);
 JsVar *jswrap_arraybufferview_map(JsVar *parent, JsVar *funcVar, JsVar *thisVar);
 JsVar *jswrap_arraybufferview_subarray(JsVar *parent, JsVarInt begin, JsVar *endVar);
 JsVar *jswrap_arraybufferview_indexOf(JsVar *array, JsVar *valueVar, JsVarInt startIdx);
+bool jswrap_arraybufferview_includes(JsVar *array, JsVar *valueVar, JsVarInt startIdx);
 JsVar *jswrap_arraybufferview_sort(JsVar *array, JsVar *compareFn);
+JsVar *jswrap_arraybufferview_reverse(JsVar *array);
+bool jswrap_arraybufferview_sum(JsVar *array, JsVarFloat mean, bool squared, JsVarFloat *result);
 
 #endif // JSWRAP_ARRAYBUFFER_H_
@@ -411,6 +411,8 @@ JsVarFloat jswrap_espruino_sum(JsVar *arr) {
     return NAN;
   }
   JsVarFloat sum = 0;
+  if (jsvIsArrayBuffer(arr) && jswrap_arraybufferview_sum(arr, 0, false, &sum))
+    return sum;
 
   JsvIterator itsrc;
   jsvIteratorNew(&itsrc, arr, JSIF_DEFINED_ARRAY_ElEMENTS);
@@ -450,6 +452,8 @@ JsVarFloat jswrap_espruino_variance(JsVar *arr, JsVarFloat mean) {
     return NAN;
   }
   JsVarFloat variance = 0;
+  if (jsvIsArrayBuffer(arr) && jswrap_arraybufferview_sum(arr, mean, true, &variance))
+    return variance;
 
   JsvIterator itsrc;
   jsvIteratorNew(&itsrc, arr, JSIF_EVERY_ARRAY_ELEMENT);
@@ -868,7 +872,8 @@ type ErrorFlag =
 Get and reset the error flags. Returns an array that can contain:
 
 `'FIFO_FULL'`: The receive FIFO filled up and data was lost. This could be state
-transitions for setWatch, or received characters.
+transitions for setWatch, or received characters. `E.getIOStats()` reports
+which devices lost data.
 
 `'BUFFER_FULL'`: A buffer for a stream filled up and characters were lost. This
 can happen to any stream - Serial,HTTP,etc.
@@ -891,6 +896,52 @@ JsVar *jswrap_espruino_getErrorFlags() {
   return jswrap_espruino_getErrorFlagArray(flags);
 }
 
+/*JSON{
+  "type" : "staticmethod",
+  "ifndef" : "SAVE_ON_FLASH",
+  "class" : "E",
+  "name" : "getIOStats",
+  "generate" : "jswrap_espruino_getIOStats",
+  "return" : ["JsVar","An object containing information on the IO event queue"],
+  "typescript" : "getIOStats(): { size: number, used: number, highWater: number, drops: { [device: string]: number } }"
+}
+Get and reset statistics about the queue of received characters and pin events
+(the 'IO event queue'). Returns an object containing:
+
+* `size` - the size of the queue in bytes
+* `used` - how many bytes are in the queue right now
+* `highWater` - the most bytes that have been in the queue at once
+* `drops` - an object containing the number of events that were lost because
+  the queue was full (or characters for Serial devices) for each device, eg.
+  `{ Serial1 : 23, EXTI3 : 1 }`. Devices which didn't lose any events aren't
+  included.
+
+If `drops` isn't empty then `E.getErrorFlags()` will have reported `FIFO_FULL`.
+ */
+JsVar *jswrap_espruino_getIOStats() {
+  JshIOEventStats stats;
+  jshGetIOEventStats(&stats, true);
+  JsVar *obj = jsvNewObject();
+  if (!obj) return 0;
+  jsvObjectSetChildAndUnLock(obj, "size", jsvNewFromInteger(IOBUFFERMASK+1));
+  jsvObjectSetChildAndUnLock(obj, "used", jsvNewFromInteger(jshGetEventsUsed()));
+  jsvObjectSetChildAndUnLock(obj, "highWater", jsvNewFromInteger(stats.highWater));
+  JsVar *drops = jsvNewObject();
+  if (drops) {
+    for (int i=0;i<=EV_TYPE_MASK;i++) {
+      if (!stats.drops[i]) continue;
+      char name[16];
+      const char *deviceName = jshGetDeviceString((IOEventFlags)i);
+      if (DEVICE_IS_EXTI(i)) espruino_snprintf(name, sizeof(name), "EXTI%d", i-EV_EXTI0);
+      else if (*deviceName) espruino_snprintf(name, sizeof(name), "%s", deviceName);
+      else espruino_snprintf(name, sizeof(name), "EV%d", i);
+      jsvObjectSetChildAndUnLock(drops, name, jsvNewFromInteger(stats.drops[i]));
+    }
+    jsvObjectSetChildAndUnLock(obj, "drops", drops);
+  }
+  return obj;
+}
+
 
 /*TYPESCRIPT
 type Flag =
@@ -1742,6 +1793,31 @@ See `E.dumpFragmentation()` to show a map of the arrangement of variables
 within memory.
 */
 
+/*JSON{
+  "type" : "staticmethod",
+  "ifndef" : "SAVE_ON_FLASH",
+  "class" : "E",
+  "name" : "setDefragThreshold",
+  "generate" : "jswrap_espruino_setDefragThreshold",
+  "params" : [
+    ["blocks","int","Compact memory when idle if fewer than this many contiguous blocks are free (0 disables)"]
+  ]
+}
+[2v30+] When Espruino is idle, if the largest area of contiguous free memory
+(`process.memory().largestFree`) is smaller than `blocks` (256 by default),
+Espruino moves a few variables at a time down to the start of memory so that
+large flat strings (for `Graphics.createArrayBuffer`, large `Uint8Array`s, etc)
+can be allocated. This only happens if there is at least 50% more free memory
+in total, and unlike `E.defrag()` it doesn't stop Espruino for long.
+*/
+void jswrap_espruino_setDefragThreshold(int blocks) {
+#ifndef ESPR_NO_AUTO_DEFRAG
+  jsvDefragmentSetThreshold(blocks>0 ? (unsigned int)blocks : 0);
+#else
+  NOT_USED(blocks);
+#endif
+}
+
 /*TYPESCRIPT
 type VariableSizeInformation = {
   name: string;
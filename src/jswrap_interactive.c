@@ -348,7 +348,7 @@ To set the timezone for all new Dates, use `E.setTimeZone(hours)`.
 void jswrap_interactive_setTime(JsVarFloat time) {
   jshInterruptOff();
   JsSysTime stime = jshGetTimeFromMilliseconds(time*1000);
-  jsiLastIdleTime = stime;
+  jsiSetLastIdleTime(stime);
   JsSysTime oldtime = jshGetSystemTime();
   // set system time
   jshSetSystemTime(stime);
@@ -491,7 +491,7 @@ JsVar *_jswrap_interface_setTimeoutOrInterval(JsVar *func, JsVarFloat interval,
   JsVar *timerPtr = jsvNewObject();
   if (!timerPtr) return 0;
   JsSysTime intervalInt = jshGetTimeFromMilliseconds(interval);
-  jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger((jshGetSystemTime() - jsiLastIdleTime) + intervalInt));
+  jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger((jshGetSystemTime() - jsiTimerBaseTime) + intervalInt));
   if (!isTimeout) {
     jsvObjectSetChildAndUnLock(timerPtr, "intr", jsvNewFromLongInteger(intervalInt));
   }
@@ -502,7 +502,6 @@ JsVar *_jswrap_interface_setTimeoutOrInterval(JsVar *func, JsVarFloat interval,
   // Add to array
   JsVar *itemIndex = jsvNewFromInteger(jsiTimerAdd(timerPtr));
   jsvUnLock(timerPtr);
-  jsiTimersChanged(); // mark timers as changed
   return itemIndex;
 }
 JsVar *jswrap_interface_setInterval(JsVar *func, JsVarFloat timeout, JsVar *args) {
@@ -578,7 +577,6 @@ void _jswrap_interface_clearTimeoutOrInterval(JsVar *idVarArr, bool isTimeout) {
       jsvUnLock(idVar);
     }
   }
-  jsiTimersChanged(); // mark timers as changed
 }
 void jswrap_interface_clearInterval(JsVar *idVarArr) {
   _jswrap_interface_clearTimeoutOrInterval(idVarArr, false);
@@ -611,13 +609,11 @@ void jswrap_interface_changeInterval(JsVar *idVar, JsVarFloat interval) {
   if (interval<TIMER_MIN_INTERVAL) interval=TIMER_MIN_INTERVAL;
   JsVar *timerName = jsvIsBasic(idVar) ? jsvFindChildFromVar(timerArray, idVar, false) : 0;
   if (timerName) {
-    JsVar *timer = jsvSkipNameAndUnLock(timerName);
+    JsVar *timer = jsvSkipName(timerName);
     JsSysTime intervalInt = jshGetTimeFromMilliseconds(interval);
     jsvObjectSetChildAndUnLock(timer, "intr", jsvNewFromLongInteger(intervalInt));
-    jsvObjectSetChildAndUnLock(timer, "time", jsvNewFromLongInteger((jshGetSystemTime()-jsiLastIdleTime) + intervalInt));
-    jsvUnLock(timer);
-    // timerName already unlocked
-    jsiTimersChanged(); // mark timers as changed
+    jsiTimerSetTime(timer, jsvGetInteger(timerName), (jshGetSystemTime()-jsiTimerBaseTime) + intervalInt);
+    jsvUnLock2(timer, timerName);
   } else {
     jsExceptionHere(JSET_ERROR, "Unknown Interval");
   }
@@ -859,6 +859,7 @@ JsVar *jswrap_interface_setWatch(
 
     itemIndex = jsvArrayAddToEnd(watchArray, watchPtr, 1) - 1;
     jsvUnLock(watchPtr);
+    jsiWatchesChanged();
 
 
   }
@@ -897,6 +898,7 @@ void jswrap_interface_clearWatch(JsVar *idVarArr) {
     jsvObjectIteratorFree(&it);
     // remove all items
     jsvRemoveAllChildren(watchArray);
+    jsiWatchesChanged();
   } else {
     JsVar *idVar = jsvGetArrayItem(idVarArr, 0);
     if (jsvIsUndefined(idVar)) {
@@ -910,6 +912,7 @@ void jswrap_interface_clearWatch(JsVar *idVarArr) {
       jsvUnLock(watchPtr);
 
       jsvRemoveChildAndUnLock(watchArray, watchNamePtr);
+      jsiWatchesChanged();
 
       // Now check if this pin is still being watched
       if (!jsiIsWatchingPin(pin))
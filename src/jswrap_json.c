@@ -90,9 +90,10 @@ JsVar *jswrap_json_parse_internal(JSONFlags flags) {
     jslGetNextToken();
     if (lex->tk!=LEX_INT && lex->tk!=LEX_FLOAT) return 0;
     JsVar *v = jswrap_json_parse_internal(flags);
-    JsVar *zero = jsvNewFromInteger(0);
-    JsVar *r = jsvMathsOp(zero, v, '-');
-    jsvUnLock2(v, zero);
+    JsVar *r;
+    if (jsvIsInt(v)) r = jsvNewFromLongInteger(-(long long)jsvGetInteger(v));
+    else r = jsvNewFromFloat(-jsvGetFloat(v));
+    jsvUnLock(v);
     return r;
   }
   case LEX_INT: {
@@ -204,6 +205,582 @@ JsVar *jswrap_json_parse_liberal(JsVar *v, bool noExceptions) {
   return res;
 }
 
+#ifndef SAVE_ON_FLASH
+#define JSON_PARSER_STATE_NAME JS_HIDDEN_CHAR_STR"jps" ///< JSONParser: JsonParserState, stored as a String
+#define JSON_PARSER_STACK_NAME JS_HIDDEN_CHAR_STR"stk" ///< JSONParser: for each depth, the array/object being built or the current key/index
+#define JSON_PARSER_PATH_NAME  JS_HIDDEN_CHAR_STR"pth" ///< JSONParser: array of keys to filter values on
+#define JSON_PARSER_TOKEN_NAME JS_HIDDEN_CHAR_STR"tok" ///< JSONParser: String we're part way through reading
+#define JSON_PARSER_MAX_DEPTH 32
+#define JSON_PARSER_NOT_BUILDING 0xFF
+
+typedef enum {
+  JP_VALUE,        ///< expecting a value
+  JP_VALUE_OR_END, ///< after '[' - expecting a value or ']'
+  JP_KEY,          ///< after ',' in an object - expecting a key
+  JP_KEY_OR_END,   ///< after '{' - expecting a key or '}'
+  JP_COLON,        ///< after a key - expecting ':'
+  JP_AFTER_VALUE,  ///< expecting ',' or the end of the array/object
+  JP_STRING,       ///< in a String value
+  JP_STRING_KEY,   ///< in a String that's an object's key
+  JP_NUMBER,       ///< in a number
+  JP_LITERAL,      ///< in true/false/null
+} JsonParserStateType;
+
+typedef enum {
+  JPF_KEEP = 1,    ///< we're keeping the value we're reading (otherwise we're just skipping over it)
+  JPF_ESCAPE = 2,  ///< the last character in the String was '\'
+  JPF_UTF8 = 4,    ///< the String we're reading should be UTF8
+} JsonParserFlags;
+
+/// State of a JSON parser between calls to write
+typedef struct {
+  uint8_t state;          ///< JsonParserStateType
+  uint8_t flags;          ///< JsonParserFlags
+  uint8_t depth;          ///< number of arrays/objects we're inside
+  uint8_t buildDepth;     ///< depth of the array/object we're building, or JSON_PARSER_NOT_BUILDING
+  uint8_t pathLen;        ///< number of keys in the path we're filtering on
+  uint8_t tokenLen;       ///< characters in token, or hex digits left in a \u escape
+  uint16_t codepoint;     ///< \u escape we're reading
+  uint16_t highSurrogate; ///< the first half of a \u surrogate pair
+  uint32_t isObject;      ///< bit set for each depth that's an object (not an array)
+  uint32_t matched;       ///< bit set for each depth where the current key matches the path
+  char token[32];         ///< number or true/false/null we're reading
+} JsonParserState;
+
+typedef struct {
+  JsVar *parser;
+  JsonParserState s;
+  JsVar *stack;           ///< JSON_PARSER_STACK_NAME
+  JsVar *path;            ///< JSON_PARSER_PATH_NAME
+  JsVar *token;           ///< String we're reading (if JPF_KEEP)
+  JsvStringIterator tokenIt;
+  bool error;
+} JsonParser;
+
+static void jsonParserError(JsonParser *p, const char *msg, char ch) {
+  if (ch) jsExceptionHere(JSET_SYNTAXERROR, "%s '%c' in JSON", msg, ch);
+  else jsExceptionHere(JSET_SYNTAXERROR, "%s in JSON", msg);
+  p->error = true;
+}
+
+static bool jsonParserIsBuilding(JsonParser *p) {
+  return p->s.buildDepth != JSON_PARSER_NOT_BUILDING;
+}
+
+/// Should we keep a value that starts here? (are we building an array/object, or does the path match?)
+static bool jsonParserIsSelected(JsonParser *p) {
+  if (jsonParserIsBuilding(p)) return true;
+  if (p->s.depth!=p->s.pathLen) return false;
+  uint32_t mask = (1U<<p->s.depth)-1;
+  return (p->s.matched&mask)==mask;
+}
+
+/// Set the key (or array index) for the current depth, and see whether it matches the path
+static void jsonParserSetKey(JsonParser *p, JsVar *key) {
+  int level = p->s.depth-1;
+  jsvSetArrayItem(p->stack, level, key);
+  JsVar *pathKey = jsvGetArrayItem(p->path, level);
+  bool match = jsvIsStringEqual(pathKey, "*");
+  if (!match) {
+    JsVar *a = jsvAsString(pathKey), *b = jsvAsString(key);
+    match = jsvCompareString(a, b, 0, 0, true)==0;
+    jsvUnLock2(a, b);
+  }
+  jsvUnLock(pathKey);
+  if (match) p->s.matched |= 1U<<level;
+  else p->s.matched &= ~(1U<<level);
+}
+
+/// Call the 'value' event with a value that matched
+static void jsonParserEmit(JsonParser *p, JsVar *value) {
+  JsVar *args[2];
+  unsigned int argCount = 0;
+  args[argCount++] = value;
+  if (p->s.pathLen) { // also pass the keys we used to get here
+    JsVar *keys = jsvNewEmptyArray();
+    int i;
+    for (i=0;i<p->s.pathLen;i++)
+      jsvArrayPushAndUnLock(keys, jsvGetArrayItem(p->stack, i));
+    args[argCount++] = keys;
+  }
+  jsiExecuteEventCallbackName(p->parser, JS_EVENT_PREFIX"value", argCount, args);
+  if (argCount>1) jsvUnLock(args[1]);
+  if (jspHasError()) p->error = true;
+}
+
+/// Add a value to the array/object we're building
+static void jsonParserAddToParent(JsonParser *p, JsVar *value) {
+  JsVar *parent = jsvGetLastArrayItem(p->stack);
+  if (p->s.isObject & (1U<<(p->s.depth-1))) {
+    // the key was added when we read it, so set its value
+    JsVar *name = jsvLock(jsvGetLastChild(parent));
+    jsvSetValueOfName(name, value);
+    jsvUnLock(name);
+  } else
+    jsvArrayPush(parent, value);
+  jsvUnLock(parent);
+}
+
+/// We've read a whole value (which is 0 if we weren't keeping it)
+static void jsonParserValue(JsonParser *p, JsVar *value) {
+  if (value) {
+    if (jsonParserIsBuilding(p)) jsonParserAddToParent(p, value);
+    else jsonParserEmit(p, value);
+  }
+  p->s.state = p->s.depth ? JP_AFTER_VALUE : JP_VALUE;
+}
+
+static void jsonParserStartContainer(JsonParser *p, bool isObject) {
+  if (p->s.depth >= JSON_PARSER_MAX_DEPTH) {
+    jsonParserError(p, "Too much nesting", 0);
+    return;
+  }
+  if (jsonParserIsSelected(p)) {
+    JsVar *container = isObject ? jsvNewObject() : jsvNewEmptyArray();
+    if (!container) { p->error = true; return; }
+    if (jsonParserIsBuilding(p)) jsonParserAddToParent(p, container);
+    else p->s.buildDepth = p->s.depth;
+    jsvArrayPushAndUnLock(p->stack, container);
+    p->s.depth++;
+  } else if (p->s.depth < p->s.pathLen) { // somewhere on the path - keep track of our key
+    jsvArrayPushAndUnLock(p->stack, jsvNewFromInteger(0));
+    p->s.depth++;
+    if (isObject) p->s.matched &= ~(1U<<(p->s.depth-1));
+    else {
+      JsVar *idx = jsvNewFromInteger(0);
+      jsonParserSetKey(p, idx);
+      jsvUnLock(idx);
+    }
+  } else // skipping over this
+    p->s.depth++;
+  if (isObject) p->s.isObject |= 1U<<(p->s.depth-1);
+  else p->s.isObject &= ~(1U<<(p->s.depth-1));
+  p->s.state = isObject ? JP_KEY_OR_END : JP_VALUE_OR_END;
+}
+
+static void jsonParserEndContainer(JsonParser *p, char ch) {
+  int level = p->s.depth-1;
+  if (!p->s.depth || (ch=='}') != ((p->s.isObject>>level)&1)) {
+    jsonParserError(p, "Unexpected", ch);
+    return;
+  }
+  JsVar *container = 0;
+  if (jsonParserIsBuilding(p) || level < p->s.pathLen)
+    container = jsvSkipNameAndUnLock(jsvArrayPop(p->stack));
+  p->s.depth--;
+  if (p->s.buildDepth == p->s.depth) { // we've finished the value we were building
+    p->s.buildDepth = JSON_PARSER_NOT_BUILDING;
+    jsonParserEmit(p, container);
+  }
+  jsvUnLock(container);
+  p->s.state = p->s.depth ? JP_AFTER_VALUE : JP_VALUE;
+}
+
+static void jsonParserStartString(JsonParser *p, bool keep, JsonParserStateType state) {
+  p->s.state = state;
+  p->s.flags = keep ? JPF_KEEP : 0;
+  p->s.tokenLen = 0;
+  p->s.highSurrogate = 0;
+  if (keep) {
+    p->token = jsvNewFromEmptyString();
+    if (!p->token) { p->error = true; return; }
+    jsvStringIteratorNew(&p->tokenIt, p->token, 0);
+  }
+}
+
+static void jsonParserEndString(JsonParser *p) {
+  JsVar *str = 0;
+  if (p->token) {
+    jsvStringIteratorFree(&p->tokenIt);
+    str = p->token;
+    p->token = 0;
+  }
+  if (p->s.state==JP_STRING_KEY) {
+    p->s.state = JP_COLON;
+    if (!str) return;
+    if (jsonParserIsBuilding(p)) {
+      JsVar *parent = jsvGetLastArrayItem(p->stack);
+      JsVar *key = jsvAsArrayIndexAndUnLock(str);
+      jsvAddName(parent, jsvMakeIntoVariableName(key, 0));
+      jsvUnLock2(key, parent);
+    } else {
+      jsonParserSetKey(p, str);
+      jsvUnLock(str);
+    }
+    return;
+  }
+#ifdef ESPR_UNICODE_SUPPORT
+  if (str && (p->s.flags & JPF_UTF8))
+    str = jsvNewUTF8StringAndUnLock(str);
+#endif
+  jsonParserValue(p, str);
+  jsvUnLock(str);
+}
+
+/// Add a character to the String we're reading
+static void jsonParserStringChar(JsonParser *p, char ch) {
+  if (!p->token) return;
+#ifdef ESPR_UNICODE_SUPPORT
+  if (jsUTF8IsStartChar(ch)) p->s.flags |= JPF_UTF8;
+#endif
+  jsvStringIteratorAppend(&p->tokenIt, ch);
+}
+
+/// Add a character from a \u escape to the String
+static void jsonParserStringCodepoint(JsonParser *p, int codepoint) {
+  if (jsUnicodeIsHighSurrogate(codepoint)) {
+    p->s.highSurrogate = (uint16_t)codepoint;
+    return;
+  }
+  if (p->s.highSurrogate && jsUnicodeIsLowSurrogate(codepoint))
+    codepoint = 0x10000 + ((codepoint & 0x03FF) | ((p->s.highSurrogate & 0x03FF) << 10));
+  p->s.highSurrogate = 0;
+#ifdef ESPR_UNICODE_SUPPORT
+  if (codepoint >= 0x80) {
+    char buf[4];
+    unsigned int i, len = jsUTF8Encode(codepoint, buf);
+    for (i=0;i<len;i++) jsonParserStringChar(p, buf[i]);
+    return;
+  }
+#endif
+  jsonParserStringChar(p, (char)codepoint);
+}
+
+/// We've got to the end of a number, or true/false/null
+static void jsonParserEndToken(JsonParser *p) {
+  JsVar *v = 0;
+  p->s.token[p->s.tokenLen] = 0;
+  const char *tok = p->s.token;
+  if (p->s.state==JP_LITERAL) {
+    if (!strcmp(tok, "true") || !strcmp(tok, "false")) v = jsvNewFromBool(tok[0]=='t');
+    else if (!strcmp(tok, "null")) v = jsvNewWithFlags(JSV_NULL);
+    else {
+      jsonParserError(p, "Unexpected literal", 0);
+      return;
+    }
+  } else {
+    if (!strpbrk(tok, "0123456789") || isnan(stringToFloat(tok))) {
+      jsonParserError(p, "Invalid number", 0);
+      return;
+    }
+    if (!(p->s.flags & JPF_KEEP)) {
+      // not keeping it - don't allocate a var
+    } else if (strpbrk(tok, ".eE")) v = jsvNewFromFloat(stringToFloat(tok));
+    else v = jsvNewFromLongInteger(stringToInt(tok));
+  }
+  if (!(p->s.flags & JPF_KEEP)) {
+    jsvUnLock(v);
+    v = 0;
+  }
+  jsonParserValue(p, v);
+  jsvUnLock(v);
+}
+
+/// Handle one character of JSON
+static void jsonParserChar(JsonParser *p, char ch) {
+  switch (p->s.state) {
+    case JP_STRING:
+    case JP_STRING_KEY:
+      if (p->s.tokenLen) { // \u escape
+        if (!isHexadecimal(ch)) {
+          jsonParserError(p, "Invalid escape", 0);
+          return;
+        }
+        p->s.codepoint = (uint16_t)((p->s.codepoint<<4) | (unsigned)chtod(ch));
+        if (!--p->s.tokenLen) jsonParserStringCodepoint(p, p->s.codepoint);
+      } else if (p->s.flags & JPF_ESCAPE) {
+        p->s.flags &= (uint8_t)~JPF_ESCAPE;
+        switch (ch) {
+          case 'n': ch = 0x0A; break;
+          case 'b': ch = 0x08; break;
+          case 'f': ch = 0x0C; break;
+          case 'r': ch = 0x0D; break;
+          case 't': ch = 0x09; break;
+          case 'v': ch = 0x0B; break;
+          case 'u': p->s.tokenLen = 4; p->s.codepoint = 0; return;
+        }
+        jsonParserStringChar(p, ch);
+      } else if (ch=='\\') {
+        p->s.flags |= JPF_ESCAPE;
+      } else if (ch=='"') {
+        jsonParserEndString(p);
+      } else
+        jsonParserStringChar(p, ch);
+      return;
+    case JP_NUMBER:
+    case JP_LITERAL:
+      if (p->s.state==JP_NUMBER ? (isNumeric(ch) || ch=='.' || ch=='e' || ch=='E' || ch=='-' || ch=='+') : isAlpha(ch)) {
+        if (p->s.tokenLen >= sizeof(p->s.token)-1) {
+          jsonParserError(p, "Token too long", 0);
+          return;
+        }
+        p->s.token[p->s.tokenLen++] = ch;
+        return;
+      }
+      jsonParserEndToken(p);
+      if (p->error) return;
+      break; // now handle ch
+    default: break;
+  }
+  if (isWhitespace(ch)) return;
+  switch (p->s.state) {
+    case JP_VALUE_OR_END:
+      if (ch==']') {
+        jsonParserEndContainer(p, ch);
+        return;
+      } // else fall through
+    case JP_VALUE:
+      if (ch=='{' || ch=='[') {
+        jsonParserStartContainer(p, ch=='{');
+      } else if (ch=='"') {
+        jsonParserStartString(p, jsonParserIsSelected(p), JP_STRING);
+      } else if (ch=='-' || isNumeric(ch) || ch=='t' || ch=='f' || ch=='n') {
+        p->s.state = (ch=='-' || isNumeric(ch)) ? JP_NUMBER : JP_LITERAL;
+        p->s.flags = jsonParserIsSelected(p) ? JPF_KEEP : 0;
+        p->s.token[0] = ch;
+        p->s.tokenLen = 1;
+      } else
+        jsonParserError(p, "Unexpected", ch);
+      return;
+    case JP_KEY_OR_END:
+      if (ch=='}') {
+        jsonParserEndContainer(p, ch);
+        return;
+      } // else fall through
+    case JP_KEY:
+      if (ch=='"') {
+        // keep the key if we're building an object, or need it to check the path
+        bool keep = jsonParserIsBuilding(p) || (p->s.depth <= p->s.pathLen);
+        jsonParserStartString(p, keep, JP_STRING_KEY);
+      } else
+        jsonParserError(p, "Expecting a key, got", ch);
+      return;
+    case JP_COLON:
+      if (ch==':') p->s.state = JP_VALUE;
+      else jsonParserError(p, "Expecting ':', got", ch);
+      return;
+    case JP_AFTER_VALUE:
+      if (ch==',') {
+        int level = p->s.depth-1;
+        if ((p->s.isObject>>level)&1) {
+          p->s.state = JP_KEY;
+        } else {
+          p->s.state = JP_VALUE;
+          if (!jsonParserIsBuilding(p) && level < p->s.pathLen) { // next array index
+            JsVar *idx = jsvNewFromInteger(jsvGetIntegerAndUnLock(jsvGetArrayItem(p->stack, level))+1);
+            jsonParserSetKey(p, idx);
+            jsvUnLock(idx);
+          }
+        }
+      } else if (ch==']' || ch=='}') {
+        jsonParserEndContainer(p, ch);
+      } else
+        jsonParserError(p, "Expecting ',', got", ch);
+      return;
+    default:
+      return;
+  }
+}
+
+/// Handle a block of JSON (called from jsvIterateBufferCallback)
+static void jsonParserBuffer(unsigned char *data, unsigned int len, void *userData) {
+  JsonParser *p = (JsonParser*)userData;
+  unsigned int i = 0;
+  while (i<len && !p->error) {
+    if ((p->s.state==JP_STRING || p->s.state==JP_STRING_KEY) &&
+        !p->s.tokenLen && !(p->s.flags & JPF_ESCAPE)) {
+      // Quickly copy (or skip) normal characters in a String
+      while (i<len && data[i]!='"' && data[i]!='\\') {
+        if (p->token) jsonParserStringChar(p, (char)data[i]);
+        i++;
+      }
+      if (i>=len) break;
+    }
+    jsonParserChar(p, (char)data[i++]);
+  }
+}
+
+/// Start again from the beginning (eg. after an error)
+static void jsonParserReset(JsonParser *p) {
+  uint8_t pathLen = p->s.pathLen;
+  memset(&p->s, 0, sizeof(p->s));
+  p->s.pathLen = pathLen;
+  p->s.buildDepth = JSON_PARSER_NOT_BUILDING;
+  p->s.state = JP_VALUE;
+  if (p->token) {
+    jsvStringIteratorFree(&p->tokenIt);
+    jsvUnLock(p->token);
+    p->token = 0;
+  }
+  jsvUnLock(p->stack);
+  p->stack = jsvNewEmptyArray();
+  jsvObjectSetChild(p->parser, JSON_PARSER_STACK_NAME, p->stack);
+}
+
+static bool jsonParserLoad(JsonParser *p, JsVar *parser) {
+  JsVar *state = jsvObjectGetChildIfExists(parser, JSON_PARSER_STATE_NAME);
+  if (!jsvIsString(state) || jsvGetStringLength(state)!=sizeof(JsonParserState)) {
+    jsvUnLock(state);
+    jsExceptionHere(JSET_ERROR, "Not a JSON parser");
+    return false;
+  }
+  jsvGetStringChars(state, 0, (char*)&p->s, sizeof(JsonParserState));
+  jsvUnLock(state);
+  p->parser = parser;
+  p->stack = jsvObjectGetChildIfExists(parser, JSON_PARSER_STACK_NAME);
+  p->path = jsvObjectGetChildIfExists(parser, JSON_PARSER_PATH_NAME);
+  p->token = 0;
+  p->error = false;
+  if ((p->s.state==JP_STRING || p->s.state==JP_STRING_KEY) && (p->s.flags & JPF_KEEP)) {
+    p->token = jsvObjectGetChildIfExists(parser, JSON_PARSER_TOKEN_NAME);
+    jsvObjectRemoveChild(parser, JSON_PARSER_TOKEN_NAME); // so the String can become a key (see jsonParserSave)
+    if (p->token) {
+      jsvStringIteratorNew(&p->tokenIt, p->token, 0);
+      jsvStringIteratorGotoEnd(&p->tokenIt);
+    }
+  }
+  return true;
+}
+
+static void jsonParserSave(JsonParser *p) {
+  if (p->error) jsonParserReset(p);
+  if (p->token) jsvStringIteratorFree(&p->tokenIt);
+  jsvObjectSetOrRemoveChild(p->parser, JSON_PARSER_TOKEN_NAME, p->token);
+  jsvObjectSetChildAndUnLock(p->parser, JSON_PARSER_STATE_NAME, jsvNewStringOfLength(sizeof(JsonParserState), (char*)&p->s));
+  jsvUnLock3(p->token, p->stack, p->path);
+}
+
+/*JSON{
+  "type" : "staticmethod",
+  "class" : "JSON",
+  "name" : "parser",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_json_parser",
+  "params" : [
+    ["options","JsVar","[optional] An object containing `{path : [\"key\", ...]}`"]
+  ],
+  "return" : ["JsVar","A JSONParser"],
+  "return_object" : "JSONParser",
+  "typescript" : "parser(options?: { path?: (string | number)[] }): JSONParser;"
+}
+Create a parser that JSON can be written to a bit at a time (with `.write`), which
+calls its `value` event whenever it has parsed a complete value. This means JSON
+can be parsed straight from Storage or a network connection without first
+having to load it all into memory.
+
+If `options.path` is supplied, only values at that path are built and passed to
+the `value` event (along with an array of the keys that were matched) - everything
+else is skipped over without using any memory. `"*"` matches any key or array index.
+
+```
+var p = JSON.parser({path:["apps","*"]});
+p.on('value', (app, keys) => print(keys[1], app.name));
+p.write('{"apps":[{"name":"Clock"},');
+p.write('{"name":"Alarm"}],"version":3}');
+p.end();
+// prints 0 Clock, then 1 Alarm
+// To parse a file straight from flash:
+p.write(require("Storage").read("apps.json"));
+p.end();
+```
+
+Without a path, `value` is called for each value at the top level (so a stream of
+JSON values, one per line, can also be parsed).
+*/
+JsVar *jswrap_json_parser(JsVar *options) {
+  JsVar *path = 0;
+  if (jsvIsObject(options)) {
+    path = jsvObjectGetChildIfExists(options, "path");
+    if (path && (!jsvIsArray(path) || jsvGetArrayLength(path)>=JSON_PARSER_MAX_DEPTH)) {
+      jsExceptionHere(JSET_TYPEERROR, "Expecting options.path to be an array, got %t", path);
+      jsvUnLock(path);
+      return 0;
+    }
+  }
+  JsVar *parser = jspNewObject(0, "JSONParser");
+  if (!parser) {
+    jsvUnLock(path);
+    return 0;
+  }
+  JsonParser p;
+  memset(&p, 0, sizeof(p));
+  p.parser = parser;
+  p.s.pathLen = (uint8_t)(path ? jsvGetArrayLength(path) : 0);
+  if (path) jsvObjectSetChild(parser, JSON_PARSER_PATH_NAME, path);
+  p.path = path;
+  jsonParserReset(&p);
+  jsonParserSave(&p);
+  return parser;
+}
+
+/*JSON{
+  "type" : "class",
+  "class" : "JSONParser",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+A JSON parser that JSON can be written to a bit at a time, created with `JSON.parser()`
+*/
+/*JSON{
+  "type" : "event",
+  "class" : "JSONParser",
+  "name" : "value",
+  "params" : [
+    ["value","JsVar","The value that was parsed"],
+    ["keys","JsVar","If a path was supplied to `JSON.parser`, an array of the keys (or array indices) that matched it"]
+  ],
+  "ifndef" : "SAVE_ON_FLASH"
+}
+Called when a complete value has been parsed
+*/
+/*JSON{
+  "type" : "method",
+  "class" : "JSONParser",
+  "name" : "write",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_jsonparser_write",
+  "params" : [
+    ["data","JsVar","A String (or Uint8Array) containing some JSON"]
+  ]
+}
+Parse some more JSON. The `value` event is called for each value that is
+completed.
+
+If there's an error in the JSON an exception is thrown and the parser starts
+again from scratch.
+*/
+void jswrap_jsonparser_write(JsVar *parser, JsVar *data) {
+  JsonParser p;
+  if (!jsonParserLoad(&p, parser)) return;
+  jsvIterateBufferCallback(data, jsonParserBuffer, &p);
+  jsonParserSave(&p);
+}
+
+/*JSON{
+  "type" : "method",
+  "class" : "JSONParser",
+  "name" : "end",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_jsonparser_end",
+  "params" : [
+    ["data","JsVar","[optional] A String (or Uint8Array) containing the last of the JSON"]
+  ]
+}
+Finish parsing - this throws an exception if the JSON isn't complete, and
+resets the parser so it can be used again.
+*/
+void jswrap_jsonparser_end(JsVar *parser, JsVar *data) {
+  if (!jsvIsUndefined(data)) jswrap_jsonparser_write(parser, data);
+  JsonParser p;
+  if (jspHasError() || !jsonParserLoad(&p, parser)) return;
+  if (p.s.state==JP_NUMBER || p.s.state==JP_LITERAL)
+    jsonParserEndToken(&p);
+  if (!p.error && (p.s.depth || p.s.state!=JP_VALUE))
+    jsonParserError(&p, "Unexpected end", 0);
+  jsonParserReset(&p);
+  jsonParserSave(&p);
+}
+#endif
+
 /* This is like jsfGetJSONWithCallback, but handles ONLY functions (and does not print the initial 'function' text) */
 void jsfGetJSONForFunctionWithCallback(JsVar *var, JSONFlags flags, vcbprintf_callback user_callback, void *user_data) {
   assert(jsvIsFunction(var));
@@ -273,6 +850,40 @@ void jsonNewLine(JSONFlags flags, const char *whitespace, vcbprintf_callback use
     user_callback(whitespace, user_data);
 }
 
+/// Write a quoted String, passing runs of characters that don't need escaping on in blocks rather than one at a time
+static void jsonWriteString(JsVar *var, bool jsonStyle, vcbprintf_callback user_callback, void *user_data) {
+  if (!jsvHasCharacterData(var) || jsvIsUTF8String(var)) {
+    // eg. an integer key, or UTF8 that needs decoding - use the (slower) general case
+    cbprintf(user_callback, user_data, jsonStyle?"%Q":"%q", var);
+    return;
+  }
+  char buf[48];
+  size_t len = 0;
+  buf[len++] = '"';
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, var, 0);
+  while (jsvStringIteratorHasChar(&it)) {
+    unsigned char ch = (unsigned char)jsvStringIteratorGetChar(&it);
+    jsvStringIteratorNextInline(&it);
+    if (ch>=' ' && ch<127 && ch!='"' && ch!='\\') {
+      buf[len++] = (char)ch;
+    } else {
+      int nextCh = jsvStringIteratorHasChar(&it) ? (unsigned char)jsvStringIteratorGetChar(&it) : -1;
+      const char *e = escapeCharacter(ch, nextCh, jsonStyle);
+      while (*e) buf[len++] = *(e++);
+    }
+    if (len > sizeof(buf)-8) { // leave room for the longest escape (\u00XX) and the terminator
+      buf[len] = 0;
+      user_callback(buf, user_data);
+      len = 0;
+    }
+  }
+  jsvStringIteratorFree(&it);
+  buf[len++] = '"';
+  buf[len] = 0;
+  user_callback(buf, user_data);
+}
+
 static bool jsfGetJSONForObjectItWithCallback(JsvObjectIterator *it, JSONFlags flags, const char *whitespace, JSONFlags nflags, vcbprintf_callback user_callback, void *user_data, bool first) {
   bool needNewLine = false;
   size_t sinceNewLine = 0;
@@ -285,7 +896,7 @@ static bool jsfGetJSONForObjectItWithCallback(JsvObjectIterator *it, JSONFlags f
         jsvIsGetterOrSetter(item);
     if (!hidden) {
       sinceNewLine++;
-      if (!first) cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?", ":",");
+      if (!first) user_callback((flags&JSON_PRETTY)?", ":",", user_data);
       bool newNeedsNewLine = (flags&JSON_SOME_NEWLINES) && jsonNeedsNewLine(item);
       if ((flags&JSON_SOME_NEWLINES) && sinceNewLine>JSON_ITEMS_ON_LINE_OBJECT)
         needNewLine = true;
@@ -300,14 +911,21 @@ static bool jsfGetJSONForObjectItWithCallback(JsvObjectIterator *it, JSONFlags f
       }
       bool addQuotes = true;
       if (flags&JSON_DROP_QUOTES) {
-        if (jsvIsIntegerish(index)) addQuotes = false;
-        else if (jsvIsString(index) && jsvGetStringLength(index)<63) {
+        if (jsvIsIntegerish(index)) {
+          addQuotes = false;
+          cbprintf(user_callback, user_data, "%v", index);
+        } else if (jsvIsString(index) && jsvGetStringLength(index)<63) {
           char buf[64];
           jsvGetString(index,buf,sizeof(buf));
-          if (isIDString(buf)) addQuotes=false;
+          if (isIDString(buf)) {
+            addQuotes = false;
+            user_callback(buf, user_data);
+          }
         }
       }
-      cbprintf(user_callback, user_data, addQuotes?((flags&JSON_ALL_UNICODE_ESCAPE)?"%Q%s":"%q%s"):"%v%s", index, (flags&JSON_PRETTY)?": ":":");
+      if (addQuotes)
+        jsonWriteString(index, flags&JSON_ALL_UNICODE_ESCAPE, user_callback, user_data);
+      user_callback((flags&JSON_PRETTY)?": ":":", user_data);
       if (first)
         first = false;
       jsfGetJSONWithCallback(item, index, nflags, whitespace, user_callback, user_data);
@@ -324,13 +942,13 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
   if (!whitespace) whitespace="  ";
 
   if (jsvIsUndefined(var)) {
-    cbprintf(user_callback, user_data, (flags&JSON_NO_UNDEFINED)?"null":"undefined");
+    user_callback((flags&JSON_NO_UNDEFINED)?"null":"undefined", user_data);
     return;
   }
   // Use IS_RECURSING flag to stop recursion
   if ((var->flags & JSV_IS_RECURSING) || (jsuGetFreeStack() < 512) || jspIsInterrupted()) {
     // also check for stack overflow/interruption
-    cbprintf(user_callback, user_data, " ... ");
+    user_callback(" ... ", user_data);
     return;
   }
   var->flags |= JSV_IS_RECURSING;
@@ -339,7 +957,7 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
     JsVarInt length = jsvGetArrayLength(var);
     bool limited = (flags&JSON_LIMIT) && (length>(JsVarInt)JSON_LIMIT_AMOUNT);
     bool needNewLine = false;
-    cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?"[ ":"[");
+    user_callback((flags&JSON_PRETTY)?"[ ":"[", user_data);
     JsVarInt lastIndex = -1;
     bool numeric = true;
     bool first = true;
@@ -353,9 +971,9 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
         while (lastIndex < index) {
           lastIndex++;
           if (!limited || lastIndex<(JsVarInt)JSON_LIMITED_AMOUNT || lastIndex>=length-(JsVarInt)JSON_LIMITED_AMOUNT) {
-            if (!first) cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?", ":",");
+            if (!first) user_callback((flags&JSON_PRETTY)?", ":",", user_data);
             first = false;
-            if (limited && lastIndex==length-(JsVarInt)JSON_LIMITED_AMOUNT) cbprintf(user_callback, user_data, JSON_LIMIT_TEXT);
+            if (limited && lastIndex==length-(JsVarInt)JSON_LIMITED_AMOUNT) user_callback(JSON_LIMIT_TEXT, user_data);
             bool newNeedsNewLine = ((flags&JSON_SOME_NEWLINES) && jsonNeedsNewLine(item));
             if (flags&JSON_ALL_NEWLINES) {
               needNewLine = true;
@@ -366,11 +984,12 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
               needNewLine = false;
             }
             if (lastIndex == index) {
-              JsVar *indexVar = jsvNewFromInteger(index);
+              // the index is only needed as the argument to toJSON, so don't allocate it for anything else
+              JsVar *indexVar = ((flags&JSON_ALLOW_TOJSON) && jsvIsObject(item)) ? jsvNewFromInteger(index) : 0;
               jsfGetJSONWithCallback(item, indexVar, nflags, whitespace, user_callback, user_data);
               jsvUnLock(indexVar);
             } else
-              cbprintf(user_callback, user_data, (flags&JSON_NO_UNDEFINED)?"null":"undefined");
+              user_callback((flags&JSON_NO_UNDEFINED)?"null":"undefined", user_data);
             needNewLine = newNeedsNewLine;
           }
         }
@@ -387,7 +1006,7 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
       jsfGetJSONForObjectItWithCallback(&it, flags, whitespace, nflags, user_callback, user_data, first);
     jsvObjectIteratorFree(&it);
     if (needNewLine) jsonNewLine(flags, whitespace, user_callback, user_data);
-    cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?" ]":"]");
+    user_callback((flags&JSON_PRETTY)?" ]":"]", user_data);
   } else if (jsvIsArrayBuffer(var)) {
     JsvArrayBufferIterator it;
     bool allZero = true;
@@ -419,9 +1038,9 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
       jsvArrayBufferIteratorNew(&it, var, 0);
       while (jsvArrayBufferIteratorHasElement(&it) && !jspIsInterrupted()) {
         if (!limited || it.index<JSON_LIMITED_AMOUNT || it.index>=length-JSON_LIMITED_AMOUNT) {
-          if (it.index>0) cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?", ":",");
+          if (it.index>0) user_callback((flags&JSON_PRETTY)?", ":",", user_data);
           if (flags&JSON_ALL_NEWLINES) jsonNewLine(nflags, whitespace, user_callback, user_data);
-          if (limited && it.index==length-JSON_LIMITED_AMOUNT) cbprintf(user_callback, user_data, JSON_LIMIT_TEXT);
+          if (limited && it.index==length-JSON_LIMITED_AMOUNT) user_callback(JSON_LIMIT_TEXT, user_data);
           JsVar *item = jsvArrayBufferIteratorGetValue(&it, false/*little endian*/);
           jsfGetJSONWithCallback(item, NULL, nflags, whitespace, user_callback, user_data);
           jsvUnLock(item);
@@ -480,11 +1099,11 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
         } else {
           JsvObjectIterator it;
           jsvObjectIteratorNew(&it, var);
-          cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?"{ ":"{");
+          user_callback((flags&JSON_PRETTY)?"{ ":"{", user_data);
           bool needNewLine = jsfGetJSONForObjectItWithCallback(&it, flags, whitespace, nflags, user_callback, user_data, true);
           jsvObjectIteratorFree(&it);
           if (needNewLine) jsonNewLine(flags, whitespace, user_callback, user_data);
-          cbprintf(user_callback, user_data, (flags&JSON_PRETTY)?" }":"}");
+          user_callback((flags&JSON_PRETTY)?" }":"}", user_data);
         }
         jsvUnLock(toStringFn);
       }
@@ -504,10 +1123,15 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
       cbprintf(user_callback, user_data, "%q%s%q", var1, JSON_LIMIT_TEXT, var2);
       jsvUnLock2(var1, var2);
     } else {
-      cbprintf(user_callback, user_data, (flags&JSON_ALL_UNICODE_ESCAPE)?"%Q":"%q", var);
+      jsonWriteString(var, flags&JSON_ALL_UNICODE_ESCAPE, user_callback, user_data);
     }
   } else if ((flags&JSON_NO_NAN) && jsvIsFloat(var) && !isfinite(jsvGetFloat(var))) {
-    cbprintf(user_callback, user_data, "null");
+    user_callback("null", user_data);
+  } else if (jsvIsInt(var) || jsvIsFloat(var) || jsvIsBoolean(var) || jsvIsNull(var)) {
+    // format straight into a buffer rather than allocating a String with %v
+    char buf[JS_NUMBER_BUFFER_SIZE];
+    jsvGetString(var, buf, sizeof(buf));
+    user_callback(buf, user_data);
   } else {
     cbprintf(user_callback, user_data, "%v", var);
   }
@@ -515,15 +1139,37 @@ void jsfGetJSONWithCallback(JsVar *var, JsVar *varName, JSONFlags flags, const c
   var->flags &= ~JSV_IS_RECURSING;
 }
 
+/// Collects JSON output in a buffer on the stack, and appends it to a String a block at a time
+typedef struct {
+  JsvStringIterator it;
+  size_t len;
+  char buf[64];
+} JsonStringWriter;
+
+static void jsonStringWriterFlush(JsonStringWriter *w) {
+  jsvStringIteratorAppendBuf(&w->it, w->buf, w->len);
+  w->len = 0;
+}
+
+static void jsonStringWriterCallback(const char *str, void *user_data) {
+  JsonStringWriter *w = (JsonStringWriter*)user_data;
+  while (*str) {
+    if (w->len == sizeof(w->buf)) jsonStringWriterFlush(w);
+    w->buf[w->len++] = *(str++);
+  }
+}
+
 void jsfGetJSONWhitespace(JsVar *var, JsVar *result, JSONFlags flags, const char *whitespace) {
   assert(jsvIsString(result));
-  JsvStringIterator it;
-  jsvStringIteratorNew(&it, result, 0);
-  jsvStringIteratorGotoEnd(&it);
+  JsonStringWriter w;
+  w.len = 0;
+  jsvStringIteratorNew(&w.it, result, 0);
+  jsvStringIteratorGotoEnd(&w.it);
 
-  jsfGetJSONWithCallback(var, NULL, flags, whitespace, (vcbprintf_callback)&jsvStringIteratorPrintfCallback, &it);
+  jsfGetJSONWithCallback(var, NULL, flags, whitespace, jsonStringWriterCallback, &w);
 
-  jsvStringIteratorFree(&it);
+  jsonStringWriterFlush(&w);
+  jsvStringIteratorFree(&w.it);
 }
 
 void jsfGetJSON(JsVar *var, JsVar *result, JSONFlags flags) {
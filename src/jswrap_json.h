@@ -43,6 +43,10 @@ JsVar *jswrap_json_parse_ext(JsVar *v, JSONFlags flags);
 JsVar *jswrap_json_parse_liberal(JsVar *v, bool noExceptions);
 JsVar *jswrap_json_parse(JsVar *v);
 
+JsVar *jswrap_json_parser(JsVar *options);
+void jswrap_jsonparser_write(JsVar *parser, JsVar *data);
+void jswrap_jsonparser_end(JsVar *parser, JsVar *data);
+
 /* This is like jsfGetJSONWithCallback, but handles ONLY functions (and does not print the initial 'function' text) */
 void jsfGetJSONForFunctionWithCallback(JsVar *var, JSONFlags flags, vcbprintf_callback user_callback, void *user_data);
 /* Dump to JSON, using the given callbacks for printing data
@@ -202,6 +202,9 @@ memory usage.
   Note that this is INCLUDED in the figure for 'free'
 * `gc` : Memory freed during the GC pass
 * `gctime` : Time taken for GC pass (in milliseconds)
+* `gcmaxpause` : [2v30+] The longest time (in milliseconds) that Espruino has spent in a single
+  GC pass. When idle, Espruino garbage collects incrementally in small steps, so this should
+  stay low unless memory runs out or `process.memory()` is called.
 * `blocksize` : Size of a block (variable) in bytes
 * `stackEndAddress` : (on ARM) the address (that can be used with peek/poke/etc)
   of the END of the stack. The stack grows down, so unless you do a lot of
@@ -225,6 +228,16 @@ the data, and you may receive a `FIFO_FULL` error in `E.getErrorFlags()` if it g
 * `tx` : [2v30+] `{ used : int, total : int }` bytes of data that are in the
 transmit buffer. This can be used for flow control - for example only writing to
 Bluetooth/Serial/USB when there is space in the buffer.
+* `nursery` : [2v30+] `{ size : int, hits : int, misses : int, promoted : int }`. Numbers
+are allocated from a small area at the end of memory (`size` blocks) so that temporary
+values don't fragment the rest of memory. `hits` and `misses` are the number of numbers
+that were and weren't allocated in it, and `promoted` is how many long-lived values
+have been moved out of it into main memory. If `misses` is high compared to `hits`,
+the nursery may be too small (`JSV_NURSERY_SIZE` when building).
+* `largestFree` : [2v30+] The largest number of contiguous free blocks. This is roughly the
+size of the biggest flat string (e.g. for `Graphics.createArrayBuffer` or a large `Uint8Array`)
+that can be allocated. When idle, Espruino compacts memory if this falls too low - see
+`E.setDefragThreshold`.
 
 Memory units are specified in 'blocks', which are around 16 bytes each
 (depending on your device). The actual size is available in `blocksize`. See
@@ -254,10 +267,12 @@ JsVar *jswrap_process_memory(JsVar *gc) {
     jsvObjectSetIntChild(obj, "usage", (JsVarInt)usage);
     jsvObjectSetIntChild(obj, "total", (JsVarInt)total);
     jsvObjectSetIntChild(obj, "history", (JsVarInt)history);
+    jsvObjectSetIntChild(obj, "largestFree", (JsVarInt)jsvGetLargestFreeRun());
     if (varsGCd>=0) {
       jsvObjectSetIntChild(obj, "gc", (JsVarInt)varsGCd);
       jsvObjectSetFloatChild(obj, "gctime", jshGetMillisecondsFromTime(time2-time1));
     }
+    jsvObjectSetFloatChild(obj, "gcmaxpause", jshGetMillisecondsFromTime(jsvGarbageCollectGetMaxPause()));
     jsvObjectSetIntChild(obj, "blocksize", sizeof(JsVar));
 #ifndef SAVE_ON_FLASH
     JsVar *rx = jsvNewObject();
@@ -266,9 +281,19 @@ JsVar *jswrap_process_memory(JsVar *gc) {
     jsvObjectSetChildAndUnLock(obj, "rx", rx);
     JsVar *tx = jsvNewObject();
     jsvObjectSetIntChild(tx, "used", jshGetTransmitBufferUsage());
-    jsvObjectSetIntChild(tx, "total", TXBUFFERMASK+1);
+    jsvObjectSetIntChild(tx, "total", TXRINGCOUNT*(TXBUFFERMASK+1));
     jsvObjectSetChildAndUnLock(obj, "tx", tx);
 #endif
+#ifndef ESPR_NO_NURSERY
+    unsigned int nurserySize, nurseryHits, nurseryMisses, nurseryPromoted;
+    jsvNurseryGetStats(&nurserySize, &nurseryHits, &nurseryMisses, &nurseryPromoted);
+    JsVar *nursery = jsvNewObject();
+    jsvObjectSetIntChild(nursery, "size", (JsVarInt)nurserySize);
+    jsvObjectSetIntChild(nursery, "hits", (JsVarInt)nurseryHits);
+    jsvObjectSetIntChild(nursery, "misses", (JsVarInt)nurseryMisses);
+    jsvObjectSetIntChild(nursery, "promoted", (JsVarInt)nurseryPromoted);
+    jsvObjectSetChildAndUnLock(obj, "nursery", nursery);
+#endif
 #ifdef ARM
     extern uint32_t LINKER_END_VAR; // end of ram used (variables) - should be 'void', but 'int' avoids warnings
     extern uint32_t LINKER_ETEXT_VAR; // end of flash text (binary) section - should be 'void', but 'int' avoids warnings
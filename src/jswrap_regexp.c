@@ -19,252 +19,717 @@
 #include "jslex.h"
 #include "jsinteractive.h"
 
-/* TODO:
- *
- * Handling of 'global' flag especially
- * lastIndex support?
- */
+#define MAX_GROUPS 31 ///< Maximum number of capture groups in a RegEx
+#define JSWRAP_REGEXP_PROGRAM_NAME JS_HIDDEN_CHAR_STR"prg" ///< RegExp: the compiled program (see regexCompile)
+
+/* RegExps are compiled once (when the RegExp is created) into a small program of
+RegexOp instructions that is stored on the RegExp object. This is run with a 'Pike VM':
+a Thompson NFA where each thread keeps track of its own capture groups. Every way
+the RegEx could match is run in parallel as we step through the string one character
+at a time, so matching is linear in the length of the string and the memory used is
+bounded by the size of the program - there's no backtracking.
+
+Threads are kept in priority order, so the match we return is the same one a
+backtracking matcher would find: the leftmost match, with greedy quantifiers preferring
+more repetitions and lazy ones fewer.
+
+A compiled program is:
+
+* RE_PROG_HEADER_LEN bytes: number of groups, RegexProgFlags, max threads (uint16),
+  total slots cleared by RE_CLEAR instructions (uint16)
+* If RE_PROG_FIRSTCHARS, a RE_CLASS_BYTES bitmap of chars a match can start with
+* If RE_PROG_FIRSTCHAR, the single char a match must start with
+* The instructions
+*/
+
+typedef enum {
+  RE_MATCH,   ///< We've matched
+  RE_CHAR,    ///< [ch] match one character (the lowercase character if RE_PROG_IGNORECASE)
+  RE_ANY,     ///< match any character
+  RE_CLASS,   ///< [RE_CLASS_BYTES] match any character in the bitmap
+  RE_SPLIT,   ///< [int16 x, int16 y] carry on at both x and y, with x having priority
+  RE_JMP,     ///< [int16 x] carry on at x
+  RE_SAVE,    ///< [slot] save the current index in a capture group slot
+  RE_BOL,     ///< start of the string (^)
+  RE_EOL,     ///< end of the string ($)
+  RE_WORDB,   ///< word boundary (\b)
+  RE_NWORDB,  ///< not a word boundary (\B)
+  RE_CLEAR,   ///< [slot, count] unset 'count' capture slots from 'slot' (groups inside a repeated atom)
+} RegexOp;
+// Jump offsets are relative to the start of the RE_SPLIT/RE_JMP instruction
+#define RE_SPLIT_LEN 5
+#define RE_JMP_LEN 3
+#define RE_CLEAR_LEN 3
+#define RE_CLASS_BYTES 32 // 256 bits, one for each character
 
-#define MAX_GROUPS 9
-#define NO_RANGE  256
+typedef enum {
+  RE_PROG_IGNORECASE = 1, ///< Characters should be lowercased before comparing with RE_CHAR
+  RE_PROG_FIRSTCHARS = 2, ///< A bitmap of the characters a match can start with follows the header
+  RE_PROG_FIRSTCHAR = 4,  ///< The one character a match must start with follows the header
+} RegexProgFlags;
+#define RE_PROG_HEADER_LEN 6
+#define RE_NO_INDEX ((size_t)-1) ///< Capture slot that hasn't been set
 
 typedef struct {
-  JsVar *sourceStr;
-  size_t startIndex;
+  const char *src;     ///< Where we are in the RegEx source
+  unsigned char *out;  ///< Where to write instructions, or 0 if we're only working out the length
+  size_t len;          ///< Length of the instructions so far
+  int groups;          ///< Number of capture groups
+  int threads;         ///< Number of instructions that match a character (+1 is the max threads we need)
+  int clearSlots;      ///< Total capture slots cleared by RE_CLEAR instructions
   bool ignoreCase;
-  bool rangeMatch;
-  short rangeFirstChar;
-  int groups;
-  size_t groupStart[MAX_GROUPS];
-  size_t groupEnd[MAX_GROUPS];
-} matchInfo;
-
-static JsVar *matchhere(char *regexp, JsvStringIterator *txtIt, matchInfo info);
-
-static JsVar *matchfound(JsvStringIterator *txtIt, matchInfo info) {
-  JsVar *rmatch = jsvNewEmptyArray();
-  size_t endIndex = jsvStringIteratorGetIndex(txtIt);
-  JsVar *matchStr = jsvNewFromStringVar(info.sourceStr, info.startIndex, endIndex-info.startIndex);
-  jsvSetArrayItem(rmatch, 0, matchStr);
-  jsvUnLock(matchStr);
-  int i;
-  for (i=0;i<info.groups;i++) {
-    matchStr = jsvNewFromStringVar(info.sourceStr, info.groupStart[i], info.groupEnd[i]-info.groupStart[i]);
-    jsvSetArrayItem(rmatch, i+1, matchStr);
-    jsvUnLock(matchStr);
+  bool error;          ///< An exception has been thrown
+} RegexCompiler;
+
+static void regexError(RegexCompiler *c, const char *msg) {
+  if (!c->error) jsExceptionHere(JSET_SYNTAXERROR, "%s", msg);
+  c->error = true;
+}
+
+static void regexEmit(RegexCompiler *c, int byte) {
+  if (c->out) c->out[c->len] = (unsigned char)byte;
+  c->len++;
+}
+
+static void regexSetOffset(RegexCompiler *c, size_t at, int offset) {
+  if (!c->out) return;
+  c->out[at] = (unsigned char)offset;
+  c->out[at+1] = (unsigned char)(offset>>8);
+}
+
+static int regexGetOffset(const unsigned char *code, int at) {
+  return (int16_t)(code[at] | (code[at+1]<<8));
+}
+
+static void regexEmitJmp(RegexCompiler *c, int x) {
+  regexEmit(c, RE_JMP);
+  regexEmit(c, 0); regexEmit(c, 0);
+  regexSetOffset(c, c->len-2, x);
+}
+
+static void regexEmitSplit(RegexCompiler *c, int x, int y) {
+  regexEmit(c, RE_SPLIT);
+  regexEmit(c, 0); regexEmit(c, 0);
+  regexEmit(c, 0); regexEmit(c, 0);
+  regexSetOffset(c, c->len-4, x);
+  regexSetOffset(c, c->len-2, y);
+}
+
+/// Insert a split before the instructions at 'at'. Offsets are relative so the code we move stays valid
+static void regexInsertSplit(RegexCompiler *c, size_t at, int x, int y) {
+  if (c->out) {
+    memmove(&c->out[at+RE_SPLIT_LEN], &c->out[at], c->len-at);
+    c->out[at] = RE_SPLIT;
+  }
+  c->len += RE_SPLIT_LEN;
+  regexSetOffset(c, at+1, x);
+  regexSetOffset(c, at+3, y);
+}
+
+/// Insert an RE_CLEAR before the instructions at 'at'
+static void regexInsertClear(RegexCompiler *c, size_t at, int slot, int count) {
+  if (c->out) {
+    memmove(&c->out[at+RE_CLEAR_LEN], &c->out[at], c->len-at);
+    c->out[at] = RE_CLEAR;
+    c->out[at+1] = (unsigned char)slot;
+    c->out[at+2] = (unsigned char)count;
   }
-  jsvObjectSetIntChild(rmatch, "index", (JsVarInt)info.startIndex);
-  jsvObjectSetChild(rmatch, "input", info.sourceStr);
+  c->len += RE_CLEAR_LEN;
+  c->clearSlots += count;
+}
 
-  return rmatch;
+static void regexClassAdd(unsigned char *set, int ch) {
+  set[ch>>3] |= (unsigned char)(1<<(ch&7));
 }
 
-// No match found, so search to end of regex to see if there's an '|'
-static JsVar *nomatchfound(char *regexp, matchInfo info) {
-  if (!jspCheckStackPosition()) return 0;
-  // TODO: | inside a group?
-  while (*regexp && *regexp!='|') {
-    if (*regexp=='\\') {
-      regexp++; // end of regex after escape char!
-      if (!*regexp) return 0;
-    }
-    regexp++;
+static bool regexClassHas(const unsigned char *set, unsigned char ch) {
+  return (set[ch>>3]>>(ch&7))&1;
+}
+
+static bool regexIsWordChar(char ch) {
+  return isNumeric(ch) || isAlpha(ch); // isAlpha includes '_'
+}
+
+/// If esc is d,D,s,S,w or W, add the characters it matches to 'set' and return true
+static bool regexClassAddEscape(unsigned char *set, char esc) {
+  char type = charToLowerCase(esc);
+  if (type!='d' && type!='s' && type!='w') return false;
+  bool invert = type!=esc;
+  int i;
+  for (i=0;i<256;i++) {
+    char ch = (char)i;
+    bool match = (type=='d') ? isNumeric(ch) : ((type=='s') ? isWhitespace(ch) : regexIsWordChar(ch));
+    if (match != invert) regexClassAdd(set, i);
   }
-  if (*regexp != '|') return 0;
-  regexp++;
+  return true;
+}
 
-  JsvStringIterator txtIt;
-  jsvStringIteratorNew(&txtIt,  info.sourceStr, info.startIndex);
-  JsVar *rmatch = matchhere(regexp, &txtIt, info);
-  jsvStringIteratorFree(&txtIt);
-  return rmatch;
+/// Parse the character after a '\' and return its character code
+static int regexCompileEscape(RegexCompiler *c) {
+  char ch = *(c->src++);
+  switch (ch) {
+    case 0: c->src--; regexError(c, "Unfinished escape in RegEx"); return 0;
+    case 'f': return 0x0C;
+    case 'n': return 0x0A;
+    case 'r': return 0x0D;
+    case 't': return 0x09;
+    case 'v': return 0x0B;
+    case '0': return 0;
+    case 'x':
+      if (isHexadecimal(c->src[0]) && isHexadecimal(c->src[1])) {
+        c->src += 2;
+        return hexToByte(c->src[-2], c->src[-1]);
+      }
+      break;
+  }
+  if (ch>='1' && ch<='9')
+    regexError(c, "Backreferences not supported");
+  return (unsigned char)ch; // the quoted character (e.g. /,-,? etc.)
 }
 
-/* match: search for regexp anywhere in text */
-static JsVar *match(char *regexp, JsVar *str, size_t startIndex, bool ignoreCase) {
-  matchInfo info;
-  info.sourceStr = str;
-  info.startIndex = startIndex;
-  info.ignoreCase = ignoreCase;
-  info.rangeMatch = false;
-  info.rangeFirstChar = NO_RANGE;
-  info.groups = 0;
-
-  JsVar *rmatch;
-  JsvStringIterator txtIt, txtIt2;
-  jsvStringIteratorNew(&txtIt, str, startIndex);
-  /* must look even if string is empty */
-  jsvStringIteratorClone(&txtIt2, &txtIt);
-  rmatch = matchhere(regexp, &txtIt2, info);
-  jsvStringIteratorFree(&txtIt2);
-  jsvStringIteratorNext(&txtIt);
-  while (!rmatch && jsvStringIteratorHasChar(&txtIt)) {
-    info.startIndex++;
-    jsvStringIteratorClone(&txtIt2, &txtIt);
-    rmatch = matchhere(regexp, &txtIt2, info);
-    jsvStringIteratorFree(&txtIt2);
-    jsvStringIteratorNext(&txtIt);
-  }
-  jsvStringIteratorFree(&txtIt);
-  return rmatch;
+/// Parse a character in a character set, returning its code. \d/\w/etc are added to set, and return -1
+static int regexCompileClassChar(RegexCompiler *c, unsigned char *set) {
+  char ch = *(c->src++);
+  if (ch!='\\') return (unsigned char)ch;
+  if (*c->src=='b') { // backspace inside a character set
+    c->src++;
+    return 0x08;
+  }
+  if (regexClassAddEscape(set, *c->src)) {
+    c->src++;
+    return -1;
+  }
+  return regexCompileEscape(c);
+}
+
+static void regexEmitClass(RegexCompiler *c, unsigned char *set, bool inverted) {
+  int i;
+  if (c->ignoreCase) {
+    for (i=0;i<256;i++)
+      if (regexClassHas(set, (unsigned char)i)) {
+        regexClassAdd(set, (unsigned char)charToLowerCase((char)i));
+        regexClassAdd(set, (unsigned char)charToUpperCase((char)i));
+      }
+  }
+  regexEmit(c, RE_CLASS);
+  for (i=0;i<RE_CLASS_BYTES;i++)
+    regexEmit(c, inverted ? ~set[i] : set[i]);
+  c->threads++;
 }
 
-/* Match one character. Doesn't modify txtIt, returns length of regexp char in *length  */
-bool matchcharacter(char *regexp, JsvStringIterator *txtIt, int *length, matchInfo *info) {
-  *length = 1;
-  char ch = jsvStringIteratorGetChar(txtIt);
-  if (regexp[0]=='.') return true;
-  if (regexp[0]=='[') { // Character set (any char inside '[]')
-    info->rangeMatch = true;
-    bool inverted = regexp[1]=='^';
-    if (inverted) (*length)++;
-    bool matchAny = false;
-    while (regexp[*length] && regexp[*length]!=']') {
-      int matchLen;
-      if (regexp[*length]=='.') { // https://github.com/espruino/Espruino/issues/1948
-        matchAny |= ch=='.';
-        (*length)++;
-      } else {
-        matchAny |= matchcharacter(&regexp[*length], txtIt, &matchLen, info);
-        (*length) += matchLen;
+/// Parse a character set ('[...]')
+static void regexCompileClass(RegexCompiler *c) {
+  unsigned char set[RE_CLASS_BYTES];
+  memset(set, 0, sizeof(set));
+  bool inverted = *c->src=='^';
+  if (inverted) c->src++;
+  while (*c->src && *c->src!=']' && !c->error) {
+    int lo = regexCompileClassChar(c, set);
+    if (lo<0) continue; // \d, \w, etc
+    int hi = lo;
+    if (c->src[0]=='-' && c->src[1] && c->src[1]!=']') { // Character set range
+      c->src++;
+      hi = regexCompileClassChar(c, set);
+      if (hi<0) { // eg. [a-\d] - the '-' is just a character
+        regexClassAdd(set, '-');
+        hi = lo;
       }
     }
-    if (regexp[*length]==']') {
-      (*length)++;
+    for (;lo<=hi;lo++) regexClassAdd(set, lo);
+  }
+  if (*c->src!=']') {
+    regexError(c, "Unfinished character set in RegEx");
+    return;
+  }
+  c->src++;
+  regexEmitClass(c, set, inverted);
+}
+
+static void regexCompileAlternatives(RegexCompiler *c);
+
+/// Compile one character, character set or group. Returns false if it can't be followed by a quantifier
+static bool regexCompileAtom(RegexCompiler *c) {
+  char ch = *(c->src++);
+  if (ch=='(') {
+    int group = 0;
+    if (c->src[0]=='?') {
+      if (c->src[1]!=':') {
+        regexError(c, "Only (?: groups are supported in RegEx");
+        return false;
+      }
+      c->src += 2;
     } else {
-      jsExceptionHere(JSET_ERROR, "Unfinished character set in RegEx");
+      if (c->groups >= MAX_GROUPS) {
+        regexError(c, "Too many groups in RegEx");
+        return false;
+      }
+      group = ++c->groups;
+      regexEmit(c, RE_SAVE);
+      regexEmit(c, group*2);
+    }
+    regexCompileAlternatives(c);
+    if (*c->src!=')') {
+      regexError(c, "Unfinished group in RegEx");
       return false;
     }
-    info->rangeMatch = false;
-    return matchAny != inverted;
-  }
-  char cH = regexp[0];
-  if (cH=='\\') { // escape character
-    *length = 2;
-    // fallback to the quoted character (e.g. /,-,? etc.)
-    cH = regexp[1];
-    // missing quite a few here
-    // https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions
-    if (cH=='d') return isNumeric(ch);
-    if (cH=='D') return !isNumeric(ch);
-    if (cH=='f') { cH=0x0C; goto haveCode; }
-    if (cH=='b') { cH=0x08; goto haveCode; }
-    if (cH=='n') { cH=0x0A; goto haveCode; }
-    if (cH=='r') { cH=0x0D; goto haveCode; }
-    if (cH=='s') return isWhitespace(ch);
-    if (cH=='S') return !isWhitespace(ch);
-    if (cH=='t') { cH=0x09; goto haveCode; }
-    if (cH=='v') { cH=0x0B; goto haveCode; }
-    if (cH=='w') return isNumeric(ch) || isAlpha(ch) || ch=='_';
-    if (cH=='W') return !(isNumeric(ch) || isAlpha(ch) || ch=='_');
-    if (cH=='0') { cH=0; goto haveCode; }
-    if (cH>='1' && cH<='9') {
-      jsExceptionHere(JSET_ERROR, "Backreferences not supported");
+    c->src++;
+    if (group) {
+      regexEmit(c, RE_SAVE);
+      regexEmit(c, group*2+1);
+    }
+    return true;
+  }
+  if (ch=='[') {
+    regexCompileClass(c);
+    return true;
+  }
+  if (ch=='^') { regexEmit(c, RE_BOL); return false; }
+  if (ch=='$') { regexEmit(c, RE_EOL); return false; }
+  if (ch=='*' || ch=='+' || ch=='?') {
+    regexError(c, "Nothing to repeat in RegEx");
+    return false;
+  }
+  if (ch=='.') {
+    regexEmit(c, RE_ANY);
+    c->threads++;
+    return true;
+  }
+  int code = (unsigned char)ch;
+  if (ch=='\\') {
+    if (*c->src=='b' || *c->src=='B') {
+      regexEmit(c, (*(c->src++)=='b') ? RE_WORDB : RE_NWORDB);
       return false;
-      // we could implement this if needed by matching against info->groupStart/End
     }
-    if (cH=='x' && regexp[2] && regexp[3]) {
-      *length = 4;
-      cH = (char)hexToByte(regexp[2],regexp[3]);
-      goto haveCode;
+    unsigned char set[RE_CLASS_BYTES];
+    memset(set, 0, sizeof(set));
+    if (regexClassAddEscape(set, *c->src)) {
+      c->src++;
+      regexEmitClass(c, set, false);
+      return true;
     }
+    code = regexCompileEscape(c);
   }
-haveCode:
-  if (info->rangeMatch && regexp[*length] == '-' && regexp[1+*length] != ']') { // Character set range start
-    info->rangeFirstChar = cH;
-    (*length)++;
-    int matchLen;
-    bool match = matchcharacter(&regexp[*length], txtIt, &matchLen, info);
-    (*length)+=matchLen;
-    return match;
-  }
-  if (info->ignoreCase) {
-    ch = charToLowerCase(ch);
-    cH = charToLowerCase(cH);
-  }
-  if (info->rangeFirstChar != NO_RANGE) { // Character set range
-    char cL = (char)info->rangeFirstChar;
-    if (info->ignoreCase) {
-      cL = charToLowerCase(cL);
+  if (c->ignoreCase) code = (unsigned char)charToLowerCase((char)code);
+  regexEmit(c, RE_CHAR);
+  regexEmit(c, code);
+  c->threads++;
+  return true;
+}
+
+/// Compile a list of atoms (with quantifiers) up to the next '|' or ')'
+static void regexCompileSequence(RegexCompiler *c) {
+  while (*c->src && *c->src!='|' && *c->src!=')' && !c->error) {
+    size_t start = c->len;
+    int groupsBefore = c->groups;
+    bool canRepeat = regexCompileAtom(c);
+    char op = *c->src;
+    if (op!='*' && op!='+' && op!='?') continue;
+    if (!canRepeat) {
+      regexError(c, "Nothing to repeat in RegEx");
+      return;
     }
-    info->rangeFirstChar = NO_RANGE;
-    return (ch >= cL && ch <= cH && cL < cH);
-  }
-  return cH==ch;
-}
-
-/* matchhere: search for regexp at beginning of text. Only handles up to '|' character. Modifies txtIt */
-static JsVar *matchhere(char *regexp, JsvStringIterator *txtIt, matchInfo info) {
-  if (jspIsInterrupted()) return 0;
-  if (regexp[0] == '\0' || // end of regex
-      regexp[0] == '|') // end of this 'or' section of regex
-    return matchfound(txtIt, info);
-  if (regexp[0] == '^') { // must be beginning of String
-    if (jsvStringIteratorGetIndex(txtIt)!=0)
-      return 0; // no match
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
-  }
-  // Marker for end of String
-  if (regexp[0] == '$') {
-    if (!jsvStringIteratorHasChar(txtIt))
-      return matchhere(regexp+1, txtIt, info);
-    else
-      return nomatchfound(regexp+1, info); // not the end, it's a fail
-  }
-  if (regexp[0] == '(') {
-    info.groupStart[info.groups] = jsvStringIteratorGetIndex(txtIt);
-    info.groupEnd[info.groups] = info.groupStart[info.groups];
-    if (info.groups<MAX_GROUPS) info.groups++;
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
-  }
-  if (regexp[0] == ')') {
-    if (info.groups>0)
-      info.groupEnd[info.groups-1] = jsvStringIteratorGetIndex(txtIt);
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
-  }
-  int charLength;
-  bool charMatched = matchcharacter(regexp, txtIt, &charLength, &info);
-  if (regexp[charLength] == '*' || regexp[charLength] == '+') {
-    char op = regexp[charLength];
-    if (!charMatched && op=='+') {
-      // with '+' operator it has to match at least once
-      return nomatchfound(&regexp[charLength+1], info);
+    c->src++;
+    bool lazy = *c->src=='?';
+    if (lazy) c->src++;
+    // Groups inside a repeated atom are unset at the start of each repetition (`/((a)|b)+/` on "ab" gives [..,"b",undefined])
+    if (op!='?' && c->groups>groupsBefore)
+      regexInsertClear(c, start, (groupsBefore+1)*2, (c->groups-groupsBefore)*2);
+    int atomLen = (int)(c->len - start);
+    if (op=='+') { // atom; SPLIT atom, next
+      regexEmitSplit(c, lazy ? RE_SPLIT_LEN : -atomLen, lazy ? -atomLen : RE_SPLIT_LEN);
+    } else { // SPLIT next, after; atom; ['*' only: JMP split]
+      int after = RE_SPLIT_LEN + atomLen + ((op=='*') ? RE_JMP_LEN : 0);
+      regexInsertSplit(c, start, lazy ? after : RE_SPLIT_LEN, lazy ? RE_SPLIT_LEN : after);
+      if (op=='*') regexEmitJmp(c, -(int)(c->len - start));
     }
-    char *regexpAfterStar = regexp+charLength+1;
-    JsvStringIterator txtIt2;
-    // Try and match everything after right now
-    jsvStringIteratorClone(&txtIt2, txtIt);
-    JsVar *lastrmatch = matchhere(regexpAfterStar, &txtIt2, info);
-    jsvStringIteratorFree(&txtIt2);
-    // Otherwise try and match more than one
-    while (jsvStringIteratorHasChar(txtIt) && charMatched) {
-      // We had this character matched, so move on and see if we can match with the new one
-      jsvStringIteratorNext(txtIt);
-      charMatched = matchcharacter(regexp, txtIt, &charLength, &info);
-      // See if we can match after the character...
-      jsvStringIteratorClone(&txtIt2, txtIt);
-      JsVar *rmatch = matchhere(regexpAfterStar, &txtIt2, info);
-      jsvStringIteratorFree(&txtIt2);
-      // can't match with this - use the last one
-      if (rmatch) {
-        jsvUnLock(lastrmatch);
-        lastrmatch = rmatch;
+  }
+}
+
+/// Compile sequences separated by '|' (stopping at ')' or the end)
+static void regexCompileAlternatives(RegexCompiler *c) {
+  if (!jspCheckStackPosition()) {
+    c->error = true;
+    return;
+  }
+  size_t start = c->len;
+  regexCompileSequence(c);
+  while (*c->src=='|' && !c->error) {
+    c->src++;
+    // SPLIT previous, next; previous; JMP end; next
+    size_t jmp = c->len + RE_SPLIT_LEN;
+    regexInsertSplit(c, start, RE_SPLIT_LEN, (int)(jmp + RE_JMP_LEN - start));
+    regexEmitJmp(c, 0);
+    regexCompileSequence(c);
+    regexSetOffset(c, jmp+1, (int)(c->len - jmp));
+  }
+}
+
+#ifndef ESPR_NO_REGEX_OPTIMISE
+/** Add the characters that the program could start matching with to set. This is for
+matches that don't start at index 0 (so '^' never matches). Returns false if the program
+could match without a character (in which case we can't filter on the first char).
+The other branch of each RE_SPLIT is pushed on 'stack', which needs an entry per RE_SPLIT */
+static bool regexFirstChars(const unsigned char *code, unsigned char *set, unsigned char *visited, uint16_t *stack, bool ignoreCase) {
+  int sp = 0;
+  int pc = 0;
+  while (true) {
+    if (visited[pc>>3] & (1<<(pc&7))) {
+      if (!sp) return true;
+      pc = stack[--sp];
+      continue;
+    }
+    visited[pc>>3] |= (unsigned char)(1<<(pc&7));
+    switch (code[pc]) {
+      case RE_CHAR:
+        regexClassAdd(set, code[pc+1]);
+        if (ignoreCase) regexClassAdd(set, (unsigned char)charToUpperCase((char)code[pc+1]));
+        break;
+      case RE_CLASS: {
+        int i;
+        for (i=0;i<RE_CLASS_BYTES;i++) set[i] |= code[pc+1+i];
+        break;
       }
+      case RE_BOL: break; // never matches after index 0
+      case RE_SPLIT:
+        stack[sp++] = (uint16_t)(pc+regexGetOffset(code, pc+3));
+        pc += regexGetOffset(code, pc+1);
+        continue;
+      case RE_JMP: pc += regexGetOffset(code, pc+1); continue;
+      case RE_SAVE: pc += 2; continue;
+      case RE_CLEAR: pc += RE_CLEAR_LEN; continue;
+      case RE_WORDB:
+      case RE_NWORDB: pc++; continue;
+      default: return false; // RE_ANY, RE_MATCH or RE_EOL
     }
-    return lastrmatch;
+    // this path needs a character - try the next one
+    if (!sp) return true;
+    pc = stack[--sp];
   }
+}
+#endif
 
-  // This character is matched
-  if (jsvStringIteratorHasChar(txtIt) && charMatched) {
-    jsvStringIteratorNext(txtIt);
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+charLength, txtIt, info);
+/// Compile RegEx source into a program (see RegexOp). Returns 0 and throws an exception on error
+static JsVar *regexCompile(JsVar *source, bool ignoreCase) {
+  size_t sourceLen = jsvGetStringLength(source);
+  if (sourceLen+256 > jsuGetFreeStack()) {
+    jsExceptionHere(JSET_ERROR, "Not enough stack memory for RegEx");
+    return 0;
+  }
+  char *sourcePtr = (char *)alloca(sourceLen+1);
+  jsvGetString(source, sourcePtr, sourceLen+1);
+  // Compile twice - once to get the length, and once to write the instructions
+  RegexCompiler c;
+  unsigned char *prog = 0;
+  const size_t codeStart = RE_PROG_HEADER_LEN+RE_CLASS_BYTES; // leave room for the first chars
+  while (true) {
+    c.src = sourcePtr;
+    c.out = prog ? &prog[codeStart] : 0;
+    c.len = 0;
+    c.groups = 0;
+    c.threads = 1; // for RE_MATCH
+    c.clearSlots = 0;
+    c.ignoreCase = ignoreCase;
+    c.error = false;
+    regexCompileAlternatives(&c);
+    if (*c.src==')') regexError(&c, "Unmatched ')' in RegEx");
+    regexEmit(&c, RE_MATCH);
+    if (c.error) return 0;
+    if (prog) break;
+    if (c.len > 0x7FFF || c.clearSlots > 0xFFFF || codeStart+c.len+256 > jsuGetFreeStack()) {
+      jsExceptionHere(JSET_ERROR, "RegEx too long");
+      return 0;
+    }
+    prog = (unsigned char *)alloca(codeStart+c.len);
+  }
+  prog[0] = (unsigned char)c.groups;
+  prog[1] = ignoreCase ? RE_PROG_IGNORECASE : 0;
+  prog[2] = (unsigned char)c.threads;
+  prog[3] = (unsigned char)(c.threads>>8);
+  prog[4] = (unsigned char)c.clearSlots;
+  prog[5] = (unsigned char)(c.clearSlots>>8);
+  size_t firstLen = 0;
+#ifndef ESPR_NO_REGEX_OPTIMISE
+  /* Work out what characters a match could start with, so when nothing is matching
+  we can skip straight to a character that might start a match */
+  size_t stackLen = sizeof(uint16_t)*(c.len/RE_SPLIT_LEN + 1);
+  if (stackLen+((c.len+7)>>3)+256 > jsuGetFreeStack()) {
+    jsExceptionHere(JSET_ERROR, "Not enough stack memory for RegEx");
+    return 0;
+  }
+  uint16_t *stack = (uint16_t *)alloca(stackLen);
+  unsigned char *visited = (unsigned char *)alloca((c.len+7)>>3);
+  memset(visited, 0, (c.len+7)>>3);
+  unsigned char *firstChars = &prog[RE_PROG_HEADER_LEN];
+  memset(firstChars, 0, RE_CLASS_BYTES);
+  if (regexFirstChars(&prog[codeStart], firstChars, visited, stack, ignoreCase)) {
+    int i, count = 0, firstChar = 0;
+    for (i=0;i<256;i++)
+      if (regexClassHas(firstChars, (unsigned char)i)) {
+        count++;
+        firstChar = i;
+      }
+    if (count==1) {
+      prog[1] |= RE_PROG_FIRSTCHAR;
+      firstChars[0] = (unsigned char)firstChar;
+      firstLen = 1;
+    } else {
+      prog[1] |= RE_PROG_FIRSTCHARS;
+      firstLen = RE_CLASS_BYTES;
+    }
   }
-  // No match
-  return nomatchfound(&regexp[charLength], info);
+#endif
+  memmove(&prog[RE_PROG_HEADER_LEN+firstLen], &prog[codeStart], c.len);
+  return jsvNewStringOfLength((unsigned int)(RE_PROG_HEADER_LEN+firstLen+c.len), (char*)prog);
+}
+
+typedef struct {
+  int count;
+  uint16_t *pc;  ///< instruction each thread is waiting at
+  size_t *caps;  ///< capture slots for each thread
+} RegexThreadList;
+
+/// Work left to do in regexAddThread - an instruction to add a thread at, or a capture slot to restore
+typedef struct {
+  size_t old;   ///< value to restore the capture slot to
+  uint16_t pc;  ///< instruction, or RE_RESTORE_SLOT|slot
+} RegexAddItem;
+#define RE_RESTORE_SLOT 0x8000 // programs are at most 0x7FFF long, so this bit is free
+
+typedef struct {
+  const unsigned char *code;
+  unsigned char *visited; ///< bitmap of instructions we've added threads for in this step
+  RegexAddItem *stack;    ///< work stack for regexAddThread (codeLen+1+clearSlots items)
+  int slots;              ///< capture slots per thread (2 per group, including group 0 - the whole match)
+  JsvStringIterator it;   ///< iterator at 'index'
+  size_t index;           ///< index in the string we're at
+  char prevCh, ch;        ///< characters before and at index
+  bool atEnd;             ///< is index at the end of the string?
+} RegexVM;
+
+static void regexNextChar(RegexVM *vm) {
+  vm->prevCh = vm->ch;
+  jsvStringIteratorNext(&vm->it);
+  vm->ch = jsvStringIteratorGetChar(&vm->it);
+  vm->atEnd = !jsvStringIteratorHasChar(&vm->it);
+  vm->index++;
+}
+
+/** Add a thread at pc to the list, following jumps/splits and checking assertions at the current index.
+This is a depth-first search (the same order as a backtracking matcher) but uses vm->stack rather
+than recursing, so long chains of '?'/'*' can't overflow the C stack. Each instruction is only expanded
+once and pushes at most one item per byte of it (plus one per slot for RE_CLEAR), so the stack never
+needs more than codeLen+1+clearSlots items */
+static void regexAddThread(RegexVM *vm, RegexThreadList *l, int pc, size_t *caps) {
+  const unsigned char *code = vm->code;
+  RegexAddItem *stack = vm->stack;
+  int sp = 0;
+  stack[sp++].pc = (uint16_t)pc;
+  while (sp) {
+    RegexAddItem *item = &stack[--sp];
+    pc = item->pc;
+    if (pc & RE_RESTORE_SLOT) { // we've finished with everything after an RE_SAVE
+      caps[pc & ~RE_RESTORE_SLOT] = item->old;
+      continue;
+    }
+    if (vm->visited[pc>>3] & (1<<(pc&7))) continue; // already have a (higher priority) thread here
+    vm->visited[pc>>3] |= (unsigned char)(1<<(pc&7));
+    switch (code[pc]) {
+      case RE_JMP:
+        stack[sp++].pc = (uint16_t)(pc+regexGetOffset(code, pc+1));
+        break;
+      case RE_SPLIT: // push y first so x is handled (and has priority) first
+        stack[sp++].pc = (uint16_t)(pc+regexGetOffset(code, pc+3));
+        stack[sp++].pc = (uint16_t)(pc+regexGetOffset(code, pc+1));
+        break;
+      case RE_SAVE: {
+        int slot = code[pc+1];
+        stack[sp].pc = (uint16_t)(RE_RESTORE_SLOT|slot);
+        stack[sp++].old = caps[slot];
+        caps[slot] = vm->index;
+        stack[sp++].pc = (uint16_t)(pc+2);
+        break;
+      }
+      case RE_CLEAR: {
+        int slot, end = code[pc+1]+code[pc+2];
+        for (slot=code[pc+1];slot<end;slot++) {
+          stack[sp].pc = (uint16_t)(RE_RESTORE_SLOT|slot);
+          stack[sp++].old = caps[slot];
+          caps[slot] = RE_NO_INDEX;
+        }
+        stack[sp++].pc = (uint16_t)(pc+RE_CLEAR_LEN);
+        break;
+      }
+      case RE_BOL:
+        if (vm->index==0) stack[sp++].pc = (uint16_t)(pc+1);
+        break;
+      case RE_EOL:
+        if (vm->atEnd) stack[sp++].pc = (uint16_t)(pc+1);
+        break;
+      case RE_WORDB:
+      case RE_NWORDB: {
+        bool boundary = regexIsWordChar(vm->prevCh) != (!vm->atEnd && regexIsWordChar(vm->ch));
+        if (boundary == (code[pc]==RE_WORDB)) stack[sp++].pc = (uint16_t)(pc+1);
+        break;
+      }
+      default: // waiting for a character, or RE_MATCH
+        l->pc[l->count] = (uint16_t)pc;
+        memcpy(&l->caps[l->count*vm->slots], caps, sizeof(size_t)*(size_t)vm->slots);
+        l->count++;
+    }
+  }
+}
+
+/** Run a compiled program on str, starting at startIndex. Returns a match array (like RegExp.exec)
+or 0 if there was no match */
+static JsVar *regexMatch(const unsigned char *prog, size_t progLen, JsVar *str, size_t startIndex) {
+  RegexVM vm;
+  int groups = prog[0];
+  RegexProgFlags flags = (RegexProgFlags)prog[1];
+  int threads = prog[2] | (prog[3]<<8);
+  size_t clearSlots = (size_t)(prog[4] | (prog[5]<<8));
+  unsigned char firstChars[RE_CLASS_BYTES];
+  bool useFirstChars = (flags & (RE_PROG_FIRSTCHAR|RE_PROG_FIRSTCHARS))!=0;
+  vm.code = &prog[RE_PROG_HEADER_LEN];
+  if (flags & RE_PROG_FIRSTCHARS) {
+    memcpy(firstChars, vm.code, RE_CLASS_BYTES);
+    vm.code += RE_CLASS_BYTES;
+  } else if (flags & RE_PROG_FIRSTCHAR) {
+    memset(firstChars, 0, RE_CLASS_BYTES);
+    regexClassAdd(firstChars, vm.code[0]);
+    vm.code++;
+  }
+  size_t codeLen = progLen - (size_t)(vm.code - prog);
+  vm.slots = (groups+1)*2;
+  // Allocate everything we need on the stack, or in a flat string if there isn't enough stack
+  size_t visitedLen = (codeLen+7)>>3;
+  size_t capsLen = sizeof(size_t)*(size_t)vm.slots;
+  size_t stackItems = codeLen+1+clearSlots;
+  size_t workLen = capsLen*(2 + 2*(size_t)threads) + sizeof(RegexAddItem)*stackItems +
+                   sizeof(uint16_t)*2*(size_t)threads + visitedLen;
+  JsVar *workVar = 0;
+  size_t *caps; // caps for new threads
+  if (workLen+256 > jsuGetFreeStack()) {
+    workVar = jsvNewFlatStringOfLength((unsigned int)(workLen+sizeof(size_t)));
+    if (!workVar) {
+      jsExceptionHere(JSET_ERROR, "Not enough memory for RegEx");
+      return 0;
+    }
+    caps = (size_t *)(((size_t)jsvGetFlatStringPointer(workVar)+sizeof(size_t)-1) & ~(sizeof(size_t)-1));
+  } else
+    caps = (size_t *)alloca(workLen);
+  size_t *matchCaps = &caps[vm.slots]; // caps for the best match so far
+  RegexThreadList lists[2];
+  lists[0].caps = &matchCaps[vm.slots];
+  lists[1].caps = &lists[0].caps[vm.slots*threads];
+  vm.stack = (RegexAddItem *)&lists[1].caps[vm.slots*threads];
+  lists[0].pc = (uint16_t *)&vm.stack[stackItems];
+  lists[1].pc = &lists[0].pc[threads];
+  vm.visited = (unsigned char *)&lists[1].pc[threads];
+  RegexThreadList *clist = &lists[0], *nlist = &lists[1];
+  clist->count = 0;
+  memset(vm.visited, 0, visitedLen);
+  bool matched = false;
+  int i;
+
+  vm.ch = 0;
+  if (startIndex) { // we need the character before startIndex for \b
+    jsvStringIteratorNew(&vm.it, str, startIndex-1);
+    vm.ch = jsvStringIteratorGetChar(&vm.it);
+    vm.index = startIndex-1;
+    regexNextChar(&vm);
+  } else {
+    jsvStringIteratorNew(&vm.it, str, 0);
+    vm.index = 0;
+    vm.prevCh = 0;
+    vm.ch = jsvStringIteratorGetChar(&vm.it);
+    vm.atEnd = !jsvStringIteratorHasChar(&vm.it);
+  }
+  while (true) {
+    if (!matched) {
+      // If nothing is matching, skip straight to a character that could start a match
+      if (!clist->count && useFirstChars && vm.index) {
+        while (!vm.atEnd && !regexClassHas(firstChars, (unsigned char)vm.ch))
+          regexNextChar(&vm);
+        if (vm.atEnd) break;
+      }
+      // Start a new (lowest priority) thread at this index
+      if (!useFirstChars || !vm.index || regexClassHas(firstChars, (unsigned char)vm.ch)) {
+        for (i=0;i<vm.slots;i++) caps[i] = RE_NO_INDEX;
+        caps[0] = vm.index;
+        regexAddThread(&vm, clist, 0, caps);
+      }
+    }
+    if (!clist->count) { // nothing matched here (eg. '^' or '\b' failed) so try the next character
+      if (matched || vm.atEnd) break;
+      regexNextChar(&vm);
+      memset(vm.visited, 0, visitedLen);
+      continue;
+    }
+    // Step every thread along by one character
+    size_t index = vm.index;
+    bool hasChar = !vm.atEnd;
+    char ch = vm.ch;
+    char lowerCh = (flags & RE_PROG_IGNORECASE) ? charToLowerCase(ch) : ch;
+    if (hasChar) regexNextChar(&vm);
+    memset(vm.visited, 0, visitedLen);
+    nlist->count = 0;
+    for (i=0;i<clist->count;i++) {
+      int pc = clist->pc[i];
+      size_t *threadCaps = &clist->caps[i*vm.slots];
+      RegexOp op = (RegexOp)vm.code[pc];
+      if (op==RE_MATCH) {
+        // lower priority threads can't override this match, so drop them
+        matched = true;
+        memcpy(matchCaps, threadCaps, capsLen);
+        matchCaps[1] = index;
+        break;
+      }
+      if (!hasChar) continue;
+      if (op==RE_CHAR) {
+        if (vm.code[pc+1]==(unsigned char)lowerCh)
+          regexAddThread(&vm, nlist, pc+2, threadCaps);
+      } else if (op==RE_CLASS) {
+        if (regexClassHas(&vm.code[pc+1], (unsigned char)ch))
+          regexAddThread(&vm, nlist, pc+1+RE_CLASS_BYTES, threadCaps);
+      } else // RE_ANY
+        regexAddThread(&vm, nlist, pc+1, threadCaps);
+    }
+    RegexThreadList *l = clist;
+    clist = nlist;
+    nlist = l;
+    if (!hasChar || jspIsInterrupted()) break;
+  }
+  jsvStringIteratorFree(&vm.it);
+  JsVar *rmatch = matched ? jsvNewEmptyArray() : 0;
+  if (!rmatch) {
+    jsvUnLock(workVar);
+    return 0;
+  }
+  for (i=0;i<=groups;i++) {
+    size_t start = matchCaps[i*2], end = matchCaps[i*2+1];
+    JsVar *matchStr = 0; // undefined if the group wasn't used
+    if (start!=RE_NO_INDEX && end!=RE_NO_INDEX && end>=start)
+      matchStr = jsvNewFromStringVar(str, start, end-start);
+    jsvSetArrayItem(rmatch, i, matchStr);
+    jsvUnLock(matchStr);
+  }
+  jsvObjectSetIntChild(rmatch, "index", (JsVarInt)matchCaps[0]);
+  jsvObjectSetChild(rmatch, "input", str);
+  jsvUnLock(workVar);
+  return rmatch;
+}
+
+/// Get the compiled program for a RegExp (compiling it if needed)
+static JsVar *jswrap_regexp_getProgram(JsVar *parent) {
+  JsVar *prog = jsvObjectGetChildIfExists(parent, JSWRAP_REGEXP_PROGRAM_NAME);
+  if (prog) return prog;
+  JsVar *source = jsvObjectGetChildIfExists(parent, "source");
+  if (jsvIsString(source)) {
+    prog = regexCompile(source, jswrap_regexp_hasFlag(parent,'i'));
+    if (prog) jsvObjectSetChild(parent, JSWRAP_REGEXP_PROGRAM_NAME, prog);
+  }
+  jsvUnLock(source);
+  return prog;
 }
 
 /*JSON{
@@ -277,8 +742,13 @@ The built-in class for handling Regular Expressions
 **Note:** Espruino's regular expression parser does not contain all the features
 present in a full ES6 JS engine. however some parts of the spec are not implemented:
 
-* [Assertions](https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions/Assertions) other than `^` and `$`
+* [Assertions](https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions/Assertions) other than `^`, `$`, `\b` and `\B`
 * [Numeric quantifiers](https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions/Quantifiers) (eg `x{3}`)
+* Backreferences, lookahead/lookbehind and named groups
+* The `m` (multiline), `s` (dotAll), `u` and `y` flags - `.` matches any character
+
+RegExps are compiled when they are created, and matching doesn't backtrack - the time
+taken is proportional to the length of the string being searched.
 
 There's a GitHub issue [concerning RegExp features here](https://github.com/espruino/Espruino/issues/1257)
 
@@ -317,6 +787,7 @@ JsVar *jswrap_regexp_constructor(JsVar *str, JsVar *flags) {
       jsvObjectSetChild(r, "flags", flags);
   }
   jsvObjectSetIntChild(r, "lastIndex", 0);
+  jsvUnLock(jswrap_regexp_getProgram(r)); // compile it now, so we throw any errors
 #ifndef ESPR_NO_REGEX_OPTIMISE
   /* Quick shortcut - if we were using regex just to find the end of a string (eg just
   normal chars and then $ at the end), do it with a single string compare which is faster.
@@ -405,22 +876,17 @@ JsVar *jswrap_regexp_exec(JsVar *parent, JsVar *arg) {
     jsvUnLock(endsWith);
   }
 #endif
-  // Otherwise do proper regex
-  JsVar *regex = jsvObjectGetChildIfExists(parent, "source");
-  if (!jsvIsString(regex) || lastIndex>(JsVarInt)jsvGetStringLength(str)) {
-    jsvUnLock2(str,regex);
-    return 0;
-  }
-  size_t regexLen = jsvGetStringLength(regex);
-  char *regexPtr = (char *)alloca(regexLen+1);
-  if (!regexPtr) {
-    jsvUnLock2(str,regex);
+  // Otherwise run the compiled regex
+  JsVar *prog = jswrap_regexp_getProgram(parent);
+  if (!prog || lastIndex<0 || lastIndex>(JsVarInt)jsvGetStringLength(str)) {
+    jsvUnLock2(str,prog);
     return 0;
   }
-  jsvGetString(regex, regexPtr, regexLen+1);
-  jsvUnLock(regex);
-  JsVar *rmatch = match(regexPtr, str, (size_t)lastIndex, jswrap_regexp_hasFlag(parent,'i'));
-  jsvUnLock(str);
+  JSV_GET_AS_CHAR_ARRAY(progPtr, progLen, prog);
+  JsVar *rmatch = 0;
+  if (progPtr)
+    rmatch = regexMatch((unsigned char *)progPtr, progLen, str, (size_t)lastIndex);
+  jsvUnLock2(str,prog);
   if (!rmatch) {
     rmatch = jsvNewWithFlags(JSV_NULL);
     lastIndex = 0;
@@ -417,7 +417,10 @@ void _jswrap_serial_print(JsVar *parent, JsVar *arg, bool isPrint, bool newLine)
     return;
 
   if (isPrint) arg = jsvAsString(arg);
-  jsvIterateCallback(arg, (void (*)(int,  void *))serialSend, (void*)&serialSendData);
+  if (serialSend == jsserialHardwareFunc) // copy whole blocks straight into the transmit buffer
+    jsvIterateBufferCallback(arg, jsserialHardwareBufferFunc, (void*)&serialSendData);
+  else
+    jsvIterateCallback(arg, (void (*)(int,  void *))serialSend, (void*)&serialSendData);
   if (isPrint) jsvUnLock(arg);
   if (newLine) {
     serialSend((unsigned char)'\r', &serialSendData);
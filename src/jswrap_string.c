@@ -367,9 +367,11 @@ static JsVar *_jswrap_string_replace(JsVar *parent, JsVar *subStr, JsVar *newSub
         unsigned int argCount = 0;
         JsVar *args[13];
         args[argCount++] = jsvLockAgain(matchStr);
-        JsVar *v;
-        while ((v = jsvGetArrayItem(match, (JsVarInt)argCount)) && argCount<11)
-          args[argCount++] = v;
+        JsVarInt groups = jsvGetArrayLength(match); // groups that weren't matched are undefined
+        while ((JsVarInt)argCount<groups && argCount<11) {
+          args[argCount] = jsvGetArrayItem(match, (JsVarInt)argCount);
+          argCount++;
+        }
         args[argCount++] = jsvObjectGetChildIfExists(match,"index");
         args[argCount++] = jsvObjectGetChildIfExists(match,"input");
         JsVar *result = jsvAsStringAndUnLock(jspeFunctionCall(replace, 0, 0, false, (JsVarInt)argCount, args));
@@ -383,11 +385,9 @@ static JsVar *_jswrap_string_replace(JsVar *parent, JsVar *subStr, JsVar *newSub
           char ch = jsvStringIteratorGetCharAndNext(&src);
           if (ch=='$') {
             ch = jsvStringIteratorGetCharAndNext(&src);
-            JsVar *group = 0;
-            if (ch>'0' && ch<='9')
-              group = jsvGetArrayItem(match, ch-'0');
-            if (group) {
-              jsvStringIteratorAppendString(&dst, group, 0, JSVAPPENDSTRINGVAR_MAXLENGTH);
+            if (ch>'0' && ch<='9' && ch-'0'<jsvGetArrayLength(match)) {
+              JsVar *group = jsvGetArrayItem(match, ch-'0'); // undefined (so empty) if the group wasn't matched
+              if (group) jsvStringIteratorAppendString(&dst, group, 0, JSVAPPENDSTRINGVAR_MAXLENGTH);
               jsvUnLock(group);
             } else {
               jsvStringIteratorAppend(&dst, '$');
@@ -572,28 +572,39 @@ JsVar *jswrap_string_split(JsVar *parent, JsVar *split) {
   // Use RegExp if one is passed in
   if (jsvIsInstanceOf(split, "RegExp")) {
     int last = 0;
+    int length = (int)jsvGetStringLength(parent);
     JsVar *match;
     jsvObjectSetIntChild(split, "lastIndex", 0);
     match = jswrap_regexp_exec(split, parent);
+    if (!length) {
+      // splitting "" gives [] if the RegExp matches it, or [""] if not
+      if (!match || jsvIsNull(match))
+        jsvArrayPush(array, parent);
+      jsvUnLock(match);
+      jsvObjectSetIntChild(split, "lastIndex", 0);
+      return array;
+    }
     while (match && !jsvIsNull(match)) {
       // get info about match
       JsVar *matchStr = jsvGetArrayItem(match,0);
       JsVarInt idx = jsvObjectGetIntegerChild(match,"index");
       int len = (int)jsvGetStringLength(matchStr);
-      jsvUnLock(matchStr);
-      // do the replacement
-      jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, (size_t)(idx-last)));
-      last = idx+len;
-      // search again
-      jsvUnLock(match);
-      jsvObjectSetIntChild(split, "lastIndex", last);
+      jsvUnLock2(matchStr, match);
+      match = 0;
+      // an empty match at the end of the string, or where the last match ended, doesn't split
+      if (idx >= length) break;
+      if (len || idx!=last) {
+        jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, (size_t)(idx-last)));
+        last = idx+len;
+      }
+      // search again - stepping on past empty matches so we don't match them again
+      jsvObjectSetIntChild(split, "lastIndex", idx + (len?len:1));
       match = jswrap_regexp_exec(split, parent);
     }
     jsvUnLock(match);
     jsvObjectSetIntChild(split, "lastIndex", 0);
     // add remaining string after last match
-    if (last <= (int)jsvGetStringLength(parent))
-      jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, JSVAPPENDSTRINGVAR_MAXLENGTH));
+    jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, JSVAPPENDSTRINGVAR_MAXLENGTH));
     return array;
   }
 #endif
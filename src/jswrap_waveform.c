@@ -330,7 +330,9 @@ void jswrap_waveform_stop(JsVar *waveform) {
 JsVar *_jswrap_waveform_getById(int id) {
   JsVar *waveforms = jsvObjectGetChild(execInfo.hiddenRoot, JSI_WAVEFORM_NAME, JSV_ARRAY);
   if (!waveforms) return 0;
-  return jsvGetArrayItem(waveforms, id);
+  JsVar *waveform = jsvGetArrayItem(waveforms, id);
+  jsvUnLock(waveforms);
+  return waveform;
 }
 
 /*JSON{
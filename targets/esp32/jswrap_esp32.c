@@ -285,11 +285,11 @@ void jswrap_ESP32_lightSleep(JsVarInt ms) {
 
   err = esp_light_sleep_start();
 
-  /* jsiIdle advances timers using (now - jsiLastIdleTime). While we blocked
-   * here the clock jumped but jsiLastIdleTime did not — the next idle pass
-   * would subtract the full sleep from every setInterval/setTimeout, often
-   * re-firing them in a tight loop until the watchdog resets. */
-  jsiLastIdleTime = jshGetSystemTime();
+  /* While we blocked here the clock jumped but jsiLastIdleTime did not — the
+   * next idle pass would see the full sleep as having passed for every
+   * setInterval/setTimeout, often re-firing them in a tight loop until the
+   * watchdog resets. */
+  jsiSetLastIdleTime(jshGetSystemTime());
 
 #ifdef ESPR_USE_USB_SERIAL_JTAG
   usb_serial_jtag_driver_config_t usb_cfg = {.tx_buffer_size = 128, .rx_buffer_size = 128};
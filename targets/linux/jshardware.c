@@ -286,12 +286,18 @@ void *jshInputThread() {
     // Write any data we have
     IOEventFlags device = jshGetDeviceToTransmit();
     while (device != EV_NONE) {
-      char ch = (char)jshGetCharToTransmit(device);
-      //printf("[[ '%c'\r\n", ch);
+      // write as much as we can in one go, straight from the transmit buffer
+      const unsigned char *data;
+      unsigned int len = jshGetTransmitSpan(device, &data);
+      shortSleep = true; // there may be more data on its way
       if (ioDevices[device]) {
-        write(ioDevices[device], &ch, 1);
-        shortSleep = true;
-      }
+        // only remove what was actually written - write can return -1 (EAGAIN) because O_NONBLOCK is set
+        ssize_t written = write(ioDevices[device], data, len);
+        if (written<0 && errno!=EAGAIN && errno!=EWOULDBLOCK) written = (ssize_t)len; // error - drop the data
+        if (written>0) jshTransmitSpanDone(device, (unsigned int)written);
+        if (written<(ssize_t)len) break; // device is busy - try again next time
+      } else
+        jshTransmitSpanDone(device, len); // nowhere to send it
       device = jshGetDeviceToTransmit();
     }
 
@@ -797,8 +803,14 @@ bool jshSleep(JsSysTime timeUntilWake) {
     usecs=1000; // don't sleep much if we have watches - we need to keep polling them
   if (usecs > 50000)
     usecs = 50000; // don't want to sleep too much (user input/HTTP/etc)
-  if (usecs >= 1000)
+  if (usecs >= 1000) {
+#if defined(USE_NET) && defined(__linux__)
+    // If we have sockets open, wait on those so we wake as soon as data arrives
+    extern bool net_linux_sleep(unsigned int usecs);
+    if (net_linux_sleep(usecs)) return true;
+#endif
     jshDelayMicroseconds(usecs);
+  }
   return true;
 }
 
@@ -28,6 +28,13 @@
 #define CMD_NAME "espruino"
 
 bool isRunning = true;
+#if defined(USE_NET) && defined(__linux__)
+#include "network_linux.h"
+/// Open sockets keep us running (socketIdle only reports busy if something happened)
+#define HAS_OPEN_SOCKETS() net_linux_hasSockets()
+#else
+#define HAS_OPEN_SOCKETS() false
+#endif
 struct filelist test_files;
 
 void warning(const char *, ...) __attribute__((__format__(__warning__, 1, 2)));
@@ -194,7 +201,7 @@ bool run_test(const char *filename) {
 
   isRunning = true;
   bool isBusy = true;
-  while (isRunning && (jsiHasTimers() || isBusy))
+  while (isRunning && (jsiHasTimers() || isBusy || HAS_OPEN_SOCKETS()))
     isBusy = jsiLoop();
 
   JsVar *result = jsvObjectGetChildIfExists(execInfo.root, "result");
@@ -289,6 +296,121 @@ bool run_all_tests() {
 }
 
 #ifdef ESPR_JIT
+/* Each test defines a function called 'jit' containing the 'jit' directive and
+ ends with an expression. It's run once JIT compiled, and once with the directive
+ renamed so it's interpreted - and the results must match */
+static const char *jitTests[] = {
+  "function jit() {'jit';return 1;};jit()",
+  "function jit() {'jit';return 1+2+3+4+5;};jit()",
+  "function jit() {'jit';return 'Hello';};jit()",
+  "function jit() {'jit';return true;};jit()",
+  "function jit() {'jit';return 1.5*3;};jit()",
+  "function jit() {'jit';return 12345678901;};jit()",
+  "function jit() {'jit';return null;};jit()",
+  "var test='Hello world';function jit() {'jit';return test;};jit()",
+  "function t() {return 'Hello';};function jit() {'jit';return t()+' world';};jit()",
+  "function jit() {'jit';return [!123,!0,~0,~5,-(1),+'42'];};jit()",
+  "function jit(a) {'jit';return a?5:10;};[jit(1),jit(0)]",
+  "function jit(a,b) {'jit';return a+'Hello world'+b;};jit(1,2)",
+  "i=0;function jit() {'jit';return i++;};[jit(),i]",
+  "i=0;function jit() {'jit';return ++i;};[jit(),i]",
+  "i='hello';function jit() {'jit';return i+=' world';};[jit(),i]",
+  "i=3;function jit() {'jit';return i-=2;};[jit(),i]",
+  "function jit() {'jit';i=42;};jit();i",
+  "function jit() {'jit';return [1<2,2<1,1==1,'a'=='b',3>=3];};jit()",
+  "function jit(i) {'jit';var r='';if (i<3) r+='T'; else r+='X';r+='-';return r;};[jit(2),jit(5)]",
+  "function jit() {'jit';var s=0;for (i=0;i<5;i=i+1) s+=i;return s;};jit()",
+  "function jit() {'jit';var s='';for (var i=0;i<5;++i) s+=i;return s;};jit()",
+  "function jit() {'jit';var s=0;for (var i=0;i<100;i++) { if (i&1) s+=i; else s-=1; };return s;};jit()",
+  "function jit() {'jit';while (1) return 42;};jit()",
+  "function jit() {'jit';while (0) return 0;return 42;};jit()",
+  "function jit(i) {'jit';var s='';while (i--) s+=i;return s;};jit(5)",
+  "function jit(i) {'jit';var s='';do { s+=i; } while (i--);return s;};jit(5)",
+  "a={b:42,c:function(){return this.b+1;}};function jit() {'jit';return [a.b,a['b'],a.c()];};jit()",
+  "a=new Uint8Array([42,43]);function jit() {'jit';var i=1;return a[i];};jit()",
+  "function jit() {'jit';return [1,2,1+2,'Hello','World'];};jit()",
+  "function jit() {'jit';return {a:42,b:10,12:5};};jit()",
+  "function jit() {'jit';return new Array(1,2,3,4);};jit()",
+  "function A() { this.foo=42; };function jit() {'jit';return new A();};jit()",
+  "function jit() {'jit';return [0&&2,3&&2,0||2,3||2];};jit()",
+  "o={a:42};function jit() {'jit';return this.a;};o.f=jit;o.f()",
+  "function jit() {'jit';return Math.PI;};jit()",
+  "o={a:1,b:2};function jit() {'jit';return Object.keys(o);};jit()",
+  "function jit(n) {'jit';var a=[];for (var i=0;i<n;i++) a.push(i*i);return a;};jit(10)",
+  "function jit() {'jit';var x=1073741822;var y=x;x++;++x;y+=y;return [x,y,x*x,-x];};jit()",
+  "function jit() {'jit';var x=-1073741823;x--;return [x,x-1,x<<1,x>>>1,x%7];};jit()",
+  "function jit(a) {'jit';var x=5;x='Hello';var y=a;y+=x;x={a:y};return [x,y];};jit(1)",
+  "function jit(a) {'jit';var x=6,y=3;return [x&y,x|y,x^y,x<<y,x>>1,x>>>y,x*y,x%4,x/4,x<y,x<=a,x==6,x!=a,x===6];};jit(6)",
+  "function jit() {'jit';var x=5;var r=[x++,x,++x,x,x--,x,--x,x];x*=3;r.push(x);x-=1;r.push(x);return r;};jit()",
+  "function jit(n) {'jit';for (var i=0;i<10;i++) if (i==n) return i*2;return -1;};[jit(4),jit(20)]",
+  "function jit() {'jit';var i=3;var i;let j=i+1;return [i,j];};jit()",
+  "function jit() {'jit';var s=0;for (var i=0;i<3;i++) for (var j=0;j<3;j++) s+=i*j;return s;};jit()",
+  NULL
+};
+
+/* Benchmarks - the function is defined by the first string, and the second
+ string is timed (with JIT and interpreted) */
+static const char *jitBenchmarks[][2] = {
+  { "function jit() {'jit';var s=0;for (var i=0;i<20000;i++) s+=i;return s;}", "jit()" },
+  { "function jit() {'jit';var s='';for (var i=0;i<2000;i++) s=(i&7)?s:s+i;return s.length;}", "jit()" },
+  { "function jit() {'jit';var s=0;for (var i=0;i<20000;i++) s=(s+(i&3))*3%1000;return s;}", "jit()" },
+  { "function jit() {'jit';var a={x:1};for (var i=0;i<5000;i++) a.x=a.x+i;return a.x;}", "jit()" },
+  { NULL, NULL }
+};
+
+/* Run code with or without JIT, and return the result as JSON. If 'timeMs' is
+ set, only 'timedCode' is timed */
+static JsVar *run_jit_code(const char *code, const char *timedCode, bool useJIT, JsVarFloat *timeMs) {
+  char *src = strdup(code);
+  if (!useJIT) { // rename the directive so the function is interpreted
+    char *d = src;
+    while ((d = strstr(d, "'jit'"))) memcpy(d, "'int'", 5);
+  }
+  JsVar *result = jspEvaluate(src, false);
+  free(src);
+  if (timedCode && !jspHasError()) {
+    jsvUnLock(result);
+    JsSysTime t = jshGetSystemTime();
+    result = jspEvaluate(timedCode, true);
+    *timeMs = jshGetMillisecondsFromTime(jshGetSystemTime() - t);
+  }
+  JsVar *json;
+  JsVar *exception = jspGetException();
+  if (exception) {
+    json = jsvVarPrintf("Uncaught %v", exception);
+    jsvUnLock(exception);
+  } else
+    json = jswrap_json_stringify(result, 0, 0);
+  jsvUnLock(result);
+  if (useJIT) { // check we really did compile the function
+    JsVar *fn = jsvObjectGetChildIfExists(execInfo.root, "jit");
+    JsVar *jitCode = fn ? jsvFindChildFromString(fn, JSPARSE_FUNCTION_JIT_CODE_NAME) : 0;
+    if (!jitCode) {
+      jsvUnLock(json);
+      json = jsvNewFromString("Not JIT compiled");
+    }
+    jsvUnLock2(fn, jitCode);
+  }
+  return json;
+}
+
+// Compare JIT and interpreted results for code. Returns true on pass
+static bool run_jit_test(const char *code, const char *timedCode) {
+  JsVarFloat jitTime = 0, intTime = 0;
+  JsVar *jitResult = run_jit_code(code, timedCode, true, &jitTime);
+  JsVar *intResult = run_jit_code(code, timedCode, false, &intTime);
+  bool pass = jsvIsString(jitResult) && jsvIsString(intResult) &&
+              jsvCompareString(jitResult, intResult, 0, 0, false)==0;
+  if (timedCode)
+    jsiConsolePrintf("%s %s : JIT %fms, interpreter %fms (x%f)\n", pass?"PASS":"FAIL", code, jitTime, intTime, intTime/jitTime);
+  else
+    jsiConsolePrintf("%s %s\n", pass?"PASS":"FAIL", code);
+  if (!pass)
+    jsiConsolePrintf("     JIT %v\n     interpreter %v\n", jitResult, intResult);
+  jsvUnLock2(jitResult, intResult);
+  return pass;
+}
+
 bool run_jit_tests() {
   jshInit();
   jswHWInit();
@@ -303,6 +425,18 @@ bool run_jit_tests() {
   jsvUnLock(v);
   bool pass = true;
 
+  int count = 0, passed = 0;
+  for (int i=0;jitTests[i];i++) {
+    count++;
+    if (run_jit_test(jitTests[i], NULL)) passed++;
+  }
+  for (int i=0;jitBenchmarks[i][0];i++) {
+    count++;
+    if (run_jit_test(jitBenchmarks[i][0], jitBenchmarks[i][1])) passed++;
+  }
+  jsiConsolePrintf("%d of %d JIT tests passed\n", passed, count);
+  if (passed != count) pass = false;
+
   warning("BEFORE: %d Memory Records Used", jsvGetMemoryUsage());
   // jsvTrace(execInfo.root, 0);
   jsiKill();
@@ -439,7 +573,7 @@ int main(int argc, char **argv) {
         int errCode = handleErrors();
         isRunning = !errCode;
         bool isBusy = true;
-        while (isRunning && (jsiHasTimers() || isBusy))
+        while (isRunning && (jsiHasTimers() || isBusy || HAS_OPEN_SOCKETS()))
           isBusy = jsiLoop();
         jsiKill();
         jsvKill();
@@ -526,7 +660,7 @@ int main(int argc, char **argv) {
     free(buffer);
     isRunning = !errCode;
     bool isBusy = true;
-    while (isRunning && (jsiHasTimers() || isBusy))
+    while (isRunning && (jsiHasTimers() || isBusy || HAS_OPEN_SOCKETS()))
       isBusy = jsiLoop();
     jsiKill();
     jsvKill();
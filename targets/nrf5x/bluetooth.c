@@ -985,13 +985,7 @@ void nus_transmit_string() {
   for (int packet=0;packet<1;packet++) {
     // No data? try and get some from our queue
     if (!nuxTxBufLength) {
-      nuxTxBufLength = 0;
-      int ch = jshGetCharToTransmit(EV_BLUETOOTH);
-      while (ch>=0) {
-        nusTxBuf[nuxTxBufLength++] = ch;
-        if (nuxTxBufLength>=max_data_len) break;
-        ch = jshGetCharToTransmit(EV_BLUETOOTH);
-      }
+      nuxTxBufLength = (uint16_t)jshGetDataToTransmit(EV_BLUETOOTH, nusTxBuf, (unsigned int)max_data_len);
     }
     // If there's no data in the queue, nothing to do - leave
     if (!nuxTxBufLength) return;
@@ -0,0 +1,29 @@
+// Check that memory is compacted when idle if it gets fragmented, and that data survives being moved
+var keep = [];
+for (var i=0;i<150;i++) {
+  var o = { n : i, s : "str"+i, a : [i,i+1] };
+  if (i%50==0) o.u = new Uint8Array(40).fill(i);
+  if (i%10==0) o.f = (function(k) { return function() { return k; }; })(i);
+  keep.push(o);
+  keep.push("junk"+i+"__________________________");
+}
+// free every other item to fragment memory, and fill up most of the space at the end
+for (var i=1;i<keep.length;i+=2) keep[i] = undefined;
+var m = process.memory();
+var filler = new Uint8Array((m.largestFree-50)*m.blocksize);
+var m1 = process.memory();
+E.setDefragThreshold(150);
+
+setTimeout(function() {
+  var m2 = process.memory();
+  E.setDefragThreshold(256);
+  var ok = true;
+  for (var i=0;i<150;i++) {
+    var o = keep[i*2];
+    if (o.n!=i || o.s!="str"+i || o.a.join()!=(i+","+(i+1))) ok = false;
+    if (i%50==0 && (o.u.length!=40 || o.u[39]!=(i&255))) ok = false;
+    if (i%10==0 && o.f()!=i) ok = false;
+  }
+  var big = new Uint8Array(140*m2.blocksize);
+  result = ok && m1.largestFree<150 && m2.largestFree>=150 && E.getAddressOf(big,true)!=0;
+}, 100);
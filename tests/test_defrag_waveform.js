@@ -0,0 +1,32 @@
+// Check that idle memory compaction doesn't move the buffer of a Waveform that is playing
+// (the timer IRQ holds a raw pointer to it)
+var keep = [];
+for (var i=0;i<150;i++) {
+  keep.push({ n : i, s : "str"+i });
+  keep.push("junk"+i+"__________________________");
+}
+for (var i=1;i<keep.length;i+=2) keep[i] = undefined;
+var w = new Waveform(64);
+w.buffer.fill(123);
+var addr = E.getAddressOf(w.buffer, true);
+w.startOutput(D1, 100, {repeat:true});
+var m = process.memory();
+var filler = new Uint8Array((m.largestFree-50)*m.blocksize);
+var m1 = process.memory();
+E.setDefragThreshold(150);
+
+var stillThere, m2;
+setTimeout(function() {
+  m2 = process.memory();
+  stillThere = E.getAddressOf(w.buffer, true)==addr && w.running;
+  w.stop();
+}, 100);
+setTimeout(function() {
+  // once the Waveform has stopped, memory can be compacted again
+  var m3 = process.memory();
+  E.setDefragThreshold(256);
+  var ok = true;
+  for (var i=0;i<150;i++)
+    if (keep[i*2].n!=i || keep[i*2].s!="str"+i) ok = false;
+  result = ok && stillThere && w.buffer[63]==123 && m3.largestFree>m2.largestFree;
+}, 400);
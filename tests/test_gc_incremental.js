@@ -0,0 +1,13 @@
+// Check that data survives while the garbage collector runs incrementally from idle
+var keep = { a : [1,2,3], b : "Hello" };
+for (var i=0;i<200;i++) { var o = {x:i}; o.self = o; }
+var m = process.memory();
+var hasPause = typeof m.gcmaxpause == "number";
+
+setTimeout(function() {
+  keep.c = { d : keep.a };
+  for (var i=0;i<200;i++) { var o = {x:i}; o.self = o; }
+  setTimeout(function() {
+    result = hasPause && keep.a.join()=="1,2,3" && keep.b=="Hello" && keep.c.d===keep.a;
+  }, 10);
+}, 10);
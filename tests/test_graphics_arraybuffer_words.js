@@ -0,0 +1,44 @@
+// Check word-at-a-time fillRect/blit/scroll against a simple model of the pixels
+var seed = 1;
+function rnd(n) { seed = (seed*1103515245+12345)&0x7FFFFFFF; return seed%n; }
+var ok = true, count=0;
+[1,2,4,8,16].forEach(function(bpp) {
+  [false,true].forEach(function(msb) {
+    [13,70].forEach(function(W) {
+      var H = 7;
+      var g = Graphics.createArrayBuffer(W,H,bpp,{msb:msb});
+      var m = new Uint16Array(W*H);
+      var maxc = (1<<bpp)-1;
+      for (var i=0;i<W*H;i++) { var c = rnd(maxc+1); m[i]=c; g.setPixel(i%W, 0|(i/W), c); }
+      for (var it=0;it<15;it++) {
+        var op = rnd(3);
+        if (op==0) {
+          var x1=rnd(W),x2=rnd(W),y1=rnd(H),y2=rnd(H),c=rnd(maxc+1);
+          if (x1>x2) {var t=x1;x1=x2;x2=t;} if (y1>y2) {var t=y1;y1=y2;y2=t;}
+          g.setColor(c).fillRect(x1,y1,x2,y2);
+          for (var y=y1;y<=y2;y++) for (var x=x1;x<=x2;x++) m[x+y*W]=c;
+        } else if (op==1) {
+          var w=1+rnd(W),h=1+rnd(H);
+          var x1=rnd(W-w+1),y1=rnd(H-h+1),x2=rnd(W-w+1),y2=rnd(H-h+1);
+          g.blit({x1:x1,y1:y1,w:w,h:h,x2:x2,y2:y2});
+          var s=new Uint16Array(m);
+          for (var y=0;y<h;y++) for (var x=0;x<w;x++) m[x2+x+(y2+y)*W]=s[x1+x+(y1+y)*W];
+        } else {
+          var dx=rnd(9)-4, dy=rnd(5)-2;
+          g.setBgColor(0).scroll(dx,dy);
+          var s=new Uint16Array(m);
+          for (var y=0;y<H;y++) for (var x=0;x<W;x++) {
+            var sx=x-dx, sy=y-dy;
+            m[x+y*W] = (sx>=0&&sx<W&&sy>=0&&sy<H) ? s[sx+sy*W] : 0;
+          }
+        }
+        for (var i=0;i<W*H;i++) if (g.getPixel(i%W,0|(i/W))!=m[i]) {
+          if (ok) print("FAIL bpp",bpp,"msb",msb,"W",W,"op",op,"it",it,"at",i%W,0|(i/W), g.getPixel(i%W,0|(i/W)), m[i]);
+          ok=false; break;
+        }
+        count++;
+      }
+    });
+  });
+});
+result = ok;
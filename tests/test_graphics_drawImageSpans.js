@@ -0,0 +1,65 @@
+// Check drawImage (1:1 and integer scaled) against a simple per-pixel model
+var seed = 1;
+function rnd(n) { seed = (seed*1103515245+12345)&0x7FFFFFFF; return seed%n; }
+var ok = true;
+var W = 40, H = 24;
+[1,2,4,8,16].forEach(function(gbpp) {
+  var g = Graphics.createArrayBuffer(W,H,gbpp);
+  var m = Graphics.createArrayBuffer(W,H,gbpp);
+  var gmax = (1<<gbpp)-1;
+  g.setColor(gmax).setBgColor(0);
+  [1,2,4,8,16].forEach(function(bpp) {
+    for (var it=0;it<12;it++) {
+      var w = 1+rnd(37), h = 1+rnd(9), s = 1+rnd(3);
+      if (it&1) s = 1;
+      var bits = new Uint8Array((w*h*bpp+7)>>3);
+      var maxc = (1<<bpp)-1;
+      var px = new Uint16Array(w*h);
+      // use lots of runs of the same colour
+      var c = 0;
+      for (var i=0;i<w*h;i++) {
+        if (rnd(3)==0) c = rnd(maxc+1);
+        px[i] = c;
+        for (var b=0;b<bpp;b++) if (c&(1<<(bpp-1-b))) {
+          var bit = i*bpp+b;
+          bits[bit>>3] |= 128>>(bit&7);
+        }
+      }
+      var img = {width:w,height:h,bpp:bpp,buffer:bits.buffer};
+      if (rnd(2)) img.transparent = rnd(maxc+1);
+      var pal = undefined;
+      // some image/Graphics bpp combinations get a default palette, so always give one there
+      var needPal = bpp==2 || (bpp==4 && gbpp>=8) || (bpp==8 && gbpp==16);
+      if (needPal || (bpp<=4 && rnd(2))) {
+        // palettes must be flat
+        pal = new Uint16Array(E.toArrayBuffer(E.toFlatString(new Uint8Array(2<<bpp))));
+        for (var i=0;i<pal.length;i++) pal[i] = rnd(gmax+1);
+        img.palette = pal;
+      }
+      var x = rnd(W+10)-10, y = rnd(H+10)-10;
+      // also draw from a non-flat String to check the StringIterator path
+      if (rnd(2)) {
+        var str = "";
+        for (var i=0;i<bits.length;i++) str += String.fromCharCode(bits[i]);
+        img.buffer = str;
+      }
+      g.clear(); m.clear();
+      if (rnd(2)) { g.setClipRect(2,3,W-4,H-2); m.setClipRect(2,3,W-4,H-2); }
+      else { g.reset().setColor(gmax); m.reset(); }
+      g.drawImage(img, x, y, s>1?{scale:s}:undefined);
+      for (var iy=0;iy<h;iy++) for (var ix=0;ix<w;ix++) {
+        var c = px[ix+iy*w];
+        if (img.transparent===c) continue;
+        if (pal) c = pal[c];
+        else if (bpp==1) c = c?gmax:0;
+        c &= gmax;
+        m.setColor(c).fillRect(x+ix*s, y+iy*s, x+ix*s+s-1, y+iy*s+s-1);
+      }
+      for (var py=0;py<H && ok;py++) for (var qx=0;qx<W;qx++) if (g.getPixel(qx,py)!=m.getPixel(qx,py)) {
+        print("FAIL gbpp",gbpp,"bpp",bpp,"it",it,"w",w,"h",h,"s",s,"at",qx,py,g.getPixel(qx,py),m.getPixel(qx,py));
+        ok = false; break;
+      }
+    }
+  });
+});
+result = ok;
@@ -0,0 +1,34 @@
+// Check that we keep track of separate modified areas
+var g = Graphics.createArrayBuffer(240,240,16);
+var ok = true;
+function SHOULD_BE(a, b) {
+  a = JSON.stringify(a);
+  if (a!=b) {
+    console.log("GOT :"+a+"\nSHOULD BE:"+b);
+    ok = false;
+  }
+}
+
+SHOULD_BE(g.getModifiedRects(), '[]');
+// two small areas in opposite corners stay separate
+g.setPixel(10,20).fillRect(200,200,230,230);
+SHOULD_BE(g.getModifiedRects(), '[{"x1":10,"y1":20,"x2":10,"y2":20},{"x1":200,"y1":200,"x2":230,"y2":230}]');
+SHOULD_BE(g.getModified(true), '{"x1":10,"y1":20,"x2":230,"y2":230}');
+SHOULD_BE(g.getModifiedRects(), '[]');
+// areas that overlap or are next to each other get merged
+g.fillRect(10,10,20,20).fillRect(15,15,30,30).fillRect(31,10,40,30);
+SHOULD_BE(g.getModifiedRects(true), '[{"x1":10,"y1":10,"x2":40,"y2":30}]');
+// text drawn pixel by pixel is all one area
+g.drawString("Hello",100,100);
+SHOULD_BE(g.getModifiedRects(true).length, '1');
+// we never have more than 4 areas, and everything stays covered
+for (var i=0;i<10;i++) g.fillRect(i*22,i*22,i*22+5,i*22+5);
+var r = g.getModifiedRects(true);
+SHOULD_BE(r.length<=4, 'true');
+for (var i=0;i<10;i++)
+  if (!r.some(a => a.x1<=i*22 && a.y1<=i*22 && a.x2>=i*22+5 && a.y2>=i*22+5)) ok = false;
+// areas are clipped to the screen
+g.fillRect(-10,-10,300,5);
+SHOULD_BE(g.getModifiedRects(true), '[{"x1":0,"y1":0,"x2":239,"y2":5}]');
+
+result = ok;
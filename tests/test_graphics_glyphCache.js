@@ -0,0 +1,101 @@
+// Check that glyphs drawn from the glyph cache match what we'd get drawing directly
+
+// Build a small (version 1) PBF font with glyphs 'A'..'Z' of different sizes, some of them 2bpp
+var seed = 1;
+function rnd(n) { seed = (seed*1103515245+12345)&0x7FFFFFFF; return seed%n; }
+function makePBF() {
+  var glyphs = [], cp;
+  for (cp=65;cp<=90;cp++) {
+    var w = 1+rnd(9), h = 1+rnd(12), bpp = (cp&3)==0 ? 2 : 1;
+    var data = new Uint8Array((w*h*bpp+7)>>3);
+    for (var i=0;i<data.length;i++) data[i] = rnd(256);
+    glyphs.push({cp:cp, w:w, h:h, x:rnd(3), y:rnd(4), advance:w+1, bpp:bpp, data:data});
+  }
+  var hashTable = new Uint8Array(255*4), offsets = new Uint8Array(glyphs.length*6), glyphData = [];
+  // one glyph per hash table bucket
+  var off = 4; // data offset 0 is reserved
+  glyphs.forEach(function(g, i) {
+    var h = g.cp % 255;
+    hashTable.set([h, 1, (i*6)&255, (i*6)>>8], h*4);
+    offsets.set([g.cp&255, g.cp>>8, off&255, (off>>8)&255, 0, 0], i*6);
+    var d = [g.w, g.h, g.x, g.y, g.advance | (g.bpp==2 ? 128 : 0)];
+    for (var j=0;j<g.data.length;j++) d.push(g.data[j]);
+    glyphData.push(d);
+    off += d.length;
+  });
+  var s = String.fromCharCode(1, 16, glyphs.length, 0, 32, 0) + E.toString(hashTable) + E.toString(offsets) + "\0\0\0\0";
+  glyphData.forEach(function(d) { s += E.toString(d); });
+  return s;
+}
+var font = makePBF();
+var flatFont = E.toFlatString(font); // font data in one block - glyphs are cached
+// a font made of many small strings can't be cached, so gives us the reference rendering
+var splitFont = "";
+for (var i=0;i<font.length;i+=10) splitFont += font.substr(i,10);
+
+var ok = true;
+function check(bpp, txt, scale, solid) {
+  var g1 = Graphics.createArrayBuffer(120,40,bpp);
+  var g2 = Graphics.createArrayBuffer(120,40,bpp);
+  g1.setColor(-1).setBgColor(1).clear();
+  g2.setColor(-1).setBgColor(1).clear();
+  // draw twice to check glyphs that are already in the cache
+  for (var i=0;i<2;i++) {
+    g1.setFontPBF(flatFont, scale).drawString(txt, 2+i*3, 3, solid);
+    g2.setFontPBF(splitFont, scale).drawString(txt, 2+i*3, 3, solid);
+  }
+  if (E.toString(g1.buffer)!=E.toString(g2.buffer) ||
+      g1.stringWidth(txt)!=g2.stringWidth(txt) ||
+      JSON.stringify(g1.wrapString(txt,30))!=JSON.stringify(g2.wrapString(txt,30))) {
+    print("FAIL PBF bpp",bpp,txt,scale,solid);
+    ok = false;
+  }
+}
+[1,2,16].forEach(function(bpp) {
+  check(bpp, "HELLO WORLD", 1, false);
+  check(bpp, "ABCDEFGHIJKLM\nNOPQRSTUVWXYZ", 1, true);
+  check(bpp, "QUICK", 2, false);
+  check(bpp, "abcTEST", 1, false); // missing chars
+});
+
+// Changing a font's data in place (or loading a new font into the same buffer) and calling
+// setFontPBF again mustn't draw stale glyphs - even if only the glyph bitmaps change
+seed = 1234;
+var fontB = makePBF();
+while (font.length<fontB.length) font += "\0";
+while (fontB.length<font.length) fontB += "\0";
+var fontC = font.substr(0,font.length-8) + "\x55\xAA\x55\xAA\x55\xAA\x55\xAA"; // same tables, different bitmaps
+[fontB, fontC].forEach(function(newFont, n) {
+  var splitNew = "";
+  for (var i=0;i<newFont.length;i+=10) splitNew += newFont.substr(i,10);
+  var buf = E.toFlatString(font);
+  var g1 = Graphics.createArrayBuffer(120,20,1), g2 = Graphics.createArrayBuffer(120,20,1);
+  g1.setFontPBF(buf).drawString("HELLO WORLD XYZ", 2, 2);
+  new Uint8Array(E.toArrayBuffer(buf)).set(E.toUint8Array(newFont));
+  g1.setFontPBF(buf).clear().drawString("HELLO WORLD XYZ", 2, 2);
+  g2.setFontPBF(splitNew).drawString("HELLO WORLD XYZ", 2, 2);
+  if (E.toString(g1.buffer)!=E.toString(g2.buffer) || g1.stringWidth("HELLO")!=g2.stringWidth("HELLO")) {
+    print("FAIL PBF changed in place", n);
+    ok = false;
+  }
+});
+
+// Vector fonts: compare against CRCs of what was drawn before there was a glyph cache
+var crcs = [];
+[6,11,23,40].forEach(function(size) {
+  var g = Graphics.createArrayBuffer(250,50,1);
+  for (var i=0;i<2;i++)
+    g.setFont("Vector",size).drawString("Hello 123 @#%&W", 1+i*5, 2+i, i==1);
+  crcs.push(E.CRC32(g.buffer));
+});
+// Lots of different glyphs so some get removed from the cache
+var g = Graphics.createArrayBuffer(250,50,1);
+for (var size=10;size<60;size+=7) {
+  g.clear().setFont("Vector",size).drawString("ABCDEFGHIJKLMNOPQRSTUVWXYZ", -size*3, 0);
+  crcs.push(E.CRC32(g.buffer));
+}
+if (crcs.join(",")!="3046296960,3933244601,2510805681,1821822623,1258417468,1787586265,97336855,2378658510,2465998881,3857940246,2220924494,860288361") {
+  print("FAIL Vector", crcs.join(","));
+  ok = false;
+}
+result = ok;
@@ -0,0 +1,31 @@
+// HTTP Transfer-Encoding: chunked - lots of chunks arriving in one packet,
+// and chunks split between packets
+
+var result = 0;
+var http = require("http");
+
+var big = new Array(100).fill('0123456789abcdef').join(''); // > MSS
+var expected = '';
+
+var server = http.createServer(function (req, res) {
+  res.writeHead(200, {'Content-Type': 'text/plain', 'Transfer-Encoding': 'chunked' });
+  for (var i=0;i<50;i++) res.write(i+",");
+  res.write(big);
+  for (i=0;i<20;i++) res.write("x"+i);
+  res.end();
+});
+server.listen(8080);
+
+for (var i=0;i<50;i++) expected += i+",";
+expected += big;
+for (i=0;i<20;i++) expected += "x"+i;
+
+http.get("http://localhost:8080/", function(res) {
+  var body = '';
+  res.on('data', function(data) { body += data; });
+  res.on('close', function() {
+    server.close();
+    result = body==expected;
+    console.log("Got", body.length, "expected", expected.length);
+  });
+});
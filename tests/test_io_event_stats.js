@@ -0,0 +1,25 @@
+// Check that character events get joined together, and that lost data is reported by E.getIOStats
+var s = "";
+for (var i=0;i<256;i++) s += String.fromCharCode(65+(i%26));
+E.getIOStats(); // reset stats
+E.getErrorFlags();
+
+var events = 0, got = "";
+LoopbackB.on('data', function(d) { events++; got += d; });
+LoopbackA.write(s); // 4 events of IOEVENT_MAX_LEN in the queue
+
+var r = [];
+setTimeout(function() {
+  var stats = E.getIOStats();
+  r.push(got==s, events<4, stats.highWater>=s.length, Object.keys(stats.drops).length==0);
+  events = 0;
+  got = "";
+  var big = s+s+s+s+s+s+s+s; // more than fits in the queue
+  LoopbackA.write(big);
+  setTimeout(function() {
+    var stats = E.getIOStats();
+    var flags = E.getErrorFlags();
+    r.push(stats.drops.LoopbackB>0, got.length+stats.drops.LoopbackB==big.length, flags.indexOf("FIFO_FULL")>=0);
+    result = r.every(x=>x);
+  }, 50);
+}, 50);
@@ -0,0 +1,83 @@
+// JSON.parser - parsing JSON a chunk at a time, optionally only building values at a path
+tests=0;
+testPass=0;
+
+function test(a, b) {
+  tests++;
+  if (a==b) {
+    return testPass++;
+  }
+  console.log("Test "+tests+" failed - ",a,"vs",b);
+}
+
+// Parse 'json' in chunks of 'chunk' chars, returning the values emitted
+function parse(json, chunk, options) {
+  var values = [];
+  var p = JSON.parser(options);
+  p.on('value', function(v, keys) { values.push(keys ? [keys,v] : v); });
+  for (var i=0;i<json.length;i+=chunk)
+    p.write(json.substr(i,chunk));
+  p.end();
+  return JSON.stringify(values);
+}
+
+var doc = {
+  version : 3, neg : -42, f : 1.5e3, nf : -0.25, t : true, fl : false, n : null,
+  str : "Hello \"World\"\n\t\\ /", empty : "", emptyArr : [], emptyObj : {},
+  apps : [ { name : "Clock", id : 1, files : ["a.js","b.js"] }, { name : "Alarm", id : 2, files : [] } ],
+  nested : { a : { b : { c : [1,[2,[3]]] } } }
+};
+var json = JSON.stringify(doc);
+var pretty = JSON.stringify(doc, null, 2);
+// Every chunk size should give the same result as JSON.parse
+[1,2,3,7,16,1000].forEach(function(chunk) {
+  test(parse(json, chunk), JSON.stringify([doc]));
+  test(parse(pretty, chunk), JSON.stringify([doc]));
+});
+
+// Several values at the top level (eg. one per line)
+test(parse('1 "two" [3]\n{"four":4}\n-5 true', 2), '[1,"two",[3],{"four":4},-5,true]');
+
+// Paths
+test(parse(json, 5, {path:["version"]}), '[[["version"],3]]');
+test(parse(json, 5, {path:["apps","*","name"]}), '[[["apps",0,"name"],"Clock"],[["apps",1,"name"],"Alarm"]]');
+test(parse(json, 5, {path:["apps",1]}), '[[["apps",1],{"name":"Alarm","id":2,"files":[]}]]');
+test(parse(json, 5, {path:["nested","a","*"]}), '[[["nested","a","b"],{"c":[1,[2,[3]]]}]]');
+test(parse(json, 5, {path:["missing"]}), '[]');
+test(parse('[[1,2],[3,4]]', 3, {path:["*",1]}), '[[[0,1],2],[[1,1],4]]');
+
+// Unicode escapes
+test(parse('"\\u0041\\u00e9"', 1), JSON.stringify([JSON.parse('"\\u0041\\u00e9"')]));
+test(parse('"\\ud83d\\ude00"', 3), JSON.stringify([JSON.parse('"\\ud83d\\ude00"')]));
+
+// Uint8Array data
+var values = [];
+var p = JSON.parser();
+p.on('value', function(v) { values.push(v); });
+p.write(E.toUint8Array('{"a":[1,2'));
+p.end(E.toUint8Array(',3]}'));
+test(JSON.stringify(values), '[{"a":[1,2,3]}]');
+
+// Errors throw, and the parser starts again
+var errors = 0;
+values = [];
+["[1,}", "{\"a\" 1}", "[1 2]", "nul ", "{1:2}", "]"].forEach(function(bad) {
+  try { p.write(bad); p.end(); } catch (e) { errors++; }
+});
+test(errors, 6);
+try { p.end("[1,2"); } catch (e) { errors++; }
+test(errors, 7);
+p.end('[3]');
+test(JSON.stringify(values), '[[3]]');
+
+// Parse straight from Storage
+var s = require("Storage");
+s.write("jsonparser.json", pretty);
+test(parse(s.read("jsonparser.json"), 1000, {path:["apps","*","files"]}), '[[["apps",0,"files"],["a.js","b.js"]],[["apps",1,"files"],[]]]');
+s.erase("jsonparser.json");
+
+// negative numbers in JSON.parse
+test(JSON.stringify(JSON.parse("[-1,-2.5,-1e3,-0]")), "[-1,-2.5,-1000,0]");
+
+result = tests==testPass;
+console.log(result?"Pass":"Fail",":",tests,"tests total");
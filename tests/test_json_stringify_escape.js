@@ -0,0 +1,32 @@
+// JSON.stringify writes strings, keys and numbers in blocks - check block boundaries and escapes
+var tests=0, testPass=0;
+function test(a, b) {
+  tests++;
+  if (a==b) return testPass++;
+  console.log("Test "+tests+" failed - ",a,"vs",b);
+}
+
+// escapes at every position relative to the buffer/block boundaries
+for (var i=0;i<70;i++) {
+  var s = "x".repeat(i)+"\"\\\n\x01"+"y".repeat(i);
+  var j = JSON.stringify(s);
+  test(j, '"'+"x".repeat(i)+'\\"\\\\\\n\\u0001'+"y".repeat(i)+'"');
+  test(JSON.parse(j), s);
+}
+// lots of escapes in a row
+var s = "\"\x02".repeat(50);
+test(JSON.parse(JSON.stringify(s)), s);
+test(JSON.stringify("\xFF"), '"\\u00FF"');
+// keys
+test(JSON.stringify({ab:1, "a\"b":2, 5:3, "":4}), '{"ab":1,"a\\"b":2,"5":3,"":4}');
+// numbers and other simple values
+test(JSON.stringify([0,-1,123456789,1.5,-2.25e-10,NaN,true,false,null,undefined]), '[0,-1,123456789,1.5,-2.25e-10,null,true,false,null,null]');
+// a big array, built up across many StringExts
+var a = [];
+for (var i=0;i<500;i++) a.push(i&1 ? "s"+i : i);
+var j = JSON.stringify(a);
+test(j.length, JSON.stringify(a.slice(0,250)).length + JSON.stringify(a.slice(250)).length - 1);
+test(JSON.stringify(JSON.parse(j)), j);
+
+result = tests==testPass;
+console.log(result?"Pass":"Fail",":",tests,"tests total");
@@ -0,0 +1,41 @@
+// Check that 'a op= b' and ++/-- which update numbers in place keep JS semantics
+var r = [];
+
+var a = 5; var b = a; a += 1;
+r.push(a===6 && b===5); // shared value must not be modified
+var i = 2147483647; i++;
+r.push(i===2147483648); // int overflow becomes float
+var j = -2147483648; --j;
+r.push(j===-2147483649);
+var k = 1; var l = k++;
+r.push(l===1 && k===2); // postfix returns the old value
+var m = 1; var n = ++m;
+r.push(m===2 && n===2);
+var f = 1.5; f *= 2;
+r.push(f===3);
+var d = 7; d /= 2;
+r.push(d===3.5);
+var z = 5; z %= 0;
+r.push(isNaN(z));
+var s = 1; s += "2";
+r.push(s==="12");
+var x = 0xF0; x |= 0x0F; x &= 0x3C; x ^= 1; x <<= 1; x >>= 2;
+r.push(x===((((0xF0|0x0F)&0x3C)^1)<<1)>>2);
+var u = -1; u >>>= 0;
+r.push(u===4294967295);
+var o = { v : 1 }; var ov = o.v; o.v++; o.v += 10;
+r.push(o.v===12 && ov===1);
+var arr = [1,2,3]; arr[1] *= 5; arr[2]--;
+r.push(arr[1]===10 && arr[2]===2);
+var t = new Uint8Array(2); t[0] += 300; t[1]--;
+r.push(t[0]===44 && t[1]===255);
+function fn(p) { p += 1; return p; }
+var q = 3;
+r.push(fn(q)===4 && q===3); // argument values are shared
+const c = 1;
+try { c += 1; r.push(false); } catch (e) { r.push(c===1); }
+var sum = 0;
+for (var w=0;w<100;++w) sum += w;
+r.push(sum===4950 && w===100);
+
+result = r.every(x=>x);
@@ -0,0 +1,28 @@
+// Identifier lookups are cached by position - check they still resolve to the right variable
+var ok = true;
+var x = "global";
+function get() { return x; }
+function makeGetter(v) { var x = v; return function() { return x; }; }
+var a = makeGetter("a"), b = makeGetter("b");
+var r = "";
+for (var i=0;i<3;i++) r += a()+b()+get();
+if (r!="abglobalabglobalabglobal") ok = false;
+// shadowing
+var y = "g";
+function shadow(local) { if (local) { var y = "local"; return y; } return global.y; }
+if (shadow(true)!="local" || shadow(false)!="g" || y!="g") ok = false;
+// deleting and re-adding a global between uses
+var s = 0;
+for (var i=0;i<4;i++) {
+  z = i;
+  s += z;
+  delete z;
+}
+if (s!=6 || typeof z!="undefined") ok = false;
+// the same position in different code
+var e1 = eval("x"), e2 = eval("i");
+if (e1!="global" || e2!=4) ok = false;
+// recursion
+function fact(n) { return n<=1 ? 1 : n*fact(n-1); }
+if (fact(6)!=720) ok = false;
+result = ok;
@@ -0,0 +1,14 @@
+// Check that numbers allocated in the nursery survive being moved out into main memory
+var a = [];
+for (var i=0;i<300;i++) a.push(i*1.5);
+var o = { x : 1.5, y : 7, z : true };
+var m = process.memory(false).nursery;
+
+setTimeout(function() {
+  var m2 = process.memory(false).nursery;
+  var sum = 0;
+  a.forEach(function(x) { sum += x; });
+  result = m.size>0 && m.hits>0 && m2.promoted>0 &&
+           a.length==300 && sum==67275 && a[299]==448.5 &&
+           o.x==1.5 && o.y==7 && o.z===true;
+}, 10);
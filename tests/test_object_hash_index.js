@@ -0,0 +1,45 @@
+// Objects with lots of keys get a hash index - check lookups stay correct as they change
+var ok = true;
+var o = {};
+for (var i=0;i<200;i++) o["key"+i] = i;
+for (var i=0;i<200;i++) if (o["key"+i]!==i) ok = false;
+if (o.nothere!==undefined || ("key200" in o)) ok = false;
+// delete some from the middle, start and end
+delete o.key0;
+delete o.key199;
+for (var i=50;i<150;i+=3) delete o["key"+i];
+for (var i=0;i<200;i++) {
+  var shouldExist = !(i==0 || i==199 || (i>=50 && i<150 && ((i-50)%3)==0));
+  if ((o["key"+i]===i) != shouldExist) ok = false;
+}
+// add more, so the index has to grow
+for (var i=200;i<500;i++) o["key"+i] = i*2;
+for (var i=200;i<500;i++) if (o["key"+i]!==i*2) ok = false;
+if (Object.keys(o).length != 200-2-34+300) ok = false;
+// modify existing
+o.key10 = "ten";
+if (o.key10!=="ten") ok = false;
+// short and numeric-looking keys
+for (var i=0;i<40;i++) o[String.fromCharCode(65+i)] = i;
+for (var i=0;i<40;i++) if (o[String.fromCharCode(65+i)]!==i) ok = false;
+o[5] = "five";
+if (o["5"]!=="five" || o[5]!=="five") ok = false;
+// lots of globals
+for (var i=0;i<100;i++) global["g"+i] = i;
+if (g42!==42 || g99!==99) ok = false;
+delete global.g42;
+if (typeof g42!=="undefined") ok = false;
+// lots of different big objects at once
+var objs = [];
+for (var j=0;j<8;j++) {
+  var x = {};
+  for (var i=0;i<30;i++) x["k"+i] = j*100+i;
+  objs.push(x);
+}
+for (var j=0;j<8;j++)
+  for (var i=0;i<30;i++)
+    if (objs[j]["k"+i]!==j*100+i) ok = false;
+var y = JSON.parse(JSON.stringify(o));
+if (y.key300!==600 || y.key10!=="ten") ok = false;
+
+result = ok;
@@ -0,0 +1,29 @@
+// Pretokenised code stores where each block ends, so skipped blocks can be jumped over
+E.setFlags({pretokenise:1});
+function f(n) {
+  var s = 0;
+  for (var i=0;i<n;i++) {
+    if (i%2) { s += 1; if (s>1000) { s = 0; } else { var o = {a:{b:i}}; s += o.a.b; } }
+    else { if (i==4) { continue; } s += 100; }
+    if (i==7) { break; }
+  }
+  return s;
+}
+// deeper than the block stack, so some blocks don't store their end
+function deep(x) {
+  if (x) {{{{{{{{{{{{{{{{{{{{ x++; }}}}}}}}}}}}}}}}}}}}
+  else {{{{{{{{{{{{{{{{{{{{ x--; }}}}}}}}}}}}}}}}}}}}
+  return x;
+}
+function ret(x) {
+  while (true) { if (x>3) { return x; } x++; }
+}
+function sw(x) {
+  switch (x) { case 1: { return "one"; } default: { return "other"; } }
+}
+var src = f.toString();
+var g = eval("("+src+")");
+E.setFlags({pretokenise:0});
+result = f(10)==320 &&
+  deep(1)==2 && deep(0)==-1 && ret(0)==4 && sw(1)=="one" && sw(2)=="other" &&
+  g(10)==f(10) && src.indexOf("{")>0 && src.indexOf("\xD6")<0;
@@ -0,0 +1,92 @@
+// RegExp features that need the compiled matcher: '?', lazy quantifiers, nested alternation,
+// non-capturing groups, word boundaries, unmatched groups and (lack of) backtracking
+tests=0;
+testPass=0;
+
+function test(a, b) {
+  tests++;
+  if (JSON.stringify(a)==JSON.stringify(b)) {
+    return testPass++;
+  }
+  console.log("Test "+tests+" failed - ",a,"vs",b);
+}
+function exec(re, str) {
+  var m = re.exec(str);
+  if (!m) return null;
+  var r = [];
+  for (var i=0;i<m.length;i++) r.push(m[i]===undefined ? "undef" : m[i]);
+  r.push(m.index);
+  return r;
+}
+function throws(src) {
+  try { new RegExp(src); } catch (e) { return true; }
+  return false;
+}
+
+test(exec(/colou?r/, "the color"), ["color",4]);
+test(exec(/colou?r/, "the colour"), ["colour",4]);
+test(exec(/a+?/, "aaa"), ["a",0]);
+test(exec(/a*?b/, "xaab"), ["aab",1]);
+test(exec(/<.+>/, "<a><b>"), ["<a><b>",0]);
+test(exec(/<.+?>/, "<a><b>"), ["<a>",0]);
+test(exec(/x(ab|cd|e)+y/, "xabcdey"), ["xabcdey","e",0]);
+test(exec(/(?:ab)+c/, "ababc"), ["ababc",0]);
+test(exec(/(a)|(b)/, "xb"), ["b","undef","b",1]);
+test(exec(/a(b)?c/, "ac"), ["ac","undef",0]);
+test(exec(/\bcat\b/, "concat cat"), ["cat",7]);
+test(exec(/\Bcat/, "cat concat"), ["cat",7]);
+test(exec(/(a)(b)(c)(d)(e)(f)(g)(h)(i)(j)(k)/, "abcdefghijk").length, 13);
+test(exec(/^(?:GET|POST) (\/\w*)/, "POST /data HTTP/1.1"), ["POST /data","/data",0]);
+test(exec(/[^a-c]+/i, "abCDEfa"), ["DEf",3]);
+test(exec(/\d+$/, "a1b22"), ["22",3]);
+test(exec(/^$/, ""), ["",0]);
+test(exec(/b*/, "abc"), ["",0]);
+
+// a global regex continues from lastIndex
+var re = /o/g;
+re.exec("foo");
+test(re.lastIndex, 2);
+test(exec(re, "foo"), ["o",2]);
+test(re.lastIndex, 3);
+
+test("a1b2c3".replace(/(\d)|(x)/g, "[$1$2]"), "a[1]b[2]c[3]");
+test("a1b".replace(/(\d)|(x)/, function(m,a,b) { return typeof a+","+typeof b; }), "astring,undefinedb");
+test("one\r\ntwo\nthree".split(/\r?\n/), ["one","two","three"]);
+test("Hello World".match(/o\b/g), ["o"]);
+
+// Invalid RegExps throw when they're created
+test(throws("a)"), true);
+test(throws("(a"), true);
+test(throws("[a"), true);
+test(throws("*a"), true);
+test(throws("a**"), true);
+test(throws("(a)\\1"), true);
+test(throws("a|b"), false);
+
+// This used to take exponential time with backtracking
+var s = "";
+for (var i=0;i<200;i++) s += "a";
+var t = getTime();
+test(/(a*)*a*a*b/.test(s), false);
+test(/(a|aa)+$/.test(s), true);
+test((getTime()-t) < 1, true);
+
+// Groups inside a repeated group are unset at the start of each repetition
+test(exec(/((a)|b)+/, "ab"), ["ab","b","undef",0]);
+test(exec(/(?:(x)|y)+/, "xy"), ["xy","undef",0]);
+test(exec(/(?:(x)|y)*z/, "xyz"), ["xyz","undef",0]);
+test(exec(/(?:(x)|(y))+/, "yx"), ["yx","x","undef",0]);
+test(exec(/((a)|b)+?c/, "abc"), ["abc","b","undef",0]);
+test(exec(/(?:(a)|b)?/, "a"), ["a","a",0]);
+test(exec(/(?:(?:(a)|b)(c))+/, "acbc"), ["acbc","undef","c",0]);
+
+// Long chains of optional atoms used to recurse once per atom when adding threads
+var greedy = "", lazy = "", groups = "";
+for (var i=0;i<1000;i++) { greedy += "a?"; lazy += "a??"; groups += "(?:a|b)?"; }
+test(exec(new RegExp(greedy+"b"), "xaaab"), ["aaab",1]);
+test(exec(new RegExp(lazy+"b"), "xaaab"), ["aaab",1]);
+test(exec(new RegExp("("+lazy+")c"), "aac"), ["aac","aa",0]);
+test(exec(new RegExp(groups+"$"), "abba"), ["abba",0]);
+
+result = tests==testPass;
+console.log(result?"Pass":"Fail",":",tests,"tests total");
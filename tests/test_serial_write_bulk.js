@@ -0,0 +1,17 @@
+// Writes of whole strings should go through complete and in order - both for loopback and for devices using the transmit buffer
+var s = "";
+for (var i=0;i<64;i++) s += String.fromCharCode(48+i);
+var got = "";
+LoopbackB.on('data', function(d) { got += d; });
+LoopbackA.write(E.toString(s));
+LoopbackA.print("x");
+LoopbackA.write([65,66,67]);
+
+// Serial1 isn't connected on Linux, so this just checks that the buffer empties and we don't lock up
+var big = E.toString(s+s+s+s+s+s+s+s+s+s); // flat string, bigger than the transmit buffer
+Serial1.write(big);
+Serial1.print(s);
+
+setTimeout(function() {
+  result = got == s+"xABC" && process.memory().tx.used == 0;
+}, 100);
@@ -0,0 +1,27 @@
+// `s = s + x` appends to the String in place when nothing else can see it - check it never changes what code sees
+var r = [];
+var s = "ab"; var t = s; s = s + "c"; r.push(s, t);
+s = "ab"; var o = {k:s}; s = s + "c"; r.push(s, o.k);
+s = "ab"; function f(x) { return s + "|" + x; } s = f(s + "c"); r.push(s);
+s = "ab"; s = s + "c" ? "yes" : "no"; r.push(s);
+s = "ab"; s = s + (t = s, "d"); r.push(s, t);
+s = "ab"; s = s + s; r.push(s);
+s = "ab"; s = s + 1 + 2; r.push(s);
+s = "ab"; s = s + {toString:function(){ return "X"+s; }}; r.push(s);
+s = "ab"; s = s + null + undefined; r.push(s);
+s = "ab"; var arr=[s]; s = s + "q"; r.push(arr[0], s);
+s = "ab"; s = s + "é"; r.push(s, s.length);
+s = "ab"; s = s + 5; r.push(s);
+s = "ab"; s = s + 5
+r.push(s)
+var n = 1; n = n + "x"; r.push(n);
+s = "ab"; [1,2].forEach(function(){ s = s + "!"; }); r.push(s);
+s = "ab"; "xy".replace(/./g, function(c){ s = s + c; return c; }); r.push(s);
+s = E.toFlatString("flatflatflatflatflat"); s = s + "!"; r.push(s);
+s = "ab"; s = s + "c" + (s = "z"); r.push(s);
+s = "ab"; var g = s; s = s + "1"; s = s + "2"; r.push(g, s);
+const k = "ab"+"q"; try { k = k + "c"; } catch (e) { r.push(e instanceof TypeError); } r.push(k);
+var x = "ab"+"", setTo; Object.defineProperty(this, "gs", {get:function(){ return x; }, set:function(v){ setTo = v; }, configurable:true});
+gs = gs + "c"; r.push(x, setTo);
+var s = ""; for (var i=0;i<500;i++) s = s + "0123456789"; r.push(s.length, s.substr(4990));
+result = JSON.stringify(r) == JSON.stringify(["abc","ab","abc","ab","ab|abc","yes","abd","ab","abab","ab12","abXab","abnullundefined","ab","abq","abé",3,"ab5","ab5","1x","ab!!","abxy","flatflatflatflatflat!","abcz","ab","ab12",true,"abq","ab","abc",5000,"0123456789"]);
@@ -0,0 +1,25 @@
+// String.split with RegExps that can match an empty string
+var tests = [
+  ["abc", /(?:)/, '["a","b","c"]'],
+  ["abc", /x*/, '["a","b","c"]'],
+  ["axb", /x*/, '["a","b"]'],
+  ["axxbx", /x*/, '["a","b",""]'],
+  ["abc", /b*/, '["a","c"]'],
+  ["abc", /$/, '["abc"]'],
+  ["abc", /^/, '["abc"]'],
+  ["a,b,,c", /,/, '["a","b","","c"]'],
+  ["1a2b3", /[a-z]/g, '["1","2","3"]'],
+  ["", /(?:)/, '[]'],
+  ["", /x*/, '[]'],
+  ["", /a/, '[""]'],
+  [",a,", /,/, '["","a",""]'],
+];
+var ok = true;
+tests.forEach(function(t) {
+  var r = JSON.stringify(t[0].split(t[1]));
+  if (r!=t[2]) {
+    console.log(JSON.stringify(t[0])+".split("+t[1]+") = "+r+", expected "+t[2]);
+    ok = false;
+  }
+});
+result = ok;
@@ -0,0 +1,20 @@
+// Lots of timers at once - check they run in the order they're due, and that clearing/changing them works
+var fired = [];
+var ids = [];
+for (var i=0;i<1000;i++) {
+  var t = (i*37)%100; // not in the order they're added
+  ids.push(setTimeout(function(due) { fired.push(due); }, t, getTime()*1000+t));
+}
+// clear every 10th one
+for (i=0;i<1000;i+=10) clearTimeout(ids[i]);
+var count = 0;
+var iv = setInterval(function() { count++; }, 1000);
+changeInterval(iv, 20);
+
+setTimeout(function() {
+  clearInterval(iv);
+  var ordered = true;
+  for (var i=1;i<fired.length;i++)
+    if (fired[i] < fired[i-1]-1) ordered = false;
+  result = fired.length==900 && ordered && count>=4;
+}, 200);
@@ -0,0 +1,151 @@
+// Typed array sort/indexOf/includes and E.sum/E.variance, which use native
+// kernels when the data is in one flat block, and iterate otherwise
+var ok = true;
+function check(name, got, expected) {
+  if (got !== expected) {
+    console.log("FAIL", name, JSON.stringify(got), "!=", JSON.stringify(expected));
+    ok = false;
+  }
+}
+function str(a) { return a.join(","); }
+
+// pseudo-random data so results don't depend on Math.random
+var seed = 1;
+function rnd() { seed = (seed*1103515245 + 12345) & 0x7FFFFFFF; return seed; }
+
+var types = {Int8Array:Int8Array, Uint8Array:Uint8Array, Uint8ClampedArray:Uint8ClampedArray,
+  Int16Array:Int16Array, Uint16Array:Uint16Array, Int32Array:Int32Array, Uint32Array:Uint32Array,
+  Float32Array:Float32Array, Float64Array:Float64Array};
+Object.keys(types).forEach(function(name) {
+  var T = types[name];
+  [0, 1, 2, 5, 17, 63, 64, 300].forEach(function(n) {
+    var a = new T(n);
+    var ref = [];
+    for (var i=0;i<n;i++) {
+      a[i] = (rnd() % 2000) - 1000;
+      if (T==Float32Array || T==Float64Array) a[i] /= 7;
+      ref.push(a[i]);
+    }
+    ref.sort(function(x,y) { return x-y; });
+    a.sort();
+    check(name+" sort "+n, str(a), str(ref));
+    // already sorted, reversed and all-equal inputs
+    a.sort();
+    check(name+" sorted "+n, str(a), str(ref));
+    a.reverse(); a.sort();
+    check(name+" reversed "+n, str(a), str(ref));
+    a.fill(3); a.sort();
+    check(name+" equal "+n, a.every(function(v) { return v==3; }), true);
+  });
+});
+
+// reverse
+var r = new Uint16Array([1, 2, 3, 4, 5]);
+r.reverse();
+check("reverse odd", str(r), "5,4,3,2,1");
+r = new Float64Array([1.5, -2]);
+r.reverse();
+check("reverse f64", str(r), "-2,1.5");
+r = new Uint8Array(300);
+for (var i=0;i<r.length;i++) r[i] = i;
+r.reverse();
+check("reverse big", r[0]+","+r[299], "43,0");
+check("reverse empty", str(new Int32Array(0).reverse()), "");
+
+// NaN sorts last
+var f = new Float64Array([3, NaN, 0, 1, NaN, 0, -Infinity, Infinity, -2]);
+f.sort();
+check("float sort", str(f), "-Infinity,-2,0,0,1,3,Infinity,NaN,NaN");
+f = new Float32Array([NaN, 2, NaN, 1]);
+f.sort();
+check("float32 NaN", str(f), "1,2,NaN,NaN");
+// compare functions still work
+f = new Int16Array([1, 5, -3, 2]);
+f.sort(function(a,b) { return b-a; });
+check("compareFn", str(f), "5,2,1,-3");
+// a view onto part of a buffer only sorts its own elements
+var buf = new Uint16Array([9, 8, 7, 6, 5, 4]);
+new Uint16Array(buf.buffer, 2, 4).sort();
+check("view sort", str(buf), "9,5,6,7,8,4");
+// large 8 bit arrays use a counting sort
+var b = new Int8Array(1000);
+for (var i=0;i<b.length;i++) b[i] = rnd();
+b.sort();
+var sorted = true;
+for (var i=1;i<b.length;i++) if (b[i-1]>b[i]) sorted = false;
+check("int8 counting sort", sorted, true);
+
+// data that isn't in one flat block uses the iterator fallback
+var s = ""; for (var i=0;i<40;i++) s += String.fromCharCode(i*37&255);
+var nf = new Uint32Array(E.toArrayBuffer(s));
+nf.sort();
+check("non-flat sort", str(nf), "64928148,267044256,721871292,1395526116,1867130112,2069246220,2540850472,2742966580,3214570832,3888291192");
+var nf8 = new Uint8Array(E.toArrayBuffer(s));
+check("non-flat indexOf", nf8.indexOf(37), 17);
+check("non-flat includes", nf8.includes(74), true);
+check("non-flat sum", E.sum(nf8), 4540);
+// values no element can equal are rejected the same way as for flat data
+var nf16 = new Int16Array(E.toArrayBuffer(s.substr(0,38)));
+nf16.fill(0); nf16[1] = 3;
+check("non-flat indexOf NaN", nf16.indexOf(NaN), -1);
+check("non-flat indexOf 0.5", nf16.indexOf(0.5), -1);
+check("non-flat indexOf 3.7", nf16.indexOf(3.7), -1);
+check("non-flat indexOf string", nf16.indexOf("3"), -1);
+check("non-flat indexOf 3", nf16.indexOf(3), 1);
+check("non-flat indexOf neg start", nf16.indexOf(0, -2), 17);
+check("non-flat includes NaN", nf16.includes(NaN), false);
+check("non-flat includes string", nf16.includes("3"), false);
+check("non-flat includes 3", nf16.includes(3), true);
+var nff = new Float32Array(E.toArrayBuffer(s.substr(0,36)+"\0\0\xC0\x7F"));
+check("non-flat f32 indexOf NaN", nff.indexOf(NaN), -1);
+check("non-flat f32 includes NaN", nff.includes(NaN), true);
+check("non-flat f32 indexOf string", nff.indexOf("0"), -1);
+
+// indexOf/includes
+var u = new Uint8Array([1, 2, 3, 200, 2]);
+check("u8 indexOf", u.indexOf(2), 1);
+check("u8 indexOf start", u.indexOf(2, 2), 4);
+check("u8 indexOf neg start", u.indexOf(2, -1), 4);
+check("u8 indexOf big start", u.indexOf(2, 10), -1);
+check("u8 indexOf 200", u.indexOf(200), 3);
+check("u8 indexOf -56", u.indexOf(-56), -1);
+check("u8 indexOf 1.5", u.indexOf(1.5), -1);
+check("u8 indexOf string", u.indexOf("2"), -1);
+check("u8 includes", u.includes(3), true);
+check("u8 includes start", u.includes(1, 1), false);
+var i8 = new Int8Array([5, -1, 127, -128]);
+check("i8 indexOf -1", i8.indexOf(-1), 1);
+check("i8 indexOf -128", i8.indexOf(-128), 3);
+check("i8 indexOf 255", i8.indexOf(255), -1);
+var i32 = new Int32Array([100000, -7, 0]);
+check("i32 indexOf", i32.indexOf(-7), 1);
+check("i32 indexOf 0", i32.indexOf(-0), 2);
+var u32 = new Uint32Array([4000000000, 1]);
+check("u32 indexOf", u32.indexOf(4000000000), 0);
+check("u32 indexOf -1", u32.indexOf(-1), -1);
+var f32 = new Float32Array([0.5, NaN, -0]);
+check("f32 indexOf", f32.indexOf(0.5), 0);
+check("f32 indexOf 0", f32.indexOf(0), 2);
+check("f32 indexOf NaN", f32.indexOf(NaN), -1);
+check("f32 includes NaN", f32.includes(NaN), true);
+check("f32 includes 0.1", f32.includes(0.1), false);
+var f64 = new Float64Array([0.1, 0.2]);
+check("f64 indexOf", f64.indexOf(0.2), 1);
+check("f64 includes NaN", f64.includes(NaN), false);
+
+// E.sum / E.variance
+var s = new Int16Array([1000, -2000, 3000, 32767]);
+check("sum i16", E.sum(s), 34767);
+check("variance i16", E.variance(s, 0), 1000*1000+2000*2000+3000*3000+32767*32767);
+check("sum u32", E.sum(new Uint32Array([4000000000, 4000000000])), 8000000000);
+check("sum u8", E.sum(new Uint8Array([255, 255, 1])), 511);
+check("sum clamped", E.sum(new Uint8ClampedArray([255, 255])), 510);
+check("sum f32", E.sum(new Float32Array([1.5, 2])), 7/2);
+check("variance f64", E.variance(new Float64Array([1, 2, 3]), 2), 2);
+check("sum ArrayBuffer", E.sum(new Uint8Array([1, 2, 3]).buffer), 6);
+check("sum view", E.sum(new Uint8Array(new Uint8Array([1, 2, 3, 4]).buffer, 1, 2)), 5);
+check("sum empty", E.sum(new Float32Array(0)), 0);
+check("sum array", E.sum([1, 2, 3]), 6);
+check("variance array", E.variance([1, 2, 3], 2), 2);
+
+result = ok;